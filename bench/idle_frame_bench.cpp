@@ -0,0 +1,76 @@
+#include "application.hpp"
+#include "database/statement_stats.hpp"
+#include "utils/alloc_profiler.hpp"
+#include <functional>
+#include <iostream>
+#include <iterator>
+
+// Renders the application headless and fails if an idle frame touches the heap. Built with
+// -DDEAR_SQL_BUILD_BENCHMARKS=ON, which needs -DDEAR_SQL_ALLOC_PROFILER=ON, and run by ctest.
+namespace {
+    constexpr int kWarmupFrames = 30;
+    constexpr int kMeasuredFrames = 240;
+    constexpr double kFrameSeconds = 1.0 / 60.0;
+
+    struct Scenario {
+        const char *name;
+        std::function<void(Application &)> setup;
+    };
+
+    const Scenario kScenarios[] = {
+        {"empty window", [](Application &) {}},
+        {"SQL editor",
+         [](Application &app) {
+             app.getTabManager()->createSQLEditorTab();
+         }},
+    };
+
+    // The statement stats flush submits a job every few seconds; that is periodic work rather
+    // than part of an idle frame, so the whole run fits between two flushes
+    static_assert(std::size(kScenarios) * (kWarmupFrames + kMeasuredFrames) * kFrameSeconds <
+                      StatementStats::kFlushIntervalSeconds,
+                  "benchmark must finish within one statement stats flush interval");
+} // namespace
+
+int main() {
+    if (!AllocProfiler::isEnabled()) {
+        std::cerr << "Configure with -DDEAR_SQL_ALLOC_PROFILER=ON to count allocations"
+                  << std::endl;
+        return 1;
+    }
+
+    auto &app = Application::getInstance();
+    app.initializeHeadless(1280.0f, 720.0f);
+
+    double now = 0.0;
+    auto renderFrames = [&app, &now](const int count) {
+        for (int i = 0; i < count; i++) {
+            app.renderFrame(now);
+            now += kFrameSeconds;
+        }
+    };
+
+    bool passed = true;
+    for (const auto &scenario : kScenarios) {
+        scenario.setup(app);
+        // The first frames lay out windows, measure text and grow ImGui's buffers
+        renderFrames(kWarmupFrames);
+
+        const AllocProfiler::Counters before = AllocProfiler::getTotals();
+        renderFrames(kMeasuredFrames);
+        const AllocProfiler::Counters after = AllocProfiler::getTotals();
+
+        const uint64_t allocations = after.allocations - before.allocations;
+        std::cout << scenario.name << ": " << allocations << " allocations, "
+                  << after.bytes - before.bytes << " bytes over " << kMeasuredFrames
+                  << " idle frames" << std::endl;
+        passed = passed && allocations == 0;
+    }
+
+    app.cleanup();
+    if (!passed) {
+        std::cerr << "Idle frames allocated on the heap" << std::endl;
+        return 1;
+    }
+    return 0;
+}
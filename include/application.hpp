@@ -18,10 +18,17 @@ typedef void *MetalLayer;
 #include <GLFW/glfw3.h>
 #endif
 #include <memory>
+#include <unordered_map>
 #include <vector>
+#include "database/query_cache.hpp"
+#include "database/schema_index.hpp"
+#include "database/schema_watcher.hpp"
 #include "ui/db_sidebar.hpp"
 #include "tabs/tab_manager.hpp"
+#include "utils/alloc_profiler.hpp"
 #include "utils/file_dialog.hpp"
+#include "utils/frame_arena.hpp"
+#include "utils/job_runner.hpp"
 
 class Application {
 public:
@@ -36,6 +43,11 @@ public:
     void run();
     void cleanup();
 
+    // UI without a window or renderer, driven by renderFrame(); used by the idle frame benchmark
+    void initializeHeadless(float width, float height);
+    // Build one frame of the UI, up to ImGui::Render(); now is in seconds
+    void renderFrame(double now);
+
     // Getters for managers and state
     TabManager *getTabManager() const {
         return tabManager.get();
@@ -46,6 +58,18 @@ public:
     FileDialog *getFileDialog() const {
         return fileDialog.get();
     }
+    // Background workers; results come back through JobRunner::post on the main thread
+    JobRunner &getJobRunner() const {
+        return *jobRunner;
+    }
+    // Scratch memory for the current frame, reset before each frame is built
+    FrameArena &getFrameArena() {
+        return frameArena;
+    }
+    // Results of editor queries that opted into caching
+    QueryCache &getQueryCache() {
+        return queryCache;
+    }
 
     // Theme management
     bool isDarkTheme() const {
@@ -83,6 +107,8 @@ public:
         return databases;
     }
     void addDatabase(const std::shared_ptr<DatabaseInterface>& db);
+    // Completion index of a connection, brought up to date with its tables
+    SchemaIndex &getSchemaIndex(const DatabaseInterface &db);
 
     // Window reference
     GLFWwindow *getWindow() const {
@@ -98,6 +124,11 @@ private:
     std::unique_ptr<TabManager> tabManager;
     std::unique_ptr<DatabaseSidebar> databaseSidebar;
     std::unique_ptr<FileDialog> fileDialog;
+    FrameArena frameArena;
+    QueryCache queryCache;
+    std::unordered_map<const DatabaseInterface *, SchemaIndex> schemaIndexes;
+    SchemaWatcher schemaWatcher;
+    std::unique_ptr<JobRunner> jobRunner;
 
 #ifdef USE_METAL_BACKEND
 // Metal-specific components (using void* for C++ compatibility)
@@ -117,6 +148,14 @@ private:
     int selectedDatabase = -1;
     int selectedTable = -1;
     bool dockingLayoutInitialized = false;
+    bool showPerformanceWindow = false;
+    double nextStatsFlush = 0.0;
+
+    // Per-frame history for the performance window, oldest first
+    static constexpr int kPerformanceHistory = 120;
+    float frameTimeHistory[kPerformanceHistory] = {};
+    float allocationHistory[kPerformanceHistory] = {};
+    AllocProfiler::Counters lastFrameAllocations;
 
     // Data
     std::vector<std::shared_ptr<DatabaseInterface>> databases;
@@ -128,4 +167,6 @@ private:
     void setupDockingLayout(ImGuiID dockSpaceId);
     void renderMainUI();
     void renderMenuBar();
+    void recordFrameStats();
+    void renderPerformanceWindow();
 };
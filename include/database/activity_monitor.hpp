@@ -0,0 +1,93 @@
+#pragma once
+
+#include "utils/ring_buffer.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pqxx {
+    class connection;
+}
+
+enum class ActivityMetric { TPS, ACTIVE_SESSIONS, WAITING_SESSIONS, LOCK_WAITS, CACHE_HIT_RATIO };
+
+// One non-idle client backend from pg_stat_activity
+struct ActivitySession {
+    int pid = 0;
+    std::string user;
+    std::string state;
+    std::string wait;
+    std::string blockedBy;
+    double durationMs = 0.0;
+    std::string query;
+};
+
+// Samples pg_stat_activity, pg_locks and pg_stat_database of a PostgreSQL server on a thread and
+// connection of its own, so a slow or stuck server never holds up the UI or the connection used
+// for queries. Each metric keeps the last kHistory samples.
+class ActivityMonitor {
+public:
+    static constexpr size_t kHistory = 300;
+    static constexpr size_t kMetricCount = 5;
+    // Caps how long one sample may keep the server busy
+    static constexpr int kStatementTimeoutMs = 5000;
+
+    ActivityMonitor(const std::string &connectionString, double intervalSeconds);
+    ~ActivityMonitor();
+
+    ActivityMonitor(const ActivityMonitor &) = delete;
+    ActivityMonitor &operator=(const ActivityMonitor &) = delete;
+
+    void setInterval(double seconds);
+    double getInterval() const;
+
+    // Copy a metric's samples oldest first into out (kHistory floats); returns the count
+    size_t copySeries(ActivityMetric metric, float *out) const;
+    float getLatest(ActivityMetric metric) const;
+    // Bumped after every completed sample
+    uint64_t getGeneration() const {
+        return generation;
+    }
+    std::vector<ActivitySession> getSessions() const;
+    // Empty while sampling works
+    std::string getError() const;
+    double getSecondsSinceSample() const;
+    double getLastSampleMs() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Counters {
+        Clock::time_point takenAt;
+        int64_t transactions = 0;
+        int64_t blocksHit = 0;
+        int64_t blocksRead = 0;
+    };
+
+    std::string connectionString;
+    std::thread worker;
+
+    mutable std::mutex stateMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    double intervalSeconds;
+    std::array<RingBuffer<float, kHistory>, kMetricCount> series;
+    std::vector<ActivitySession> sessions;
+    std::string error;
+    Clock::time_point lastSampleAt;
+    double lastSampleMs = 0.0;
+    std::atomic<uint64_t> generation{0};
+
+    // Only the pointer is guarded, so stop() can cancel a sample that is in flight
+    std::mutex connectionMutex;
+    std::unique_ptr<pqxx::connection> connection;
+
+    void run();
+    void sample(pqxx::connection &conn, Counters &previous, bool &havePrevious);
+};
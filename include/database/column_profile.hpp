@@ -0,0 +1,65 @@
+#pragma once
+
+#include "database/db_interface.hpp"
+#include "utils/job_progress.hpp"
+#include "utils/sketches.hpp"
+#include <string>
+#include <vector>
+
+using ProfileProgress = JobProgress;
+
+struct ProfileOptions {
+    // Reader threads; 0 picks one per hardware thread
+    size_t workers = 0;
+    // Below 100, only about this share of the rows is read
+    double samplePercent = 100.0;
+};
+
+struct ColumnProfile {
+    std::string name;
+    uint64_t values = 0;
+    uint64_t nulls = 0;
+    // Values that parse as numbers; min, max and the histogram are numeric when all of them do
+    uint64_t numericValues = 0;
+    bool numeric = false;
+    std::string min;
+    std::string max;
+    double mean = 0.0;
+    double distinct = 0.0;
+    std::vector<SpaceSaving::Item> topValues;
+    std::vector<float> histogram;
+
+    double nullFraction() const {
+        return values + nulls ? static_cast<double>(nulls) / static_cast<double>(values + nulls)
+                              : 0.0;
+    }
+};
+
+struct ProfileResult {
+    bool success = false;
+    std::string error;
+    uint64_t rows = 0;
+    size_t chunks = 0;
+    size_t workers = 0;
+    bool sampled = false;
+    double elapsedMs = 0.0;
+    std::vector<ColumnProfile> columns;
+};
+
+// Per-column statistics of a table in one pass. Each worker reads key-range chunks
+// (DatabaseInterface::beginParallelRead) into fixed-size sketches per column (HyperLogLog for
+// distinct values, Space-Saving for the most frequent ones, a streaming histogram), which are
+// merged at the end, so memory doesn't grow with the table. A sample reads a share of the
+// table instead: TABLESAMPLE SYSTEM on PostgreSQL, a random() filter on SQLite.
+namespace ColumnProfiler {
+    constexpr size_t kTopValues = 10;
+    // Counters kept per column to find the top values; more counters, smaller errors
+    constexpr size_t kTopCounters = 100;
+    constexpr size_t kHistogramBuckets = 32;
+    // Longer values are cut to this many bytes for min/max and the top values
+    constexpr size_t kMaxValueBytes = 256;
+    constexpr size_t kChunksPerWorker = 4;
+
+    ProfileResult profile(DatabaseInterface &db, const std::string &tableName,
+                          const ProfileOptions &options, ProfileProgress *progress = nullptr);
+} // namespace ColumnProfiler
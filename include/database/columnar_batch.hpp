@@ -0,0 +1,93 @@
+#pragma once
+
+#include "database/db_interface.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Physical encoding of a serialized column
+enum class ColumnKind : uint8_t { TEXT = 0, INT64 = 1, DOUBLE = 2 };
+
+// A group of rows stored column by column. Serialized batches can be read back in place from
+// a memory mapping. Per column the layout is:
+//   TEXT:          [null bitmap, padded to 4][uint32 offsets, rows + 1][bytes, padded to 8]
+//   INT64, DOUBLE: [null bitmap, padded to 8][8-byte values, rows]
+// Numeric encodings are only chosen when every value prints back to exactly the same text.
+class ColumnarBatchBuilder {
+public:
+    explicit ColumnarBatchBuilder(size_t columnCount);
+
+    void append(const RowValues &values);
+    void clear();
+
+    size_t getRowCount() const {
+        return rowCount;
+    }
+    // Approximate heap footprint of the buffered values
+    size_t getByteSize() const {
+        return byteSize;
+    }
+    size_t getSerializedSize() const;
+
+    bool isNull(size_t row, size_t col) const;
+    std::string_view getCell(size_t row, size_t col) const;
+
+    // Serialize all columns as TEXT, or infer a numeric encoding per column when kinds is given
+    void serialize(std::string &out, std::vector<ColumnKind> *kinds = nullptr) const;
+
+private:
+    struct ColumnData {
+        std::vector<uint8_t> nulls;
+        std::vector<uint32_t> offsets{0};
+        std::string bytes;
+    };
+
+    std::vector<ColumnData> columns;
+    size_t rowCount = 0;
+    size_t byteSize = 0;
+
+    ColumnKind inferKind(const ColumnData &column) const;
+};
+
+// Zero-copy view over a serialized batch
+class ColumnarBatchView {
+public:
+    // Enough room for any formatted INT64 or DOUBLE value
+    static constexpr size_t kScratchSize = 32;
+
+    ColumnarBatchView() = default;
+    // kinds holds one entry per column; nullptr means every column is TEXT
+    ColumnarBatchView(const char *data, size_t rowCount, size_t columnCount,
+                      const ColumnKind *kinds = nullptr);
+
+    // True if a batch with this shape fits in the size bytes at data and its text offsets are in
+    // order and in range, so a view over it never reads outside them. Reads every offset array.
+    static bool validate(const char *data, size_t size, size_t rowCount, size_t columnCount,
+                         const ColumnKind *kinds);
+
+    size_t getRowCount() const {
+        return rowCount;
+    }
+    ColumnKind getKind(size_t col) const {
+        return columns[col].kind;
+    }
+    bool isNull(size_t row, size_t col) const;
+    // TEXT columns only
+    std::string_view getCell(size_t row, size_t col) const;
+    int64_t getInt(size_t row, size_t col) const;
+    double getDouble(size_t row, size_t col) const;
+    // Text of any column; numeric values are formatted into scratch (kScratchSize bytes)
+    std::string_view getDisplayText(size_t row, size_t col, char *scratch) const;
+
+private:
+    struct ColumnView {
+        ColumnKind kind = ColumnKind::TEXT;
+        const uint8_t *nulls = nullptr;
+        const uint32_t *offsets = nullptr;
+        const char *bytes = nullptr;
+    };
+
+    std::vector<ColumnView> columns;
+    size_t rowCount = 0;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <string>
+
+// Read-only "csv" virtual table module. A CSV file is mapped into memory and parsed in place:
+//   CREATE VIRTUAL TABLE temp.sales USING csv('/data/sales.csv', header=yes)
+// Row start offsets are indexed lazily while rows are scanned, so lookups by rowid and
+// LIMIT/OFFSET paging only scan the part of the file that has not been seen yet.
+namespace CsvTable {
+    constexpr const char *kModuleName = "csv";
+
+    bool registerModule(sqlite3 *db);
+
+    bool isCsvPath(const std::string &path);
+    // File name without directory and extension as a plain identifier, used as the table name
+    std::string tableNameFor(const std::string &csvPath);
+    std::string createTableSql(const std::string &schema, const std::string &tableName,
+                               const std::string &csvPath);
+} // namespace CsvTable
@@ -12,10 +12,37 @@ struct Column {
     bool isNotNull = false;
 };
 
+enum class TableKind {
+    TABLE,
+    VIEW,
+    MATERIALIZED_VIEW,
+    PARTITIONED_TABLE,
+    PARTITION,
+    FOREIGN_TABLE
+};
+
 struct Table {
+    // Empty on backends without schemas
+    std::string schema;
     std::string name;
+    TableKind kind = TableKind::TABLE;
+    // Table a partition belongs to
+    std::string parent;
     std::vector<Column> columns;
+    // Views and partitions may be listed before their columns are fetched
+    bool columnsLoaded = true;
     bool expanded = false;
+
+    // How the table is named in the UI and in DatabaseInterface calls
+    std::string getQualifiedName() const {
+        return schema.empty() ? name : schema + "." + name;
+    }
+};
+
+// A schema of a backend that has them. Its tables are fetched when it is first expanded.
+struct Schema {
+    std::string name;
+    bool loaded = false;
 };
 
 class Database {
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "db.hpp"
+#include "query_plan.hpp"
 
 enum class DatabaseType {
     SQLITE,
@@ -22,6 +27,90 @@ struct DatabaseConnectionInfo {
     std::string password;
 };
 
+// Outcome of a single statement from a multi-statement script
+struct StatementResult {
+    std::string sql;
+    std::string output;
+    std::string error;
+    bool executed = false;
+    bool success = false;
+    double elapsedMs = 0.0;
+};
+
+// One row read from a cursor; std::nullopt marks SQL NULL. Views are only valid during the call.
+using RowValues = std::vector<std::optional<std::string_view>>;
+
+// Progress of a statement running on a worker thread. The worker bumps the counters, the UI
+// reads them and may set cancelRequested.
+struct QueryProgress {
+    // SQLite virtual machine instructions executed so far
+    std::atomic<uint64_t> steps{0};
+    // Rows read so far
+    std::atomic<uint64_t> rows{0};
+    std::atomic<bool> cancelRequested{false};
+    std::chrono::steady_clock::time_point startedAt = std::chrono::steady_clock::now();
+};
+
+// Receives rows as they are read, so results never have to be materialized in one piece
+class RowSink {
+public:
+    virtual ~RowSink() = default;
+
+    virtual void begin(const std::vector<std::string> &columnNames) = 0;
+    // Return false to stop reading
+    virtual bool row(const RowValues &values) = 0;
+    virtual void end() {}
+};
+
+// A table split into key-range chunks that can be streamed concurrently. Where the backend
+// allows it, every chunk sees the same snapshot of the data.
+class ParallelReader {
+public:
+    virtual ~ParallelReader() = default;
+
+    virtual size_t getChunkCount() const = 0;
+    // Stream one chunk. Safe to call from several threads at once; each call borrows a
+    // connection of the reader's own, never the database's main one.
+    virtual StatementResult readChunk(size_t index, RowSink &sink) = 0;
+};
+
+// Fills a newly created table inside one transaction, which is rolled back if the writer is
+// destroyed without commit(). Used from a single thread.
+class TableWriter {
+public:
+    virtual ~TableWriter() = default;
+
+    virtual bool writeRow(const RowValues &values) = 0;
+    virtual bool commit() = 0;
+
+    const std::string &getError() const {
+        return error;
+    }
+
+protected:
+    std::string error;
+};
+
+// Catalog changes since getTables() was last brought up to date. Built off the UI thread by
+// diffSchema() and applied on it by applySchemaPatch().
+struct SchemaPatch {
+    // getSchemaGeneration() when the diff was taken; the patch is stale once that moves on
+    uint64_t generation = 0;
+    // Qualified names of dropped tables
+    std::vector<std::string> removed;
+    // Added and altered tables, and the catalog signature of each at the same index
+    std::vector<Table> changed;
+    std::vector<std::string> signatures;
+    // The new schema list, when schemas were created, dropped or renamed
+    std::optional<std::vector<Schema>> schemas;
+    // Set when the catalog could not be read; such a patch is never applied
+    std::string error;
+
+    bool isEmpty() const {
+        return removed.empty() && changed.empty() && !schemas;
+    }
+};
+
 class DatabaseInterface {
 public:
     virtual ~DatabaseInterface() = default;
@@ -44,21 +133,79 @@ public:
     virtual std::vector<Table>& getTables() = 0;
     virtual bool areTablesLoaded() const = 0;
     virtual void setTablesLoaded(bool loaded) = 0;
+    // Bumped whenever getTables() changes, so anything derived from it knows when to update
+    virtual uint64_t getSchemaGeneration() const = 0;
+    // Schemas, empty on backends without them. A schema's tables only appear in getTables() once
+    // the patch of fetchSchema() is applied, which marks the schema loaded.
+    virtual const std::vector<Schema>& getSchemas() const = 0;
+    // Read the tables of a schema for applySchemaPatch(); meant for a worker
+    virtual SchemaPatch fetchSchema(const std::string& schema) = 0;
+    // Fetch the columns of a table listed without them; false if there is no such table
+    virtual bool loadTableColumns(const std::string& tableName) = 0;
+    // Read a table's columns without touching getTables(); meant for a worker
+    virtual std::vector<Column> getTableColumns(const std::string& tableName) = 0;
+    // SQL reference to a table given by its qualified name
+    virtual std::string quoteTableName(const std::string& tableName) const = 0;
+    // Cheap value that moves on whenever DDL may have changed the catalog; empty when it can't be
+    // read
+    virtual std::string getSchemaToken() = 0;
+    // Compare the catalog with getTables() and fetch the tables that changed; meant for a worker
+    virtual SchemaPatch diffSchema() = 0;
+    // Patch the changed tables into getTables(), bumping the generation if anything changed; main
+    // thread only. Returns false, changing nothing, for a failed or stale patch.
+    virtual bool applySchemaPatch(SchemaPatch patch) = 0;
 
     // Query execution
     virtual std::string executeQuery(const std::string& query) = 0;
+    virtual std::vector<StatementResult> executeScript(const std::string& script, QueryProgress* progress = nullptr) = 0;
+    virtual StatementResult streamQuery(const std::string& query, RowSink& sink, QueryProgress* progress = nullptr) = 0;
     virtual std::vector<std::vector<std::string>> getTableData(const std::string& tableName, int limit, int offset) = 0;
     virtual std::vector<std::string> getColumnNames(const std::string& tableName) = 0;
     virtual int getRowCount(const std::string& tableName) = 0;
+    // Opaque value that changes whenever data or schema visible to this connection may have
+    // changed; empty when it cannot be determined
+    virtual std::string getChangeToken() = 0;
+    // Plan of a single statement. With analyze the statement really runs (where supported)
+    // inside a transaction that is rolled back afterwards.
+    virtual QueryPlan explainQuery(const std::string& query, bool analyze) = 0;
+    // Split a table into at least minChunks ranges of its row key for reading in parallel.
+    // Returns nullptr and sets error when the table can't be read that way.
+    virtual std::unique_ptr<ParallelReader> beginParallelRead(const std::string& tableName, size_t minChunks, std::string& error) = 0;
+    // Create a table with columns given in this backend's types and open a writer to fill it.
+    // Returns nullptr and sets error if the table can't be created.
+    virtual std::unique_ptr<TableWriter> beginTableWrite(const std::string& tableName, const std::vector<Column>& columns, std::string& error) = 0;
+
+    // Background execution. Every call above may come from a worker thread and holds the
+    // connection while it runs; isBusy lets the UI thread skip work instead of waiting.
+    virtual bool isBusy() const = 0;
+    // Called from a worker every so often while a statement with this progress runs. Forwards
+    // cancellation to the server and returns the phase it reports, if any.
+    virtual std::string pollProgress(QueryProgress& progress) = 0;
+    // Request a cancel and stop the statement running with this progress right away, without
+    // waiting for the next poll; safe from any thread. Other callers' statements are left alone.
+    virtual void cancel(QueryProgress& progress) = 0;
 
     // UI state
     virtual bool isExpanded() const = 0;
     virtual void setExpanded(bool expanded) = 0;
+};
 
-protected:
-    // Helper methods to be implemented by subclasses
-    virtual std::vector<std::string> getTableNames() = 0;
-    virtual std::vector<Column> getTableColumns(const std::string& tableName) = 0;
+// One chunk holding a whole query, read on the database's own connection. Stands in for
+// beginParallelRead when a table can't be split, or when the query isn't a plain table scan.
+class SingleQueryReader : public ParallelReader {
+public:
+    SingleQueryReader(DatabaseInterface& db, std::string query) : db(db), query(std::move(query)) {}
+
+    size_t getChunkCount() const override {
+        return 1;
+    }
+    StatementResult readChunk(size_t, RowSink& sink) override {
+        return db.streamQuery(query, sink);
+    }
+
+private:
+    DatabaseInterface& db;
+    std::string query;
 };
 
 // Factory for creating database instances
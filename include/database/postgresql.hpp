@@ -1,6 +1,9 @@
 #pragma once
 
 #include "db_interface.hpp"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 #include <pqxx/pqxx>
 #ifdef PQXX_HAVE_CXA_DEMANGLE
 #undef PQXX_HAVE_CXA_DEMANGLE
@@ -31,21 +34,37 @@ public:
     std::vector<Table>& getTables() override;
     bool areTablesLoaded() const override;
     void setTablesLoaded(bool loaded) override;
+    uint64_t getSchemaGeneration() const override;
+    const std::vector<Schema>& getSchemas() const override;
+    SchemaPatch fetchSchema(const std::string& schema) override;
+    bool loadTableColumns(const std::string& tableName) override;
+    std::vector<Column> getTableColumns(const std::string& tableName) override;
+    std::string quoteTableName(const std::string& tableName) const override;
+    std::string getSchemaToken() override;
+    SchemaPatch diffSchema() override;
+    bool applySchemaPatch(SchemaPatch patch) override;
 
     // Query execution
     std::string executeQuery(const std::string& query) override;
+    std::vector<StatementResult> executeScript(const std::string& script, QueryProgress* progress = nullptr) override;
+    StatementResult streamQuery(const std::string& query, RowSink& sink, QueryProgress* progress = nullptr) override;
     std::vector<std::vector<std::string>> getTableData(const std::string& tableName, int limit, int offset) override;
     std::vector<std::string> getColumnNames(const std::string& tableName) override;
     int getRowCount(const std::string& tableName) override;
+    std::string getChangeToken() override;
+    QueryPlan explainQuery(const std::string& query, bool analyze) override;
+    std::unique_ptr<ParallelReader> beginParallelRead(const std::string& tableName, size_t minChunks, std::string& error) override;
+    std::unique_ptr<TableWriter> beginTableWrite(const std::string& tableName, const std::vector<Column>& columns, std::string& error) override;
+
+    // Background execution
+    bool isBusy() const override;
+    std::string pollProgress(QueryProgress& progress) override;
+    void cancel(QueryProgress& progress) override;
 
     // UI state
     bool isExpanded() const override;
     void setExpanded(bool expanded) override;
 
-protected:
-    std::vector<std::string> getTableNames() override;
-    std::vector<Column> getTableColumns(const std::string& tableName) override;
-
 private:
     std::string name;
     std::string host;
@@ -56,7 +75,39 @@ private:
     std::string connectionString;
     std::unique_ptr<pqxx::connection> connection;
     std::vector<Table> tables;
+    std::vector<Schema> schemas;
+    // SQL reference of every listed table by qualified name; read from worker threads
+    std::unordered_map<std::string, std::string> quotedNames;
+    // Catalog signature of every listed table by qualified name, to tell which ones DDL touched
+    std::unordered_map<std::string, std::string> signatures;
+    // Guards quotedNames, signatures and, against diffSchema(), the writes in applySchemaPatch()
+    mutable std::mutex catalogMutex;
     bool connected = false;
     bool expanded = false;
     bool tablesLoaded = false;
+    std::atomic<uint64_t> schemaGeneration{0};
+    // Held for every call that uses the connection; recursive since calls nest
+    mutable std::recursive_mutex connectionMutex;
+    std::atomic<int> backendPid{0};
+
+    // Second connection for watching and cancelling statements on the main one
+    std::mutex monitorMutex;
+    std::unique_ptr<pqxx::connection> monitorConnection;
+    bool progressViewsAvailable = true;
+    // Progress of the call running on the main connection, if it has one. cancel() holds
+    // runningMutex while it signals the backend, so the call can't end and another begin
+    // in between.
+    std::mutex runningMutex;
+    const QueryProgress* runningProgress = nullptr;
+
+    class RunningScope;
+
+    // Replace the tables of the given schemas with a fresh listing, columns included
+    void fetchSchemas(const std::vector<std::string>& names);
+    // Relations matching a condition on pg_class c and pg_namespace n, sorted by schema and name
+    std::vector<Table> fetchTables(pqxx::transaction_base& txn, const std::string& condition);
+    // Catalog signature of each relation matching the condition, by qualified name
+    std::unordered_map<std::string, std::string> readSignatures(pqxx::transaction_base& txn,
+                                                                const std::string& condition);
+    void indexTables();
 };
\ No newline at end of file
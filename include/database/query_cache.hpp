@@ -0,0 +1,67 @@
+#pragma once
+
+#include "database/result_store.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// Opt-in cache of editor results, keyed by connection and normalized SQL. Each entry remembers
+// the connection's change token (DatabaseInterface::getChangeToken) from before the query ran
+// and is only returned while the token is unchanged and the entry has not expired.
+class QueryCache {
+public:
+    static constexpr size_t kDefaultMemoryBudget = 256 * 1024 * 1024;
+    // PostgreSQL statistics counters are flushed with a delay, so entries also expire
+    static constexpr std::chrono::seconds kPostgresTtl{60};
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::shared_ptr<ResultStore> result;
+        std::string changeToken;
+        Clock::time_point storedAt;
+        Clock::time_point expiresAt; // Clock::time_point::max() when there is no TTL
+        double elapsedMs = 0.0;
+        uint64_t lastUsed = 0;
+    };
+
+    struct Stats {
+        size_t entries = 0;
+        size_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    explicit QueryCache(size_t memoryBudget = kDefaultMemoryBudget);
+
+    // Single read-only statements that do not depend on the clock or randomness
+    static bool isCacheable(const std::string &sql);
+
+    std::optional<Entry> lookup(const std::string &connectionKey, const std::string &sql,
+                                const std::string &changeToken);
+    // ttl of zero means the entry only goes stale when the change token moves
+    void store(const std::string &connectionKey, const std::string &sql,
+               const std::string &changeToken, std::shared_ptr<ResultStore> result,
+               double elapsedMs, std::chrono::seconds ttl);
+
+    // Drop every entry of a connection, e.g. after a write went through it
+    void invalidate(const std::string &connectionKey);
+    void clear();
+
+    Stats getStats() const;
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    size_t memoryBudget;
+    uint64_t useCounter = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    static std::string makeKey(const std::string &connectionKey, const std::string &sql);
+    size_t memoryUsage() const;
+    void evictOverBudget();
+};
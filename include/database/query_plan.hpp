@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// One operator of a query plan. PostgreSQL fills in costs and row estimates, plus timings and
+// buffer counts under EXPLAIN ANALYZE; SQLite only reports the operator text.
+struct PlanNode {
+    std::string label;    // e.g. "Seq Scan on orders" or "SCAN orders"
+    std::string relation; // table the node reads, if any
+    std::string detail;   // conditions and filters, shown as a tooltip
+    bool fullScan = false;
+
+    double startupCost = 0.0;
+    double totalCost = 0.0;
+    double planRows = 0.0;
+
+    // EXPLAIN ANALYZE; rows are per loop, time is inclusive of children and all loops
+    double actualRows = 0.0;
+    double actualLoops = 0.0;
+    double actualTotalMs = 0.0;
+    int64_t sharedHitBlocks = 0;
+    int64_t sharedReadBlocks = 0;
+
+    // Filled in by QueryPlanParser::annotate
+    double selfMs = 0.0;
+    double selfCost = 0.0;
+    double selfShare = 0.0; // of the whole plan's time, or of its cost when not analyzed
+    bool hot = false;
+    std::string warning;
+
+    std::vector<PlanNode> children;
+};
+
+struct QueryPlan {
+    std::string sql;
+    std::vector<PlanNode> roots;
+    bool hasCosts = false;
+    bool analyzed = false;
+    double planningMs = 0.0;
+    double executionMs = 0.0;
+    std::string error;
+};
+
+namespace QueryPlanParser {
+    // Nodes taking at least this share of the plan's time (or cost) are highlighted
+    constexpr double kHotShare = 0.2;
+    // Full scans of tables with at least this many rows are flagged
+    constexpr double kLargeTableRows = 10000.0;
+
+    // One row of SQLite's EXPLAIN QUERY PLAN
+    struct SqliteRow {
+        int id = 0;
+        int parent = 0;
+        std::string detail;
+    };
+
+    QueryPlan fromSqlite(const std::vector<SqliteRow> &rows);
+    // Output of EXPLAIN (FORMAT JSON), with or without ANALYZE and BUFFERS
+    QueryPlan fromPostgresJson(const std::string &json);
+
+    // Compute self time/cost and mark hot nodes and large full scans. tableRows returns the
+    // row count of a relation, or a negative value when it is unknown.
+    void annotate(QueryPlan &plan, const std::function<double(const std::string &)> &tableRows);
+} // namespace QueryPlanParser
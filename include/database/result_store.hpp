@@ -0,0 +1,99 @@
+#pragma once
+
+#include "database/columnar_batch.hpp"
+#include "database/db_interface.hpp"
+#include "utils/mapped_file.hpp"
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// Holds a query result of any size. Rows are kept in memory until the budget is exceeded; after
+// that, sealed batches are appended to an unlinked temporary file and mapped back for reading,
+// so browsing a huge result only costs address space and reclaimable page cache.
+class ResultStore : public RowSink {
+public:
+    static constexpr size_t kDefaultMemoryBudget = 64 * 1024 * 1024;
+
+    explicit ResultStore(size_t memoryBudget = kDefaultMemoryBudget);
+    ~ResultStore() override;
+
+    ResultStore(const ResultStore &) = delete;
+    ResultStore &operator=(const ResultStore &) = delete;
+
+    // RowSink
+    void begin(const std::vector<std::string> &columnNames) override;
+    bool row(const RowValues &values) override;
+    void end() override;
+
+    const std::vector<std::string> &getColumnNames() const {
+        return columnNames;
+    }
+    size_t getColumnCount() const {
+        return columnNames.size();
+    }
+    size_t getRowCount() const {
+        return rowCount;
+    }
+
+    bool isNull(size_t row, size_t col) const;
+    std::string_view getCell(size_t row, size_t col) const;
+
+    // Memory accounting
+    size_t getMemoryUsage() const {
+        return residentBytes;
+    }
+    size_t getSpilledBytes() const {
+        return spillSize;
+    }
+    bool isSpilled() const {
+        return spillSize > 0;
+    }
+
+    // Feed the stored rows to another sink, e.g. to save them without re-running the query.
+    // May run on a worker while the UI thread reads cells; spill() and clear() wait for it.
+    void replay(RowSink &sink) const;
+
+    // Move every resident batch to disk, releasing its memory
+    bool spill();
+    // spill() for the UI thread: while a replay runs, nothing is done and busy is set
+    bool trySpill(bool &busy);
+    void clear();
+
+private:
+    static constexpr size_t kBatchRows = 4096;
+    static constexpr size_t kMaxBatchBytes = 8 * 1024 * 1024;
+
+    struct Batch {
+        size_t firstRow = 0;
+        size_t rowCount = 0;
+        std::unique_ptr<ColumnarBatchBuilder> resident;
+        size_t fileOffset = 0;
+        ColumnarBatchView view;
+    };
+
+    size_t memoryBudget;
+    std::vector<std::string> columnNames;
+    std::vector<Batch> batches;
+    size_t rowCount = 0;
+    size_t residentBytes = 0;
+    bool batchOpen = false;
+
+    // Spill file, unlinked as soon as it is created so it vanishes with the descriptor
+    int spillFd = -1;
+    size_t spillSize = 0;
+    MappedFile mapping;
+
+    // Last batch looked up, since the grid reads rows in order
+    mutable std::atomic<size_t> lastBatch{0};
+    // Held shared by replay(), exclusively while batches are remapped or dropped
+    mutable std::shared_mutex accessMutex;
+
+    const Batch &findBatch(size_t row) const;
+    void sealBatch();
+    bool spillLocked();
+    // Append a resident batch to the spill file; it stays resident until remap()
+    bool writeBatch(Batch &batch);
+    bool remap(const std::vector<Batch *> &written);
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "database/db_interface.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Row-level comparison of two runs of the same query. Rows are compared by a 64-bit hash of
+// their cells regardless of position, so rows that only moved do not count as changed.
+namespace RowDiff {
+    uint64_t hashRow(const RowValues &values);
+    uint64_t hashRow(const std::vector<std::string> &cells);
+
+    struct Result {
+        // One flag per row of the new result; 1 when the row is new or modified
+        std::vector<uint8_t> changed;
+        size_t changedCount = 0;
+        // Rows of the previous result with no identical row left (removed or modified)
+        size_t removedCount = 0;
+
+        bool isIdentical() const {
+            return changedCount == 0 && removedCount == 0;
+        }
+    };
+
+    Result compare(const std::vector<uint64_t> &previous, const std::vector<uint64_t> &current);
+
+    // Hashes rows on their way to another sink (or on their own when target is null)
+    class HashingSink : public RowSink {
+    public:
+        explicit HashingSink(RowSink *target = nullptr) : target(target) {}
+
+        void begin(const std::vector<std::string> &columnNames) override;
+        bool row(const RowValues &values) override;
+        void end() override;
+
+        std::vector<uint64_t> &getHashes() {
+            return hashes;
+        }
+
+    private:
+        RowSink *target;
+        std::vector<uint64_t> hashes;
+    };
+} // namespace RowDiff
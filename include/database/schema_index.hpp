@@ -0,0 +1,86 @@
+#pragma once
+
+#include "database/db_interface.hpp"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Table and column names of one connection, for completion in the SQL editor. Names live in
+// ordered maps keyed by their lower-cased form, so a prefix lookup is one binary search plus the
+// matches it returns. update() only re-indexes the tables whose definition changed.
+class SchemaIndex {
+public:
+    enum class MatchKind { TABLE, COLUMN, KEYWORD };
+
+    struct Match {
+        std::string name;
+        // Column type, a table's schema and column count, or how many tables have a column
+        // of this name
+        std::string detail;
+        MatchKind kind = MatchKind::KEYWORD;
+    };
+
+    // What to offer at the cursor, and which part of the text an accepted match replaces
+    struct Completion {
+        size_t wordStart = 0;
+        std::vector<Match> matches;
+    };
+
+    // Cheap when the connection's schema generation has not moved since the last call
+    void update(const DatabaseInterface &db);
+
+    // Names starting with prefix, case-insensitively, at most limit of them
+    void findTables(std::string_view prefix, size_t limit, std::vector<Match> &out) const;
+    // Columns of one table; false when the table is not known
+    bool findColumns(std::string_view table, std::string_view prefix, size_t limit,
+                     std::vector<Match> &out) const;
+    // Distinct column names across every table
+    void findAnyColumn(std::string_view prefix, size_t limit, std::vector<Match> &out) const;
+
+    // Completion for the statement around the cursor: tables after FROM, JOIN and the like,
+    // columns of the right table after "alias.", otherwise columns of the tables the statement
+    // reads followed by keywords
+    Completion complete(std::string_view text, size_t cursor, size_t limit) const;
+
+    size_t getTableCount() const {
+        return tables.size();
+    }
+    size_t getColumnCount() const {
+        return columnCount;
+    }
+
+private:
+    struct IndexedColumn {
+        std::string key;
+        std::string name;
+        std::string type;
+    };
+
+    struct IndexedTable {
+        std::string name;
+        std::string schema;
+        uint64_t signature = 0;
+        // Sorted by key
+        std::vector<IndexedColumn> columns;
+    };
+
+    struct ColumnName {
+        std::string name;
+        size_t tableCount = 0;
+    };
+
+    // Keyed by lower-cased name, the name itself and the schema, so tables differing only in case
+    // or schema coexist
+    std::map<std::string, IndexedTable, std::less<>> tables;
+    std::map<std::string, ColumnName, std::less<>> columnNames;
+    size_t columnCount = 0;
+    uint64_t generation = 0;
+    bool indexed = false;
+
+    void addTable(std::string key, const Table &table, uint64_t signature);
+    void removeTable(std::map<std::string, IndexedTable, std::less<>>::iterator it);
+    const IndexedTable *lookupTable(std::string_view name) const;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "database/db_interface.hpp"
+#include "utils/job_runner.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Keeps the table lists of open connections in step with DDL run anywhere. Every few seconds a
+// worker reads each idle connection's schema token; when it moved, the catalog is diffed on the
+// worker and only the changed tables are patched in on the main thread. The sidebar, the
+// completion index and open table tabs follow getSchemaGeneration(), so they pick the change up
+// without a full refreshTables().
+class SchemaWatcher {
+public:
+    static constexpr double kPollIntervalSeconds = 3.0;
+
+    // Runs on the main thread after a patch changed a connection's tables
+    void setOnPatched(std::function<void(const DatabaseInterface &)> callback) {
+        onPatched = std::move(callback);
+    }
+
+    // Main thread, once per frame; now is in seconds
+    void update(const std::vector<std::shared_ptr<DatabaseInterface>> &databases, JobRunner &jobs,
+                double now);
+
+private:
+    struct WatchState {
+        // Token the tables were last brought up to date with; empty until the first poll
+        std::string token;
+        double nextPoll = 0.0;
+        bool polling = false;
+    };
+
+    // Shared with the jobs in flight, which may outlive a closed connection's entry
+    std::unordered_map<const DatabaseInterface *, std::shared_ptr<WatchState>> states;
+    std::function<void(const DatabaseInterface &)> onPatched;
+
+    void poll(const std::shared_ptr<DatabaseInterface> &db,
+              const std::shared_ptr<WatchState> &state, JobRunner &jobs);
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "database/columnar_batch.hpp"
+#include "database/db_interface.hpp"
+#include "utils/job_progress.hpp"
+#include "utils/mapped_file.hpp"
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// On-disk result snapshot. Everything is little-endian and 8-byte aligned so a mapped file can
+// be read in place:
+//   [SnapshotHeader][batch 0][batch 1]...[footer]
+//   footer = [SnapshotBatchEntry x batchCount][ColumnKind x batchCount x columnCount, padded]
+//            [per column: uint32 name length + name bytes]
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t columnCount;
+    uint64_t rowCount;
+    uint64_t batchCount;
+    uint64_t footerOffset;
+    uint64_t reserved[3];
+};
+
+struct SnapshotBatchEntry {
+    uint64_t offset;
+    uint64_t rowCount;
+};
+
+// Writes a snapshot while rows stream in from a cursor; memory is bounded by one batch
+class SnapshotWriter : public RowSink {
+public:
+    // With progress, rows are counted there and a cancel request stops the write with an error
+    explicit SnapshotWriter(const std::string &path, JobProgress *progress = nullptr);
+
+    // RowSink
+    void begin(const std::vector<std::string> &columnNames) override;
+    bool row(const RowValues &values) override;
+    void end() override;
+
+    bool isOk() const {
+        return error.empty();
+    }
+    const std::string &getError() const {
+        return error;
+    }
+    uint64_t getRowCount() const {
+        return rowCount;
+    }
+
+private:
+    static constexpr size_t kBatchRows = 65536;
+
+    std::string path;
+    JobProgress *progress;
+    std::ofstream file;
+    std::vector<std::string> columnNames;
+    std::unique_ptr<ColumnarBatchBuilder> batch;
+    std::vector<SnapshotBatchEntry> entries;
+    std::vector<ColumnKind> kinds;
+    uint64_t rowCount = 0;
+    uint64_t offset = 0;
+    std::string error;
+
+    void flushBatch();
+    void write(const std::string &bytes);
+};
+
+// A snapshot being written on a worker. The UI reads progress and may cancel; the rest is set
+// on the main thread when the job posts back.
+struct SnapshotSave {
+    std::string sourceName;
+    std::string path;
+    JobProgress progress;
+    bool finished = false;
+    std::string error;
+    uint64_t rows = 0;
+};
+
+// Read-only snapshot opened by mapping the file. Only the footer and the batches' offset arrays
+// are read on open, to check that no cell lies outside the file.
+class Snapshot {
+public:
+    bool open(const std::string &path, std::string &error);
+
+    const std::string &getPath() const {
+        return path;
+    }
+    const std::vector<std::string> &getColumnNames() const {
+        return columnNames;
+    }
+    size_t getColumnCount() const {
+        return columnNames.size();
+    }
+    uint64_t getRowCount() const {
+        return rowCount;
+    }
+    size_t getFileSize() const {
+        return mapping.size();
+    }
+
+    bool isNull(uint64_t row, size_t col) const;
+    // Numeric cells are formatted into scratch (ColumnarBatchView::kScratchSize bytes)
+    std::string_view getDisplayText(uint64_t row, size_t col, char *scratch) const;
+
+private:
+    std::string path;
+    MappedFile mapping;
+    std::vector<std::string> columnNames;
+    std::vector<uint64_t> firstRows;
+    std::vector<ColumnarBatchView> batches;
+    uint64_t rowCount = 0;
+    mutable size_t lastBatch = 0;
+
+    size_t findBatch(uint64_t row) const;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace SqlScript {
+    // Split a script into individual statements. Quotes, comments, dollar-quoted bodies and
+    // trigger BEGIN ... END blocks are honoured so that embedded semicolons don't split.
+    std::vector<std::string> splitStatements(const std::string &script);
+
+    // Strip leading and trailing whitespace
+    std::string trim(const std::string &text);
+
+    // Double-quoted identifier with embedded quotes doubled; valid in SQLite and PostgreSQL
+    std::string quoteIdentifier(const std::string &name);
+
+    // Upper-cased first keyword of a statement, skipping leading whitespace and comments
+    std::string firstKeyword(const std::string &statement);
+
+    // True if any statement begins, commits or rolls back a transaction itself
+    bool managesTransactions(const std::vector<std::string> &statements);
+
+    // Canonical text of a statement: comments removed, whitespace kept only between words,
+    // text outside quotes lower-cased and trailing semicolons dropped. Used as a cache key.
+    std::string normalize(const std::string &statement);
+
+    // Normalized statement with every literal replaced by '?', so statements that differ only in
+    // their constants share one fingerprint. Lists of literals collapse to "(...)" whatever their
+    // length, and so do repeated VALUES rows.
+    std::string fingerprint(const std::string &statement);
+
+    // Upper-cased words outside quotes and comments, in order
+    std::vector<std::string> words(const std::string &statement);
+
+    // True for statements that cannot modify data or schema (SELECT, VALUES, SHOW, ...).
+    // Anything unrecognised counts as a write.
+    bool isReadOnly(const std::string &statement);
+} // namespace SqlScript
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "db_interface.hpp"
+#include "sqlite_profile.hpp"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <sqlite3.h>
 
 class SQLiteDatabase : public DatabaseInterface {
@@ -26,27 +31,103 @@ public:
     std::vector<Table>& getTables() override;
     bool areTablesLoaded() const override;
     void setTablesLoaded(bool loaded) override;
+    uint64_t getSchemaGeneration() const override;
+    const std::vector<Schema>& getSchemas() const override;
+    SchemaPatch fetchSchema(const std::string& schema) override;
+    bool loadTableColumns(const std::string& tableName) override;
+    std::vector<Column> getTableColumns(const std::string& tableName) override;
+    std::string quoteTableName(const std::string& tableName) const override;
+    std::string getSchemaToken() override;
+    SchemaPatch diffSchema() override;
+    bool applySchemaPatch(SchemaPatch patch) override;
 
     // Query execution
     std::string executeQuery(const std::string& query) override;
+    std::vector<StatementResult> executeScript(const std::string& script, QueryProgress* progress = nullptr) override;
+    StatementResult streamQuery(const std::string& query, RowSink& sink, QueryProgress* progress = nullptr) override;
     std::vector<std::vector<std::string>> getTableData(const std::string& tableName, int limit, int offset) override;
     std::vector<std::string> getColumnNames(const std::string& tableName) override;
     int getRowCount(const std::string& tableName) override;
+    std::string getChangeToken() override;
+    QueryPlan explainQuery(const std::string& query, bool analyze) override;
+    std::unique_ptr<ParallelReader> beginParallelRead(const std::string& tableName, size_t minChunks, std::string& error) override;
+    std::unique_ptr<TableWriter> beginTableWrite(const std::string& tableName, const std::vector<Column>& columns, std::string& error) override;
+
+    // Background execution
+    bool isBusy() const override;
+    std::string pollProgress(QueryProgress& progress) override;
+    void cancel(QueryProgress& progress) override;
+
+    // Expose a CSV file as a read-only virtual table for the lifetime of the connection
+    bool attachCsv(const std::string& csvPath);
+
+    // How the file is opened, the saved profile for it to start with. A new profile takes effect
+    // on the next connect().
+    const SqliteProfile& getProfile() const;
+    void setProfile(const SqliteProfile& profile);
 
     // UI state
     bool isExpanded() const override;
     void setExpanded(bool expanded) override;
 
-protected:
-    std::vector<std::string> getTableNames() override;
-    std::vector<Column> getTableColumns(const std::string& tableName) override;
-
 private:
     std::string name;
     std::string path;
     sqlite3* connection = nullptr;
+    SqliteProfile profile;
     std::vector<Table> tables;
     bool connected = false;
     bool expanded = false;
     bool tablesLoaded = false;
+    std::atomic<uint64_t> schemaGeneration{0};
+    std::vector<std::string> attachedCsvFiles;
+    // Held for every call that uses the connection; recursive since calls nest
+    mutable std::recursive_mutex connectionMutex;
+    // Read-only connections that reads are spread over, so a long query never holds up browsing;
+    // every write stays on the main connection. Only used in WAL mode or for a read-only file,
+    // where readers don't stall the writer.
+    static constexpr size_t kMaxReaders = 4;
+    std::mutex readerMutex;
+    std::vector<sqlite3*> idleReaders;
+    size_t openReaders = 0;
+    bool readersEnabled = false;
+    SqliteProfile readerProfile;
+    // Set while the main connection has a transaction open, whose changes only it can see
+    std::atomic<bool> writerInTransaction{false};
+    // Lower-cased names in the main connection's temp schema, which readers don't have; a reader
+    // would take such a name for the main table it shadows. Guarded by readerMutex.
+    std::unordered_set<std::string> tempNames;
+    // Connection each statement with a progress is running on, so cancel() can interrupt it
+    std::mutex runningMutex;
+    std::unordered_map<const QueryProgress*, sqlite3*> runningStatements;
+    // CREATE statement of every listed table by name, to tell which ones DDL touched
+    std::unordered_map<std::string, std::string> signatures;
+    std::mutex signaturesMutex;
+
+    // A table or view as sqlite_master lists it
+    struct Definition {
+        std::string name;
+        std::string sql;
+        bool isView = false;
+    };
+
+    class PooledStatement;
+    class ProgressScope;
+
+    bool createCsvTable(const std::string& schema, const std::string& csvPath);
+    // An idle or new reader, or nullptr when reads have to use the main connection
+    sqlite3* acquireReader();
+    void releaseReader(sqlite3* reader);
+    void closeReaders();
+    // Prepare a statement on a reader; false, with stmt finalized, unless it only reads and
+    // sees the same tables and connection state there as on the main connection
+    bool prepareOnReader(sqlite3* reader, const std::string& sql, sqlite3_stmt*& stmt);
+    // Note what only the main connection can see after it ran something; connection held
+    void updateWriterState();
+    // Run a script statement by statement on one connection
+    std::vector<StatementResult> runScript(sqlite3* db, const std::string& script,
+                                           QueryProgress* progress);
+    // Tables and views of the main and temp schemas, by name, with temp ones shadowing main ones;
+    // false if the read failed
+    bool readDefinitions(std::vector<Definition>& definitions);
 };
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// How a SQLite file is opened and tuned, chosen per file in the connection dialog. Profiles are
+// remembered in sqlite_profiles.json in the data directory.
+struct SqliteProfile {
+    // Open with mode=ro, so nothing can be written through the connection
+    bool readOnly = false;
+    // Open with immutable=1: no locks are taken and the file is never checked for changes, which
+    // is only right for files nothing else writes to. Implies readOnly.
+    bool immutable = false;
+    // Bytes of the file read through a memory map rather than copied into the page cache; SQLite
+    // caps it at its compile-time SQLITE_MAX_MMAP_SIZE
+    int64_t mmapSize = 0;
+    // Page cache per connection, in KiB
+    int cacheSizeKb = 2000;
+    // Switch the file to write-ahead logging so readers and the writer don't block each other.
+    // The journal mode is stored in the file and outlives the profile.
+    bool wal = false;
+    // Keep temporary tables and sort spills in memory
+    bool tempStoreMemory = false;
+    // Open with SQLITE_OPEN_NOMUTEX. Every connection here is used by one thread at a time, the
+    // main one under its connection mutex, so SQLite's own locking is redundant.
+    bool noMutex = true;
+
+    bool isReadOnly() const {
+        return readOnly || immutable;
+    }
+
+    // Profile for a file without a saved one: a file that can't be written is opened read-only
+    // and memory mapped whole
+    static SqliteProfile defaultsFor(const std::string &path);
+    // Saved profile of a file, or defaultsFor(path)
+    static SqliteProfile load(const std::string &path);
+    // Remember the profile of a file; false if it could not be written
+    static bool save(const std::string &path, const SqliteProfile &profile);
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Client-side statement statistics in the spirit of pg_stat_statements. Every statement the
+// backends run is fingerprinted with SqlScript::fingerprint and aggregated per connection name;
+// the totals are kept in a small SQLite file so they survive restarts.
+namespace StatementStats {
+    // Latency histogram with four buckets per doubling, from 1 us up to about an hour
+    constexpr size_t kHistogramBuckets = 128;
+    // Past this many fingerprints the least-called one is dropped to make room
+    constexpr size_t kMaxEntries = 5000;
+    constexpr double kFlushIntervalSeconds = 10.0;
+
+    struct Entry {
+        std::string database;
+        std::string fingerprint;
+        uint64_t calls = 0;
+        double totalMs = 0.0;
+        double minMs = 0.0;
+        double maxMs = 0.0;
+        uint64_t rows = 0;
+        int64_t lastSeen = 0; // Unix time
+        std::array<uint32_t, kHistogramBuckets> histogram{};
+
+        double meanMs() const {
+            return calls ? totalMs / static_cast<double>(calls) : 0.0;
+        }
+        // Estimated from the histogram, so within about 10% of the true value
+        double percentileMs(double fraction) const;
+    };
+
+    // Load the totals stored at path and keep writing them there. Without a store the numbers
+    // are only kept for the session.
+    bool open(const std::string &path);
+    // Record one successful execution; called from the backends on any thread
+    void record(const std::string &database, const std::string &sql, double elapsedMs,
+                uint64_t rows);
+    std::vector<Entry> snapshot();
+    // Changes on every record, so a view can tell when its copy is stale
+    uint64_t getGeneration();
+    // Write entries changed since the last flush to the store
+    void flush();
+    // Forget everything, including what is in the store
+    void reset();
+} // namespace StatementStats
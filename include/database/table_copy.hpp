@@ -0,0 +1,35 @@
+#pragma once
+
+#include "database/db_interface.hpp"
+#include "utils/job_progress.hpp"
+#include <atomic>
+#include <string>
+
+// rows counts rows read from the source
+struct CopyProgress : JobProgress {
+    std::atomic<uint64_t> rowsWritten{0};
+};
+
+struct CopyResult {
+    bool success = false;
+    std::string error;
+    uint64_t rows = 0;
+    double elapsedMs = 0.0;
+};
+
+// Copies a table into another database, SQLite and PostgreSQL in either direction. Reading the
+// source cursor, converting values and writing (COPY on PostgreSQL, a prepared INSERT on SQLite)
+// run on three threads joined by bounded queues, so at most kQueueBatches batches are in flight
+// between two stages. The target table is created and filled in one transaction; a failed or
+// cancelled copy leaves nothing behind.
+namespace TableCopy {
+    constexpr size_t kBatchRows = 4096;
+    constexpr size_t kQueueBatches = 8;
+
+    // Column type in the target backend for a type reported by the source backend
+    std::string mapType(const std::string &type, DatabaseType from, DatabaseType to);
+
+    // The target table gets the source table's name; table.columns must be loaded
+    CopyResult copyTable(DatabaseInterface &source, const Table &table, DatabaseInterface &target,
+                         CopyProgress *progress = nullptr);
+} // namespace TableCopy
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "database/db_interface.hpp"
+#include "utils/job_progress.hpp"
+#include <atomic>
+#include <optional>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+// rows counts rows fetched from both sides to compare them
+struct TableDiffProgress : JobProgress {
+    std::atomic<uint64_t> rangesHashed{0};
+    std::atomic<uint64_t> differences{0};
+};
+
+struct TableDiffRow {
+    enum class Kind { ONLY_LEFT, ONLY_RIGHT, CHANGED };
+
+    Kind kind = Kind::CHANGED;
+    int64_t key = 0;
+    // Cells as compared (blobs as hex, booleans as 0/1), in TableDiffResult::columns order;
+    // empty on the side the row is missing from
+    std::vector<std::optional<std::string>> left;
+    std::vector<std::optional<std::string>> right;
+};
+
+struct TableDiffResult {
+    bool success = false;
+    std::string error;
+    // Compared columns, key first; columns only one side has are listed in skippedColumns
+    std::vector<std::string> columns;
+    std::vector<std::string> skippedColumns;
+    uint64_t leftRows = 0;
+    uint64_t rightRows = 0;
+    std::vector<TableDiffRow> rows;
+    // Stopped after kMaxDifferences rows
+    bool truncated = false;
+    uint64_t rangesHashed = 0;
+    uint64_t rowsFetched = 0;
+    double elapsedMs = 0.0;
+};
+
+// Compares two tables, in the same or different databases (SQLite or PostgreSQL), keyed by an
+// integer primary key. Each side hashes its rows inside the database and sums the hashes per
+// key range, so a range is one (count, hash) pair on the wire. Ranges whose pairs differ are
+// split kFanout ways until they hold at most kLeafRows rows, and only those are fetched and
+// compared row by row; traffic and memory grow with the difference, not the table.
+//
+// Values are compared in a text form both backends can produce (blobs as hex, booleans as
+// 0/1, whole floats without a fraction), so representation differences that survive that, such
+// as numeric scale, show up as changed rows.
+namespace TableDiff {
+    constexpr size_t kFanout = 16;
+    constexpr uint64_t kLeafRows = 1000;
+    constexpr size_t kMaxDifferences = 10000;
+
+    // Aggregate used on SQLite connections: the sum, modulo 2^64, of the first 64 bits of the
+    // md5 of each value, matching what the PostgreSQL side computes with md5()
+    constexpr const char *kSqliteHashFunction = "dearsql_hash_sum";
+
+    bool registerFunctions(sqlite3 *db);
+
+    // Both tables' columns must be loaded; the key is the left table's primary key
+    TableDiffResult compare(DatabaseInterface &left, const Table &leftTable,
+                            DatabaseInterface &right, const Table &rightTable,
+                            TableDiffProgress *progress = nullptr);
+} // namespace TableDiff
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "database/db_interface.hpp"
+#include "utils/job_progress.hpp"
+#include <string>
+#include <vector>
+
+using ExportProgress = JobProgress;
+
+struct ExportOptions {
+    // Reader threads; 0 picks one per hardware thread
+    size_t workers = 0;
+    // One file per chunk (name.part0001.csv, ...) instead of a single file
+    bool partitioned = false;
+};
+
+struct ExportResult {
+    bool success = false;
+    std::string error;
+    uint64_t rows = 0;
+    size_t chunks = 0;
+    size_t workers = 0;
+    double elapsedMs = 0.0;
+    std::vector<std::string> files;
+};
+
+// Table to CSV export. The table is split into key ranges (DatabaseInterface::beginParallelRead)
+// that worker threads read and format concurrently, each on a connection of its own. A single
+// output file is assembled strictly in chunk order by a writer thread; workers that get ahead
+// of it wait once kMaxBufferedBytes are queued, so memory stays bounded.
+namespace TableExport {
+    constexpr size_t kMaxBufferedBytes = 256 * 1024 * 1024;
+    // Formatted output is handed over in blocks of about this size
+    constexpr size_t kBlockBytes = 1024 * 1024;
+    // Chunks per worker, so a slow chunk doesn't leave the other workers idle at the end
+    constexpr size_t kChunksPerWorker = 4;
+
+    ExportResult exportCsv(DatabaseInterface &db, const std::string &tableName,
+                           const std::string &path, const ExportOptions &options,
+                           ExportProgress *progress = nullptr);
+
+    // Path of one partition: /data/orders.csv -> /data/orders.part0003.csv
+    std::string partitionPath(const std::string &path, size_t index);
+} // namespace TableExport
@@ -1,10 +1,31 @@
 #pragma once
 
+#include "database/activity_monitor.hpp"
+#include "database/column_profile.hpp"
+#include "database/db_interface.hpp"
+#include "database/query_plan.hpp"
+#include "database/result_store.hpp"
+#include "database/schema_index.hpp"
+#include "database/snapshot.hpp"
+#include "database/statement_stats.hpp"
+#include "database/table_diff.hpp"
+#include "ui/chart_data.hpp"
+#include "ui/grid_layout.hpp"
+#include "ui/sql_highlighter.hpp"
+#include <chrono>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
-enum class TabType { SQL_EDITOR, TABLE_VIEWER };
+struct ImGuiInputTextCallbackData;
+
+enum class TabType { SQL_EDITOR, TABLE_VIEWER, SNAPSHOT, QUERY_PLAN, STATEMENT_STATS,
+                     ACTIVITY_DASHBOARD, TABLE_DIFF, COLUMN_PROFILE, CHART };
+
+// What re-runs a watched tab: a fixed interval, or a change of the connection's change token
+// (SQLite data_version, PostgreSQL row counters), which is polled cheaply
+enum class WatchTrigger { INTERVAL, DATA_CHANGE };
 
 class Tab {
 public:
@@ -37,16 +58,74 @@ public:
     // Virtual method for rendering tab content
     virtual void render() = 0;
 
+    // Memory held by the tab's data, used to decide which background tabs to hibernate
+    virtual size_t getMemoryUsage() const {
+        return 0;
+    }
+    bool isHibernated() const {
+        return hibernated;
+    }
+    int getLastActiveFrame() const {
+        return lastActiveFrame;
+    }
+    // Called every frame the tab is visible; restores it first if it was hibernated
+    void activate(int frame);
+    // Drop data that can be reloaded, keeping only what is needed to restore the tab
+    void hibernate();
+
+    // Auto-refresh; called every frame for every tab, visible or not
+    void updateWatch(double now, bool visible);
+    bool isWatching() const {
+        return watchEnabled;
+    }
+
 protected:
     std::string name;
     TabType type;
     bool open = true;
     bool needsFocus = false;
+    bool hibernated = false;
+    int lastActiveFrame = 0;
+
+    // False if the data can't be released right now; the tab then stays awake and is
+    // hibernated on a later try
+    virtual bool releaseData() {
+        return true;
+    }
+    virtual void restoreData() {}
+
+    // Watch mode; tabs that support it re-run their query in watchRefresh
+    static constexpr double kDataChangePollSeconds = 0.5;
+    // Hidden tabs double their interval on every run, up to this factor
+    static constexpr double kMaxWatchBackoff = 16.0;
+
+    bool watchEnabled = false;
+    WatchTrigger watchTrigger = WatchTrigger::INTERVAL;
+    float watchIntervalSeconds = 5.0f;
+    double nextWatchRun = 0.0;
+    double watchBackoff = 1.0;
+    std::string watchToken;
+    std::string watchStatus;
+
+    void renderWatchControls();
+    // Database the tab reads from, if any
+    virtual std::shared_ptr<DatabaseInterface> getDatabase() const {
+        return nullptr;
+    }
+    // Database watch mode polls; tabs that pin what they watch return that one
+    virtual std::shared_ptr<DatabaseInterface> getWatchDatabase() const {
+        return getDatabase();
+    }
+    // Called when the user turns watch mode on or off
+    virtual void onWatchEnabled() {}
+    virtual void onWatchDisabled() {}
+    virtual void watchRefresh() {}
 };
 
 class SQLEditorTab : public Tab {
 public:
     SQLEditorTab(const std::string &name);
+    ~SQLEditorTab() override;
 
     void render() override;
 
@@ -54,9 +133,7 @@ public:
     const std::string &getQuery() const {
         return sqlQuery;
     }
-    void setQuery(const std::string &query) {
-        sqlQuery = query;
-    }
+    void setQuery(const std::string &query);
     const std::string &getResult() const {
         return queryResult;
     }
@@ -64,17 +141,94 @@ public:
         queryResult = result;
     }
 
+    size_t getMemoryUsage() const override;
+
+protected:
+    bool releaseData() override;
+
 private:
     std::string sqlQuery;
     std::string queryResult;
-    char sqlBuffer[4096] = "";
     char resultBuffer[16384] = "";
+
+    // Per-statement results when a multi-statement script was executed
+    std::vector<StatementResult> scriptResults;
+    int selectedStatement = -1;
+
+    // Full result of a single row-returning statement; spills to disk past its budget. Shared
+    // with the query cache when caching is enabled.
+    std::shared_ptr<ResultStore> resultStore;
+    double resultElapsedMs = 0.0;
+
+    // Opt-in result caching; resultCachedAt is when a result served from cache was stored
+    bool useCache = false;
+    bool resultFromCache = false;
+    std::chrono::steady_clock::time_point resultCachedAt;
+
+    // Row hashes of resultStore, kept only while watching, and the rows that changed in the
+    // last watch refresh
+    std::vector<uint64_t> resultHashes;
+    std::vector<uint8_t> changedRows;
+    // Statement and connection that produced resultStore
+    std::string resultSql;
+    std::weak_ptr<DatabaseInterface> resultDb;
+    // What watch mode re-runs, pinned when it is turned on and moved to each new result, so
+    // edits in the editor or another selected connection never change what is diffed
+    std::string watchSql;
+    std::weak_ptr<DatabaseInterface> watchDb;
+
+    // Completion of the word at the cursor, recomputed when the text or the cursor moves
+    static constexpr size_t kMaxCompletions = 12;
+    SchemaIndex::Completion completion;
+    int completionSelected = 0;
+    int completionCursor = -1;
+
+    // Line states of sqlQuery for highlighting, and where the caret was in the last frame
+    SqlHighlighter highlighter;
+    std::vector<SqlHighlighter::Token> lineTokens;
+    int editorCursor = 0;
+
+    // Statement or script running on a worker; null while idle
+    struct QueryRun;
+    std::shared_ptr<QueryRun> activeRun;
+    static constexpr double kProgressPollSeconds = 0.5;
+
+    std::shared_ptr<DatabaseInterface> getDatabase() const override;
+    std::shared_ptr<DatabaseInterface> getWatchDatabase() const override {
+        return watchDb.lock();
+    }
+    void onWatchEnabled() override;
+    void onWatchDisabled() override;
+    void watchRefresh() override;
+
+    void runQuery();
+    // Plan of the current statement, opened in a QueryPlanTab
+    void explain(bool analyze);
+    void startRun(bool watchRun);
+    // Runs on a worker thread
+    static void executeRun(QueryRun &run);
+    void finishRun(QueryRun &run);
+    void clearResults();
+    void renderProgress();
+    void saveSnapshot();
+    // Snapshot of resultStore being written on a worker, or the last one that failed
+    std::shared_ptr<SnapshotSave> snapshotSave;
+    void renderScriptResults();
+    void renderResultGrid();
+    void showStatementResult(int index);
+    void setResultText(const std::string &text);
+    static int editorCallback(ImGuiInputTextCallbackData *data);
+    void updateCompletion(std::string_view text, int cursor);
+    void acceptCompletion(ImGuiInputTextCallbackData &data);
+    void renderCompletion();
+    void renderHighlighting(bool active);
 };
 
 class TableViewerTab : public Tab {
 public:
     TableViewerTab(const std::string &name, const std::string &databasePath,
                    const std::string &tableName);
+    ~TableViewerTab() override;
 
     void render() override;
 
@@ -94,6 +248,14 @@ public:
     void saveChanges();
     void cancelChanges();
 
+    size_t getMemoryUsage() const override {
+        return dataBytes;
+    }
+
+protected:
+    bool releaseData() override;
+    void restoreData() override;
+
 private:
     std::string databasePath;
     std::string tableName;
@@ -111,9 +273,228 @@ private:
     int selectedCol = -1;
     char editBuffer[1024] = "";
     bool hasChanges = false;
-    
+
+    // Column widths and truncated cell text of the current page
+    std::shared_ptr<GridLayoutCache> gridLayout = std::make_shared<GridLayoutCache>();
+
+    // Approximate size of tableData, originalData and columnNames
+    size_t dataBytes = 0;
+    // Unsaved edits kept across hibernation: row key -> (column name -> value). A row is keyed
+    // by its primary key, or by all of its original values when the table has none, so an edit
+    // finds its row wherever a re-read puts it. Entries whose row isn't on the page stay here.
+    std::map<std::vector<std::string>, std::map<std::string, std::string>> editJournal;
+    // Columns the journal's row keys are made of; empty means every column
+    std::vector<std::string> journalKeyColumns;
+    // Rows of the current page that changed in the last watch refresh
+    std::vector<uint8_t> changedRows;
+    // Schema generation of the connection when the columns were last checked
+    uint64_t schemaGeneration = 0;
+
+    // Page read on a worker, so a statement holding the connection never stalls the UI
+    struct PageLoad;
+    std::shared_ptr<PageLoad> pageLoad;
+
+    std::shared_ptr<DatabaseInterface> getDatabase() const override;
+    void watchRefresh() override;
+    // Reload the page when the table's columns changed in the connection's table list
+    void followSchema();
+    // Read the current page on a worker; a watch load diffs against the rows shown
+    void startLoad(bool watch);
+    void finishLoad(PageLoad &load);
+    // Replace the rows that changed since the last read and mark them
+    void applyWatchRows(int rowCount, std::vector<std::vector<std::string>> rows);
+
+    // Key of a page row in the edit journal, from its original values
+    std::vector<std::string> journalRowKey(size_t row) const;
+    // Reapply journaled edits to the rows of the current page
+    void applyEditJournal();
+
     // Helper methods
+    void updateDataBytes();
     void enterEditMode(int row, int col);
     void exitEditMode(bool saveEdit);
     void selectCell(int row, int col);
 };
+
+class SnapshotTab : public Tab {
+public:
+    SnapshotTab(const std::string &name, const std::string &snapshotPath);
+
+    void render() override;
+
+    const std::string &getSnapshotPath() const {
+        return snapshotPath;
+    }
+
+private:
+    std::string snapshotPath;
+    Snapshot snapshot;
+    std::string loadError;
+    bool loaded = false;
+};
+
+class QueryPlanTab : public Tab {
+public:
+    QueryPlanTab(const std::string &name, QueryPlan plan);
+
+    void render() override;
+
+private:
+    QueryPlan plan;
+
+    void renderNode(const PlanNode &node, int &nodeId);
+};
+
+// Per-fingerprint timings of every statement run from this client, sortable by any column
+class StatementStatsTab : public Tab {
+public:
+    explicit StatementStatsTab(const std::string &name);
+
+    void render() override;
+
+private:
+    // The copy is refreshed at most this often while statements keep running
+    static constexpr double kRefreshSeconds = 1.0;
+
+    std::vector<StatementStats::Entry> entries;
+    std::vector<size_t> visibleRows;
+    uint64_t generation = 0;
+    double lastRefresh = -1.0;
+    bool needsSort = true;
+    char filter[128] = "";
+
+    void refresh();
+    void sortEntries(int column, bool ascending);
+    void updateVisibleRows();
+};
+
+// Live charts of a PostgreSQL server's load, sampled by an ActivityMonitor
+class ActivityDashboardTab : public Tab {
+public:
+    ActivityDashboardTab(const std::string &name, std::shared_ptr<DatabaseInterface> database);
+
+    void render() override;
+
+    std::shared_ptr<DatabaseInterface> getDatabase() const override {
+        return database;
+    }
+
+private:
+    std::shared_ptr<DatabaseInterface> database;
+    std::unique_ptr<ActivityMonitor> monitor;
+    float intervalSeconds = 1.0f;
+    float plotValues[ActivityMonitor::kHistory] = {};
+    std::vector<ActivitySession> sessions;
+    uint64_t sessionsGeneration = 0;
+
+    void renderMetric(const char *label, ActivityMetric metric, const char *format, float maxValue);
+};
+
+// Rows that differ between two tables, found by TableDiff on a worker
+class TableDiffTab : public Tab {
+public:
+    TableDiffTab(const std::string &name, std::shared_ptr<DatabaseInterface> leftDatabase,
+                 Table leftTable, std::shared_ptr<DatabaseInterface> rightDatabase,
+                 Table rightTable);
+    ~TableDiffTab() override;
+
+    void render() override;
+
+private:
+    // Shared with the worker, which outlives the tab if it is closed mid-diff
+    struct DiffRun {
+        TableDiffProgress progress;
+        bool finished = false;
+        TableDiffResult result;
+    };
+
+    std::shared_ptr<DatabaseInterface> leftDatabase;
+    Table leftTable;
+    std::shared_ptr<DatabaseInterface> rightDatabase;
+    Table rightTable;
+    std::shared_ptr<DiffRun> run;
+    // Grid lines: index into the result rows, and whether the line shows the right side
+    std::vector<std::pair<size_t, bool>> lines;
+    bool linesBuilt = false;
+
+    void start();
+    void buildLines();
+};
+
+// Per-column statistics of one table, computed by ColumnProfiler on a worker
+class ColumnProfileTab : public Tab {
+public:
+    ColumnProfileTab(const std::string &name, std::shared_ptr<DatabaseInterface> database,
+                     std::string tableName);
+    ~ColumnProfileTab() override;
+
+    void render() override;
+
+    std::shared_ptr<DatabaseInterface> getDatabase() const override {
+        return database;
+    }
+
+private:
+    // Shared with the worker, which outlives the tab if it is closed mid-profile
+    struct ProfileRun {
+        ProfileProgress progress;
+        bool finished = false;
+        ProfileResult result;
+    };
+
+    std::shared_ptr<DatabaseInterface> database;
+    std::string tableName;
+    std::shared_ptr<ProfileRun> run;
+    bool sample = false;
+    float samplePercent = 1.0f;
+
+    void start();
+    void renderColumn(const ColumnProfile &column) const;
+};
+
+// Line chart of the numeric columns of a query result. The columns are read on a worker, and
+// each view is downsampled there too, so results with millions of rows stay interactive.
+class ChartTab : public Tab {
+public:
+    ChartTab(const std::string &name, std::shared_ptr<ResultStore> store);
+    ~ChartTab() override;
+
+    void render() override;
+
+    size_t getMemoryUsage() const override;
+
+private:
+    // Shared with the workers, which outlive the tab if it is closed
+    struct ChartRun {
+        std::atomic<size_t> rowsRead{0};
+        std::atomic<bool> cancelRequested{false};
+        std::shared_ptr<const ChartColumns> columns;
+        std::shared_ptr<const ChartPlot> plot;
+        std::shared_ptr<const ChartSample> sample;
+        // Plot builds are numbered so a superseded one is dropped
+        uint64_t plotGeneration = 0;
+        bool sampling = false;
+    };
+
+    static constexpr float kAxisWidth = 70.0f;
+
+    std::shared_ptr<ChartRun> run;
+    int xColumn = -1;
+    std::vector<uint8_t> ySelected;
+    DownsampleMethod method = DownsampleMethod::LTTB;
+
+    // Visible x window; a change marks the sample stale, and the next one is requested as soon
+    // as the one in flight is done, while the stale one keeps being drawn
+    double viewMin = 0.0;
+    double viewMax = 0.0;
+    uint64_t viewGeneration = 0;
+    bool sampleStale = false;
+    size_t plotPixels = 0;
+
+    void buildPlot();
+    void requestSample();
+    void resetView();
+    void clampView();
+    void renderControls();
+    void renderPlot();
+};
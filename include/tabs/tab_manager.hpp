@@ -19,6 +19,7 @@ public:
     std::shared_ptr<Tab> findTab(const std::string &name) const;
     std::shared_ptr<Tab> findTableTab(const std::string &databasePath,
                                       const std::string &tableName) const;
+    std::shared_ptr<Tab> findSnapshotTab(const std::string &snapshotPath) const;
     bool hasTab(const std::string &name) const;
     bool isEmpty() const {
         return tabs.empty();
@@ -31,13 +32,41 @@ public:
     std::shared_ptr<Tab> createSQLEditorTab(const std::string &name = "");
     std::shared_ptr<Tab> createTableViewerTab(const std::string &databasePath,
                                               const std::string &tableName);
+    std::shared_ptr<Tab> createSnapshotTab(const std::string &snapshotPath);
+    std::shared_ptr<Tab> createQueryPlanTab(const std::string &sourceName, QueryPlan plan);
+    std::shared_ptr<Tab> createStatementStatsTab();
+    std::shared_ptr<Tab> createActivityDashboardTab(std::shared_ptr<DatabaseInterface> db);
+    std::shared_ptr<Tab> createTableDiffTab(std::shared_ptr<DatabaseInterface> leftDb,
+                                            const Table &leftTable,
+                                            std::shared_ptr<DatabaseInterface> rightDb,
+                                            const Table &rightTable);
+    std::shared_ptr<Tab> createColumnProfileTab(std::shared_ptr<DatabaseInterface> db,
+                                                const std::string &tableName);
+    std::shared_ptr<Tab> createChartTab(const std::string &sourceName,
+                                        std::shared_ptr<ResultStore> store);
 
     // UI rendering
     void renderTabs();
     void renderEmptyState();
 
+    // Memory management: background tabs are hibernated, least recently used first, while the
+    // total usage is over budget. A hibernated tab reloads its data when it is shown again.
+    static constexpr size_t kDefaultMemoryBudget = 256 * 1024 * 1024;
+    size_t getMemoryUsage() const;
+    size_t getMemoryBudget() const {
+        return memoryBudget;
+    }
+    void setMemoryBudget(size_t budget) {
+        memoryBudget = budget;
+    }
+    void hibernateInactiveTabs();
+
 private:
     std::vector<std::shared_ptr<Tab>> tabs;
+    size_t memoryBudget = kDefaultMemoryBudget;
+    std::shared_ptr<Tab> activeTab;
+
+    void enforceMemoryBudget();
 
     std::string generateSQLEditorName() const;
 };
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ResultStore;
+
+// Numeric columns of a query result, column-major. A column qualifies when every non-NULL cell
+// is a number, or every one is an ISO date/time, which is stored as seconds since the epoch.
+struct ChartColumns {
+    std::vector<std::string> names;
+    std::vector<bool> isTime;
+    // NaN where the cell is NULL
+    std::vector<std::vector<double>> values;
+    size_t rowCount = 0;
+
+    size_t getMemoryUsage() const;
+
+    // Replays the whole result; stops early and returns what it has once cancelled
+    static std::shared_ptr<ChartColumns> extract(const ResultStore &store,
+                                                 std::atomic<size_t> &rowsRead,
+                                                 const std::atomic<bool> &cancelRequested);
+};
+
+// One y column against the chosen x, sorted by x, without the rows where either is NULL
+struct ChartSeries {
+    int column = 0;
+    std::string name;
+    std::vector<double> x;
+    std::vector<double> y;
+};
+
+struct ChartPlot {
+    // Index into ChartColumns, or -1 to plot against the row number
+    int xColumn = -1;
+    bool timeX = false;
+    double minX = 0.0;
+    double maxX = 0.0;
+    size_t pointCount = 0;
+    std::vector<ChartSeries> series;
+
+    size_t getMemoryUsage() const;
+
+    static std::shared_ptr<ChartPlot> build(const ChartColumns &columns, int xColumn,
+                                            const std::vector<int> &yColumns);
+};
+
+enum class DownsampleMethod { LTTB, MIN_MAX };
+
+// The points of each series that are drawn for one x window
+struct ChartSample {
+    std::shared_ptr<const ChartPlot> plot;
+    double viewMin = 0.0;
+    double viewMax = 0.0;
+    std::vector<std::vector<double>> x;
+    std::vector<std::vector<double>> y;
+    // Range of the points inside the window, for fitting the y axis
+    double minY = 0.0;
+    double maxY = 0.0;
+    size_t pointCount = 0;
+    double elapsedMs = 0.0;
+
+    // Costs one pass over the points inside the window, plus the point just outside each edge
+    // so lines run to the border
+    static std::shared_ptr<ChartSample> compute(std::shared_ptr<const ChartPlot> plot,
+                                                double viewMin, double viewMax, size_t pixels,
+                                                DownsampleMethod method);
+};
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "database/db_interface.hpp"
+#include "database/sqlite_profile.hpp"
 #include <memory>
 
 class DatabaseInterface;
+class SQLiteDatabase;
 
 class DatabaseConnectionDialog {
 public:
@@ -27,6 +29,7 @@ private:
     bool isOpen = false;
     bool showingTypeSelection = false;
     bool showingPostgreSQLConnection = false;
+    bool showingSQLiteOptions = false;
     
     // Selected database type
     int selectedDatabaseType = 0; // 0 = SQLite, 1 = PostgreSQL
@@ -38,6 +41,11 @@ private:
     char database[256] = "";
     char username[256] = "";
     char password[256] = "";
+
+    // SQLite file picked, and the profile being edited for it
+    std::shared_ptr<SQLiteDatabase> pendingSQLite;
+    SqliteProfile sqliteProfile;
+    int mmapSizeMb = 0;
     
     // Result
     std::shared_ptr<DatabaseInterface> result = nullptr;
@@ -45,6 +53,7 @@ private:
     // Dialog rendering functions
     void renderTypeSelection();
     void renderPostgreSQLConnection();
+    void renderSQLiteOptions();
     
     // Helper functions
     static std::shared_ptr<DatabaseInterface> createSQLiteDatabase();
@@ -1,6 +1,15 @@
 #pragma once
 
+#include "database/snapshot.hpp"
+#include "database/table_copy.hpp"
+#include "database/table_export.hpp"
 #include "ui/db_connection_dialog.hpp"
+#include "ui/table_filter.hpp"
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 class DatabaseSidebar {
 public:
@@ -8,13 +17,63 @@ public:
     ~DatabaseSidebar() = default;
 
     void render();
+    // Ask running exports, copies and snapshots to stop, e.g. before the workers are joined on
+    // shutdown
+    void cancelExports();
 
 private:
     void renderDatabaseNode(size_t databaseIndex);
+    void renderSchemaNode(size_t databaseIndex, size_t schemaIndex);
+    struct SchemaLoad;
+    // Read a schema's tables on a worker and patch them in on the main thread
+    std::shared_ptr<SchemaLoad> loadSchema(const std::shared_ptr<DatabaseInterface> &db,
+                                           const std::string &schema);
+    // Tables of one schema, or of the whole database when the backend has no schemas
+    void renderTableList(size_t databaseIndex, const std::string &schema);
     void renderTableNode(size_t databaseIndex, size_t tableIndex);
     void handleDatabaseContextMenu(size_t databaseIndex);
     void handleTableContextMenu(size_t databaseIndex, size_t tableIndex);
-    
+    void saveTableSnapshot(size_t databaseIndex, size_t tableIndex);
+    void exportTableCsv(size_t databaseIndex, size_t tableIndex, bool partitioned);
+    void renderExports();
+    void renderSnapshots();
+    void copyTable(size_t databaseIndex, size_t tableIndex, size_t targetIndex);
+    void renderCopies();
+
     // Database connection dialog
     DatabaseConnectionDialog connectionDialog;
+
+    // Fuzzy filter applied to the tables of every open database or schema node
+    char tableFilterText[128] = "";
+    std::map<std::pair<const DatabaseInterface *, std::string>, TableFilter> tableFilters;
+
+    // Schema reads, running or finished; error is set when one failed
+    struct SchemaLoad {
+        bool finished = false;
+        std::string error;
+    };
+    std::map<std::pair<const DatabaseInterface *, std::string>, std::shared_ptr<SchemaLoad>>
+        schemaLoads;
+
+    // CSV exports running on a worker, or finished and not yet dismissed
+    struct ExportJob {
+        std::string tableName;
+        ExportProgress progress;
+        bool finished = false;
+        ExportResult result;
+    };
+    std::vector<std::shared_ptr<ExportJob>> exports;
+
+    // Table copies between databases, kept the same way
+    struct CopyJob {
+        std::string tableName;
+        std::string targetName;
+        CopyProgress progress;
+        bool finished = false;
+        CopyResult result;
+    };
+    std::vector<std::shared_ptr<CopyJob>> copies;
+
+    // Table snapshots being written on a worker, kept the same way
+    std::vector<std::shared_ptr<SnapshotSave>> snapshots;
 };
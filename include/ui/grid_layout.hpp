@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ImFont;
+
+// Column widths and display text for one page of grid data. Measured once per page load so a
+// frame only draws the visible cells instead of measuring every cell.
+struct GridLayout {
+    size_t rowCount = 0;
+    size_t columnCount = 0;
+    std::vector<float> columnWidths;
+    // Per cell (row-major): index into truncatedText, or -1 when the whole value fits
+    std::vector<int32_t> truncatedIndex;
+    std::vector<std::string> truncatedText;
+
+    bool matches(size_t rows, size_t columns) const {
+        return rows == rowCount && columns == columnCount;
+    }
+    const char *getDisplayText(size_t row, size_t col, const std::string &value) const {
+        const int32_t index = truncatedIndex[row * columnCount + col];
+        return index < 0 ? value.c_str() : truncatedText[index].c_str();
+    }
+};
+
+// Holds the latest layout of a grid and measures new pages on a worker thread when the font
+// backend allows it. Results of superseded requests are dropped.
+class GridLayoutCache : public std::enable_shared_from_this<GridLayoutCache> {
+public:
+    static constexpr float kMinColumnWidth = 40.0f;
+    static constexpr float kMaxColumnWidth = 320.0f;
+
+    void request(const std::vector<std::string> &columnNames,
+                 const std::vector<std::vector<std::string>> &rows);
+    void invalidate();
+
+    // nullptr until the current page has been measured
+    std::shared_ptr<const GridLayout> get() const;
+
+private:
+    mutable std::mutex mutex;
+    std::shared_ptr<const GridLayout> layout;
+    uint64_t generation = 0;
+
+    void store(uint64_t requestGeneration, std::shared_ptr<const GridLayout> result);
+    static std::shared_ptr<GridLayout> measure(const std::vector<std::string> &columnNames,
+                                               const std::vector<std::vector<std::string>> &rows,
+                                               ImFont *font, float fontSize);
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Incremental lexer behind the SQL editor's syntax highlighting. The lexer state at the start of
+// every line (inside a string, block comment, quoted identifier or dollar quote) is cached, so an
+// edit re-lexes from the changed line only until the states line up with the cached ones again.
+// Tokens are produced on demand, for the lines on screen.
+class SqlHighlighter {
+public:
+    enum class TokenKind : uint8_t { KEYWORD, STRING, NUMBER, COMMENT, IDENTIFIER };
+
+    // Byte range in the text; anything between tokens is plain text
+    struct Token {
+        size_t begin = 0;
+        size_t end = 0;
+        TokenKind kind = TokenKind::KEYWORD;
+    };
+
+    SqlHighlighter();
+
+    // Bring the line states up to date with the edited text
+    void update(std::string_view newText);
+
+    size_t getLineCount() const {
+        return lines.size();
+    }
+    size_t getLineStart(size_t line) const {
+        return lines[line].start;
+    }
+    // Offset of the line's newline, or the end of the text
+    size_t getLineEnd(size_t line) const;
+    size_t findLine(size_t offset) const;
+
+    void tokenizeLine(size_t line, std::vector<Token> &out) const;
+
+    // Lines whose state the last update() had to recompute
+    size_t getLastRelexedLines() const {
+        return lastRelexedLines;
+    }
+    size_t getMemoryUsage() const;
+
+private:
+    enum class State : uint8_t { NORMAL, BLOCK_COMMENT, STRING, QUOTED_IDENTIFIER, DOLLAR_QUOTE };
+
+    struct Line {
+        size_t start = 0;
+        State state = State::NORMAL;
+        // Index into dollarTags while state is DOLLAR_QUOTE
+        uint32_t tag = 0;
+    };
+
+    // Copy of the text the states were computed for, to find what an edit changed
+    std::string text;
+    std::vector<Line> lines;
+    // Tags of the dollar quotes seen so far; 0 is the empty tag of $$
+    std::vector<std::string> dollarTags;
+    size_t lastRelexedLines = 0;
+
+    uint32_t internTag(std::string_view tag);
+    // Lex text[begin, end) starting in `state` and return the state the line ends in. The tag of
+    // an open dollar quote is carried in `tag`; tokens are only collected when asked for.
+    static State lexLine(std::string_view text, size_t begin, size_t end, State state,
+                         std::string &tag, std::vector<Token> *tokens);
+};
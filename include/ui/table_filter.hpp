@@ -0,0 +1,46 @@
+#pragma once
+
+#include "database/db_interface.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Fuzzy filter over the table names of one schema of a connection, for the sidebar. The
+// lower-cased names are kept in one buffer together with a bitmask of the characters each
+// contains, so most names are rejected without looking at them; a query that extends the previous
+// one only rescans the previous matches.
+class TableFilter {
+public:
+    // Indices into db.getTables() of the schema's tables, best match first; all of them in their
+    // order for an empty query. Backends without schemas list every table under "".
+    const std::vector<size_t> &match(const DatabaseInterface &db, std::string_view schema,
+                                     std::string_view query);
+
+    // Score of query as a subsequence of name, or -1 when it is not one. Both are lower case.
+    static int score(std::string_view name, std::string_view query);
+
+private:
+    struct Entry {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        uint32_t table = 0;
+        uint64_t mask = 0;
+    };
+
+    std::string names;
+    std::vector<Entry> entries;
+    uint64_t generation = 0;
+    bool indexed = false;
+
+    std::string lastQuery;
+    // Entries that matched lastQuery, and the tables they stand for
+    std::vector<size_t> candidates;
+    std::vector<size_t> matches;
+    // Score and index of each match, and the counting sort's buckets
+    std::vector<std::pair<int, size_t>> scored;
+    std::vector<size_t> bucketStarts;
+
+    void rebuild(const std::vector<Table> &tables, std::string_view schema);
+};
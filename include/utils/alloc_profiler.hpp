@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocation counters. The global operator new is only replaced when the build is
+// configured with -DDEAR_SQL_ALLOC_PROFILER=ON; otherwise every counter stays at zero.
+namespace AllocProfiler {
+    struct Counters {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    bool isEnabled();
+    Counters getTotals();
+    // Allocations since the previous call; called once per frame
+    Counters endFrame();
+} // namespace AllocProfiler
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+// Per-user locations for files the application keeps between runs
+namespace AppPaths {
+    // ~/.dear-sql, created on first use; empty if there is no home directory to put it in
+    std::string dataDirectory();
+    // Path of a file inside dataDirectory(), or empty if that isn't available
+    std::string dataFile(const std::string &name);
+} // namespace AppPaths
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Point reduction for drawing long series. Both work on the points [begin, end) of a series
+// whose x values are ascending, append the indices they keep to `out` in order, and cost one
+// pass over the range, so a zoomed-in view only pays for the points it shows.
+namespace Downsample {
+    // Largest-Triangle-Three-Buckets: keeps the first and last point and, from each of
+    // threshold - 2 equal-count buckets, the point forming the largest triangle with the point
+    // kept before it and the average of the next bucket. Preserves the visual shape well.
+    void lttb(const double *x, const double *y, size_t begin, size_t end, size_t threshold,
+              std::vector<size_t> &out);
+
+    // Lowest and highest point of each of `buckets` equal-width x slices, in x order. Every
+    // spike survives, so with one bucket per pixel the line looks the same as the full series.
+    void minMax(const double *x, const double *y, size_t begin, size_t end, size_t buckets,
+                std::vector<size_t> &out);
+} // namespace Downsample
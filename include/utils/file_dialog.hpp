@@ -2,6 +2,7 @@
 
 #include "database/db_interface.hpp"
 #include <memory>
+#include <string>
 
 class DatabaseInterface;
 
@@ -16,6 +17,12 @@ public:
 
     // File operations only
     static std::shared_ptr<DatabaseInterface> openSQLiteFile();
+
+    // An empty path means the dialog was cancelled
+    static std::string openCsvFile();
+    static std::string openSnapshotFile();
+    static std::string saveSnapshotFile(const std::string &defaultName);
+    static std::string saveCsvFile(const std::string &defaultName);
 private:
     static bool isInitialized;
 };
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the frame, such as formatted labels.
+// reset() runs once per frame and keeps the memory, so a steady frame never touches the heap.
+class FrameArena {
+public:
+    static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+    explicit FrameArena(size_t blockSize = kDefaultBlockSize);
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    template <typename T> T *allocateArray(size_t count) {
+        return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // NUL-terminated strings valid until the next reset()
+    const char *copy(std::string_view text);
+    const char *format(const char *fmt, ...);
+
+    // Release everything allocated this frame. If the frame overflowed the first block, the
+    // blocks are merged into one so the next frame fits without allocating.
+    void reset();
+
+    size_t getUsedBytes() const {
+        return usedBytes;
+    }
+    size_t getPeakBytes() const {
+        return peakBytes;
+    }
+    size_t getCapacity() const;
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
+    size_t blockSize;
+    std::vector<Block> blocks;
+    size_t offset = 0;
+    size_t usedBytes = 0;
+    size_t peakBytes = 0;
+
+    char *allocateBytes(size_t size, size_t alignment);
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Progress of a job running on a worker (export, copy, diff, profile). The workers bump the
+// counters, the UI reads them and may set cancelRequested. Jobs with counters of their own
+// derive from it.
+struct JobProgress {
+    // Rows read so far
+    std::atomic<uint64_t> rows{0};
+    // Chunks finished out of chunkCount, for jobs that split their input; chunkCount stays 0
+    // until the chunks are known
+    std::atomic<size_t> chunksDone{0};
+    std::atomic<size_t> chunkCount{0};
+    std::atomic<bool> cancelRequested{false};
+
+    // Parallel readers add to rows in batches of this many, to stay off one cache line
+    static constexpr uint64_t kRowBatch = 4096;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small worker pool for work that should not block the UI thread. Workers hand results back
+// with post(), which queues a callback for the main thread to run in drainMainThread().
+class JobRunner {
+public:
+    // workerCount 0 picks one worker per hardware thread, leaving one for the UI
+    explicit JobRunner(size_t workerCount = 0);
+    ~JobRunner();
+
+    JobRunner(const JobRunner &) = delete;
+    JobRunner &operator=(const JobRunner &) = delete;
+
+    void submit(std::function<void()> job);
+    void post(std::function<void()> callback);
+
+    // Run callbacks posted since the last call; main thread only, once per frame
+    void drainMainThread();
+
+    size_t getWorkerCount() const {
+        return workers.size();
+    }
+    size_t getPendingJobs() const;
+
+private:
+    std::vector<std::thread> workers;
+    mutable std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::deque<std::function<void()>> jobs;
+    bool stopping = false;
+
+    std::mutex callbackMutex;
+    std::vector<std::function<void()>> callbacks;
+    std::vector<std::function<void()>> runningCallbacks;
+
+    void workerLoop();
+};
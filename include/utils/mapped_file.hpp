@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    // Map a file by path; the descriptor is closed again once mapped
+    bool open(const std::string &path);
+    // Map the first size bytes of an already open descriptor, which stays owned by the caller.
+    // On failure the previous mapping is kept.
+    bool map(int fd, size_t size);
+    void close();
+
+    const char *data() const {
+        return static_cast<const char *>(address);
+    }
+    size_t size() const {
+        return length;
+    }
+    bool isOpen() const {
+        return address != nullptr;
+    }
+
+private:
+    void *address = nullptr;
+    size_t length = 0;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// MD5 (RFC 1321), for matching hashes computed by PostgreSQL's md5(); not for security
+namespace Md5 {
+    std::array<uint8_t, 16> digest(std::string_view data);
+    // First 8 bytes of the digest, big-endian, as ('x' || substr(md5(s), 1, 16))::bit(64) reads
+    uint64_t prefix64(std::string_view data);
+} // namespace Md5
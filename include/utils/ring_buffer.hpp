@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+// Fixed-capacity circular buffer; once full, every push overwrites the oldest element, so a
+// time series costs the same memory however long it runs
+template <typename T, size_t Capacity> class RingBuffer {
+public:
+    static_assert(Capacity > 0, "RingBuffer needs room for at least one element");
+
+    void push(const T &value) {
+        items[(first + count) % Capacity] = value;
+        if (count < Capacity) {
+            count++;
+        } else {
+            first = (first + 1) % Capacity;
+        }
+    }
+
+    void clear() {
+        first = 0;
+        count = 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+    bool empty() const {
+        return count == 0;
+    }
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+    // Index 0 is the oldest element
+    const T &operator[](size_t index) const {
+        return items[(first + index) % Capacity];
+    }
+    const T &back() const {
+        return (*this)[count - 1];
+    }
+
+    // Copy the elements out oldest first; out must have room for size() elements
+    size_t copyTo(T *out) const {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = (*this)[i];
+        }
+        return count;
+    }
+
+private:
+    std::array<T, Capacity> items{};
+    size_t first = 0;
+    size_t count = 0;
+};
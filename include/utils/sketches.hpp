@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Fixed-size summaries of a stream. Each one can be filled on its own thread and merged.
+
+// 64-bit hash of a value, good enough to feed HyperLogLog
+uint64_t sketchHash(std::string_view value);
+
+// Distinct count estimate (HyperLogLog with the small-range correction) in 2^kPrecision bytes;
+// the standard error is about 1.04 / sqrt(2^kPrecision), 0.8% here
+class HyperLogLog {
+public:
+    static constexpr int kPrecision = 14;
+
+    HyperLogLog();
+
+    void add(uint64_t hash);
+    void merge(const HyperLogLog &other);
+    double estimate() const;
+
+private:
+    std::vector<uint8_t> registers;
+};
+
+// Most frequent values (Space-Saving) with a fixed number of counters. A value that is not
+// tracked takes over the smallest counter, so a reported count may exceed the true one by at
+// most its error.
+class SpaceSaving {
+public:
+    struct Item {
+        std::string value;
+        uint64_t count = 0;
+        uint64_t error = 0;
+    };
+
+    explicit SpaceSaving(size_t capacity);
+
+    void add(std::string_view value);
+    void merge(const SpaceSaving &other);
+    // Up to k items, most frequent first
+    std::vector<Item> top(size_t k) const;
+
+private:
+    size_t capacity;
+    // Min-heap on count, with each value's position in it
+    std::vector<Item> heap;
+    std::unordered_map<std::string, size_t> positions;
+
+    void siftDown(size_t index);
+    void swapItems(size_t a, size_t b);
+    uint64_t minCount() const;
+};
+
+// Streaming histogram (Ben-Haim and Tom-Tov): at most kBins centroids, the closest two merged
+// when another one is needed
+class StreamingHistogram {
+public:
+    static constexpr size_t kBins = 64;
+
+    void add(double value, uint64_t count = 1);
+    void merge(const StreamingHistogram &other);
+    // Counts in equal-width buckets between low and high
+    std::vector<float> equalWidth(size_t buckets, double low, double high) const;
+
+private:
+    // Sorted by value
+    std::vector<std::pair<double, uint64_t>> centroids;
+
+    void compress();
+};
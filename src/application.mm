@@ -1,10 +1,14 @@
 #include "application.hpp"
 #include "database/db.hpp"
+#include "database/statement_stats.hpp"
 #include "imgui_impl_metal.h"
 #include "tabs/tab_manager.hpp"
 #include "themes.hpp"
+#include "utils/app_paths.hpp"
 #include "utils/file_dialog.hpp"
 #include "utils/toggle_button.hpp"
+#include <cfloat>
+#include <cstring>
 #include <fstream>
 #include <imgui_internal.h>
 #include <iostream>
@@ -49,10 +53,24 @@ bool Application::initialize() {
     }
 
     // Create managers
+    jobRunner = std::make_unique<JobRunner>();
     tabManager = std::make_unique<TabManager>();
     databaseSidebar = std::make_unique<DatabaseSidebar>();
     fileDialog = std::make_unique<FileDialog>();
 
+    // Patched tables move around in the list, so a selection by index would point elsewhere
+    schemaWatcher.setOnPatched([this](const DatabaseInterface &db) {
+        if (selectedDatabase >= 0 && selectedDatabase < (int)databases.size() &&
+            databases[selectedDatabase].get() == &db) {
+            selectedTable = -1;
+        }
+    });
+
+    const std::string statsPath = AppPaths::dataFile("statement_stats.db");
+    if (!statsPath.empty()) {
+        StatementStats::open(statsPath);
+    }
+
 #ifdef USE_METAL_BACKEND
     std::cout << "Application initialized successfully (with Metal backend)" << std::endl;
 #else
@@ -99,11 +117,7 @@ void Application::run() {
         ImGui_ImplOpenGL3_NewFrame();
 #endif
         ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
-        renderMainUI();
-
-        ImGui::Render();
+        renderFrame(glfwGetTime());
 
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
@@ -128,7 +142,53 @@ void Application::run() {
     }
 }
 
+void Application::initializeHeadless(const float width, const float height) {
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO &io = ImGui::GetIO();
+    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+    io.DisplaySize = ImVec2(width, height);
+    io.IniFilename = nullptr;
+
+    setupFonts();
+    io.Fonts->Build();
+    ImGui::StyleColorsDark();
+    Theme::ApplyNativeTheme(darkTheme ? Theme::NATIVE_DARK : Theme::NATIVE_LIGHT);
+
+    jobRunner = std::make_unique<JobRunner>();
+    tabManager = std::make_unique<TabManager>();
+    databaseSidebar = std::make_unique<DatabaseSidebar>();
+    fileDialog = std::make_unique<FileDialog>();
+}
+
+void Application::renderFrame(const double now) {
+    ImGui::NewFrame();
+    frameArena.reset();
+    recordFrameStats();
+    jobRunner->drainMainThread();
+    if (now >= nextStatsFlush) {
+        nextStatsFlush = now + StatementStats::kFlushIntervalSeconds;
+        jobRunner->submit([] { StatementStats::flush(); });
+    }
+    schemaWatcher.update(databases, *jobRunner, now);
+
+    renderMainUI();
+
+    ImGui::Render();
+}
+
 void Application::cleanup() {
+    // Stop background work before anything it might touch goes away. Closing the tabs first
+    // cancels their running queries, so the workers are not waited on for long.
+    if (tabManager) {
+        tabManager->closeAllTabs();
+    }
+    if (databaseSidebar) {
+        databaseSidebar->cancelExports();
+    }
+    jobRunner.reset();
+    StatementStats::flush();
+
     // Cleanup databases
     for (auto &db : databases) {
         db->disconnect();
@@ -140,16 +200,18 @@ void Application::cleanup() {
     databaseSidebar.reset();
     fileDialog.reset();
 
-    // Cleanup NFD
-    FileDialog::cleanup();
+    // A headless run has no window, file dialogs or renderer to shut down
+    if (window) {
+        // Cleanup NFD
+        FileDialog::cleanup();
 
-    // Cleanup ImGui
 #ifdef USE_METAL_BACKEND
-    ImGui_ImplMetal_Shutdown();
+        ImGui_ImplMetal_Shutdown();
 #elif defined(USE_OPENGL_BACKEND)
-    ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplOpenGL3_Shutdown();
 #endif
-    ImGui_ImplGlfw_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+    }
     ImGui::DestroyContext();
 
     // Cleanup GLFW
@@ -170,6 +232,12 @@ void Application::addDatabase(const std::shared_ptr<DatabaseInterface> &db) {
     databases.push_back(db);
 }
 
+SchemaIndex &Application::getSchemaIndex(const DatabaseInterface &db) {
+    SchemaIndex &index = schemaIndexes[&db];
+    index.update(db);
+    return index;
+}
+
 bool Application::initializeGLFW() {
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -453,6 +521,13 @@ void Application::renderMainUI() {
     }
     ImGui::End();
 
+    if (ImGui::IsKeyPressed(ImGuiKey_F12, false)) {
+        showPerformanceWindow = !showPerformanceWindow;
+    }
+    if (showPerformanceWindow) {
+        renderPerformanceWindow();
+    }
+
     // End DockSpace
     ImGui::End();
 }
@@ -461,12 +536,14 @@ void Application::renderMenuBar() {
     if (ImGui::BeginMenuBar()) {
         if (ImGui::BeginMenu("View")) {
             if (ImGui::MenuItem("Refresh All")) {
+                // Each list reloads in the sidebar once its connection is free
                 for (auto &db : databases) {
                     if (db->isConnected()) {
-                        db->refreshTables();
+                        db->setTablesLoaded(false);
                     }
                 }
             }
+            ImGui::MenuItem("Performance", "F12", &showPerformanceWindow);
             ImGui::EndMenu();
         }
 
@@ -483,3 +560,62 @@ void Application::renderMenuBar() {
         ImGui::EndMenuBar();
     }
 }
+
+void Application::recordFrameStats() {
+    // Counts everything allocated since the previous call, i.e. during the whole last frame
+    lastFrameAllocations = AllocProfiler::endFrame();
+
+    memmove(frameTimeHistory, frameTimeHistory + 1, sizeof(float) * (kPerformanceHistory - 1));
+    memmove(allocationHistory, allocationHistory + 1, sizeof(float) * (kPerformanceHistory - 1));
+    frameTimeHistory[kPerformanceHistory - 1] = ImGui::GetIO().DeltaTime * 1000.0f;
+    allocationHistory[kPerformanceHistory - 1] = (float)lastFrameAllocations.allocations;
+}
+
+void Application::renderPerformanceWindow() {
+    ImGui::SetNextWindowSize(ImVec2(360, 320), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Performance", &showPerformanceWindow)) {
+        ImGui::End();
+        return;
+    }
+
+    const ImGuiIO &io = ImGui::GetIO();
+    ImGui::Text("%.1f FPS (%.2f ms/frame)", io.Framerate, 1000.0f / io.Framerate);
+    ImGui::PlotLines("##FrameTime", frameTimeHistory, kPerformanceHistory, 0, "Frame time (ms)",
+                     0.0f, 50.0f, ImVec2(-1, 60));
+
+    ImGui::SeparatorText("Heap");
+    if (AllocProfiler::isEnabled()) {
+        const AllocProfiler::Counters totals = AllocProfiler::getTotals();
+        ImGui::Text("Last frame: %llu allocations, %llu bytes",
+                    (unsigned long long)lastFrameAllocations.allocations,
+                    (unsigned long long)lastFrameAllocations.bytes);
+        ImGui::Text("Total: %llu allocations, %.1f MB", (unsigned long long)totals.allocations,
+                    (double)totals.bytes / (1024.0 * 1024.0));
+        ImGui::PlotHistogram("##Allocations", allocationHistory, kPerformanceHistory, 0,
+                             "Allocations per frame", 0.0f, FLT_MAX, ImVec2(-1, 60));
+    } else {
+        ImGui::TextDisabled("Configure with -DDEAR_SQL_ALLOC_PROFILER=ON to count allocations");
+    }
+
+    ImGui::SeparatorText("Frame arena");
+    ImGui::Text("Used %zu bytes, peak %zu, capacity %zu", frameArena.getUsedBytes(),
+                frameArena.getPeakBytes(), frameArena.getCapacity());
+
+    ImGui::SeparatorText("Tabs");
+    ImGui::Text("Memory: %.1f / %.0f MB", (double)tabManager->getMemoryUsage() / (1024.0 * 1024.0),
+                (double)tabManager->getMemoryBudget() / (1024.0 * 1024.0));
+    if (ImGui::Button("Hibernate Background Tabs")) {
+        tabManager->hibernateInactiveTabs();
+    }
+
+    ImGui::SeparatorText("Query cache");
+    const QueryCache::Stats cacheStats = queryCache.getStats();
+    ImGui::Text("%zu results, %.1f MB, %llu hits, %llu misses", cacheStats.entries,
+                (double)cacheStats.bytes / (1024.0 * 1024.0), (unsigned long long)cacheStats.hits,
+                (unsigned long long)cacheStats.misses);
+    if (ImGui::Button("Clear Query Cache")) {
+        queryCache.clear();
+    }
+
+    ImGui::End();
+}
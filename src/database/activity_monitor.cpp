@@ -0,0 +1,204 @@
+#include "database/activity_monitor.hpp"
+#include <algorithm>
+#include <pqxx/pqxx>
+
+namespace {
+    // Server-wide counters plus a census of client backends, in one round trip
+    constexpr const char *kTotalsSql =
+        "SELECT (SELECT coalesce(sum(xact_commit + xact_rollback), 0) FROM pg_stat_database), "
+        "(SELECT coalesce(sum(blks_hit), 0) FROM pg_stat_database), "
+        "(SELECT coalesce(sum(blks_read), 0) FROM pg_stat_database), "
+        "count(*) FILTER (WHERE state = 'active'), "
+        "count(*) FILTER (WHERE state = 'active' AND wait_event_type IS NOT NULL), "
+        "(SELECT count(*) FROM pg_locks WHERE NOT granted) "
+        "FROM pg_stat_activity "
+        "WHERE backend_type = 'client backend' AND pid <> pg_backend_pid()";
+
+    constexpr const char *kSessionsSql =
+        "SELECT pid, coalesce(usename, ''), coalesce(state, ''), "
+        "coalesce(wait_event_type || ': ' || wait_event, ''), "
+        "array_to_string(pg_blocking_pids(pid), ', '), "
+        "coalesce(extract(epoch FROM clock_timestamp() - query_start) * 1000, 0), "
+        "left(query, 500) "
+        "FROM pg_stat_activity "
+        "WHERE backend_type = 'client backend' AND state IS DISTINCT FROM 'idle' "
+        "AND pid <> pg_backend_pid() "
+        "ORDER BY query_start NULLS LAST LIMIT 100";
+
+    size_t metricIndex(const ActivityMetric metric) {
+        return static_cast<size_t>(metric);
+    }
+} // namespace
+
+ActivityMonitor::ActivityMonitor(const std::string &connectionString, const double intervalSeconds)
+    : connectionString(connectionString), intervalSeconds(intervalSeconds) {
+    worker = std::thread(&ActivityMonitor::run, this);
+}
+
+ActivityMonitor::~ActivityMonitor() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    // Don't wait out a sample the server is slow to answer
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        if (connection) {
+            try {
+                connection->cancel_query();
+            } catch (const std::exception &) {
+            }
+        }
+    }
+    worker.join();
+}
+
+void ActivityMonitor::setInterval(const double seconds) {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        intervalSeconds = seconds;
+    }
+    wake.notify_all();
+}
+
+double ActivityMonitor::getInterval() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return intervalSeconds;
+}
+
+size_t ActivityMonitor::copySeries(const ActivityMetric metric, float *out) const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return series[metricIndex(metric)].copyTo(out);
+}
+
+float ActivityMonitor::getLatest(const ActivityMetric metric) const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    const auto &values = series[metricIndex(metric)];
+    return values.empty() ? 0.0f : values.back();
+}
+
+std::vector<ActivitySession> ActivityMonitor::getSessions() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return sessions;
+}
+
+std::string ActivityMonitor::getError() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return error;
+}
+
+double ActivityMonitor::getSecondsSinceSample() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (generation == 0) {
+        return 0.0;
+    }
+    return std::chrono::duration<double>(Clock::now() - lastSampleAt).count();
+}
+
+double ActivityMonitor::getLastSampleMs() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return lastSampleMs;
+}
+
+void ActivityMonitor::run() {
+    Counters previous;
+    bool havePrevious = false;
+
+    std::unique_lock<std::mutex> lock(stateMutex);
+    while (!stopping) {
+        lock.unlock();
+        const auto started = Clock::now();
+        std::string failure;
+        try {
+            // Only this thread replaces the connection, so reading it here needs no lock
+            if (!connection || !connection->is_open()) {
+                auto fresh = std::make_unique<pqxx::connection>(
+                    connectionString + " connect_timeout=5 application_name=dear-sql-monitor");
+                pqxx::nontransaction txn(*fresh);
+                txn.exec("SET statement_timeout = " + std::to_string(kStatementTimeoutMs));
+                txn.commit();
+
+                std::lock_guard<std::mutex> guard(connectionMutex);
+                connection = std::move(fresh);
+            }
+            sample(*connection, previous, havePrevious);
+        } catch (const std::exception &e) {
+            failure = e.what();
+            havePrevious = false;
+            std::lock_guard<std::mutex> guard(connectionMutex);
+            connection.reset();
+        }
+
+        lock.lock();
+        error = failure;
+        const auto next = started + std::chrono::duration_cast<Clock::duration>(
+                                        std::chrono::duration<double>(intervalSeconds));
+        wake.wait_until(lock, next, [this] { return stopping; });
+    }
+    lock.unlock();
+
+    std::lock_guard<std::mutex> guard(connectionMutex);
+    connection.reset();
+}
+
+void ActivityMonitor::sample(pqxx::connection &conn, Counters &previous, bool &havePrevious) {
+    const auto started = Clock::now();
+    pqxx::nontransaction txn(conn);
+
+    const pqxx::row totals = txn.exec(kTotalsSql).one_row();
+    Counters current;
+    current.takenAt = Clock::now();
+    current.transactions = totals[0].as<int64_t>();
+    current.blocksHit = totals[1].as<int64_t>();
+    current.blocksRead = totals[2].as<int64_t>();
+    const auto active = totals[3].as<float>();
+    const auto waiting = totals[4].as<float>();
+    const auto lockWaits = totals[5].as<float>();
+
+    std::vector<ActivitySession> currentSessions;
+    for (const auto &row : txn.exec(kSessionsSql)) {
+        ActivitySession session;
+        session.pid = row[0].as<int>();
+        session.user = row[1].c_str();
+        session.state = row[2].c_str();
+        session.wait = row[3].c_str();
+        session.blockedBy = row[4].c_str();
+        session.durationMs = row[5].as<double>();
+        session.query = row[6].c_str();
+        currentSessions.push_back(std::move(session));
+    }
+    const double elapsedMs =
+        std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+
+    // Rates need two samples; counters going backwards means the statistics were reset
+    const bool haveRates = havePrevious && current.transactions >= previous.transactions &&
+                           current.blocksHit >= previous.blocksHit &&
+                           current.blocksRead >= previous.blocksRead;
+
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (haveRates) {
+        const double seconds =
+            std::max(std::chrono::duration<double>(current.takenAt - previous.takenAt).count(),
+                     1e-3);
+        const auto hits = static_cast<double>(current.blocksHit - previous.blocksHit);
+        const auto reads = static_cast<double>(current.blocksRead - previous.blocksRead);
+        series[metricIndex(ActivityMetric::TPS)].push(
+            static_cast<float>(static_cast<double>(current.transactions - previous.transactions) /
+                               seconds));
+        // An interval that touched no blocks didn't miss the cache either
+        series[metricIndex(ActivityMetric::CACHE_HIT_RATIO)].push(
+            hits + reads > 0.0 ? static_cast<float>(100.0 * hits / (hits + reads)) : 100.0f);
+    }
+    series[metricIndex(ActivityMetric::ACTIVE_SESSIONS)].push(active);
+    series[metricIndex(ActivityMetric::WAITING_SESSIONS)].push(waiting);
+    series[metricIndex(ActivityMetric::LOCK_WAITS)].push(lockWaits);
+    sessions = std::move(currentSessions);
+    lastSampleAt = Clock::now();
+    lastSampleMs = elapsedMs;
+    generation++;
+
+    previous = current;
+    havePrevious = true;
+}
@@ -0,0 +1,283 @@
+#include "database/column_profile.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace {
+    // The whole value must be a finite number
+    std::optional<double> parseNumber(const std::string_view value) {
+        char buffer[64];
+        if (value.empty() || value.size() >= sizeof(buffer)) {
+            return std::nullopt;
+        }
+        memcpy(buffer, value.data(), value.size());
+        buffer[value.size()] = '\0';
+        char *end = nullptr;
+        const double number = strtod(buffer, &end);
+        if (end != buffer + value.size() || !std::isfinite(number)) {
+            return std::nullopt;
+        }
+        return number;
+    }
+
+    std::string formatNumber(const double value) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.15g", value);
+        return buffer;
+    }
+
+    // Everything one worker knows about one column
+    struct ColumnAccumulator {
+        uint64_t values = 0;
+        uint64_t nulls = 0;
+        uint64_t numericValues = 0;
+        double numericMin = std::numeric_limits<double>::infinity();
+        double numericMax = -std::numeric_limits<double>::infinity();
+        double sum = 0.0;
+        std::optional<std::string> textMin;
+        std::optional<std::string> textMax;
+        HyperLogLog distinct;
+        SpaceSaving top{ColumnProfiler::kTopCounters};
+        StreamingHistogram histogram;
+
+        void add(const std::optional<std::string_view> &value) {
+            if (!value) {
+                nulls++;
+                return;
+            }
+            values++;
+            distinct.add(sketchHash(*value));
+
+            const std::string_view cut = value->substr(0, ColumnProfiler::kMaxValueBytes);
+            top.add(cut);
+            if (!textMin || cut < *textMin) {
+                textMin = std::string(cut);
+            }
+            if (!textMax || cut > *textMax) {
+                textMax = std::string(cut);
+            }
+
+            if (const auto number = parseNumber(*value)) {
+                numericValues++;
+                numericMin = std::min(numericMin, *number);
+                numericMax = std::max(numericMax, *number);
+                sum += *number;
+                histogram.add(*number);
+            }
+        }
+
+        void merge(const ColumnAccumulator &other) {
+            values += other.values;
+            nulls += other.nulls;
+            numericValues += other.numericValues;
+            numericMin = std::min(numericMin, other.numericMin);
+            numericMax = std::max(numericMax, other.numericMax);
+            sum += other.sum;
+            if (other.textMin && (!textMin || *other.textMin < *textMin)) {
+                textMin = other.textMin;
+            }
+            if (other.textMax && (!textMax || *other.textMax > *textMax)) {
+                textMax = other.textMax;
+            }
+            distinct.merge(other.distinct);
+            top.merge(other.top);
+            histogram.merge(other.histogram);
+        }
+
+        ColumnProfile finish(std::string name) const {
+            ColumnProfile profile;
+            profile.name = std::move(name);
+            profile.values = values;
+            profile.nulls = nulls;
+            profile.numericValues = numericValues;
+            profile.numeric = values > 0 && numericValues == values;
+            if (profile.numeric) {
+                profile.min = formatNumber(numericMin);
+                profile.max = formatNumber(numericMax);
+                profile.mean = sum / static_cast<double>(numericValues);
+                profile.histogram = histogram.equalWidth(ColumnProfiler::kHistogramBuckets,
+                                                         numericMin, numericMax);
+            } else {
+                profile.min = textMin.value_or("");
+                profile.max = textMax.value_or("");
+            }
+            // Below a few hundred values the estimate can't beat the exact bound
+            profile.distinct = std::min(distinct.estimate(), static_cast<double>(values));
+            // Only values that surely occur more than once; in a column of unique values the
+            // counters just hold whatever came last
+            profile.topValues = top.top(ColumnProfiler::kTopValues);
+            profile.topValues.erase(std::remove_if(profile.topValues.begin(),
+                                                   profile.topValues.end(),
+                                                   [](const SpaceSaving::Item &item) {
+                                                       return item.count - item.error < 2;
+                                                   }),
+                                    profile.topValues.end());
+            return profile;
+        }
+    };
+
+    // Feeds rows of any number of chunks into one worker's accumulators
+    class ProfileSink : public RowSink {
+    public:
+        explicit ProfileSink(ProfileProgress *progress) : progress(progress) {}
+
+        void begin(const std::vector<std::string> &names) override {
+            if (columns.empty()) {
+                columnNames = names;
+                columns.resize(names.size());
+            }
+        }
+
+        bool row(const RowValues &values) override {
+            if (progress && progress->cancelRequested) {
+                return false;
+            }
+            for (size_t i = 0; i < values.size() && i < columns.size(); i++) {
+                columns[i].add(values[i]);
+            }
+            if (++pendingRows == JobProgress::kRowBatch) {
+                flushProgress();
+            }
+            return true;
+        }
+
+        void end() override {
+            flushProgress();
+        }
+
+        std::vector<std::string> columnNames;
+        std::vector<ColumnAccumulator> columns;
+
+    private:
+        ProfileProgress *progress;
+        uint64_t pendingRows = 0;
+
+        void flushProgress() {
+            if (progress) {
+                progress->rows += pendingRows;
+            }
+            pendingRows = 0;
+        }
+    };
+} // namespace
+
+ProfileResult ColumnProfiler::profile(DatabaseInterface &db, const std::string &tableName,
+                                      const ProfileOptions &options, ProfileProgress *progress) {
+    const auto started = std::chrono::steady_clock::now();
+    ProfileResult result;
+    ProfileProgress localProgress;
+    if (!progress) {
+        progress = &localProgress;
+    }
+
+    size_t workers = options.workers;
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    const std::string table = db.quoteTableName(tableName);
+    std::unique_ptr<ParallelReader> reader;
+    if (options.samplePercent < 100.0) {
+        result.sampled = true;
+        const std::string percent = formatNumber(std::max(options.samplePercent, 0.0001));
+        if (db.getType() == DatabaseType::POSTGRESQL) {
+            // Whole pages are picked, so unread pages cost no I/O
+            reader = std::make_unique<SingleQueryReader>(
+                db, "SELECT * FROM " + table + " TABLESAMPLE SYSTEM (" + percent + ")");
+        } else {
+            // SQLite can't skip pages; the filter only saves the per-value work
+            reader = std::make_unique<SingleQueryReader>(
+                db, "SELECT * FROM " + table + " WHERE abs(random() % 1000000) < " +
+                        std::to_string(static_cast<int64_t>(options.samplePercent * 10000)));
+        }
+    } else {
+        std::string splitError;
+        reader = db.beginParallelRead(tableName, workers * kChunksPerWorker, splitError);
+        if (!reader) {
+            reader = std::make_unique<SingleQueryReader>(db, "SELECT * FROM " + table);
+        }
+    }
+    const size_t chunkCount = reader->getChunkCount();
+    workers = std::min(workers, chunkCount);
+    progress->chunkCount = chunkCount;
+
+    std::vector<std::unique_ptr<ProfileSink>> sinks;
+    for (size_t i = 0; i < workers; i++) {
+        sinks.push_back(std::make_unique<ProfileSink>(progress));
+    }
+
+    std::mutex errorMutex;
+    std::string error;
+    std::atomic<size_t> nextChunk{0};
+    auto work = [&](ProfileSink &sink) {
+        while (!progress->cancelRequested) {
+            const size_t chunk = nextChunk++;
+            if (chunk >= chunkCount) {
+                return;
+            }
+            const StatementResult chunkResult = reader->readChunk(chunk, sink);
+            if (!chunkResult.success) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (error.empty()) {
+                    error = chunkResult.error;
+                }
+                progress->cancelRequested = true;
+                return;
+            }
+            progress->chunksDone++;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers; i++) {
+        threads.emplace_back(work, std::ref(*sinks[i]));
+    }
+    work(*sinks[0]);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    result.chunks = chunkCount;
+    result.workers = workers;
+    result.elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started)
+            .count();
+    if (!error.empty()) {
+        result.error = error;
+        return result;
+    }
+    if (progress->cancelRequested) {
+        result.error = "Profile cancelled";
+        return result;
+    }
+
+    // Workers that never got a chunk have no columns
+    ProfileSink &merged = *sinks[0];
+    for (size_t i = 1; i < sinks.size(); i++) {
+        if (merged.columns.empty()) {
+            std::swap(merged.columnNames, sinks[i]->columnNames);
+            std::swap(merged.columns, sinks[i]->columns);
+            continue;
+        }
+        for (size_t col = 0; col < merged.columns.size() && col < sinks[i]->columns.size();
+             col++) {
+            merged.columns[col].merge(sinks[i]->columns[col]);
+        }
+    }
+    for (size_t col = 0; col < merged.columns.size(); col++) {
+        result.columns.push_back(merged.columns[col].finish(merged.columnNames[col]));
+    }
+    result.rows = result.columns.empty()
+                      ? 0
+                      : result.columns[0].values + result.columns[0].nulls;
+    result.success = true;
+    return result;
+}
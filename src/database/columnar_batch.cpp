@@ -0,0 +1,274 @@
+#include "database/columnar_batch.hpp"
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    size_t alignUp(const size_t value, const size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    size_t bitmapSize(const size_t rows) {
+        return alignUp((rows + 7) / 8, 4);
+    }
+
+    std::string_view formatInt(const int64_t value, char *scratch) {
+        const auto result =
+            std::to_chars(scratch, scratch + ColumnarBatchView::kScratchSize, value);
+        return {scratch, static_cast<size_t>(result.ptr - scratch)};
+    }
+
+    std::string_view formatDouble(const double value, char *scratch) {
+        const int length = snprintf(scratch, ColumnarBatchView::kScratchSize, "%.15g", value);
+        return {scratch, static_cast<size_t>(length)};
+    }
+
+    // True if text is exactly how the value would be printed, so nothing changes on read back
+    bool parseInt(const std::string_view text, int64_t &value) {
+        const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+            return false;
+        }
+        char scratch[ColumnarBatchView::kScratchSize];
+        return formatInt(value, scratch) == text;
+    }
+
+    bool parseDouble(const std::string_view text, double &value) {
+        char buffer[ColumnarBatchView::kScratchSize];
+        if (text.empty() || text.size() >= sizeof(buffer)) {
+            return false;
+        }
+        memcpy(buffer, text.data(), text.size());
+        buffer[text.size()] = '\0';
+
+        char *end = nullptr;
+        value = strtod(buffer, &end);
+        if (end != buffer + text.size()) {
+            return false;
+        }
+        char scratch[ColumnarBatchView::kScratchSize];
+        return formatDouble(value, scratch) == text;
+    }
+} // namespace
+
+ColumnarBatchBuilder::ColumnarBatchBuilder(const size_t columnCount) : columns(columnCount) {}
+
+void ColumnarBatchBuilder::append(const RowValues &values) {
+    const size_t bit = rowCount % 8;
+    for (size_t col = 0; col < columns.size(); col++) {
+        auto &column = columns[col];
+        if (bit == 0) {
+            column.nulls.push_back(0);
+            byteSize++;
+        }
+
+        const bool isNullValue = col >= values.size() || !values[col].has_value();
+        if (isNullValue) {
+            column.nulls.back() |= static_cast<uint8_t>(1u << bit);
+        } else {
+            column.bytes.append(values[col]->data(), values[col]->size());
+            byteSize += values[col]->size();
+        }
+        column.offsets.push_back(static_cast<uint32_t>(column.bytes.size()));
+        byteSize += sizeof(uint32_t);
+    }
+    rowCount++;
+}
+
+void ColumnarBatchBuilder::clear() {
+    for (auto &column : columns) {
+        column = ColumnData();
+    }
+    rowCount = 0;
+    byteSize = 0;
+}
+
+size_t ColumnarBatchBuilder::getSerializedSize() const {
+    size_t size = 0;
+    for (const auto &column : columns) {
+        size += bitmapSize(rowCount);
+        size += (rowCount + 1) * sizeof(uint32_t);
+        size = alignUp(size + column.bytes.size(), 8);
+    }
+    return size;
+}
+
+bool ColumnarBatchBuilder::isNull(const size_t row, const size_t col) const {
+    return (columns[col].nulls[row / 8] >> (row % 8)) & 1u;
+}
+
+std::string_view ColumnarBatchBuilder::getCell(const size_t row, const size_t col) const {
+    const auto &column = columns[col];
+    const uint32_t begin = column.offsets[row];
+    return {column.bytes.data() + begin, column.offsets[row + 1] - begin};
+}
+
+void ColumnarBatchBuilder::serialize(std::string &out, std::vector<ColumnKind> *kinds) const {
+    const size_t start = out.size();
+    out.reserve(start + getSerializedSize());
+
+    for (const auto &column : columns) {
+        const ColumnKind kind = kinds ? inferKind(column) : ColumnKind::TEXT;
+        if (kinds) {
+            kinds->push_back(kind);
+        }
+
+        out.append(reinterpret_cast<const char *>(column.nulls.data()), column.nulls.size());
+
+        if (kind == ColumnKind::TEXT) {
+            out.resize(alignUp(out.size() - start, 4) + start, '\0');
+            out.append(reinterpret_cast<const char *>(column.offsets.data()),
+                       column.offsets.size() * sizeof(uint32_t));
+            out.append(column.bytes);
+        } else {
+            out.resize(alignUp(out.size() - start, 8) + start, '\0');
+            for (size_t row = 0; row < rowCount; row++) {
+                const std::string_view text(column.bytes.data() + column.offsets[row],
+                                            column.offsets[row + 1] - column.offsets[row]);
+                char value[8] = {};
+                if (kind == ColumnKind::INT64) {
+                    int64_t number = 0;
+                    parseInt(text, number);
+                    memcpy(value, &number, sizeof(value));
+                } else {
+                    double number = 0.0;
+                    parseDouble(text, number);
+                    memcpy(value, &number, sizeof(value));
+                }
+                out.append(value, sizeof(value));
+            }
+        }
+        out.resize(alignUp(out.size() - start, 8) + start, '\0');
+    }
+}
+
+ColumnKind ColumnarBatchBuilder::inferKind(const ColumnData &column) const {
+    bool allInt = true;
+    bool allDouble = true;
+    bool anyValue = false;
+
+    for (size_t row = 0; row < rowCount && (allInt || allDouble); row++) {
+        if ((column.nulls[row / 8] >> (row % 8)) & 1u) {
+            continue;
+        }
+        anyValue = true;
+        const std::string_view text(column.bytes.data() + column.offsets[row],
+                                    column.offsets[row + 1] - column.offsets[row]);
+        int64_t intValue;
+        double doubleValue;
+        allInt = allInt && parseInt(text, intValue);
+        allDouble = allDouble && (allInt || parseDouble(text, doubleValue));
+    }
+
+    if (!anyValue) {
+        return ColumnKind::TEXT;
+    }
+    if (allInt) {
+        return ColumnKind::INT64;
+    }
+    return allDouble ? ColumnKind::DOUBLE : ColumnKind::TEXT;
+}
+
+ColumnarBatchView::ColumnarBatchView(const char *data, const size_t rowCount,
+                                     const size_t columnCount, const ColumnKind *kinds)
+    : columns(columnCount), rowCount(rowCount) {
+    size_t pos = 0;
+    for (size_t col = 0; col < columnCount; col++) {
+        auto &column = columns[col];
+        column.kind = kinds ? kinds[col] : ColumnKind::TEXT;
+        column.nulls = reinterpret_cast<const uint8_t *>(data + pos);
+
+        if (column.kind == ColumnKind::TEXT) {
+            pos += bitmapSize(rowCount);
+            column.offsets = reinterpret_cast<const uint32_t *>(data + pos);
+            pos += (rowCount + 1) * sizeof(uint32_t);
+            column.bytes = data + pos;
+            pos = alignUp(pos + column.offsets[rowCount], 8);
+        } else {
+            pos += alignUp((rowCount + 7) / 8, 8);
+            column.bytes = data + pos;
+            pos += rowCount * 8;
+        }
+    }
+}
+
+bool ColumnarBatchView::validate(const char *data, const size_t size, const size_t rowCount,
+                                 const size_t columnCount, const ColumnKind *kinds) {
+    // Every column takes at least four bytes a row, which also keeps the sizes below from
+    // overflowing
+    if (columnCount > 0 && rowCount > size / 4) {
+        return false;
+    }
+
+    size_t pos = 0;
+    for (size_t col = 0; col < columnCount; col++) {
+        const ColumnKind kind = kinds ? kinds[col] : ColumnKind::TEXT;
+        if (kind == ColumnKind::TEXT) {
+            const size_t offsetsSize = (rowCount + 1) * sizeof(uint32_t);
+            if (size - pos < bitmapSize(rowCount) + offsetsSize) {
+                return false;
+            }
+            pos += bitmapSize(rowCount);
+            const char *offsets = data + pos;
+            pos += offsetsSize;
+
+            uint32_t previous = 0;
+            for (size_t row = 0; row <= rowCount; row++) {
+                uint32_t offset;
+                memcpy(&offset, offsets + row * sizeof(uint32_t), sizeof(offset));
+                if (offset < previous) {
+                    return false;
+                }
+                previous = offset;
+            }
+            if (size - pos < previous || alignUp(pos + previous, 8) > size) {
+                return false;
+            }
+            pos = alignUp(pos + previous, 8);
+        } else if (kind == ColumnKind::INT64 || kind == ColumnKind::DOUBLE) {
+            const size_t columnSize = alignUp((rowCount + 7) / 8, 8) + rowCount * 8;
+            if (size - pos < columnSize) {
+                return false;
+            }
+            pos += columnSize;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ColumnarBatchView::isNull(const size_t row, const size_t col) const {
+    return (columns[col].nulls[row / 8] >> (row % 8)) & 1u;
+}
+
+std::string_view ColumnarBatchView::getCell(const size_t row, const size_t col) const {
+    const auto &column = columns[col];
+    const uint32_t begin = column.offsets[row];
+    return {column.bytes + begin, column.offsets[row + 1] - begin};
+}
+
+int64_t ColumnarBatchView::getInt(const size_t row, const size_t col) const {
+    int64_t value;
+    memcpy(&value, columns[col].bytes + row * 8, sizeof(value));
+    return value;
+}
+
+double ColumnarBatchView::getDouble(const size_t row, const size_t col) const {
+    double value;
+    memcpy(&value, columns[col].bytes + row * 8, sizeof(value));
+    return value;
+}
+
+std::string_view ColumnarBatchView::getDisplayText(const size_t row, const size_t col,
+                                                   char *scratch) const {
+    switch (columns[col].kind) {
+    case ColumnKind::INT64:
+        return formatInt(getInt(row, col), scratch);
+    case ColumnKind::DOUBLE:
+        return formatDouble(getDouble(row, col), scratch);
+    default:
+        return getCell(row, col);
+    }
+}
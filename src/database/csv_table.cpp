@@ -0,0 +1,542 @@
+#include "database/csv_table.hpp"
+#include "database/sql_script.hpp"
+#include "utils/mapped_file.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+    // One checkpoint per this many rows keeps the index small even for billions of rows
+    constexpr uint64_t kIndexStride = 64;
+
+    struct Field {
+        size_t begin = 0;
+        size_t end = 0;
+        bool quoted = false;
+    };
+
+    class CsvFile {
+    public:
+        bool open(const std::string &path, bool hasHeader, std::vector<std::string> &columnNames,
+                  std::string &error);
+
+        // Parse the record starting at pos and return where the next one starts. Quotes are
+        // only special at the start of a field, as in RFC 4180.
+        size_t parseRecord(size_t pos, std::vector<Field> *fields) const;
+
+        // Find the start of a data row, extending the index as far as needed
+        bool seek(uint64_t row, size_t &pos);
+        // Record a row boundary seen by a scan so later seeks can start from it
+        void noteRow(uint64_t row, size_t start, size_t next);
+
+        double estimateRows() const;
+
+        const char *data() const {
+            return mapping.data();
+        }
+        size_t size() const {
+            return mapping.size();
+        }
+
+    private:
+        MappedFile mapping;
+        size_t dataStart = 0;
+        std::vector<size_t> checkpoints;
+        uint64_t indexedRows = 0;
+        size_t indexedEnd = 0;
+        bool indexComplete = false;
+    };
+
+    struct CsvVtab : sqlite3_vtab {
+        CsvFile file;
+        size_t columnCount = 0;
+    };
+
+    struct CsvCursor : sqlite3_vtab_cursor {
+        uint64_t row = 0;
+        size_t pos = 0;
+        size_t next = 0;
+        bool eof = true;
+        bool single = false;
+        bool parsed = false;
+        std::vector<Field> fields;
+        std::string buffer;
+    };
+
+    enum IndexPlan { FULL_SCAN = 0, ROWID_EQ = 1, OFFSET_SCAN = 2 };
+
+    bool CsvFile::open(const std::string &path, const bool hasHeader,
+                       std::vector<std::string> &columnNames, std::string &error) {
+        if (!mapping.open(path)) {
+            error = "cannot open CSV file: " + path;
+            return false;
+        }
+
+        // Skip a UTF-8 byte order mark
+        size_t pos = 0;
+        if (size() >= 3 && memcmp(data(), "\xEF\xBB\xBF", 3) == 0) {
+            pos = 3;
+        }
+
+        std::vector<Field> fields;
+        const size_t afterFirst = parseRecord(pos, &fields);
+        for (size_t i = 0; i < fields.size(); i++) {
+            std::string name;
+            if (hasHeader) {
+                name.assign(data() + fields[i].begin, fields[i].end - fields[i].begin);
+            }
+            if (name.empty()) {
+                name = "c" + std::to_string(i + 1);
+            }
+            while (std::find(columnNames.begin(), columnNames.end(), name) != columnNames.end()) {
+                name += "_" + std::to_string(i + 1);
+            }
+            columnNames.push_back(name);
+        }
+
+        dataStart = hasHeader ? afterFirst : pos;
+        indexedEnd = dataStart;
+        indexComplete = dataStart >= size();
+        return true;
+    }
+
+    size_t CsvFile::parseRecord(size_t pos, std::vector<Field> *fields) const {
+        const char *d = data();
+        const size_t n = size();
+
+        while (true) {
+            Field field{pos, pos, false};
+            if (pos < n && d[pos] == '"') {
+                field.quoted = true;
+                field.begin = ++pos;
+                while (pos < n) {
+                    if (d[pos] == '"') {
+                        if (pos + 1 < n && d[pos + 1] == '"') {
+                            pos += 2;
+                            continue;
+                        }
+                        break;
+                    }
+                    pos++;
+                }
+                field.end = pos;
+                if (pos < n) {
+                    pos++; // Closing quote
+                }
+            }
+            // Anything up to the delimiter; for quoted fields this is malformed and ignored
+            while (pos < n && d[pos] != ',' && d[pos] != '\n' && d[pos] != '\r') {
+                pos++;
+            }
+            if (!field.quoted) {
+                field.end = pos;
+            }
+            if (fields) {
+                fields->push_back(field);
+            }
+
+            if (pos >= n) {
+                return n;
+            }
+            if (d[pos] == ',') {
+                pos++;
+                continue;
+            }
+            if (d[pos] == '\r') {
+                pos++;
+            }
+            if (pos < n && d[pos] == '\n') {
+                pos++;
+            }
+            return pos;
+        }
+    }
+
+    bool CsvFile::seek(const uint64_t row, size_t &pos) {
+        while (!indexComplete && indexedRows <= row) {
+            noteRow(indexedRows, indexedEnd, parseRecord(indexedEnd, nullptr));
+        }
+        if (row >= indexedRows) {
+            return false;
+        }
+
+        pos = checkpoints[row / kIndexStride];
+        for (uint64_t i = row / kIndexStride * kIndexStride; i < row; i++) {
+            pos = parseRecord(pos, nullptr);
+        }
+        return true;
+    }
+
+    void CsvFile::noteRow(const uint64_t row, const size_t start, const size_t next) {
+        if (indexComplete || row != indexedRows) {
+            return;
+        }
+        if (row % kIndexStride == 0) {
+            checkpoints.push_back(start);
+        }
+        indexedRows++;
+        indexedEnd = next;
+        indexComplete = next >= size();
+    }
+
+    double CsvFile::estimateRows() const {
+        if (indexComplete) {
+            return (double)indexedRows;
+        }
+        // Extrapolate from the rows seen so far, assuming ~100 bytes per row before any scan
+        const double bytesPerRow =
+            indexedRows > 0 ? (double)(indexedEnd - dataStart) / (double)indexedRows : 100.0;
+        return (double)(size() - dataStart) / std::max(bytesPerRow, 1.0);
+    }
+
+    std::string unquote(const std::string &value) {
+        if (value.size() < 2 || (value.front() != '\'' && value.front() != '"') ||
+            value.back() != value.front()) {
+            return value;
+        }
+        const char quote = value.front();
+        std::string result;
+        for (size_t i = 1; i + 1 < value.size(); i++) {
+            result += value[i];
+            if (value[i] == quote && value[i + 1] == quote) {
+                i++;
+            }
+        }
+        return result;
+    }
+
+    // Unquoted numeric text is returned as a number so WHERE comparisons behave as expected.
+    // Leading zeros are kept as text, since they usually mark codes rather than quantities.
+    bool setNumericResult(sqlite3_context *context, const char *text, const size_t length) {
+        if (length == 0 || length >= 32) {
+            return false;
+        }
+
+        const size_t digitsStart = (text[0] == '-') ? 1 : 0;
+        if (digitsStart == length ||
+            (text[digitsStart] == '0' && length > digitsStart + 1 && text[digitsStart + 1] != '.')) {
+            return false;
+        }
+
+        sqlite3_int64 intValue = 0;
+        const auto intResult = std::from_chars(text, text + length, intValue);
+        if (intResult.ec == std::errc() && intResult.ptr == text + length) {
+            sqlite3_result_int64(context, intValue);
+            return true;
+        }
+
+        for (size_t i = digitsStart; i < length; i++) {
+            if (!strchr("0123456789.eE+-", text[i])) {
+                return false;
+            }
+        }
+        char buffer[32];
+        memcpy(buffer, text, length);
+        buffer[length] = '\0';
+        char *end = nullptr;
+        const double doubleValue = strtod(buffer, &end);
+        if (end != buffer + length) {
+            return false;
+        }
+        sqlite3_result_double(context, doubleValue);
+        return true;
+    }
+
+    int csvConnect(sqlite3 *db, void *, int argc, const char *const *argv, sqlite3_vtab **vtab,
+                   char **error) {
+        std::string path;
+        bool hasHeader = true;
+        for (int i = 3; i < argc; i++) {
+            const std::string arg = argv[i];
+            const size_t equals = arg.find('=');
+            if (equals == std::string::npos) {
+                path = unquote(arg);
+                continue;
+            }
+
+            std::string key = arg.substr(0, equals);
+            key.erase(key.find_last_not_of(' ') + 1);
+            const size_t valueStart = arg.find_first_not_of(' ', equals + 1);
+            const std::string value =
+                valueStart == std::string::npos ? "" : unquote(arg.substr(valueStart));
+            if (key == "filename") {
+                path = value;
+            } else if (key == "header") {
+                hasHeader = value == "yes" || value == "true" || value == "1";
+            } else {
+                *error = sqlite3_mprintf("unknown csv option: %s", key.c_str());
+                return SQLITE_ERROR;
+            }
+        }
+        if (path.empty()) {
+            *error = sqlite3_mprintf("csv: a file name is required");
+            return SQLITE_ERROR;
+        }
+
+        auto *table = new CsvVtab();
+        std::vector<std::string> columnNames;
+        std::string message;
+        if (!table->file.open(path, hasHeader, columnNames, message) || columnNames.empty()) {
+            *error = sqlite3_mprintf("csv: %s", message.empty() ? "file has no columns"
+                                                                : message.c_str());
+            delete table;
+            return SQLITE_ERROR;
+        }
+        table->columnCount = columnNames.size();
+
+        std::string schema = "CREATE TABLE x(";
+        for (size_t i = 0; i < columnNames.size(); i++) {
+            schema += (i > 0 ? ", " : "") + SqlScript::quoteIdentifier(columnNames[i]);
+        }
+        schema += ")";
+
+        const int rc = sqlite3_declare_vtab(db, schema.c_str());
+        if (rc != SQLITE_OK) {
+            *error = sqlite3_mprintf("csv: %s", sqlite3_errmsg(db));
+            delete table;
+            return rc;
+        }
+
+        *vtab = table;
+        return SQLITE_OK;
+    }
+
+    int csvDisconnect(sqlite3_vtab *vtab) {
+        delete static_cast<CsvVtab *>(vtab);
+        return SQLITE_OK;
+    }
+
+    int csvBestIndex(sqlite3_vtab *vtab, sqlite3_index_info *info) {
+        const auto *table = static_cast<CsvVtab *>(vtab);
+        const double rows = table->file.estimateRows();
+
+        int rowidConstraint = -1;
+        int offsetConstraint = -1;
+        bool hasFilters = false;
+        for (int i = 0; i < info->nConstraint; i++) {
+            const auto &constraint = info->aConstraint[i];
+#ifdef SQLITE_INDEX_CONSTRAINT_OFFSET
+            if (constraint.op == SQLITE_INDEX_CONSTRAINT_OFFSET) {
+                offsetConstraint = constraint.usable ? i : -1;
+                continue;
+            }
+            if (constraint.op == SQLITE_INDEX_CONSTRAINT_LIMIT) {
+                continue;
+            }
+#endif
+            hasFilters = true;
+            if (constraint.usable && constraint.iColumn == -1 &&
+                constraint.op == SQLITE_INDEX_CONSTRAINT_EQ) {
+                rowidConstraint = i;
+            }
+        }
+        // Rows come out in file order, which is rowid order
+        const bool fileOrder = info->nOrderBy == 0 ||
+                               (info->nOrderBy == 1 && info->aOrderBy[0].iColumn == -1 &&
+                                !info->aOrderBy[0].desc);
+
+        // The offset may only be consumed when SQLite has no filtering or sorting left to do
+        if (hasFilters || !fileOrder) {
+            offsetConstraint = -1;
+        }
+
+        if (rowidConstraint >= 0) {
+            info->idxNum = ROWID_EQ;
+            info->aConstraintUsage[rowidConstraint].argvIndex = 1;
+            info->aConstraintUsage[rowidConstraint].omit = 1;
+            info->estimatedCost = 1.0;
+            info->estimatedRows = 1;
+            info->idxFlags = SQLITE_INDEX_SCAN_UNIQUE;
+        } else if (offsetConstraint >= 0) {
+            // Paging: jump to the first row through the index instead of parsing the skipped ones
+            info->idxNum = OFFSET_SCAN;
+            info->aConstraintUsage[offsetConstraint].argvIndex = 1;
+            info->aConstraintUsage[offsetConstraint].omit = 1;
+            info->estimatedCost = rows;
+            info->estimatedRows = (sqlite3_int64)rows;
+        } else {
+            info->idxNum = FULL_SCAN;
+            info->estimatedCost = rows;
+            info->estimatedRows = (sqlite3_int64)rows;
+        }
+
+        if (info->nOrderBy > 0 && fileOrder) {
+            info->orderByConsumed = 1;
+        }
+        return SQLITE_OK;
+    }
+
+    int csvOpen(sqlite3_vtab *, sqlite3_vtab_cursor **cursor) {
+        *cursor = new CsvCursor();
+        return SQLITE_OK;
+    }
+
+    int csvClose(sqlite3_vtab_cursor *cursor) {
+        delete static_cast<CsvCursor *>(cursor);
+        return SQLITE_OK;
+    }
+
+    void positionCursor(CsvCursor *cursor, const uint64_t row) {
+        auto &file = static_cast<CsvVtab *>(cursor->pVtab)->file;
+        cursor->row = row;
+        cursor->parsed = false;
+        cursor->eof = !file.seek(row, cursor->pos);
+    }
+
+    int csvFilter(sqlite3_vtab_cursor *base, const int idxNum, const char *, int,
+                  sqlite3_value **argv) {
+        auto *cursor = static_cast<CsvCursor *>(base);
+        cursor->single = idxNum == ROWID_EQ;
+
+        if (idxNum == ROWID_EQ) {
+            const sqlite3_int64 rowid = sqlite3_value_int64(argv[0]);
+            if (sqlite3_value_numeric_type(argv[0]) != SQLITE_INTEGER || rowid < 1) {
+                cursor->eof = true;
+                return SQLITE_OK;
+            }
+            positionCursor(cursor, (uint64_t)rowid - 1);
+        } else if (idxNum == OFFSET_SCAN) {
+            positionCursor(cursor, (uint64_t)std::max<sqlite3_int64>(0, sqlite3_value_int64(argv[0])));
+        } else {
+            positionCursor(cursor, 0);
+        }
+        return SQLITE_OK;
+    }
+
+    int csvNext(sqlite3_vtab_cursor *base) {
+        auto *cursor = static_cast<CsvCursor *>(base);
+        auto &file = static_cast<CsvVtab *>(cursor->pVtab)->file;
+        if (cursor->single) {
+            cursor->eof = true;
+            return SQLITE_OK;
+        }
+
+        // Rows skipped by WHERE or OFFSET are never split into fields
+        if (!cursor->parsed) {
+            cursor->next = file.parseRecord(cursor->pos, nullptr);
+        }
+        file.noteRow(cursor->row, cursor->pos, cursor->next);
+
+        cursor->row++;
+        cursor->pos = cursor->next;
+        cursor->parsed = false;
+        cursor->eof = cursor->pos >= file.size();
+        return SQLITE_OK;
+    }
+
+    int csvEof(sqlite3_vtab_cursor *cursor) {
+        return static_cast<CsvCursor *>(cursor)->eof;
+    }
+
+    // Unquoted empty fields are NULL and quoted ones are text, as in PostgreSQL's CSV format
+    int csvColumn(sqlite3_vtab_cursor *base, sqlite3_context *context, const int col) {
+        auto *cursor = static_cast<CsvCursor *>(base);
+        const auto &file = static_cast<CsvVtab *>(cursor->pVtab)->file;
+        if (!cursor->parsed) {
+            cursor->fields.clear();
+            cursor->next = file.parseRecord(cursor->pos, &cursor->fields);
+            cursor->parsed = true;
+        }
+
+        if (col < 0 || (size_t)col >= cursor->fields.size()) {
+            sqlite3_result_null(context);
+            return SQLITE_OK;
+        }
+
+        const Field &field = cursor->fields[col];
+        const char *text = file.data() + field.begin;
+        const size_t length = field.end - field.begin;
+        if (!field.quoted) {
+            if (length == 0) {
+                sqlite3_result_null(context);
+            } else if (!setNumericResult(context, text, length)) {
+                sqlite3_result_text(context, text, (int)length, SQLITE_TRANSIENT);
+            }
+        } else if (!memchr(text, '"', length)) {
+            sqlite3_result_text(context, text, (int)length, SQLITE_TRANSIENT);
+        } else {
+            cursor->buffer.clear();
+            for (size_t i = 0; i < length; i++) {
+                cursor->buffer += text[i];
+                if (text[i] == '"' && i + 1 < length && text[i + 1] == '"') {
+                    i++;
+                }
+            }
+            sqlite3_result_text(context, cursor->buffer.data(), (int)cursor->buffer.size(),
+                                SQLITE_TRANSIENT);
+        }
+        return SQLITE_OK;
+    }
+
+    int csvRowid(sqlite3_vtab_cursor *cursor, sqlite3_int64 *rowid) {
+        *rowid = (sqlite3_int64)static_cast<CsvCursor *>(cursor)->row + 1;
+        return SQLITE_OK;
+    }
+
+    sqlite3_module makeModule() {
+        sqlite3_module module{};
+        module.xCreate = csvConnect;
+        module.xConnect = csvConnect;
+        module.xBestIndex = csvBestIndex;
+        module.xDisconnect = csvDisconnect;
+        module.xDestroy = csvDisconnect;
+        module.xOpen = csvOpen;
+        module.xClose = csvClose;
+        module.xFilter = csvFilter;
+        module.xNext = csvNext;
+        module.xEof = csvEof;
+        module.xColumn = csvColumn;
+        module.xRowid = csvRowid;
+        return module;
+    }
+
+    const sqlite3_module csvModule = makeModule();
+} // namespace
+
+namespace CsvTable {
+    bool registerModule(sqlite3 *db) {
+        return sqlite3_create_module_v2(db, kModuleName, &csvModule, nullptr, nullptr) ==
+               SQLITE_OK;
+    }
+
+    bool isCsvPath(const std::string &path) {
+        if (path.size() < 4) {
+            return false;
+        }
+        std::string extension = path.substr(path.size() - 4);
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        return extension == ".csv";
+    }
+
+    std::string tableNameFor(const std::string &csvPath) {
+        const size_t lastSlash = csvPath.find_last_of("/\\");
+        std::string name = (lastSlash != std::string::npos) ? csvPath.substr(lastSlash + 1) : csvPath;
+        const size_t dot = name.find_last_of('.');
+        if (dot != std::string::npos && dot > 0) {
+            name.erase(dot);
+        }
+        // Keep it a plain identifier, since table names are not always quoted in queries
+        for (char &c : name) {
+            if (!isalnum(static_cast<unsigned char>(c))) {
+                c = '_';
+            }
+        }
+        return name;
+    }
+
+    std::string createTableSql(const std::string &schema, const std::string &tableName,
+                               const std::string &csvPath) {
+        std::string path;
+        for (const char c : csvPath) {
+            path += c;
+            if (c == '\'') {
+                path += '\'';
+            }
+        }
+        return "CREATE VIRTUAL TABLE " + schema + "." + SqlScript::quoteIdentifier(tableName) +
+               " USING " + kModuleName + "('" + path + "')";
+    }
+} // namespace CsvTable
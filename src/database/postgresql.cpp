@@ -1,7 +1,290 @@
 #include "database/postgresql.hpp"
+#include "database/sql_script.hpp"
+#include "database/statement_stats.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
+
+namespace {
+    // Render a result set as text (first 1000 rows)
+    std::string formatResult(const pqxx::result &result) {
+        std::stringstream output;
+
+        if (!result.empty()) {
+            // Headers
+            for (size_t i = 0; i < result.columns(); ++i) {
+                output << result.column_name(i);
+                if (i < result.columns() - 1)
+                    output << " | ";
+            }
+            output << "\n";
+
+            // Separator
+            for (size_t i = 0; i < result.columns(); ++i) {
+                output << "----------";
+                if (i < result.columns() - 1)
+                    output << "-+-";
+            }
+            output << "\n";
+
+            // Data rows (limit to 1000)
+            size_t rowLimit = std::min<size_t>(result.size(), 1000);
+            for (size_t i = 0; i < rowLimit; ++i) {
+                for (size_t j = 0; j < result.columns(); ++j) {
+                    output << (result[i][j].is_null() ? "NULL" : result[i][j].c_str());
+                    if (j < result.columns() - 1)
+                        output << " | ";
+                }
+                output << "\n";
+            }
+
+            if (result.size() > 1000) {
+                output << "\n... (showing first 1000 rows)";
+            }
+        } else {
+            output << "Query executed successfully. Rows affected: " << result.affected_rows();
+        }
+
+        return output.str();
+    }
+
+    // Rows returned, or affected for statements without a result set
+    uint64_t rowsOf(const pqxx::result &result) {
+        return result.columns() > 0 ? result.size() : result.affected_rows();
+    }
+
+    double elapsedMs(const std::chrono::steady_clock::time_point started) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started)
+            .count();
+    }
+
+    std::vector<std::string> columnNamesOf(const pqxx::result &result) {
+        std::vector<std::string> names;
+        for (size_t i = 0; i < result.columns(); ++i) {
+            names.emplace_back(result.column_name(i));
+        }
+        return names;
+    }
+
+    // Hand every row of a result to a sink; false if the sink asked to stop
+    bool emitRows(const pqxx::result &result, RowSink &sink) {
+        RowValues values(result.columns());
+        for (const auto &row : result) {
+            for (size_t i = 0; i < row.size(); ++i) {
+                if (row[i].is_null()) {
+                    values[i].reset();
+                } else {
+                    values[i] = std::string_view(row[i].c_str(), row[i].size());
+                }
+            }
+            if (!sink.row(values)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    TableKind tableKindOf(const char relkind, const bool partition) {
+        if (partition) {
+            return TableKind::PARTITION;
+        }
+        switch (relkind) {
+        case 'v':
+            return TableKind::VIEW;
+        case 'm':
+            return TableKind::MATERIALIZED_VIEW;
+        case 'p':
+            return TableKind::PARTITIONED_TABLE;
+        case 'f':
+            return TableKind::FOREIGN_TABLE;
+        default:
+            return TableKind::TABLE;
+        }
+    }
+
+    // Schemas worth browsing: pg_catalog, pg_toast and the temp schemas all start with pg_
+    constexpr const char *kUserSchemas =
+        "n.nspname !~ '^pg_' AND n.nspname <> 'information_schema'";
+
+    // Parallel reads use at most this many 8 KB heap blocks per chunk
+    constexpr int64_t kMaxChunkBlocks = 8192;
+
+    using SnapshotTransaction =
+        pqxx::transaction<pqxx::isolation_level::repeatable_read, pqxx::write_policy::read_only>;
+
+    // Reads chunks of one table on pooled connections. The coordinating transaction exports its
+    // snapshot and stays open for the reader's lifetime, and every chunk imports it, so all
+    // chunks see exactly the same rows.
+    class PostgresParallelReader : public ParallelReader {
+    public:
+        PostgresParallelReader(std::string connectionString,
+                               std::unique_ptr<pqxx::connection> coordinator,
+                               std::unique_ptr<pqxx::transaction_base> snapshotTransaction,
+                               std::string snapshotId, std::vector<std::string> queries)
+            : connectionString(std::move(connectionString)), coordinator(std::move(coordinator)),
+              snapshotTransaction(std::move(snapshotTransaction)),
+              snapshotId(std::move(snapshotId)), queries(std::move(queries)) {}
+
+        size_t getChunkCount() const override {
+            return queries.size();
+        }
+
+        StatementResult readChunk(const size_t index, RowSink &sink) override {
+            const auto started = std::chrono::steady_clock::now();
+            StatementResult result;
+            result.sql = queries[index];
+            result.executed = true;
+
+            std::unique_ptr<pqxx::connection> conn;
+            bool begun = false;
+            try {
+                conn = acquire();
+                SnapshotTransaction txn(*conn);
+                txn.exec("SET TRANSACTION SNAPSHOT " + txn.quote(snapshotId));
+                txn.exec("DECLARE dearsql_chunk NO SCROLL CURSOR FOR " + result.sql);
+                while (true) {
+                    const pqxx::result batch = txn.exec("FETCH FORWARD 10000 FROM dearsql_chunk");
+                    if (!begun) {
+                        sink.begin(columnNamesOf(batch));
+                        begun = true;
+                    }
+                    if (!emitRows(batch, sink) || batch.size() < 10000) {
+                        break;
+                    }
+                }
+                sink.end();
+                txn.commit();
+                result.success = true;
+            } catch (const std::exception &e) {
+                if (begun) {
+                    sink.end();
+                }
+                result.error = e.what();
+            }
+
+            if (conn && conn->is_open()) {
+                release(std::move(conn));
+            }
+            result.elapsedMs = elapsedMs(started);
+            return result;
+        }
+
+    private:
+        std::string connectionString;
+        std::unique_ptr<pqxx::connection> coordinator;
+        std::unique_ptr<pqxx::transaction_base> snapshotTransaction;
+        std::string snapshotId;
+        std::vector<std::string> queries;
+        std::mutex poolMutex;
+        std::vector<std::unique_ptr<pqxx::connection>> idle;
+
+        std::unique_ptr<pqxx::connection> acquire() {
+            {
+                std::lock_guard<std::mutex> lock(poolMutex);
+                if (!idle.empty()) {
+                    auto conn = std::move(idle.back());
+                    idle.pop_back();
+                    return conn;
+                }
+            }
+            return std::make_unique<pqxx::connection>(connectionString);
+        }
+
+        void release(std::unique_ptr<pqxx::connection> conn) {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            idle.push_back(std::move(conn));
+        }
+    };
+
+    // Fills a freshly created table with COPY on its own connection, so the main connection
+    // stays usable while a copy runs. Table creation and rows share one transaction.
+    class PostgresTableWriter : public TableWriter {
+    public:
+        bool begin(const std::string &connectionString, const std::string &tableName,
+                   const std::vector<Column> &columns) {
+            try {
+                conn = std::make_unique<pqxx::connection>(connectionString);
+                txn = std::make_unique<pqxx::work>(*conn);
+
+                const std::string table = txn->quote_name(tableName);
+                std::string create = "CREATE TABLE " + table + " (";
+                std::string columnList;
+                std::string primaryKey;
+                for (size_t i = 0; i < columns.size(); i++) {
+                    const std::string name = txn->quote_name(columns[i].name);
+                    create += (i > 0 ? ", " : "") + name + " " + columns[i].type;
+                    if (columns[i].isNotNull) {
+                        create += " NOT NULL";
+                    }
+                    if (columns[i].isPrimaryKey) {
+                        primaryKey += (primaryKey.empty() ? "" : ", ") + name;
+                    }
+                    columnList += (i > 0 ? ", " : "") + name;
+                }
+                if (!primaryKey.empty()) {
+                    create += ", PRIMARY KEY (" + primaryKey + ")";
+                }
+                txn->exec(create + ")");
+
+                stream = std::make_unique<pqxx::stream_to>(
+                    pqxx::stream_to::raw_table(*txn, table, columnList));
+                return true;
+            } catch (const std::exception &e) {
+                error = e.what();
+                return false;
+            }
+        }
+
+        bool writeRow(const RowValues &values) override {
+            try {
+                stream->write_row(values);
+                return true;
+            } catch (const std::exception &e) {
+                error = e.what();
+                return false;
+            }
+        }
+
+        bool commit() override {
+            try {
+                stream->complete();
+                txn->commit();
+                return true;
+            } catch (const std::exception &e) {
+                error = e.what();
+                return false;
+            }
+        }
+
+    private:
+        // Destroyed in reverse order: the stream ends, then the uncommitted transaction aborts
+        std::unique_ptr<pqxx::connection> conn;
+        std::unique_ptr<pqxx::work> txn;
+        std::unique_ptr<pqxx::stream_to> stream;
+    };
+} // namespace
+
+// Records the progress of a call on the main connection for as long as the call runs
+class PostgreSQLDatabase::RunningScope {
+public:
+    RunningScope(PostgreSQLDatabase &owner, const QueryProgress *progress) : owner(owner) {
+        std::lock_guard<std::mutex> lock(owner.runningMutex);
+        owner.runningProgress = progress;
+    }
+    ~RunningScope() {
+        std::lock_guard<std::mutex> lock(owner.runningMutex);
+        owner.runningProgress = nullptr;
+    }
+
+    RunningScope(const RunningScope &) = delete;
+    RunningScope &operator=(const RunningScope &) = delete;
+
+private:
+    PostgreSQLDatabase &owner;
+};
 
 PostgreSQLDatabase::PostgreSQLDatabase(const std::string &name, const std::string &host, int port,
                                        const std::string &database, const std::string &username,
@@ -21,12 +304,14 @@ PostgreSQLDatabase::~PostgreSQLDatabase() {
 }
 
 bool PostgreSQLDatabase::connect() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     if (connected && connection) {
         return true;
     }
 
     try {
         connection = std::make_unique<pqxx::connection>(connectionString);
+        backendPid = connection->backendpid();
         std::cout << "Successfully connected to PostgreSQL database: " << database << std::endl;
         connected = true;
         return true;
@@ -39,10 +324,15 @@ bool PostgreSQLDatabase::connect() {
 }
 
 void PostgreSQLDatabase::disconnect() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     if (connection) {
         connection.reset();
     }
     connected = false;
+    backendPid = 0;
+
+    std::lock_guard<std::mutex> monitorLock(monitorMutex);
+    monitorConnection.reset();
 }
 
 bool PostgreSQLDatabase::isConnected() const {
@@ -66,6 +356,7 @@ DatabaseType PostgreSQLDatabase::getType() const {
 }
 
 void PostgreSQLDatabase::refreshTables() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     std::cout << "Refreshing tables for database: " << name << std::endl;
     if (!connect()) {
         std::cout << "Failed to connect to database" << std::endl;
@@ -73,19 +364,170 @@ void PostgreSQLDatabase::refreshTables() {
         return;
     }
 
-    tables.clear();
-    std::vector<std::string> tableNames = getTableNames();
-    std::cout << "Found " << tableNames.size() << " tables" << std::endl;
+    // Schemas that were browsed stay loaded; the first refresh opens public
+    std::vector<std::string> previous;
+    for (const auto &schema : schemas) {
+        if (schema.loaded) {
+            previous.push_back(schema.name);
+        }
+    }
+    if (schemas.empty()) {
+        previous.push_back("public");
+    }
 
-    for (const auto &tableName : tableNames) {
-        std::cout << "Adding table: " << tableName << std::endl;
-        Table table;
-        table.name = tableName;
-        table.columns = getTableColumns(tableName);
-        tables.push_back(table);
+    schemas.clear();
+    tables.clear();
+    std::vector<std::string> reload;
+    try {
+        pqxx::work txn(*connection);
+        const std::string sql = std::string("SELECT n.nspname FROM pg_namespace n WHERE ") +
+                                kUserSchemas + " ORDER BY n.nspname";
+        for (const auto &row : txn.exec(sql)) {
+            schemas.push_back({row[0].c_str(), false});
+            if (std::find(previous.begin(), previous.end(), schemas.back().name) !=
+                previous.end()) {
+                reload.push_back(schemas.back().name);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error listing schemas: " << e.what() << std::endl;
     }
-    std::cout << "Finished refreshing tables. Total tables: " << tables.size() << std::endl;
+
+    fetchSchemas(reload);
+    std::cout << "Finished refreshing tables. " << schemas.size() << " schemas, "
+              << tables.size() << " tables loaded" << std::endl;
     tablesLoaded = true;
+    schemaGeneration++;
+}
+
+void PostgreSQLDatabase::fetchSchemas(const std::vector<std::string> &names) {
+    if (names.empty()) {
+        indexTables();
+        return;
+    }
+
+    std::vector<Table> fetched;
+    std::unordered_map<std::string, std::string> fetchedSignatures;
+    try {
+        pqxx::work txn(*connection);
+        std::string list;
+        for (const auto &schema : names) {
+            list += (list.empty() ? "" : ", ") + txn.quote(schema);
+        }
+        // Signatures first: DDL in between makes them look stale, never the tables
+        const std::string condition = "n.nspname IN (" + list + ")";
+        fetchedSignatures = readSignatures(txn, condition);
+        fetched = fetchTables(txn, condition);
+    } catch (const std::exception &e) {
+        std::cerr << "Error loading schemas: " << e.what() << std::endl;
+        indexTables();
+        return;
+    }
+
+    // The fetched schemas replace whatever was listed for them before
+    const auto inFetchedSchema = [&names](const Table &table) {
+        return std::find(names.begin(), names.end(), table.schema) != names.end();
+    };
+    {
+        std::lock_guard<std::mutex> lock(catalogMutex);
+        for (const auto &table : tables) {
+            if (inFetchedSchema(table)) {
+                signatures.erase(table.getQualifiedName());
+            }
+        }
+        for (auto &entry : fetchedSignatures) {
+            signatures[entry.first] = std::move(entry.second);
+        }
+    }
+    tables.erase(std::remove_if(tables.begin(), tables.end(), inFetchedSchema), tables.end());
+    tables.insert(tables.end(), std::make_move_iterator(fetched.begin()),
+                  std::make_move_iterator(fetched.end()));
+    std::sort(tables.begin(), tables.end(), [](const Table &a, const Table &b) {
+        return a.schema != b.schema ? a.schema < b.schema : a.name < b.name;
+    });
+    for (auto &schema : schemas) {
+        if (std::find(names.begin(), names.end(), schema.name) != names.end()) {
+            schema.loaded = true;
+        }
+    }
+    indexTables();
+}
+
+std::vector<Table> PostgreSQLDatabase::fetchTables(pqxx::transaction_base &txn,
+                                                   const std::string &condition) {
+    // One round trip for every relation and the columns of the tables among them. Views and
+    // partitions are listed without columns; those are fetched when needed.
+    const std::string sql =
+        "SELECT n.nspname, c.relname, c.relkind, c.relispartition, "
+        "pn.nspname || '.' || p.relname, a.attname, format_type(a.atttypid, a.atttypmod), "
+        "a.attnotnull, i.indisprimary IS NOT NULL "
+        "FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace "
+        "LEFT JOIN pg_inherits h ON c.relispartition AND h.inhrelid = c.oid "
+        "LEFT JOIN pg_class p ON p.oid = h.inhparent "
+        "LEFT JOIN pg_namespace pn ON pn.oid = p.relnamespace "
+        "LEFT JOIN pg_attribute a ON a.attrelid = c.oid AND a.attnum > 0 "
+        "AND NOT a.attisdropped AND c.relkind IN ('r', 'p', 'f') AND NOT c.relispartition "
+        "LEFT JOIN pg_index i ON i.indrelid = c.oid AND i.indisprimary "
+        "AND a.attnum = ANY(i.indkey) "
+        "WHERE " + condition + " AND c.relkind IN ('r', 'v', 'm', 'p', 'f') "
+        "ORDER BY n.nspname, c.relname, a.attnum";
+    const pqxx::result result = txn.exec(sql);
+
+    std::vector<Table> fetched;
+    for (const auto &row : result) {
+        if (fetched.empty() || fetched.back().schema != row[0].c_str() ||
+            fetched.back().name != row[1].c_str()) {
+            Table table;
+            table.schema = row[0].c_str();
+            table.name = row[1].c_str();
+            const bool partition = row[3].as<bool>();
+            table.kind = tableKindOf(row[2].c_str()[0], partition);
+            if (!row[4].is_null()) {
+                table.parent = row[4].c_str();
+            }
+            table.columnsLoaded = !partition && table.kind != TableKind::VIEW &&
+                                  table.kind != TableKind::MATERIALIZED_VIEW;
+            fetched.push_back(std::move(table));
+        }
+        if (!row[5].is_null()) {
+            Column column;
+            column.name = row[5].c_str();
+            column.type = row[6].c_str();
+            column.isNotNull = row[7].as<bool>();
+            column.isPrimaryKey = row[8].as<bool>();
+            fetched.back().columns.push_back(std::move(column));
+        }
+    }
+    return fetched;
+}
+
+std::unordered_map<std::string, std::string>
+PostgreSQLDatabase::readSignatures(pqxx::transaction_base &txn, const std::string &condition) {
+    // Any DDL on a relation inserts, updates or deletes its pg_class row or one of its attribute
+    // or index rows, which moves the row's xmin or the sums
+    const std::string sql =
+        "SELECT n.nspname || '.' || c.relname, c.xmin::text || ':' || "
+        "(SELECT COALESCE(sum(a.xmin::text::bigint), 0) FROM pg_attribute a "
+        "WHERE a.attrelid = c.oid AND a.attnum > 0)::text || ':' || "
+        "(SELECT COALESCE(sum(i.xmin::text::bigint), 0) FROM pg_index i "
+        "WHERE i.indrelid = c.oid)::text "
+        "FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace "
+        "WHERE " + condition + " AND c.relkind IN ('r', 'v', 'm', 'p', 'f')";
+
+    std::unordered_map<std::string, std::string> result;
+    for (const auto &row : txn.exec(sql)) {
+        result[row[0].c_str()] = row[1].c_str();
+    }
+    return result;
+}
+
+void PostgreSQLDatabase::indexTables() {
+    std::lock_guard<std::mutex> lock(catalogMutex);
+    quotedNames.clear();
+    for (const auto &table : tables) {
+        quotedNames[table.getQualifiedName()] =
+            SqlScript::quoteIdentifier(table.schema) + "." + SqlScript::quoteIdentifier(table.name);
+    }
 }
 
 const std::vector<Table> &PostgreSQLDatabase::getTables() const {
@@ -104,71 +546,491 @@ void PostgreSQLDatabase::setTablesLoaded(bool loaded) {
     tablesLoaded = loaded;
 }
 
+uint64_t PostgreSQLDatabase::getSchemaGeneration() const {
+    return schemaGeneration;
+}
+
+const std::vector<Schema> &PostgreSQLDatabase::getSchemas() const {
+    return schemas;
+}
+
+SchemaPatch PostgreSQLDatabase::fetchSchema(const std::string &schema) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    SchemaPatch patch;
+    patch.generation = schemaGeneration;
+    if (!connect()) {
+        patch.error = "Not connected";
+        return patch;
+    }
+
+    std::vector<Schema> listed;
+    {
+        std::lock_guard<std::mutex> catalogLock(catalogMutex);
+        listed = schemas;
+    }
+    const auto it = std::find_if(listed.begin(), listed.end(),
+                                 [&schema](const Schema &s) { return s.name == schema; });
+    if (it == listed.end()) {
+        patch.error = "Schema " + schema + " no longer exists";
+        return patch;
+    }
+    if (it->loaded) {
+        return patch;
+    }
+
+    try {
+        pqxx::work txn(*connection);
+        // Signatures first: DDL in between makes them look stale, never the tables
+        const std::string condition = "n.nspname = " + txn.quote(schema);
+        const auto fetchedSignatures = readSignatures(txn, condition);
+        patch.changed = fetchTables(txn, condition);
+        for (const auto &table : patch.changed) {
+            const auto signature = fetchedSignatures.find(table.getQualifiedName());
+            patch.signatures.push_back(
+                signature != fetchedSignatures.end() ? signature->second : std::string());
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error loading schema " << schema << ": " << e.what() << std::endl;
+        patch.error = e.what();
+        patch.changed.clear();
+        patch.signatures.clear();
+        return patch;
+    }
+    it->loaded = true;
+    patch.schemas = std::move(listed);
+    return patch;
+}
+
+bool PostgreSQLDatabase::loadTableColumns(const std::string &tableName) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    const auto it = std::find_if(tables.begin(), tables.end(), [&tableName](const Table &table) {
+        return table.getQualifiedName() == tableName;
+    });
+    if (it == tables.end()) {
+        return false;
+    }
+    if (it->columnsLoaded) {
+        return true;
+    }
+    if (!connect()) {
+        return false;
+    }
+    it->columns = getTableColumns(tableName);
+    it->columnsLoaded = true;
+    schemaGeneration++;
+    return true;
+}
+
+std::string PostgreSQLDatabase::quoteTableName(const std::string &tableName) const {
+    // Names that are not listed are taken as a single identifier
+    std::lock_guard<std::mutex> lock(catalogMutex);
+    const auto it = quotedNames.find(tableName);
+    return it != quotedNames.end() ? it->second : SqlScript::quoteIdentifier(tableName);
+}
+
+std::string PostgreSQLDatabase::getSchemaToken() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    if (!connect()) {
+        return "";
+    }
+
+    // Row count and xmin sum of the user schemas, their relations and those relations' attributes
+    // and indexes. Polling this is cheaper to set up than LISTEN fed by an event trigger, which
+    // only a superuser may create.
+    const auto summary = [](const std::string &alias, const std::string &from) {
+        return "(SELECT count(*) || ':' || COALESCE(sum(" + alias +
+               ".xmin::text::bigint), 0) FROM " + from + ")";
+    };
+    const std::string relations =
+        std::string("SELECT c.oid FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace "
+                    "WHERE ") +
+        kUserSchemas + " AND c.relkind IN ('r', 'v', 'm', 'p', 'f')";
+    const std::string sql =
+        "SELECT " + summary("n", std::string("pg_namespace n WHERE ") + kUserSchemas) +
+        " || '/' || " + summary("r", "pg_class r WHERE r.oid IN (" + relations + ")") +
+        " || '/' || " +
+        summary("a", "pg_attribute a WHERE a.attnum > 0 AND a.attrelid IN (" + relations + ")") +
+        " || '/' || " + summary("i", "pg_index i WHERE i.indrelid IN (" + relations + ")");
+
+    try {
+        pqxx::nontransaction txn(*connection);
+        const pqxx::result result = txn.exec(sql);
+        if (!result.empty() && !result[0][0].is_null()) {
+            return result[0][0].c_str();
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error reading schema token: " << e.what() << std::endl;
+    }
+    return "";
+}
+
+SchemaPatch PostgreSQLDatabase::diffSchema() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    SchemaPatch patch;
+    patch.generation = schemaGeneration;
+    if (!connect()) {
+        patch.error = "Not connected";
+        return patch;
+    }
+
+    std::vector<Schema> listed;
+    std::unordered_map<std::string, std::string> known;
+    {
+        std::lock_guard<std::mutex> catalogLock(catalogMutex);
+        listed = schemas;
+        known = signatures;
+    }
+
+    try {
+        pqxx::work txn(*connection);
+        std::vector<Schema> current;
+        std::string loaded;
+        const std::string sql = std::string("SELECT n.nspname FROM pg_namespace n WHERE ") +
+                                kUserSchemas + " ORDER BY n.nspname";
+        for (const auto &row : txn.exec(sql)) {
+            const std::string schemaName = row[0].c_str();
+            const auto it = std::find_if(
+                listed.begin(), listed.end(),
+                [&schemaName](const Schema &schema) { return schema.name == schemaName; });
+            current.push_back({schemaName, it != listed.end() && it->loaded});
+            if (current.back().loaded) {
+                loaded += (loaded.empty() ? "" : ", ") + txn.quote(current.back().name);
+            }
+        }
+        if (!std::equal(current.begin(), current.end(), listed.begin(), listed.end(),
+                        [](const Schema &a, const Schema &b) { return a.name == b.name; })) {
+            patch.schemas = std::move(current);
+        }
+
+        // Only loaded schemas have their tables listed, so only those are compared. Tables of
+        // a dropped schema are left in known and so count as removed.
+        std::unordered_map<std::string, std::string> stale;
+        if (!loaded.empty()) {
+            for (auto &entry : readSignatures(txn, "n.nspname IN (" + loaded + ")")) {
+                const auto it = known.find(entry.first);
+                const bool unchanged = it != known.end() && it->second == entry.second;
+                if (it != known.end()) {
+                    known.erase(it);
+                }
+                if (!unchanged) {
+                    stale.insert(std::move(entry));
+                }
+            }
+        }
+        for (const auto &entry : known) {
+            patch.removed.push_back(entry.first);
+        }
+
+        if (!stale.empty()) {
+            std::string list;
+            for (const auto &entry : stale) {
+                list += (list.empty() ? "" : ", ") + txn.quote(entry.first);
+            }
+            patch.changed = fetchTables(txn, "n.nspname || '.' || c.relname IN (" + list + ")");
+            for (const auto &table : patch.changed) {
+                patch.signatures.push_back(stale[table.getQualifiedName()]);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error comparing schemas: " << e.what() << std::endl;
+        SchemaPatch failed;
+        failed.generation = patch.generation;
+        failed.error = e.what();
+        return failed;
+    }
+    return patch;
+}
+
+bool PostgreSQLDatabase::applySchemaPatch(SchemaPatch patch) {
+    if (patch.generation != schemaGeneration || !patch.error.empty()) {
+        return false;
+    }
+    if (patch.isEmpty()) {
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(catalogMutex);
+        for (const auto &tableName : patch.removed) {
+            signatures.erase(tableName);
+        }
+        for (size_t i = 0; i < patch.changed.size(); i++) {
+            signatures[patch.changed[i].getQualifiedName()] = patch.signatures[i];
+        }
+        if (patch.schemas) {
+            schemas = std::move(*patch.schemas);
+        }
+    }
+
+    // Replaced tables stay expanded if they were
+    std::unordered_map<std::string, bool> replaced;
+    for (const auto &tableName : patch.removed) {
+        replaced[tableName] = false;
+    }
+    for (const auto &table : patch.changed) {
+        replaced[table.getQualifiedName()] = false;
+    }
+    for (const auto &table : tables) {
+        const auto it = replaced.find(table.getQualifiedName());
+        if (it != replaced.end()) {
+            it->second = it->second || table.expanded;
+        }
+    }
+    tables.erase(std::remove_if(tables.begin(), tables.end(),
+                                [&replaced](const Table &table) {
+                                    return replaced.count(table.getQualifiedName()) > 0;
+                                }),
+                 tables.end());
+    for (auto &table : patch.changed) {
+        table.expanded = replaced[table.getQualifiedName()];
+        tables.push_back(std::move(table));
+    }
+    std::sort(tables.begin(), tables.end(), [](const Table &a, const Table &b) {
+        return a.schema != b.schema ? a.schema < b.schema : a.name < b.name;
+    });
+    indexTables();
+    schemaGeneration++;
+    return true;
+}
+
 std::string PostgreSQLDatabase::executeQuery(const std::string &query) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     if (!connect()) {
         return "Error: Failed to connect to database";
     }
 
     try {
+        const auto started = std::chrono::steady_clock::now();
         pqxx::work txn(*connection);
         pqxx::result result = txn.exec(query);
+        std::string output = formatResult(result);
+        txn.commit();
+        StatementStats::record(name, query, elapsedMs(started), rowsOf(result));
+        return output;
+    } catch (const std::exception &e) {
+        return "Error: " + std::string(e.what());
+    }
+}
 
-        std::stringstream output;
+std::vector<StatementResult> PostgreSQLDatabase::executeScript(const std::string &script,
+                                                               QueryProgress *progress) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    std::vector<StatementResult> results;
+    if (!connect()) {
+        StatementResult failure;
+        failure.sql = script;
+        failure.error = "Failed to connect to database";
+        results.push_back(failure);
+        return results;
+    }
 
-        if (!result.empty()) {
-            // Headers
-            for (size_t i = 0; i < result.columns(); ++i) {
-                output << result.column_name(i);
-                if (i < result.columns() - 1)
-                    output << " | ";
-            }
-            output << "\n";
+    const auto statements = SqlScript::splitStatements(script);
+    for (const auto &sql : statements) {
+        StatementResult result;
+        result.sql = sql;
+        results.push_back(result);
+    }
 
-            // Separator
-            for (size_t i = 0; i < result.columns(); ++i) {
-                output << "----------";
-                if (i < result.columns() - 1)
-                    output << "-+-";
+    // Cancelled while it waited for the connection
+    const RunningScope running(*this, progress);
+    if (progress && progress->cancelRequested) {
+        for (auto &result : results) {
+            result.error = "Cancelled";
+        }
+        return results;
+    }
+
+    try {
+        // Scripts with their own BEGIN/COMMIT can't run inside a pqxx::work
+        std::unique_ptr<pqxx::transaction_base> txn;
+        if (SqlScript::managesTransactions(statements)) {
+            txn = std::make_unique<pqxx::nontransaction>(*connection);
+        } else {
+            txn = std::make_unique<pqxx::work>(*connection);
+        }
+
+        bool failed = false;
+        {
+            // Queue statements so they go to the server in batches rather than one round
+            // trip each. Timings are measured as each result arrives on the client.
+            pqxx::pipeline pipe(*txn);
+            pipe.retain(64);
+
+            std::vector<pqxx::pipeline::query_id> ids;
+            ids.reserve(statements.size());
+            for (const auto &sql : statements) {
+                ids.push_back(pipe.insert(sql));
             }
-            output << "\n";
 
-            // Data rows (limit to 1000)
-            size_t rowLimit = std::min(result.size(), 1000);
-            for (size_t i = 0; i < rowLimit; ++i) {
-                for (size_t j = 0; j < result.columns(); ++j) {
-                    output << (result[i][j].is_null() ? "NULL" : result[i][j].c_str());
-                    if (j < result.columns() - 1)
-                        output << " | ";
+            auto previous = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < ids.size(); i++) {
+                auto &result = results[i];
+                if (failed) {
+                    result.error = "Skipped: an earlier statement failed";
+                    continue;
+                }
+                if (progress && progress->cancelRequested) {
+                    result.error = "Cancelled";
+                    failed = true;
+                    continue;
+                }
+
+                result.executed = true;
+                uint64_t rows = 0;
+                try {
+                    const pqxx::result rowsResult = pipe.retrieve(ids[i]);
+                    result.output = formatResult(rowsResult);
+                    rows = rowsOf(rowsResult);
+                    result.success = true;
+                } catch (const std::exception &e) {
+                    result.error = e.what();
+                    failed = true;
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                result.elapsedMs = std::chrono::duration<double, std::milli>(now - previous).count();
+                previous = now;
+                if (result.success) {
+                    StatementStats::record(name, result.sql, result.elapsedMs, rows);
                 }
-                output << "\n";
             }
+        }
 
-            if (result.size() > 1000) {
-                output << "\n... (showing first 1000 rows)";
+        if (!failed) {
+            txn->commit();
+        }
+    } catch (const std::exception &e) {
+        for (auto &result : results) {
+            if (!result.executed) {
+                result.error = "Error: " + std::string(e.what());
             }
-        } else {
-            output << "Query executed successfully. Rows affected: " << result.affected_rows();
         }
+    }
 
-        return output.str();
+    return results;
+}
+
+StatementResult PostgreSQLDatabase::streamQuery(const std::string &query, RowSink &sink,
+                                                QueryProgress *progress) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    StatementResult result;
+    result.sql = query;
+    if (!connect()) {
+        result.error = "Failed to connect to database";
+        return result;
+    }
+
+    // Cancelled while it waited for the connection
+    const RunningScope running(*this, progress);
+    if (progress && progress->cancelRequested) {
+        result.error = "Cancelled";
+        return result;
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    result.executed = true;
+
+    const std::string keyword = SqlScript::firstKeyword(query);
+    const bool useCursor =
+        keyword == "SELECT" || keyword == "WITH" || keyword == "VALUES" || keyword == "TABLE";
+    bool begun = false;
+    uint64_t rowCount = 0;
+
+    try {
+        pqxx::work txn(*connection);
+        if (useCursor) {
+            // Read through a server-side cursor so the whole result never sits in client memory
+            txn.exec("DECLARE dearsql_stream NO SCROLL CURSOR FOR " + SqlScript::trim(query));
+            while (true) {
+                pqxx::result batch = txn.exec("FETCH FORWARD 10000 FROM dearsql_stream");
+                if (!begun) {
+                    sink.begin(columnNamesOf(batch));
+                    begun = true;
+                }
+                rowCount += batch.size();
+                if (progress) {
+                    progress->rows += batch.size();
+                }
+                if (!emitRows(batch, sink) || batch.size() < 10000) {
+                    break;
+                }
+                if (progress && progress->cancelRequested) {
+                    throw std::runtime_error("Cancelled after " +
+                                             std::to_string(progress->rows.load()) + " rows");
+                }
+            }
+            txn.exec("CLOSE dearsql_stream");
+            sink.end();
+        } else {
+            pqxx::result rows = txn.exec(query);
+            rowCount = rowsOf(rows);
+            if (progress) {
+                progress->rows += rows.size();
+            }
+            if (rows.columns() > 0) {
+                sink.begin(columnNamesOf(rows));
+                begun = true;
+                emitRows(rows, sink);
+                sink.end();
+            } else {
+                result.output = "Query executed successfully. Rows affected: " +
+                                std::to_string(rows.affected_rows());
+            }
+        }
+        txn.commit();
+        result.success = true;
     } catch (const std::exception &e) {
-        return "Error: " + std::string(e.what());
+        if (begun) {
+            sink.end();
+        }
+        result.error = e.what();
+
+        // Data-modifying CTEs can't be declared as cursors; run them directly instead
+        if (keyword == "WITH" && !begun && !(progress && progress->cancelRequested)) {
+            try {
+                pqxx::work txn(*connection);
+                pqxx::result rows = txn.exec(query);
+                rowCount = rowsOf(rows);
+                if (rows.columns() > 0) {
+                    sink.begin(columnNamesOf(rows));
+                    emitRows(rows, sink);
+                    sink.end();
+                } else {
+                    result.output = "Query executed successfully. Rows affected: " +
+                                    std::to_string(rows.affected_rows());
+                }
+                txn.commit();
+                result.error.clear();
+                result.success = true;
+            } catch (const std::exception &retryError) {
+                result.error = retryError.what();
+            }
+        }
+    }
+
+    result.elapsedMs = elapsedMs(started);
+    if (result.success) {
+        StatementStats::record(name, query, result.elapsedMs, rowCount);
     }
+    return result;
 }
 
 std::vector<std::vector<std::string>> PostgreSQLDatabase::getTableData(const std::string &tableName,
                                                                        int limit, int offset) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     std::vector<std::vector<std::string>> data;
     if (!connect()) {
         return data;
     }
 
     try {
+        const auto started = std::chrono::steady_clock::now();
         pqxx::work txn(*connection);
-        std::string sql = "SELECT * FROM " + txn.quote_name(tableName) + " LIMIT " +
+        std::string sql = "SELECT * FROM " + quoteTableName(tableName) + " LIMIT " +
                           std::to_string(limit) + " OFFSET " + std::to_string(offset);
 
         pqxx::result result = txn.exec(sql);
+        StatementStats::record(name, sql, elapsedMs(started), result.size());
 
         for (const auto &row : result) {
             std::vector<std::string> rowData;
@@ -185,6 +1047,7 @@ std::vector<std::vector<std::string>> PostgreSQLDatabase::getTableData(const std
 }
 
 std::vector<std::string> PostgreSQLDatabase::getColumnNames(const std::string &tableName) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     std::vector<std::string> columnNames;
     if (!connect()) {
         return columnNames;
@@ -192,8 +1055,9 @@ std::vector<std::string> PostgreSQLDatabase::getColumnNames(const std::string &t
 
     try {
         pqxx::work txn(*connection);
-        std::string sql = "SELECT column_name FROM information_schema.columns WHERE table_name = " +
-                          txn.quote(tableName) + " ORDER BY ordinal_position";
+        std::string sql = "SELECT attname FROM pg_attribute WHERE attrelid = " +
+                          txn.quote(quoteTableName(tableName)) +
+                          "::regclass AND attnum > 0 AND NOT attisdropped ORDER BY attnum";
 
         pqxx::result result = txn.exec(sql);
 
@@ -208,13 +1072,14 @@ std::vector<std::string> PostgreSQLDatabase::getColumnNames(const std::string &t
 }
 
 int PostgreSQLDatabase::getRowCount(const std::string &tableName) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     if (!connect()) {
         return 0;
     }
 
     try {
         pqxx::work txn(*connection);
-        std::string sql = "SELECT COUNT(*) FROM " + txn.quote_name(tableName);
+        std::string sql = "SELECT COUNT(*) FROM " + quoteTableName(tableName);
         pqxx::result result = txn.exec(sql);
 
         if (!result.empty()) {
@@ -227,6 +1092,29 @@ int PostgreSQLDatabase::getRowCount(const std::string &tableName) {
     return 0;
 }
 
+std::string PostgreSQLDatabase::getChangeToken() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    if (!connect()) {
+        return "";
+    }
+
+    // Row change counters of all user tables; they lag commits by up to a second, which the
+    // result cache covers with a TTL
+    try {
+        pqxx::nontransaction txn(*connection);
+        const pqxx::result result =
+            txn.exec("SELECT COALESCE(SUM(n_tup_ins + n_tup_upd + n_tup_del), 0)::text || ':' || "
+                     "COUNT(*)::text FROM pg_stat_user_tables");
+        if (!result.empty() && !result[0][0].is_null()) {
+            return result[0][0].c_str();
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error reading change counters: " << e.what() << std::endl;
+    }
+
+    return "";
+}
+
 bool PostgreSQLDatabase::isExpanded() const {
     return expanded;
 }
@@ -239,47 +1127,237 @@ void *PostgreSQLDatabase::getConnection() const {
     return connection.get();
 }
 
-std::vector<std::string> PostgreSQLDatabase::getTableNames() {
-    std::vector<std::string> tableNames;
+QueryPlan PostgreSQLDatabase::explainQuery(const std::string &query, const bool analyze) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    QueryPlan plan;
+    plan.sql = query;
+    if (!connect()) {
+        plan.error = "Failed to connect to database";
+        return plan;
+    }
 
     try {
+        // Never committed: EXPLAIN ANALYZE really runs the statement, so writes are undone
         pqxx::work txn(*connection);
-        std::string sql =
-            "SELECT tablename FROM pg_tables WHERE schemaname = 'public' ORDER BY tablename";
+        const std::string options = analyze ? "(ANALYZE, BUFFERS, FORMAT JSON)" : "(FORMAT JSON)";
+        const pqxx::result result = txn.exec("EXPLAIN " + options + " " + query);
+        if (result.empty() || result[0][0].is_null()) {
+            plan.error = "EXPLAIN returned no plan";
+            return plan;
+        }
 
-        std::cout << "Executing query to get table names..." << std::endl;
-        pqxx::result result = txn.exec(sql);
+        plan = QueryPlanParser::fromPostgresJson(result[0][0].c_str());
+        plan.sql = query;
+        QueryPlanParser::annotate(plan, [&txn](const std::string &relation) {
+            const pqxx::result rows = txn.exec(
+                "SELECT reltuples FROM pg_class WHERE oid = to_regclass(" + txn.quote(relation) +
+                ")");
+            // reltuples is -1 (or 0 before PostgreSQL 14) until the table is analyzed
+            if (rows.empty() || rows[0][0].is_null()) {
+                return -1.0;
+            }
+            const double tuples = rows[0][0].as<double>();
+            return tuples > 0.0 ? tuples : -1.0;
+        });
+    } catch (const std::exception &e) {
+        plan.error = e.what();
+    }
+    return plan;
+}
 
-        for (const auto &row : result) {
-            std::string tableName = row[0].c_str();
-            std::cout << "Found table: " << tableName << std::endl;
-            tableNames.push_back(tableName);
+std::unique_ptr<ParallelReader>
+PostgreSQLDatabase::beginParallelRead(const std::string &tableName, const size_t minChunks,
+                                      std::string &error) {
+    try {
+        auto coordinator = std::make_unique<pqxx::connection>(connectionString);
+        auto txn = std::make_unique<SnapshotTransaction>(*coordinator);
+        const auto snapshotId = txn->query_value<std::string>("SELECT pg_export_snapshot()");
+        const std::string table = quoteTableName(tableName);
+        const std::string relation = txn->quote(table) + "::regclass";
+
+        std::vector<std::string> queries;
+        auto addRanges = [&](const std::string &key, const int64_t first, const int64_t last,
+                             const int64_t perChunkLimit, const auto &bound) {
+            const auto span = static_cast<uint64_t>(last - first) + 1;
+            const uint64_t chunks = std::min<uint64_t>(
+                span, std::max<uint64_t>({minChunks, span / perChunkLimit + 1, 1}));
+            uint64_t low = 0;
+            for (uint64_t i = 0; i < chunks; i++) {
+                const uint64_t high = low + span / chunks + (i < span % chunks ? 1 : 0);
+                std::string query = "SELECT * FROM " + table + " WHERE " + key +
+                                    " >= " + bound(first + static_cast<int64_t>(low));
+                // The last range is left open so nothing past the measured end is missed
+                if (i + 1 < chunks) {
+                    query += " AND " + key + " < " + bound(first + static_cast<int64_t>(high));
+                }
+                queries.push_back(query);
+                low = high;
+            }
+        };
+
+        // PostgreSQL 14 scans ctid ranges directly; older servers need an integer primary key
+        const auto version =
+            txn->query_value<int>("SELECT current_setting('server_version_num')::int");
+        if (version >= 140000) {
+            const auto blocks = txn->query_value<int64_t>(
+                "SELECT pg_relation_size(" + relation + ") / current_setting('block_size')::int");
+            if (blocks > 0) {
+                addRanges("ctid", 0, blocks - 1, kMaxChunkBlocks, [](const int64_t block) {
+                    return "'(" + std::to_string(block) + ",0)'::tid";
+                });
+            }
+        } else {
+            const pqxx::result key = txn->exec(
+                "SELECT a.attname FROM pg_index i JOIN pg_attribute a ON a.attrelid = i.indrelid "
+                "AND a.attnum = i.indkey[0] WHERE i.indrelid = " + relation +
+                " AND i.indisprimary AND i.indnatts = 1 "
+                "AND a.atttypid IN ('int2'::regtype, 'int4'::regtype, 'int8'::regtype)");
+            if (key.empty()) {
+                error = "Splitting a table needs PostgreSQL 14 or an integer primary key";
+                return nullptr;
+            }
+            const std::string column = txn->quote_name(key[0][0].c_str());
+            const pqxx::row range =
+                txn->exec("SELECT min(" + column + "), max(" + column + ") FROM " + table)
+                    .one_row();
+            if (!range[0].is_null()) {
+                addRanges(column, range[0].as<int64_t>(), range[1].as<int64_t>(), 1000000,
+                          [](const int64_t value) { return std::to_string(value); });
+            }
+        }
+        if (queries.empty()) {
+            queries.push_back("SELECT * FROM " + table);
         }
+
+        return std::make_unique<PostgresParallelReader>(connectionString, std::move(coordinator),
+                                                        std::move(txn), snapshotId,
+                                                        std::move(queries));
     } catch (const std::exception &e) {
-        std::cerr << "Failed to execute query: " << e.what() << std::endl;
+        error = e.what();
+        return nullptr;
     }
+}
 
-    std::cout << "Query completed. Found " << tableNames.size() << " tables." << std::endl;
-    return tableNames;
+std::unique_ptr<TableWriter>
+PostgreSQLDatabase::beginTableWrite(const std::string &tableName,
+                                    const std::vector<Column> &columns, std::string &error) {
+    auto writer = std::make_unique<PostgresTableWriter>();
+    if (!writer->begin(connectionString, tableName, columns)) {
+        error = writer->getError();
+        return nullptr;
+    }
+    return writer;
+}
+
+bool PostgreSQLDatabase::isBusy() const {
+    if (!connectionMutex.try_lock()) {
+        return true;
+    }
+    connectionMutex.unlock();
+    return false;
+}
+
+std::string PostgreSQLDatabase::pollProgress(QueryProgress &progress) {
+    const int pid = backendPid;
+    if (pid == 0) {
+        return "";
+    }
+    if (progress.cancelRequested) {
+        cancel(progress);
+        return "Cancelling";
+    }
+    const std::string pidText = std::to_string(pid);
+
+    // The main connection is busy with the statement, so this goes through a second one
+    std::lock_guard<std::mutex> lock(monitorMutex);
+    try {
+        if (!monitorConnection || !monitorConnection->is_open()) {
+            monitorConnection = std::make_unique<pqxx::connection>(connectionString);
+        }
+
+        // Commands that report progress; the ANALYZE and COPY views need PostgreSQL 13 and 14
+        if (progressViewsAvailable) {
+            try {
+                pqxx::nontransaction txn(*monitorConnection);
+                const pqxx::result result = txn.exec(
+                    "SELECT command || ': ' || phase || CASE WHEN total > 0 THEN ' (' || "
+                    "(100 * done / total)::text || '%)' ELSE '' END FROM ("
+                    "SELECT 'CREATE INDEX' AS command, phase, blocks_done AS done, "
+                    "blocks_total AS total FROM pg_stat_progress_create_index WHERE pid = " +
+                    pidText +
+                    " UNION ALL SELECT 'VACUUM', phase, heap_blks_scanned, heap_blks_total "
+                    "FROM pg_stat_progress_vacuum WHERE pid = " +
+                    pidText +
+                    " UNION ALL SELECT 'CLUSTER', phase, heap_blks_scanned, heap_blks_total "
+                    "FROM pg_stat_progress_cluster WHERE pid = " +
+                    pidText +
+                    " UNION ALL SELECT 'ANALYZE', phase, sample_blks_scanned, sample_blks_total "
+                    "FROM pg_stat_progress_analyze WHERE pid = " +
+                    pidText +
+                    " UNION ALL SELECT 'COPY', type, bytes_processed, bytes_total "
+                    "FROM pg_stat_progress_copy WHERE pid = " +
+                    pidText + ") AS progress");
+                if (!result.empty() && !result[0][0].is_null()) {
+                    return result[0][0].c_str();
+                }
+            } catch (const pqxx::sql_error &) {
+                progressViewsAvailable = false;
+            }
+        }
+
+        // Anything else only reports what the backend is waiting on
+        pqxx::nontransaction txn(*monitorConnection);
+        const pqxx::result result =
+            txn.exec("SELECT 'Waiting on ' || wait_event_type || ': ' || wait_event "
+                     "FROM pg_stat_activity WHERE pid = " +
+                     pidText + " AND state = 'active'");
+        if (!result.empty() && !result[0][0].is_null()) {
+            return result[0][0].c_str();
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error polling query progress: " << e.what() << std::endl;
+        monitorConnection.reset();
+    }
+    return "";
+}
+
+void PostgreSQLDatabase::cancel(QueryProgress &progress) {
+    progress.cancelRequested = true;
+
+    // pg_cancel_backend stops whatever the backend runs, so only while that is this call
+    std::lock_guard<std::mutex> runningLock(runningMutex);
+    const int pid = backendPid;
+    if (pid == 0 || runningProgress != &progress) {
+        return;
+    }
+
+    // The main connection is busy with the statement, so this goes through a second one
+    std::lock_guard<std::mutex> lock(monitorMutex);
+    try {
+        if (!monitorConnection || !monitorConnection->is_open()) {
+            monitorConnection = std::make_unique<pqxx::connection>(connectionString);
+        }
+        pqxx::nontransaction txn(*monitorConnection);
+        txn.exec("SELECT pg_cancel_backend(" + std::to_string(pid) + ")");
+    } catch (const std::exception &e) {
+        std::cerr << "Error cancelling query: " << e.what() << std::endl;
+        monitorConnection.reset();
+    }
 }
 
 std::vector<Column> PostgreSQLDatabase::getTableColumns(const std::string &tableName) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     std::vector<Column> columns;
 
     try {
         pqxx::work txn(*connection);
-        std::string sql = "SELECT c.column_name, c.data_type, c.is_nullable, "
-                          "CASE WHEN tc.constraint_type = 'PRIMARY KEY' THEN true ELSE false END "
-                          "as is_primary_key "
-                          "FROM information_schema.columns c "
-                          "LEFT JOIN information_schema.key_column_usage kcu ON c.column_name = "
-                          "kcu.column_name AND c.table_name = kcu.table_name "
-                          "LEFT JOIN information_schema.table_constraints tc ON "
-                          "kcu.constraint_name = tc.constraint_name "
-                          "WHERE c.table_name = " +
-                          txn.quote(tableName) +
-                          " "
-                          "ORDER BY c.ordinal_position";
+        std::string sql = "SELECT a.attname, format_type(a.atttypid, a.atttypmod), a.attnotnull, "
+                          "i.indisprimary IS NOT NULL FROM pg_attribute a "
+                          "LEFT JOIN pg_index i ON i.indrelid = a.attrelid AND i.indisprimary "
+                          "AND a.attnum = ANY(i.indkey) "
+                          "WHERE a.attrelid = " +
+                          txn.quote(quoteTableName(tableName)) +
+                          "::regclass AND a.attnum > 0 AND NOT a.attisdropped ORDER BY a.attnum";
 
         pqxx::result result = txn.exec(sql);
 
@@ -287,7 +1365,7 @@ std::vector<Column> PostgreSQLDatabase::getTableColumns(const std::string &table
             Column col;
             col.name = row[0].c_str();
             col.type = row[1].c_str();
-            col.isNotNull = std::string(row[2].c_str()) == "NO";
+            col.isNotNull = row[2].as<bool>();
             col.isPrimaryKey = row[3].as<bool>();
             columns.push_back(col);
         }
@@ -296,4 +1374,4 @@ std::vector<Column> PostgreSQLDatabase::getTableColumns(const std::string &table
     }
 
     return columns;
-}
\ No newline at end of file
+}
@@ -0,0 +1,129 @@
+#include "database/query_cache.hpp"
+#include "database/sql_script.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+    // Functions whose result changes without any table being written
+    const char *const kVolatileWords[] = {
+        "RANDOM",          "RANDOMBLOB",       "NOW",           "CURRENT_TIMESTAMP",
+        "CURRENT_DATE",    "CURRENT_TIME",     "LOCALTIME",     "LOCALTIMESTAMP",
+        "CLOCK_TIMESTAMP", "STATEMENT_TIMESTAMP", "TIMEOFDAY",  "GEN_RANDOM_UUID",
+        "UUID_GENERATE_V4", "CHANGES",         "TOTAL_CHANGES", "LAST_INSERT_ROWID",
+        "TXID_CURRENT",    "SHOW"};
+} // namespace
+
+QueryCache::QueryCache(const size_t memoryBudget) : memoryBudget(memoryBudget) {}
+
+bool QueryCache::isCacheable(const std::string &sql) {
+    if (SqlScript::splitStatements(sql).size() != 1 || !SqlScript::isReadOnly(sql)) {
+        return false;
+    }
+
+    for (const auto &word : SqlScript::words(sql)) {
+        // System catalogs and statistics views change without touching user tables
+        if (word.compare(0, 3, "PG_") == 0) {
+            return false;
+        }
+        for (const char *volatileWord : kVolatileWords) {
+            if (word == volatileWord) {
+                return false;
+            }
+        }
+    }
+
+    // SQLite date functions take 'now' as a string argument
+    std::string lower = sql;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return lower.find("'now'") == std::string::npos;
+}
+
+std::optional<QueryCache::Entry> QueryCache::lookup(const std::string &connectionKey,
+                                                    const std::string &sql,
+                                                    const std::string &changeToken) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = entries.find(makeKey(connectionKey, sql));
+    if (it == entries.end()) {
+        misses++;
+        return std::nullopt;
+    }
+
+    // An unknown token never matches, so the result is re-run rather than trusted
+    if (changeToken.empty() || it->second.changeToken != changeToken ||
+        Clock::now() >= it->second.expiresAt) {
+        entries.erase(it);
+        misses++;
+        return std::nullopt;
+    }
+
+    it->second.lastUsed = ++useCounter;
+    hits++;
+    return it->second;
+}
+
+void QueryCache::store(const std::string &connectionKey, const std::string &sql,
+                       const std::string &changeToken, std::shared_ptr<ResultStore> result,
+                       const double elapsedMs, const std::chrono::seconds ttl) {
+    if (changeToken.empty() || !result) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry entry;
+    entry.result = std::move(result);
+    entry.changeToken = changeToken;
+    entry.storedAt = Clock::now();
+    entry.expiresAt = ttl.count() > 0 ? entry.storedAt + ttl : Clock::time_point::max();
+    entry.elapsedMs = elapsedMs;
+    entry.lastUsed = ++useCounter;
+    entries[makeKey(connectionKey, sql)] = std::move(entry);
+    evictOverBudget();
+}
+
+void QueryCache::invalidate(const std::string &connectionKey) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::string prefix = connectionKey + '\n';
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void QueryCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+QueryCache::Stats QueryCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {entries.size(), memoryUsage(), hits, misses};
+}
+
+std::string QueryCache::makeKey(const std::string &connectionKey, const std::string &sql) {
+    return connectionKey + '\n' + SqlScript::normalize(sql);
+}
+
+size_t QueryCache::memoryUsage() const {
+    size_t bytes = 0;
+    for (const auto &[key, entry] : entries) {
+        bytes += key.size() + entry.result->getMemoryUsage();
+    }
+    return bytes;
+}
+
+void QueryCache::evictOverBudget() {
+    // Least recently used first; a result still shown in a tab stays alive through its owner
+    while (entries.size() > 1 && memoryUsage() > memoryBudget) {
+        auto oldest = entries.begin();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->second.lastUsed < oldest->second.lastUsed) {
+                oldest = it;
+            }
+        }
+        entries.erase(oldest);
+    }
+}
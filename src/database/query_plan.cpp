@@ -0,0 +1,206 @@
+#include "database/query_plan.hpp"
+#include <algorithm>
+#include <map>
+#include <nlohmann/json.hpp>
+
+namespace {
+    using json = nlohmann::json;
+
+    double number(const json &node, const char *key) {
+        const auto it = node.find(key);
+        return it != node.end() && it->is_number() ? it->get<double>() : 0.0;
+    }
+
+    std::string text(const json &node, const char *key) {
+        const auto it = node.find(key);
+        return it != node.end() && it->is_string() ? it->get<std::string>() : "";
+    }
+
+    PlanNode parsePostgresNode(const json &node) {
+        PlanNode result;
+        const std::string nodeType = text(node, "Node Type");
+        const std::string joinType = text(node, "Join Type");
+        const std::string indexName = text(node, "Index Name");
+        const std::string alias = text(node, "Alias");
+        result.relation = text(node, "Relation Name");
+        result.fullScan = nodeType == "Seq Scan";
+
+        // Same wording as EXPLAIN's text format, e.g. "Hash Left Join" or "Index Scan using
+        // orders_pkey on orders o"
+        result.label = nodeType;
+        if (!joinType.empty() && joinType != "Inner") {
+            const size_t join = result.label.find("Join");
+            if (join != std::string::npos) {
+                result.label.insert(join, joinType + " ");
+            } else {
+                result.label += " " + joinType + " Join";
+            }
+        }
+        if (!indexName.empty()) {
+            result.label += " using " + indexName;
+        }
+        if (!result.relation.empty()) {
+            result.label += " on " + result.relation;
+            if (!alias.empty() && alias != result.relation) {
+                result.label += " " + alias;
+            }
+        }
+
+        for (const char *key : {"Index Cond", "Hash Cond", "Merge Cond", "Join Filter",
+                                "Recheck Cond", "Filter", "Sort Key", "Group Key"}) {
+            const auto it = node.find(key);
+            if (it == node.end()) {
+                continue;
+            }
+            std::string value = it->is_string() ? it->get<std::string>() : it->dump();
+            result.detail += std::string(result.detail.empty() ? "" : "\n") + key + ": " + value;
+        }
+        if (node.contains("Rows Removed by Filter")) {
+            result.detail += "\nRows Removed by Filter: " +
+                             std::to_string((int64_t)number(node, "Rows Removed by Filter"));
+        }
+
+        result.startupCost = number(node, "Startup Cost");
+        result.totalCost = number(node, "Total Cost");
+        result.planRows = number(node, "Plan Rows");
+        result.actualRows = number(node, "Actual Rows");
+        result.actualLoops = number(node, "Actual Loops");
+        result.actualTotalMs = number(node, "Actual Total Time") * result.actualLoops;
+        result.sharedHitBlocks = (int64_t)number(node, "Shared Hit Blocks");
+        result.sharedReadBlocks = (int64_t)number(node, "Shared Read Blocks");
+
+        const auto plans = node.find("Plans");
+        if (plans != node.end() && plans->is_array()) {
+            for (const auto &child : *plans) {
+                result.children.push_back(parsePostgresNode(child));
+            }
+        }
+        return result;
+    }
+
+    // Table named by SQLite's "SCAN orders", "SEARCH orders USING INDEX ..." or the older
+    // "SCAN TABLE orders AS o"
+    std::string sqliteRelation(const std::string &detail, bool &fullScan) {
+        fullScan = false;
+        std::string rest;
+        if (detail.compare(0, 5, "SCAN ") == 0) {
+            rest = detail.substr(5);
+            fullScan = rest.find(" USING ") == std::string::npos;
+        } else if (detail.compare(0, 7, "SEARCH ") == 0) {
+            rest = detail.substr(7);
+        } else {
+            return "";
+        }
+        if (rest.compare(0, 6, "TABLE ") == 0) {
+            rest = rest.substr(6);
+        }
+        const std::string name = rest.substr(0, rest.find(' '));
+        // Subqueries and CTEs are reported as SCAN with no table behind them
+        if (name == "CONSTANT" || name == "SUBQUERY" || name.empty()) {
+            fullScan = false;
+            return "";
+        }
+        return name;
+    }
+
+    // Inclusive totals of a subtree; self values are what is left after the children
+    void computeSelf(PlanNode &node) {
+        double childMs = 0.0;
+        double childCost = 0.0;
+        for (auto &child : node.children) {
+            computeSelf(child);
+            childMs += child.actualTotalMs;
+            childCost += child.totalCost;
+        }
+        node.selfMs = std::max(0.0, node.actualTotalMs - childMs);
+        node.selfCost = std::max(0.0, node.totalCost - childCost);
+    }
+
+    void markNodes(PlanNode &node, const QueryPlan &plan, const double total,
+                   const std::function<double(const std::string &)> &tableRows,
+                   std::map<std::string, double> &knownRows) {
+        if (total > 0.0) {
+            node.selfShare = (plan.analyzed ? node.selfMs : node.selfCost) / total;
+            node.hot = node.selfShare >= QueryPlanParser::kHotShare;
+        }
+
+        if (node.fullScan && !node.relation.empty()) {
+            auto it = knownRows.find(node.relation);
+            if (it == knownRows.end()) {
+                it = knownRows.emplace(node.relation, tableRows(node.relation)).first;
+            }
+            // Fall back to what the plan itself saw when the table size is unknown
+            const double rows =
+                it->second >= 0.0 ? it->second : std::max(node.planRows, node.actualRows);
+            if (rows >= QueryPlanParser::kLargeTableRows) {
+                node.warning = "full scan of ~" + std::to_string((int64_t)rows) + " rows";
+            }
+        }
+
+        for (auto &child : node.children) {
+            markNodes(child, plan, total, tableRows, knownRows);
+        }
+    }
+} // namespace
+
+namespace QueryPlanParser {
+    QueryPlan fromSqlite(const std::vector<SqliteRow> &rows) {
+        QueryPlan plan;
+
+        // Rows come parent first, so each node's parent is already placed. Node addresses are
+        // not stable while siblings are added, hence the path of child indexes per id.
+        std::map<int, std::vector<size_t>> paths;
+        for (const auto &row : rows) {
+            PlanNode node;
+            node.label = row.detail;
+            node.relation = sqliteRelation(row.detail, node.fullScan);
+
+            std::vector<PlanNode> *siblings = &plan.roots;
+            std::vector<size_t> path;
+            const auto parent = paths.find(row.parent);
+            if (parent != paths.end()) {
+                path = parent->second;
+                PlanNode *owner = &plan.roots[path[0]];
+                for (size_t i = 1; i < path.size(); i++) {
+                    owner = &owner->children[path[i]];
+                }
+                siblings = &owner->children;
+            }
+            path.push_back(siblings->size());
+            siblings->push_back(std::move(node));
+            paths[row.id] = std::move(path);
+        }
+        return plan;
+    }
+
+    QueryPlan fromPostgresJson(const std::string &text) {
+        QueryPlan plan;
+        const json document = json::parse(text, nullptr, false);
+        if (document.is_discarded() || !document.is_array() || document.empty() ||
+            !document[0].contains("Plan")) {
+            plan.error = "Unexpected EXPLAIN output";
+            return plan;
+        }
+
+        const json &top = document[0];
+        plan.hasCosts = true;
+        plan.analyzed = top.contains("Execution Time");
+        plan.planningMs = number(top, "Planning Time");
+        plan.executionMs = number(top, "Execution Time");
+        plan.roots.push_back(parsePostgresNode(top["Plan"]));
+        return plan;
+    }
+
+    void annotate(QueryPlan &plan, const std::function<double(const std::string &)> &tableRows) {
+        double total = 0.0;
+        for (auto &root : plan.roots) {
+            computeSelf(root);
+            total += plan.analyzed ? root.actualTotalMs : root.totalCost;
+        }
+
+        std::map<std::string, double> knownRows;
+        for (auto &root : plan.roots) {
+            markNodes(root, plan, total, tableRows, knownRows);
+        }
+    }
+} // namespace QueryPlanParser
@@ -0,0 +1,194 @@
+#include "database/result_store.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <unistd.h>
+
+ResultStore::ResultStore(const size_t memoryBudget) : memoryBudget(memoryBudget) {}
+
+ResultStore::~ResultStore() {
+    clear();
+}
+
+void ResultStore::begin(const std::vector<std::string> &names) {
+    clear();
+    columnNames = names;
+}
+
+bool ResultStore::row(const RowValues &values) {
+    if (!batchOpen) {
+        Batch batch;
+        batch.firstRow = rowCount;
+        batch.resident = std::make_unique<ColumnarBatchBuilder>(columnNames.size());
+        batches.push_back(std::move(batch));
+        batchOpen = true;
+    }
+
+    auto &batch = batches.back();
+    const size_t before = batch.resident->getByteSize();
+    batch.resident->append(values);
+    residentBytes += batch.resident->getByteSize() - before;
+    batch.rowCount++;
+    rowCount++;
+
+    if (batch.rowCount >= kBatchRows || batch.resident->getByteSize() >= kMaxBatchBytes) {
+        sealBatch();
+    }
+    return true;
+}
+
+void ResultStore::end() {
+    batchOpen = false;
+}
+
+bool ResultStore::isNull(const size_t row, const size_t col) const {
+    const Batch &batch = findBatch(row);
+    const size_t local = row - batch.firstRow;
+    return batch.resident ? batch.resident->isNull(local, col) : batch.view.isNull(local, col);
+}
+
+std::string_view ResultStore::getCell(const size_t row, const size_t col) const {
+    const Batch &batch = findBatch(row);
+    const size_t local = row - batch.firstRow;
+    return batch.resident ? batch.resident->getCell(local, col) : batch.view.getCell(local, col);
+}
+
+void ResultStore::replay(RowSink &sink) const {
+    std::shared_lock<std::shared_mutex> lock(accessMutex);
+    sink.begin(columnNames);
+    RowValues values(columnNames.size());
+    for (size_t row = 0; row < rowCount; row++) {
+        for (size_t col = 0; col < columnNames.size(); col++) {
+            if (isNull(row, col)) {
+                values[col].reset();
+            } else {
+                values[col] = getCell(row, col);
+            }
+        }
+        if (!sink.row(values)) {
+            break;
+        }
+    }
+    sink.end();
+}
+
+bool ResultStore::spill() {
+    std::unique_lock<std::shared_mutex> lock(accessMutex);
+    return spillLocked();
+}
+
+bool ResultStore::trySpill(bool &busy) {
+    std::unique_lock<std::shared_mutex> lock(accessMutex, std::try_to_lock);
+    busy = !lock.owns_lock();
+    return busy || spillLocked();
+}
+
+bool ResultStore::spillLocked() {
+    batchOpen = false;
+
+    std::vector<Batch *> written;
+    for (auto &batch : batches) {
+        if (batch.resident) {
+            if (!writeBatch(batch)) {
+                break;
+            }
+            written.push_back(&batch);
+        }
+    }
+    return written.empty() || remap(written);
+}
+
+void ResultStore::clear() {
+    std::unique_lock<std::shared_mutex> lock(accessMutex);
+    batches.clear();
+    mapping.close();
+    if (spillFd >= 0) {
+        close(spillFd);
+        spillFd = -1;
+    }
+    columnNames.clear();
+    spillSize = 0;
+    rowCount = 0;
+    residentBytes = 0;
+    batchOpen = false;
+    lastBatch = 0;
+}
+
+const ResultStore::Batch &ResultStore::findBatch(const size_t row) const {
+    const size_t cachedIndex = lastBatch.load(std::memory_order_relaxed);
+    if (cachedIndex < batches.size()) {
+        const Batch &cached = batches[cachedIndex];
+        if (row >= cached.firstRow && row < cached.firstRow + cached.rowCount) {
+            return cached;
+        }
+    }
+
+    auto it = std::upper_bound(batches.begin(), batches.end(), row,
+                               [](size_t value, const Batch &batch) { return value < batch.firstRow; });
+    const size_t index = static_cast<size_t>(std::distance(batches.begin(), it)) - 1;
+    lastBatch.store(index, std::memory_order_relaxed);
+    return batches[index];
+}
+
+void ResultStore::sealBatch() {
+    batchOpen = false;
+    if (residentBytes > memoryBudget) {
+        spill();
+    }
+}
+
+bool ResultStore::writeBatch(Batch &batch) {
+    if (spillFd < 0) {
+        std::string path =
+            (std::filesystem::temp_directory_path() / "dear-sql-result-XXXXXX").string();
+        spillFd = mkstemp(path.data());
+        if (spillFd < 0) {
+            std::cerr << "Failed to create spill file in " << path << std::endl;
+            return false;
+        }
+        // Unlink right away: the space is reclaimed once the descriptor and mapping are gone,
+        // even if the application dies
+        unlink(path.c_str());
+    }
+
+    std::string buffer;
+    batch.resident->serialize(buffer);
+
+    size_t written = 0;
+    while (written < buffer.size()) {
+        const ssize_t result = pwrite(spillFd, buffer.data() + written, buffer.size() - written,
+                                      static_cast<off_t>(spillSize + written));
+        if (result <= 0) {
+            std::cerr << "Failed to write spill file" << std::endl;
+            return false;
+        }
+        written += static_cast<size_t>(result);
+    }
+
+    batch.fileOffset = spillSize;
+    spillSize += buffer.size();
+    return true;
+}
+
+bool ResultStore::remap(const std::vector<Batch *> &written) {
+    // Written batches stay resident until the larger mapping is in place; if it can't be, they
+    // are simply written again by the next spill
+    if (!mapping.map(spillFd, spillSize)) {
+        spillSize = written.front()->fileOffset;
+        return false;
+    }
+
+    for (Batch *batch : written) {
+        residentBytes -= batch->resident->getByteSize();
+        batch->resident.reset();
+    }
+    for (auto &batch : batches) {
+        if (!batch.resident) {
+            batch.view = ColumnarBatchView(mapping.data() + batch.fileOffset, batch.rowCount,
+                                           columnNames.size());
+        }
+    }
+    return true;
+}
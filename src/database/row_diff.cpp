@@ -0,0 +1,89 @@
+#include "database/row_diff.hpp"
+#include <unordered_map>
+
+namespace {
+    constexpr uint64_t kFnvOffset = 1469598103934665603ULL;
+    constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+    uint64_t mix(uint64_t hash, const char *data, const size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= kFnvPrime;
+        }
+        return hash;
+    }
+
+    // The length goes in first so ("ab", "c") and ("a", "bc") hash differently
+    uint64_t mixCell(const uint64_t hash, const std::string_view cell) {
+        const uint64_t length = cell.size();
+        return mix(mix(hash, reinterpret_cast<const char *>(&length), sizeof(length)), cell.data(),
+                   cell.size());
+    }
+} // namespace
+
+namespace RowDiff {
+    uint64_t hashRow(const RowValues &values) {
+        uint64_t hash = kFnvOffset;
+        for (const auto &value : values) {
+            // NULL is marked by an impossible length rather than hashed as an empty string
+            if (!value) {
+                const uint64_t marker = UINT64_MAX;
+                hash = mix(hash, reinterpret_cast<const char *>(&marker), sizeof(marker));
+            } else {
+                hash = mixCell(hash, *value);
+            }
+        }
+        return hash;
+    }
+
+    uint64_t hashRow(const std::vector<std::string> &cells) {
+        uint64_t hash = kFnvOffset;
+        for (const auto &cell : cells) {
+            hash = mixCell(hash, cell);
+        }
+        return hash;
+    }
+
+    Result compare(const std::vector<uint64_t> &previous, const std::vector<uint64_t> &current) {
+        std::unordered_map<uint64_t, size_t> remaining;
+        remaining.reserve(previous.size());
+        for (const uint64_t hash : previous) {
+            remaining[hash]++;
+        }
+
+        Result result;
+        result.changed.assign(current.size(), 0);
+        for (size_t i = 0; i < current.size(); i++) {
+            const auto it = remaining.find(current[i]);
+            if (it != remaining.end() && it->second > 0) {
+                it->second--;
+            } else {
+                result.changed[i] = 1;
+                result.changedCount++;
+            }
+        }
+
+        for (const auto &[hash, count] : remaining) {
+            result.removedCount += count;
+        }
+        return result;
+    }
+
+    void HashingSink::begin(const std::vector<std::string> &columnNames) {
+        hashes.clear();
+        if (target) {
+            target->begin(columnNames);
+        }
+    }
+
+    bool HashingSink::row(const RowValues &values) {
+        hashes.push_back(hashRow(values));
+        return !target || target->row(values);
+    }
+
+    void HashingSink::end() {
+        if (target) {
+            target->end();
+        }
+    }
+} // namespace RowDiff
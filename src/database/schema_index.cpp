@@ -0,0 +1,418 @@
+#include "database/schema_index.hpp"
+#include "utils/sketches.hpp"
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
+
+namespace {
+    // Offered after the schema names; sorted for the prefix search
+    constexpr const char *kKeywords[] = {
+        "ALL", "ALTER", "AND", "AS", "ASC", "BETWEEN", "BY", "CASE", "CREATE", "CROSS", "DELETE",
+        "DESC", "DISTINCT", "DROP", "ELSE", "END", "EXISTS", "FROM", "FULL", "GROUP", "HAVING",
+        "IN", "INDEX", "INNER", "INSERT", "INTO", "IS", "JOIN", "LEFT", "LIKE", "LIMIT", "NOT",
+        "NULL", "OFFSET", "ON", "OR", "ORDER", "OUTER", "RETURNING", "RIGHT", "SELECT", "SET",
+        "TABLE", "THEN", "UNION", "UPDATE", "USING", "VALUES", "VIEW", "WHEN", "WHERE", "WITH",
+    };
+
+    // Words that follow a table reference and therefore can't be its alias
+    constexpr const char *kClauseWords[] = {
+        "CROSS", "EXCEPT", "FROM", "FULL", "GROUP", "HAVING", "INNER", "INTERSECT", "JOIN", "LEFT",
+        "LIMIT", "NATURAL", "OFFSET", "ON", "ORDER", "OUTER", "RETURNING", "RIGHT", "SELECT", "SET",
+        "UNION", "USING", "VALUES", "WHERE", "WINDOW",
+    };
+
+    struct Token {
+        std::string text;
+        // Offset just past the token
+        size_t end = 0;
+        bool identifier = false;
+        bool quoted = false;
+    };
+
+    struct TableReference {
+        std::string table;
+        std::string alias;
+    };
+
+    bool isIdentifierChar(const char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    }
+
+    std::string lowerCase(const std::string_view text) {
+        std::string result(text);
+        for (char &c : result) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return result;
+    }
+
+    bool equalsIgnoreCase(const std::string_view a, const std::string_view b) {
+        const auto same = [](char x, char y) {
+            return std::tolower(static_cast<unsigned char>(x)) ==
+                   std::tolower(static_cast<unsigned char>(y));
+        };
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), same);
+    }
+
+    bool startsWith(const std::string_view text, const std::string_view prefix) {
+        return text.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    // Lower-cased name, a NUL, then the name, so one lower-cased prefix finds every spelling;
+    // the schema last keeps same-named tables of different schemas apart
+    std::string tableKey(const Table &table) {
+        std::string key = lowerCase(table.name);
+        key += '\0';
+        key += table.name;
+        key += '\0';
+        key += table.schema;
+        return key;
+    }
+
+    uint64_t tableSignature(const Table &table) {
+        std::string text = table.name;
+        for (const auto &column : table.columns) {
+            text += '\x1f';
+            text += column.name;
+            text += ' ';
+            text += column.type;
+        }
+        return sketchHash(text);
+    }
+
+    // Identifiers, bare or double-quoted, and single punctuation characters. String literals
+    // and comments are skipped.
+    std::vector<Token> tokenize(const std::string_view text) {
+        std::vector<Token> tokens;
+        size_t i = 0;
+        while (i < text.size()) {
+            const char c = text[i];
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                i++;
+            } else if (c == '-' && i + 1 < text.size() && text[i + 1] == '-') {
+                const size_t lineEnd = text.find('\n', i);
+                i = lineEnd == std::string_view::npos ? text.size() : lineEnd + 1;
+            } else if (c == '/' && i + 1 < text.size() && text[i + 1] == '*') {
+                const size_t commentEnd = text.find("*/", i + 2);
+                i = commentEnd == std::string_view::npos ? text.size() : commentEnd + 2;
+            } else if (c == '\'') {
+                const size_t close = text.find('\'', i + 1);
+                i = close == std::string_view::npos ? text.size() : close + 1;
+            } else if (c == '"') {
+                const size_t close = text.find('"', i + 1);
+                const size_t end = close == std::string_view::npos ? text.size() : close;
+                tokens.push_back({std::string(text.substr(i + 1, end - i - 1)),
+                                  std::min(end + 1, text.size()), true, true});
+                i = end + 1;
+            } else if (isIdentifierChar(c)) {
+                const size_t start = i;
+                while (i < text.size() && isIdentifierChar(text[i])) {
+                    i++;
+                }
+                tokens.push_back({std::string(text.substr(start, i - start)), i,
+                                  !std::isdigit(static_cast<unsigned char>(c)), false});
+            } else {
+                tokens.push_back({std::string(1, c), i + 1, false, false});
+                i++;
+            }
+        }
+        return tokens;
+    }
+
+    bool isWord(const Token &token, const char *word) {
+        return token.identifier && !token.quoted && equalsIgnoreCase(token.text, word);
+    }
+
+    bool isAnyWord(const Token &token, const char *const *words, const size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            if (isWord(token, words[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isClauseWord(const Token &token) {
+        return isAnyWord(token, kClauseWords, sizeof(kClauseWords) / sizeof(kClauseWords[0]));
+    }
+
+    // Words after which a table name is expected
+    bool expectsTable(const Token &token) {
+        static const char *const words[] = {"FROM", "JOIN", "INTO", "UPDATE", "TABLE"};
+        return isAnyWord(token, words, sizeof(words) / sizeof(words[0]));
+    }
+
+    // Tables after FROM, JOIN, UPDATE and INTO with their aliases; a schema prefix is dropped
+    std::vector<TableReference> tableReferences(const std::vector<Token> &tokens) {
+        std::vector<TableReference> references;
+        for (size_t i = 0; i < tokens.size(); i++) {
+            const bool fromList = isWord(tokens[i], "FROM");
+            if (!fromList && !isWord(tokens[i], "JOIN") && !isWord(tokens[i], "UPDATE") &&
+                !isWord(tokens[i], "INTO")) {
+                continue;
+            }
+
+            size_t j = i + 1;
+            while (j < tokens.size() && tokens[j].identifier && !isClauseWord(tokens[j])) {
+                TableReference reference;
+                reference.table = tokens[j++].text;
+                while (j + 1 < tokens.size() && tokens[j].text == "." &&
+                       tokens[j + 1].identifier) {
+                    reference.table = tokens[j + 1].text;
+                    j += 2;
+                }
+                if (j < tokens.size() && isWord(tokens[j], "AS")) {
+                    j++;
+                }
+                if (j < tokens.size() && tokens[j].identifier && !isClauseWord(tokens[j])) {
+                    reference.alias = tokens[j++].text;
+                }
+                references.push_back(std::move(reference));
+
+                if (!fromList || j >= tokens.size() || tokens[j].text != ",") {
+                    break;
+                }
+                j++;
+            }
+            i = j > i ? j - 1 : i;
+        }
+        return references;
+    }
+
+    // The clause the cursor is in, judged by the last clause word before it
+    bool inFromList(const std::vector<Token> &tokens) {
+        for (auto it = tokens.rbegin(); it != tokens.rend(); ++it) {
+            if (it->text == "(" || it->text == ")") {
+                return false;
+            }
+            if (isClauseWord(*it)) {
+                return isWord(*it, "FROM");
+            }
+        }
+        return false;
+    }
+
+    void findKeywords(const std::string_view prefix, const size_t limit,
+                      std::vector<SchemaIndex::Match> &out) {
+        std::string upper(prefix);
+        for (char &c : upper) {
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+        const auto first = std::lower_bound(
+            std::begin(kKeywords), std::end(kKeywords), upper,
+            [](const char *keyword, const std::string &value) { return keyword < value; });
+        for (auto it = first; it != std::end(kKeywords) && out.size() < limit; ++it) {
+            if (!startsWith(*it, upper)) {
+                break;
+            }
+            out.push_back({*it, "", SchemaIndex::MatchKind::KEYWORD});
+        }
+    }
+
+    bool containsName(const std::vector<SchemaIndex::Match> &matches, const std::string &name) {
+        return std::any_of(matches.begin(), matches.end(),
+                           [&name](const SchemaIndex::Match &match) { return match.name == name; });
+    }
+} // namespace
+
+void SchemaIndex::update(const DatabaseInterface &db) {
+    const uint64_t current = db.getSchemaGeneration();
+    if (indexed && current == generation) {
+        return;
+    }
+    generation = current;
+    indexed = true;
+
+    // Tables whose name and columns are unchanged keep their entries
+    std::unordered_set<std::string> seen;
+    for (const auto &table : db.getTables()) {
+        std::string key = tableKey(table);
+        const uint64_t signature = tableSignature(table);
+        seen.insert(key);
+        const auto it = tables.find(key);
+        if (it != tables.end()) {
+            if (it->second.signature == signature) {
+                continue;
+            }
+            removeTable(it);
+        }
+        addTable(std::move(key), table, signature);
+    }
+    for (auto it = tables.begin(); it != tables.end();) {
+        if (seen.count(it->first)) {
+            ++it;
+        } else {
+            auto next = std::next(it);
+            removeTable(it);
+            it = next;
+        }
+    }
+}
+
+void SchemaIndex::addTable(std::string key, const Table &table, const uint64_t signature) {
+    IndexedTable entry;
+    entry.name = table.name;
+    entry.schema = table.schema;
+    entry.signature = signature;
+    entry.columns.reserve(table.columns.size());
+    for (const auto &column : table.columns) {
+        std::string columnKey = lowerCase(column.name);
+        ColumnName &distinct = columnNames[columnKey];
+        if (distinct.tableCount++ == 0) {
+            distinct.name = column.name;
+        }
+        entry.columns.push_back({std::move(columnKey), column.name, column.type});
+    }
+    std::sort(entry.columns.begin(), entry.columns.end(),
+              [](const IndexedColumn &a, const IndexedColumn &b) { return a.key < b.key; });
+    columnCount += entry.columns.size();
+    tables.emplace(std::move(key), std::move(entry));
+}
+
+void SchemaIndex::removeTable(const std::map<std::string, IndexedTable, std::less<>>::iterator it) {
+    for (const auto &column : it->second.columns) {
+        const auto distinct = columnNames.find(column.key);
+        if (distinct != columnNames.end() && --distinct->second.tableCount == 0) {
+            columnNames.erase(distinct);
+        }
+    }
+    columnCount -= it->second.columns.size();
+    tables.erase(it);
+}
+
+const SchemaIndex::IndexedTable *SchemaIndex::lookupTable(const std::string_view name) const {
+    // Every spelling of the name shares the lower-cased part of the key; an exact one wins
+    std::string prefix = lowerCase(name);
+    prefix += '\0';
+    const IndexedTable *found = nullptr;
+    for (auto it = tables.lower_bound(prefix); it != tables.end() && startsWith(it->first, prefix);
+         ++it) {
+        if (it->second.name == name) {
+            return &it->second;
+        }
+        if (!found) {
+            found = &it->second;
+        }
+    }
+    return found;
+}
+
+void SchemaIndex::findTables(const std::string_view prefix, const size_t limit,
+                             std::vector<Match> &out) const {
+    const std::string key = lowerCase(prefix);
+    for (auto it = tables.lower_bound(key); it != tables.end() && out.size() < limit; ++it) {
+        if (!startsWith(it->first, key)) {
+            break;
+        }
+        const IndexedTable &table = it->second;
+        std::string detail = std::to_string(table.columns.size()) + " columns";
+        out.push_back({table.name, table.schema.empty() ? detail : table.schema + ", " + detail,
+                       MatchKind::TABLE});
+    }
+}
+
+bool SchemaIndex::findColumns(const std::string_view table, const std::string_view prefix,
+                              const size_t limit, std::vector<Match> &out) const {
+    const IndexedTable *entry = lookupTable(table);
+    if (!entry) {
+        return false;
+    }
+    const std::string key = lowerCase(prefix);
+    const auto first = std::lower_bound(
+        entry->columns.begin(), entry->columns.end(), key,
+        [](const IndexedColumn &column, const std::string &value) { return column.key < value; });
+    for (auto it = first; it != entry->columns.end() && out.size() < limit; ++it) {
+        if (!startsWith(it->key, key)) {
+            break;
+        }
+        if (!containsName(out, it->name)) {
+            out.push_back({it->name, it->type, MatchKind::COLUMN});
+        }
+    }
+    return true;
+}
+
+void SchemaIndex::findAnyColumn(const std::string_view prefix, const size_t limit,
+                                std::vector<Match> &out) const {
+    const std::string key = lowerCase(prefix);
+    for (auto it = columnNames.lower_bound(key); it != columnNames.end() && out.size() < limit;
+         ++it) {
+        if (!startsWith(it->first, key)) {
+            break;
+        }
+        const size_t count = it->second.tableCount;
+        out.push_back({it->second.name,
+                       std::to_string(count) + (count == 1 ? " table" : " tables"),
+                       MatchKind::COLUMN});
+    }
+}
+
+SchemaIndex::Completion SchemaIndex::complete(const std::string_view text, size_t cursor,
+                                              const size_t limit) const {
+    Completion completion;
+    cursor = std::min(cursor, text.size());
+    size_t wordStart = cursor;
+    while (wordStart > 0 && isIdentifierChar(text[wordStart - 1])) {
+        wordStart--;
+    }
+    completion.wordStart = wordStart;
+    const std::string_view prefix = text.substr(wordStart, cursor - wordStart);
+    if (!prefix.empty() && std::isdigit(static_cast<unsigned char>(prefix[0]))) {
+        return completion;
+    }
+
+    // Only the statement around the cursor matters
+    const size_t previousEnd =
+        wordStart > 0 ? text.rfind(';', wordStart - 1) : std::string_view::npos;
+    const size_t statementStart = previousEnd == std::string_view::npos ? 0 : previousEnd + 1;
+    const size_t nextEnd = text.find(';', cursor);
+    const size_t statementEnd = nextEnd == std::string_view::npos ? text.size() : nextEnd;
+    const std::vector<Token> before =
+        tokenize(text.substr(statementStart, wordStart - statementStart));
+    const std::vector<TableReference> references =
+        tableReferences(tokenize(text.substr(statementStart, statementEnd - statementStart)));
+    auto &matches = completion.matches;
+
+    // "alias." or "table." right before the word
+    const size_t wordOffset = wordStart - statementStart;
+    if (before.size() >= 2 && before.back().text == "." && before.back().end == wordOffset &&
+        before[before.size() - 2].identifier) {
+        const std::string &qualifier = before[before.size() - 2].text;
+        std::string table = qualifier;
+        for (const auto &reference : references) {
+            if (equalsIgnoreCase(reference.alias, qualifier)) {
+                table = reference.table;
+                break;
+            }
+        }
+        findColumns(table, prefix, limit, matches);
+        return completion;
+    }
+
+    const Token *previous = before.empty() ? nullptr : &before.back();
+    if (previous && (expectsTable(*previous) || (previous->text == "," && inFromList(before)))) {
+        findTables(prefix, limit, matches);
+        return completion;
+    }
+    // Right after a table name only an alias or the next clause can follow
+    if (previous && previous->identifier && before.size() >= 2 &&
+        (expectsTable(before[before.size() - 2]) || isWord(*previous, "AS"))) {
+        if (!prefix.empty()) {
+            findKeywords(prefix, limit, matches);
+        }
+        return completion;
+    }
+    if (prefix.empty()) {
+        return completion;
+    }
+
+    bool knownTable = false;
+    for (const auto &reference : references) {
+        knownTable |= findColumns(reference.table, prefix, limit, matches);
+    }
+    if (!knownTable) {
+        findAnyColumn(prefix, limit, matches);
+    }
+    findKeywords(prefix, limit, matches);
+    return completion;
+}
@@ -0,0 +1,56 @@
+#include "database/schema_watcher.hpp"
+#include <algorithm>
+
+void SchemaWatcher::update(const std::vector<std::shared_ptr<DatabaseInterface>> &databases,
+                           JobRunner &jobs, const double now) {
+    // Forget connections that were closed
+    if (states.size() > databases.size()) {
+        for (auto it = states.begin(); it != states.end();) {
+            const bool open =
+                std::any_of(databases.begin(), databases.end(),
+                            [&it](const auto &db) { return db.get() == it->first; });
+            it = open ? std::next(it) : states.erase(it);
+        }
+    }
+
+    for (const auto &db : databases) {
+        auto &state = states[db.get()];
+        if (!state) {
+            state = std::make_shared<WatchState>();
+        }
+        // A busy connection would only hold the poll up behind its statement
+        if (state->polling || now < state->nextPoll || !db->isConnected() ||
+            !db->areTablesLoaded() || db->isBusy()) {
+            continue;
+        }
+        state->nextPoll = now + kPollIntervalSeconds;
+        poll(db, state, jobs);
+    }
+}
+
+void SchemaWatcher::poll(const std::shared_ptr<DatabaseInterface> &db,
+                         const std::shared_ptr<WatchState> &state, JobRunner &jobs) {
+    state->polling = true;
+    jobs.submit([this, db, state, previous = state->token, &jobs] {
+        // The first poll diffs too: DDL may have run since the tables were loaded
+        std::string token = db->getSchemaToken();
+        if (token.empty() || token == previous) {
+            jobs.post([state] { state->polling = false; });
+            return;
+        }
+
+        SchemaPatch patch = db->diffSchema();
+        jobs.post([this, db, state, token = std::move(token), patch = std::move(patch)]() mutable {
+            state->polling = false;
+            const bool changed = !patch.isEmpty();
+            // A failed or stale patch leaves the token alone, so the next poll diffs again
+            if (!db->applySchemaPatch(std::move(patch))) {
+                return;
+            }
+            state->token = std::move(token);
+            if (changed && onPatched) {
+                onPatched(*db);
+            }
+        });
+    });
+}
@@ -0,0 +1,213 @@
+#include "database/snapshot.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr char kMagic[8] = {'D', 'S', 'Q', 'L', 'S', 'N', 'A', 'P'};
+    constexpr uint32_t kVersion = 1;
+} // namespace
+
+SnapshotWriter::SnapshotWriter(const std::string &path, JobProgress *progress)
+    : path(path), progress(progress) {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        error = "Failed to create snapshot file: " + path;
+        return;
+    }
+
+    // Placeholder, rewritten once the footer position is known
+    write(std::string(sizeof(SnapshotHeader), '\0'));
+}
+
+void SnapshotWriter::begin(const std::vector<std::string> &names) {
+    columnNames = names;
+    batch = std::make_unique<ColumnarBatchBuilder>(columnNames.size());
+}
+
+bool SnapshotWriter::row(const RowValues &values) {
+    if (!isOk()) {
+        return false;
+    }
+    if (progress && progress->cancelRequested) {
+        error = "Cancelled";
+        return false;
+    }
+
+    batch->append(values);
+    rowCount++;
+    if (progress && rowCount % JobProgress::kRowBatch == 0) {
+        progress->rows = rowCount;
+    }
+    if (batch->getRowCount() >= kBatchRows) {
+        flushBatch();
+    }
+    return isOk();
+}
+
+void SnapshotWriter::end() {
+    if (!isOk()) {
+        return;
+    }
+    if (!batch) {
+        error = "Query did not return a result set";
+        return;
+    }
+
+    flushBatch();
+
+    SnapshotHeader header{};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.columnCount = static_cast<uint32_t>(columnNames.size());
+    header.rowCount = rowCount;
+    if (progress) {
+        progress->rows = rowCount;
+    }
+    header.batchCount = entries.size();
+    header.footerOffset = offset;
+
+    std::string footer(reinterpret_cast<const char *>(entries.data()),
+                       entries.size() * sizeof(SnapshotBatchEntry));
+    footer.append(reinterpret_cast<const char *>(kinds.data()), kinds.size());
+    footer.resize((footer.size() + 7) / 8 * 8, '\0');
+    for (const auto &name : columnNames) {
+        const auto length = static_cast<uint32_t>(name.size());
+        footer.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        footer.append(name);
+    }
+    write(footer);
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.close();
+    if (!file) {
+        error = "Failed to finish snapshot file: " + path;
+    }
+}
+
+void SnapshotWriter::flushBatch() {
+    if (batch->getRowCount() == 0) {
+        return;
+    }
+
+    std::string bytes;
+    batch->serialize(bytes, &kinds);
+    entries.push_back({offset, static_cast<uint64_t>(batch->getRowCount())});
+    write(bytes);
+    batch->clear();
+}
+
+void SnapshotWriter::write(const std::string &bytes) {
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        error = "Failed to write snapshot file: " + path;
+        return;
+    }
+    offset += bytes.size();
+}
+
+bool Snapshot::open(const std::string &filePath, std::string &error) {
+    path = filePath;
+    if (!mapping.open(path)) {
+        error = "Failed to open snapshot: " + path;
+        return false;
+    }
+
+    const char *data = mapping.data();
+    const size_t size = mapping.size();
+
+    SnapshotHeader header{};
+    if (size < sizeof(header)) {
+        error = "Not a snapshot file: " + path;
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        error = "Not a snapshot file: " + path;
+        return false;
+    }
+    if (header.version != kVersion) {
+        error = "Unsupported snapshot version " + std::to_string(header.version);
+        return false;
+    }
+
+    // Counts are checked against the bytes left before multiplying, so a damaged header can't
+    // overflow the sizes
+    if (header.footerOffset < sizeof(header) || header.footerOffset > size ||
+        header.batchCount > (size - header.footerOffset) / sizeof(SnapshotBatchEntry)) {
+        error = "Snapshot file is truncated: " + path;
+        return false;
+    }
+    const size_t entriesSize = header.batchCount * sizeof(SnapshotBatchEntry);
+    const size_t kindsSpace = size - header.footerOffset - entriesSize;
+    if (header.columnCount > 0 && header.batchCount > kindsSpace / header.columnCount) {
+        error = "Snapshot file is truncated: " + path;
+        return false;
+    }
+    const size_t kindsSize = (header.batchCount * header.columnCount + 7) / 8 * 8;
+    if (kindsSpace < kindsSize) {
+        error = "Snapshot file is truncated: " + path;
+        return false;
+    }
+
+    const char *footer = data + header.footerOffset;
+    const auto *entries = reinterpret_cast<const SnapshotBatchEntry *>(footer);
+    const auto *kinds = reinterpret_cast<const ColumnKind *>(footer + entriesSize);
+
+    size_t pos = header.footerOffset + entriesSize + kindsSize;
+    for (uint32_t col = 0; col < header.columnCount; col++) {
+        uint32_t length = 0;
+        if (size - pos < sizeof(length)) {
+            error = "Snapshot file is truncated: " + path;
+            return false;
+        }
+        memcpy(&length, data + pos, sizeof(length));
+        pos += sizeof(length);
+        if (size - pos < length) {
+            error = "Snapshot file is truncated: " + path;
+            return false;
+        }
+        columnNames.emplace_back(data + pos, length);
+        pos += length;
+    }
+
+    uint64_t firstRow = 0;
+    for (uint64_t i = 0; i < header.batchCount; i++) {
+        const SnapshotBatchEntry &entry = entries[i];
+        const ColumnKind *batchKinds = kinds + i * header.columnCount;
+        if (entry.offset < sizeof(header) || entry.offset >= header.footerOffset ||
+            entry.offset % 8 != 0 || firstRow + entry.rowCount < firstRow ||
+            !ColumnarBatchView::validate(data + entry.offset, header.footerOffset - entry.offset,
+                                         entry.rowCount, header.columnCount, batchKinds)) {
+            error = "Snapshot file is corrupt: " + path;
+            return false;
+        }
+        firstRows.push_back(firstRow);
+        batches.emplace_back(data + entry.offset, entry.rowCount, header.columnCount, batchKinds);
+        firstRow += entry.rowCount;
+    }
+    rowCount = firstRow;
+    return true;
+}
+
+bool Snapshot::isNull(const uint64_t row, const size_t col) const {
+    const size_t index = findBatch(row);
+    return batches[index].isNull(row - firstRows[index], col);
+}
+
+std::string_view Snapshot::getDisplayText(const uint64_t row, const size_t col,
+                                          char *scratch) const {
+    const size_t index = findBatch(row);
+    return batches[index].getDisplayText(row - firstRows[index], col, scratch);
+}
+
+size_t Snapshot::findBatch(const uint64_t row) const {
+    if (lastBatch < batches.size() && row >= firstRows[lastBatch] &&
+        row < firstRows[lastBatch] + batches[lastBatch].getRowCount()) {
+        return lastBatch;
+    }
+
+    const auto it = std::upper_bound(firstRows.begin(), firstRows.end(), row);
+    lastBatch = static_cast<size_t>(std::distance(firstRows.begin(), it)) - 1;
+    return lastBatch;
+}
@@ -0,0 +1,436 @@
+#include "database/sql_script.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+    bool isIdentChar(const char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    }
+
+    std::string toUpper(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+        return text;
+    }
+
+    size_t skipLineComment(const std::string &text, const size_t pos) {
+        const size_t newline = text.find('\n', pos);
+        return newline == std::string::npos ? text.size() : newline + 1;
+    }
+
+    // PostgreSQL allows nested block comments, SQLite doesn't care either way
+    size_t skipBlockComment(const std::string &text, size_t pos) {
+        int depth = 1;
+        pos += 2;
+        while (pos < text.size() && depth > 0) {
+            if (text.compare(pos, 2, "/*") == 0) {
+                depth++;
+                pos += 2;
+            } else if (text.compare(pos, 2, "*/") == 0) {
+                depth--;
+                pos += 2;
+            } else {
+                pos++;
+            }
+        }
+        return pos;
+    }
+
+    size_t skipQuoted(const std::string &text, size_t pos, const char quote,
+                      const bool backslashEscapes) {
+        pos++;
+        while (pos < text.size()) {
+            if (backslashEscapes && text[pos] == '\\') {
+                pos += 2;
+                continue;
+            }
+            if (text[pos] == quote) {
+                if (pos + 1 < text.size() && text[pos + 1] == quote) {
+                    pos += 2;
+                    continue;
+                }
+                return pos + 1;
+            }
+            pos++;
+        }
+        return text.size();
+    }
+
+    // Returns pos unchanged if the '$' doesn't open a dollar-quoted string ($1 parameters etc.)
+    size_t skipDollarQuoted(const std::string &text, const size_t pos) {
+        size_t end = pos + 1;
+        while (end < text.size() &&
+               (std::isalnum(static_cast<unsigned char>(text[end])) || text[end] == '_')) {
+            end++;
+        }
+        if (end >= text.size() || text[end] != '$') {
+            return pos;
+        }
+        if (end > pos + 1 && std::isdigit(static_cast<unsigned char>(text[pos + 1]))) {
+            return pos;
+        }
+        const std::string tag = text.substr(pos, end - pos + 1);
+        const size_t close = text.find(tag, end + 1);
+        return close == std::string::npos ? text.size() : close + tag.size();
+    }
+
+    size_t skipTrivia(const std::string &text, size_t pos) {
+        while (pos < text.size()) {
+            if (std::isspace(static_cast<unsigned char>(text[pos]))) {
+                pos++;
+            } else if (text.compare(pos, 2, "--") == 0) {
+                pos = skipLineComment(text, pos);
+            } else if (text.compare(pos, 2, "/*") == 0) {
+                pos = skipBlockComment(text, pos);
+            } else {
+                break;
+            }
+        }
+        return pos;
+    }
+
+    std::string wordAt(const std::string &text, const size_t pos) {
+        size_t end = pos;
+        while (end < text.size() && isIdentChar(text[end])) {
+            end++;
+        }
+        return toUpper(text.substr(pos, end - pos));
+    }
+
+    // Whether BEGIN opens a body whose semicolons don't end the statement: a trigger's body in
+    // SQLite, or a routine's BEGIN ATOMIC (PostgreSQL) or AS BEGIN body. Elsewhere it's a name,
+    // such as a column called begin.
+    bool opensBlock(const std::string &createKind, const std::string &previous,
+                    const std::string &next) {
+        if (createKind == "TRIGGER") {
+            return previous != "." && previous != "," && previous != "OF";
+        }
+        if (createKind == "FUNCTION" || createKind == "PROCEDURE") {
+            return next == "ATOMIC" || previous == "AS";
+        }
+        return false;
+    }
+} // namespace
+
+std::vector<std::string> SqlScript::splitStatements(const std::string &script) {
+    std::vector<std::string> statements;
+    const size_t length = script.size();
+    size_t start = 0;
+    size_t pos = 0;
+
+    // Trigger bodies (SQLite) and BEGIN ATOMIC function bodies (PostgreSQL) contain semicolons
+    int blockDepth = 0;
+    bool atStatementStart = true;
+    bool isCreate = false;
+    // What the CREATE statement makes (TABLE, TRIGGER, FUNCTION...), and the last word or
+    // punctuation read
+    std::string createKind;
+    std::string previous;
+
+    auto flush = [&](const size_t end) {
+        std::string statement = SqlScript::trim(script.substr(start, end - start));
+        if (skipTrivia(statement, 0) < statement.size()) {
+            statements.push_back(statement);
+        }
+        start = end + 1;
+        blockDepth = 0;
+        atStatementStart = true;
+        isCreate = false;
+        createKind.clear();
+        previous.clear();
+    };
+
+    while (pos < length) {
+        const char c = script[pos];
+
+        if (script.compare(pos, 2, "--") == 0) {
+            pos = skipLineComment(script, pos);
+            continue;
+        }
+        if (script.compare(pos, 2, "/*") == 0) {
+            pos = skipBlockComment(script, pos);
+            continue;
+        }
+        if (c == '\'' || c == '"') {
+            pos = skipQuoted(script, pos, c, false);
+            atStatementStart = false;
+            previous.clear();
+            continue;
+        }
+        if (c == '$' && (pos == 0 || !isIdentChar(script[pos - 1]))) {
+            const size_t end = skipDollarQuoted(script, pos);
+            if (end != pos) {
+                pos = end;
+                atStatementStart = false;
+                previous.clear();
+                continue;
+            }
+        }
+        if ((std::isalpha(static_cast<unsigned char>(c)) || c == '_') &&
+            (pos == 0 || !isIdentChar(script[pos - 1]))) {
+            size_t end = pos;
+            while (end < length && isIdentChar(script[end])) {
+                end++;
+            }
+            const std::string word = toUpper(script.substr(pos, end - pos));
+
+            // E'...' strings use backslash escapes
+            if (word == "E" && end < length && script[end] == '\'') {
+                pos = skipQuoted(script, end, '\'', true);
+                atStatementStart = false;
+                previous.clear();
+                continue;
+            }
+
+            if (atStatementStart) {
+                isCreate = word == "CREATE";
+                atStatementStart = false;
+            } else if (isCreate && createKind.empty()) {
+                if (word != "OR" && word != "REPLACE" && word != "TEMP" && word != "TEMPORARY" &&
+                    word != "CONSTRAINT") {
+                    createKind = word;
+                }
+            } else if (blockDepth == 0 && word == "BEGIN" &&
+                       opensBlock(createKind, previous, wordAt(script, skipTrivia(script, end)))) {
+                blockDepth++;
+            } else if (blockDepth > 0 && word == "CASE") {
+                blockDepth++;
+            } else if (blockDepth > 0 && word == "END") {
+                blockDepth--;
+            }
+            previous = word;
+            pos = end;
+            continue;
+        }
+        if (c == ';' && blockDepth == 0) {
+            flush(pos);
+            pos++;
+            continue;
+        }
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            atStatementStart = false;
+            previous = std::string(1, c);
+        }
+        pos++;
+    }
+
+    if (start < length) {
+        flush(length);
+    }
+    return statements;
+}
+
+std::string SqlScript::trim(const std::string &text) {
+    const size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        return "";
+    }
+    const size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+std::string SqlScript::quoteIdentifier(const std::string &name) {
+    std::string quoted = "\"";
+    for (const char c : name) {
+        quoted += c;
+        if (c == '"') {
+            quoted += '"';
+        }
+    }
+    return quoted + '"';
+}
+
+std::string SqlScript::firstKeyword(const std::string &statement) {
+    const size_t begin = skipTrivia(statement, 0);
+    size_t end = begin;
+    while (end < statement.size() && std::isalpha(static_cast<unsigned char>(statement[end]))) {
+        end++;
+    }
+    return toUpper(statement.substr(begin, end - begin));
+}
+
+bool SqlScript::managesTransactions(const std::vector<std::string> &statements) {
+    for (const auto &statement : statements) {
+        const std::string keyword = firstKeyword(statement);
+        if (keyword == "BEGIN" || keyword == "START" || keyword == "COMMIT" || keyword == "END" ||
+            keyword == "ROLLBACK" || keyword == "SAVEPOINT" || keyword == "RELEASE") {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string SqlScript::normalize(const std::string &statement) {
+    std::string result;
+    result.reserve(statement.size());
+    bool pendingSpace = false;
+    size_t pos = skipTrivia(statement, 0);
+
+    while (pos < statement.size()) {
+        const char c = statement[pos];
+        if (std::isspace(static_cast<unsigned char>(c)) || statement.compare(pos, 2, "--") == 0 ||
+            statement.compare(pos, 2, "/*") == 0) {
+            pos = skipTrivia(statement, pos);
+            pendingSpace = true;
+            continue;
+        }
+        // Whitespace only matters between two words
+        if (pendingSpace && !result.empty() && isIdentChar(result.back()) && isIdentChar(c)) {
+            result += ' ';
+        }
+        pendingSpace = false;
+
+        size_t end = pos + 1;
+        if (c == '\'' || c == '"') {
+            end = skipQuoted(statement, pos, c, false);
+        } else if ((c == 'E' || c == 'e') && statement.compare(pos + 1, 1, "'") == 0 &&
+                   (pos == 0 || !isIdentChar(statement[pos - 1]))) {
+            end = skipQuoted(statement, pos + 1, '\'', true);
+        } else if (c == '$' && (pos == 0 || !isIdentChar(statement[pos - 1]))) {
+            end = std::max(skipDollarQuoted(statement, pos), pos + 1);
+        }
+        if (end > pos + 1) {
+            result.append(statement, pos, end - pos);
+        } else {
+            result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        pos = end;
+    }
+
+    while (!result.empty() && result.back() == ';') {
+        result.pop_back();
+    }
+    return result;
+}
+
+std::string SqlScript::fingerprint(const std::string &statement) {
+    const std::string text = normalize(statement);
+    std::string result;
+    result.reserve(text.size());
+
+    auto previousIsIdent = [&result]() { return !result.empty() && isIdentChar(result.back()); };
+    auto endsWith = [&result](const char *suffix) {
+        const size_t length = std::char_traits<char>::length(suffix);
+        return result.size() >= length &&
+               result.compare(result.size() - length, length, suffix) == 0;
+    };
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const char c = text[pos];
+        size_t end = pos;
+        if (c == '\'') {
+            end = skipQuoted(text, pos, '\'', false);
+        } else if ((c == 'e' || c == 'E' || c == 'x') && !previousIsIdent() &&
+                   text.compare(pos + 1, 1, "'") == 0) {
+            end = skipQuoted(text, pos + 1, '\'', c != 'x');
+        } else if (c == '$' && !previousIsIdent()) {
+            end = skipDollarQuoted(text, pos);
+        } else if (std::isdigit(static_cast<unsigned char>(c)) && !previousIsIdent()) {
+            end = pos + 1;
+            while (end < text.size() && (isIdentChar(text[end]) || text[end] == '.' ||
+                                         ((text[end] == '+' || text[end] == '-') &&
+                                          (text[end - 1] == 'e' || text[end - 1] == 'E')))) {
+                end++;
+            }
+            // A sign directly in front of a number belongs to the literal
+            if (endsWith("-") &&
+                (result.size() == 1 || (!isIdentChar(result[result.size() - 2]) &&
+                                        result[result.size() - 2] != ')'))) {
+                result.pop_back();
+            }
+        } else if (c == '"') {
+            end = skipQuoted(text, pos, '"', false);
+            result.append(text, pos, end - pos);
+            pos = end;
+            continue;
+        }
+
+        if (end > pos) {
+            result += '?';
+            pos = end;
+            continue;
+        }
+
+        result += c;
+        pos++;
+        if (c != ')') {
+            continue;
+        }
+
+        // Collapse "(?,?,...)" to "(...)", then "(...),(...)" to a single "(...)"
+        size_t back = result.size() - 1;
+        bool literalsOnly = false;
+        while (back >= 2 && result[back - 1] == '?' &&
+               (result[back - 2] == ',' || result[back - 2] == '(')) {
+            back -= 2;
+            if (result[back] == '(') {
+                literalsOnly = true;
+                break;
+            }
+        }
+        if (literalsOnly) {
+            result.resize(back);
+            result += "(...)";
+        }
+        if (endsWith("(...),(...)")) {
+            result.resize(result.size() - 6);
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> SqlScript::words(const std::string &statement) {
+    std::vector<std::string> result;
+    size_t pos = 0;
+    while (pos < statement.size()) {
+        pos = skipTrivia(statement, pos);
+        if (pos >= statement.size()) {
+            break;
+        }
+
+        const char c = statement[pos];
+        if (c == '\'' || c == '"') {
+            pos = skipQuoted(statement, pos, c, false);
+        } else if ((c == 'E' || c == 'e') && statement.compare(pos + 1, 1, "'") == 0 &&
+                   (pos == 0 || !isIdentChar(statement[pos - 1]))) {
+            pos = skipQuoted(statement, pos + 1, '\'', true);
+        } else if (c == '$' && (pos == 0 || !isIdentChar(statement[pos - 1])) &&
+                   skipDollarQuoted(statement, pos) != pos) {
+            pos = skipDollarQuoted(statement, pos);
+        } else if ((std::isalpha(static_cast<unsigned char>(c)) || c == '_') &&
+                   (pos == 0 || !isIdentChar(statement[pos - 1]))) {
+            size_t end = pos;
+            while (end < statement.size() && isIdentChar(statement[end])) {
+                end++;
+            }
+            result.push_back(toUpper(statement.substr(pos, end - pos)));
+            pos = end;
+        } else {
+            pos++;
+        }
+    }
+    return result;
+}
+
+bool SqlScript::isReadOnly(const std::string &statement) {
+    const std::string keyword = firstKeyword(statement);
+    if (keyword != "SELECT" && keyword != "WITH" && keyword != "VALUES" && keyword != "TABLE" &&
+        keyword != "SHOW" && keyword != "EXPLAIN") {
+        return false;
+    }
+
+    // Data-modifying CTEs, SELECT INTO, row locks and EXPLAIN ANALYZE of a write all hide behind
+    // a read-only first keyword
+    static const char *const writeWords[] = {"INSERT", "UPDATE", "DELETE", "MERGE",   "INTO",
+                                             "CREATE", "DROP",   "ALTER",  "TRUNCATE", "COPY",
+                                             "CALL",   "LOCK",   "NEXTVAL", "SETVAL"};
+    for (const auto &word : words(statement)) {
+        for (const char *writeWord : writeWords) {
+            if (word == writeWord) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -1,32 +1,735 @@
 #include "database/sqlite.hpp"
+#include "database/csv_table.hpp"
+#include "database/sql_script.hpp"
+#include "database/statement_stats.hpp"
+#include "database/table_diff.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <sstream>
+#include <unordered_set>
 #include <utility>
 
+namespace {
+    // Virtual machine instructions between progress callbacks
+    constexpr int kProgressInterval = 1000;
+    // Parallel reads use at most this many rowids per chunk, so no worker is left with a long tail
+    constexpr uint64_t kMaxChunkRowids = 1000000;
+
+    // Collected by the authorizer while a statement is prepared on a reader
+    struct ReaderCheck {
+        std::unordered_set<std::string> tempNames;
+        bool needsWriter = false;
+    };
+
+    std::string lowerCase(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+        return text;
+    }
+
+    // A statement needs the main connection if it reads a name the temp schema shadows there,
+    // or asks for the connection's own last insert or change counts
+    int checkReaderAccess(void *data, const int action, const char *first, const char *second,
+                          const char *, const char *) {
+        auto &check = *static_cast<ReaderCheck *>(data);
+        if (action == SQLITE_READ && first && check.tempNames.count(lowerCase(first)) > 0) {
+            check.needsWriter = true;
+        } else if (action == SQLITE_FUNCTION && second) {
+            const std::string function = lowerCase(second);
+            if (function == "last_insert_rowid" || function == "changes" ||
+                function == "total_changes") {
+                check.needsWriter = true;
+            }
+        }
+        return SQLITE_OK;
+    }
+
+    int onProgress(void *data) {
+        auto *progress = static_cast<QueryProgress *>(data);
+        progress->steps += kProgressInterval;
+        // Non-zero interrupts the statement with SQLITE_INTERRUPT
+        return progress->cancelRequested ? 1 : 0;
+    }
+
+    // SQLite's query plan names a table by its alias when it has one; find the table behind
+    // "FROM table [AS] alias" or "JOIN table [AS] alias"
+    std::string tableForAlias(const std::string &query, const std::string &alias) {
+        const auto words = SqlScript::words(query);
+        std::string upperAlias = alias;
+        for (auto &c : upperAlias) {
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+        for (size_t i = 2; i < words.size(); i++) {
+            if (words[i] != upperAlias) {
+                continue;
+            }
+            const size_t table = words[i - 1] == "AS" ? i - 2 : i - 1;
+            if (table > 0 && (words[table - 1] == "FROM" || words[table - 1] == "JOIN")) {
+                return words[table];
+            }
+        }
+        return alias;
+    }
+
+    double elapsedMs(const std::chrono::steady_clock::time_point started) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started)
+            .count();
+    }
+
+    // Step a prepared statement to completion and render its rows as text (first 1000 rows).
+    // rows receives the rows returned, or changed for statements without a result set.
+    bool formatStatement(sqlite3 *db, sqlite3_stmt *stmt, std::string &output,
+                         uint64_t *rows = nullptr) {
+        std::stringstream result;
+
+        const int columnCount = sqlite3_column_count(stmt);
+        if (columnCount > 0) {
+            for (int i = 0; i < columnCount; i++) {
+                result << sqlite3_column_name(stmt, i);
+                if (i < columnCount - 1)
+                    result << " | ";
+            }
+            result << "\n";
+
+            for (int i = 0; i < columnCount; i++) {
+                result << "----------";
+                if (i < columnCount - 1)
+                    result << "-+-";
+            }
+            result << "\n";
+        }
+
+        int rc = SQLITE_DONE;
+        int rowCount = 0;
+        while (rowCount < 1000 && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            for (int i = 0; i < columnCount; i++) {
+                const char *text = (const char *)sqlite3_column_text(stmt, i);
+                result << (text ? text : "NULL");
+                if (i < columnCount - 1)
+                    result << " | ";
+            }
+            result << "\n";
+            rowCount++;
+        }
+
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+            output = "Error: " + std::string(sqlite3_errmsg(db));
+            return false;
+        }
+
+        if (rows) {
+            *rows = columnCount > 0 ? static_cast<uint64_t>(rowCount) : sqlite3_changes(db);
+        }
+        if (rowCount == 0 && columnCount == 0) {
+            result << "Query executed successfully. Rows affected: " << sqlite3_changes(db);
+        } else if (rowCount == 1000) {
+            result << "\n... (showing first 1000 rows)";
+        }
+
+        output = result.str();
+        return true;
+    }
+
+    // Step a statement to the end, handing every row to the sink. Returns the last step result,
+    // SQLITE_DONE also when the sink stopped early.
+    int emitRows(sqlite3_stmt *stmt, RowSink &sink, QueryProgress *progress, uint64_t &rowCount) {
+        const int columnCount = sqlite3_column_count(stmt);
+        if (columnCount > 0) {
+            std::vector<std::string> columnNames;
+            for (int i = 0; i < columnCount; i++) {
+                columnNames.emplace_back(sqlite3_column_name(stmt, i));
+            }
+            sink.begin(columnNames);
+        }
+
+        RowValues values(columnCount);
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            rowCount++;
+            for (int i = 0; i < columnCount; i++) {
+                if (sqlite3_column_type(stmt, i) == SQLITE_NULL) {
+                    values[i].reset();
+                } else {
+                    auto text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, i));
+                    values[i] = std::string_view(text, sqlite3_column_bytes(stmt, i));
+                }
+            }
+            if (progress) {
+                progress->rows++;
+            }
+            if (!sink.row(values)) {
+                rc = SQLITE_DONE;
+                break;
+            }
+        }
+
+        if (columnCount > 0) {
+            sink.end();
+        }
+        return rc;
+    }
+
+    // Integer result of a pragma as text, empty if it can't be read
+    std::string pragmaValue(sqlite3 *connection, const char *sql) {
+        sqlite3_stmt *stmt;
+        std::string value;
+        if (sqlite3_prepare_v2(connection, sql, -1, &stmt, nullptr) == SQLITE_OK &&
+            sqlite3_step(stmt) == SQLITE_ROW) {
+            value = std::to_string(sqlite3_column_int64(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+        return value;
+    }
+
+    // SQLite URI of a file, with the profile's open mode as a query parameter. '%', '?' and '#'
+    // would be read as URI syntax, so they are escaped.
+    std::string fileUri(const std::string &path, const SqliteProfile &profile) {
+        std::string uri = "file:";
+        for (const char c : path) {
+            if (c == '%' || c == '?' || c == '#') {
+                char escaped[4];
+                snprintf(escaped, sizeof(escaped), "%%%02X", static_cast<unsigned char>(c));
+                uri += escaped;
+            } else {
+                uri += c;
+            }
+        }
+        if (profile.immutable) {
+            uri += "?immutable=1";
+        } else if (profile.readOnly) {
+            uri += "?mode=ro";
+        }
+        return uri;
+    }
+
+    int openFlags(const SqliteProfile &profile) {
+        int flags = SQLITE_OPEN_URI;
+        flags |= profile.isReadOnly() ? SQLITE_OPEN_READONLY
+                                      : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+        if (profile.noMutex) {
+            flags |= SQLITE_OPEN_NOMUTEX;
+        }
+        return flags;
+    }
+
+    // Tuning pragmas of the profile; failures only cost performance, so they are just logged
+    void applyProfile(sqlite3 *db, const SqliteProfile &profile) {
+        // A negative cache_size is in KiB rather than pages
+        std::string sql = "PRAGMA mmap_size = " + std::to_string(profile.mmapSize) +
+                          "; PRAGMA cache_size = " + std::to_string(-profile.cacheSizeKb) + ";";
+        if (profile.tempStoreMemory) {
+            sql += " PRAGMA temp_store = MEMORY;";
+        }
+        if (profile.wal && !profile.isReadOnly()) {
+            sql += " PRAGMA journal_mode = WAL;";
+        }
+        char *errorMessage = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+            std::cerr << "Failed to apply connection profile: "
+                      << (errorMessage ? errorMessage : "unknown error") << std::endl;
+        }
+        sqlite3_free(errorMessage);
+    }
+
+    // Reads rowid ranges of one table, each on a read-only connection from a small pool. Every
+    // chunk runs in its own read transaction: SQLite has no portable way to share a snapshot
+    // between connections, so writes committed during the read may show up in later chunks.
+    class SqliteParallelReader : public ParallelReader {
+    public:
+        SqliteParallelReader(std::string path, const SqliteProfile &profile,
+                             std::vector<std::string> queries)
+            : path(std::move(path)), profile(profile), queries(std::move(queries)) {
+            this->profile.readOnly = true;
+        }
+
+        ~SqliteParallelReader() override {
+            for (sqlite3 *db : idle) {
+                sqlite3_close(db);
+            }
+        }
+
+        size_t getChunkCount() const override {
+            return queries.size();
+        }
+
+        StatementResult readChunk(const size_t index, RowSink &sink) override {
+            const auto started = std::chrono::steady_clock::now();
+            StatementResult result;
+            result.sql = queries[index];
+
+            sqlite3 *db = acquire(result.error);
+            if (!db) {
+                return result;
+            }
+
+            result.executed = true;
+            sqlite3_stmt *stmt = nullptr;
+            if (sqlite3_prepare_v2(db, result.sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+                result.error = sqlite3_errmsg(db);
+            } else {
+                uint64_t rowCount = 0;
+                if (emitRows(stmt, sink, nullptr, rowCount) == SQLITE_DONE) {
+                    result.success = true;
+                } else {
+                    result.error = sqlite3_errmsg(db);
+                }
+            }
+            sqlite3_finalize(stmt);
+            release(db);
+            result.elapsedMs = elapsedMs(started);
+            return result;
+        }
+
+    private:
+        std::string path;
+        SqliteProfile profile;
+        std::vector<std::string> queries;
+        std::mutex poolMutex;
+        std::vector<sqlite3 *> idle;
+
+        sqlite3 *acquire(std::string &error) {
+            {
+                std::lock_guard<std::mutex> lock(poolMutex);
+                if (!idle.empty()) {
+                    sqlite3 *db = idle.back();
+                    idle.pop_back();
+                    return db;
+                }
+            }
+
+            // Each connection is only ever used by one thread at a time
+            sqlite3 *db = nullptr;
+            if (sqlite3_open_v2(fileUri(path, profile).c_str(), &db,
+                                openFlags(profile) | SQLITE_OPEN_NOMUTEX,
+                                nullptr) != SQLITE_OK) {
+                error = "Failed to open " + path + ": " + sqlite3_errmsg(db);
+                sqlite3_close(db);
+                return nullptr;
+            }
+            applyProfile(db, profile);
+            sqlite3_busy_timeout(db, 5000);
+            return db;
+        }
+
+        void release(sqlite3 *db) {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            idle.push_back(db);
+        }
+    };
+
+    // Inserts into a freshly created table through one reused prepared statement. The whole fill
+    // is one transaction on a connection of the writer's own, so the main connection stays free
+    // for the UI. An in-memory database only has its main connection, which is then held locked
+    // (lock) while the writer exists.
+    class SqliteTableWriter : public TableWriter {
+    public:
+        SqliteTableWriter(sqlite3 *db, std::unique_lock<std::recursive_mutex> lock)
+            : lock(std::move(lock)), db(db) {}
+
+        ~SqliteTableWriter() override {
+            sqlite3_finalize(insert);
+            if (begun && !committed) {
+                sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+            }
+            if (!lock.owns_lock()) {
+                sqlite3_close(db);
+            }
+        }
+
+        bool begin(const std::string &tableName, const std::vector<Column> &columns) {
+            std::string create = "CREATE TABLE " + SqlScript::quoteIdentifier(tableName) + " (";
+            std::string primaryKey;
+            std::string placeholders;
+            for (size_t i = 0; i < columns.size(); i++) {
+                const Column &column = columns[i];
+                create += (i > 0 ? ", " : "") + SqlScript::quoteIdentifier(column.name) + " " +
+                          column.type;
+                if (column.isNotNull) {
+                    create += " NOT NULL";
+                }
+                if (column.isPrimaryKey) {
+                    primaryKey += (primaryKey.empty() ? "" : ", ") +
+                                  SqlScript::quoteIdentifier(column.name);
+                }
+                placeholders += i > 0 ? ", ?" : "?";
+
+                std::string type = column.type;
+                std::transform(type.begin(), type.end(), type.begin(), ::toupper);
+                blobColumns.push_back(type == "BLOB");
+            }
+            if (!primaryKey.empty()) {
+                create += ", PRIMARY KEY (" + primaryKey + ")";
+            }
+            create += ")";
+
+            if (!exec("BEGIN")) {
+                return false;
+            }
+            begun = true;
+            if (!exec(create)) {
+                return false;
+            }
+            const std::string sql = "INSERT INTO " + SqlScript::quoteIdentifier(tableName) +
+                                    " VALUES (" + placeholders + ")";
+            if (sqlite3_prepare_v2(db, sql.c_str(), -1, &insert, nullptr) != SQLITE_OK) {
+                error = sqlite3_errmsg(db);
+                return false;
+            }
+            return true;
+        }
+
+        bool writeRow(const RowValues &values) override {
+            for (size_t i = 0; i < values.size() && i < blobColumns.size(); i++) {
+                const auto param = static_cast<int>(i + 1);
+                if (!values[i]) {
+                    sqlite3_bind_null(insert, param);
+                } else if (blobColumns[i]) {
+                    sqlite3_bind_blob64(insert, param, values[i]->data(), values[i]->size(),
+                                        SQLITE_STATIC);
+                } else {
+                    sqlite3_bind_text64(insert, param, values[i]->data(), values[i]->size(),
+                                        SQLITE_STATIC, SQLITE_UTF8);
+                }
+            }
+            const int rc = sqlite3_step(insert);
+            sqlite3_reset(insert);
+            if (rc != SQLITE_DONE) {
+                error = sqlite3_errmsg(db);
+                return false;
+            }
+            return true;
+        }
+
+        bool commit() override {
+            sqlite3_finalize(insert);
+            insert = nullptr;
+            if (!exec("COMMIT")) {
+                return false;
+            }
+            committed = true;
+            return true;
+        }
+
+    private:
+        std::unique_lock<std::recursive_mutex> lock;
+        sqlite3 *db;
+        sqlite3_stmt *insert = nullptr;
+        std::vector<bool> blobColumns;
+        bool begun = false;
+        bool committed = false;
+
+        bool exec(const std::string &sql) {
+            char *message = nullptr;
+            if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &message) != SQLITE_OK) {
+                error = message ? message : sqlite3_errmsg(db);
+                sqlite3_free(message);
+                return false;
+            }
+            return true;
+        }
+    };
+} // namespace
+
+// Reports progress of one call on a connection and registers it for cancel(); both are undone
+// afterwards
+class SQLiteDatabase::ProgressScope {
+public:
+    ProgressScope(SQLiteDatabase &owner, sqlite3 *db, QueryProgress *progress)
+        : owner(owner), db(progress ? db : nullptr), progress(progress) {
+        if (!this->db) {
+            return;
+        }
+        sqlite3_progress_handler(db, kProgressInterval, onProgress, progress);
+        std::lock_guard<std::mutex> lock(owner.runningMutex);
+        owner.runningStatements[progress] = db;
+    }
+    ~ProgressScope() {
+        if (!db) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(owner.runningMutex);
+            owner.runningStatements.erase(progress);
+        }
+        sqlite3_progress_handler(db, 0, nullptr, nullptr);
+    }
+
+    ProgressScope(const ProgressScope &) = delete;
+    ProgressScope &operator=(const ProgressScope &) = delete;
+
+private:
+    SQLiteDatabase &owner;
+    sqlite3 *db;
+    QueryProgress *progress;
+};
+
+// A statement prepared on a pooled reader when it only reads and a reader is free, otherwise on
+// the main connection, which then stays locked for as long as the statement lives
+class SQLiteDatabase::PooledStatement {
+public:
+    PooledStatement(SQLiteDatabase &owner, const std::string &sql, const bool readOnly)
+        : owner(owner), lock(owner.connectionMutex, std::defer_lock) {
+        reader = readOnly ? owner.acquireReader() : nullptr;
+        if (reader) {
+            if (owner.prepareOnReader(reader, sql, stmt) && stmt) {
+                db = reader;
+                return;
+            }
+            // Temp tables and CSV files only exist on the main connection
+            sqlite3_finalize(stmt);
+            stmt = nullptr;
+            owner.releaseReader(reader);
+            reader = nullptr;
+        }
+
+        lock.lock();
+        if (!owner.connect()) {
+            return;
+        }
+        db = owner.connection;
+        sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
+    }
+
+    ~PooledStatement() {
+        sqlite3_finalize(stmt);
+        if (reader) {
+            owner.releaseReader(reader);
+        } else if (db) {
+            owner.updateWriterState();
+        }
+    }
+
+    PooledStatement(const PooledStatement &) = delete;
+    PooledStatement &operator=(const PooledStatement &) = delete;
+
+    // Connection the statement belongs to; nullptr if the database could not be opened
+    sqlite3 *getConnection() const {
+        return db;
+    }
+    // nullptr if preparing failed; the connection has the error
+    sqlite3_stmt *get() const {
+        return stmt;
+    }
+
+private:
+    SQLiteDatabase &owner;
+    std::unique_lock<std::recursive_mutex> lock;
+    sqlite3 *reader = nullptr;
+    sqlite3 *db = nullptr;
+    sqlite3_stmt *stmt = nullptr;
+};
+
 SQLiteDatabase::SQLiteDatabase(std::string name, std::string path)
-    : name(std::move(name)), path(std::move(path)) {}
+    : name(std::move(name)), path(std::move(path)), profile(SqliteProfile::load(this->path)) {}
 
 SQLiteDatabase::~SQLiteDatabase() {
     SQLiteDatabase::disconnect();
 }
 
 bool SQLiteDatabase::connect() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     if (connected && connection) {
         return true;
     }
 
-    int rc = sqlite3_open(path.c_str(), &connection);
+    // A CSV file is opened as an in-memory database holding one virtual table over the file
+    const bool isCsv = CsvTable::isCsvPath(path);
+    int rc = isCsv ? sqlite3_open(":memory:", &connection)
+                   : sqlite3_open_v2(fileUri(path, profile).c_str(), &connection,
+                                     openFlags(profile), nullptr);
     if (rc != SQLITE_OK) {
         std::cerr << "Can't open database: " << sqlite3_errmsg(connection) << std::endl;
+        sqlite3_close(connection);
+        connection = nullptr;
+        return false;
+    }
+    applyProfile(connection, profile);
+    // A table writer commits on a connection of its own; wait for it rather than fail
+    sqlite3_busy_timeout(connection, 5000);
+
+    if (!CsvTable::registerModule(connection)) {
+        std::cerr << "Failed to register CSV module: " << sqlite3_errmsg(connection) << std::endl;
+    }
+    if (!TableDiff::registerFunctions(connection)) {
+        std::cerr << "Failed to register diff functions: " << sqlite3_errmsg(connection)
+                  << std::endl;
+    }
+    if (isCsv && !createCsvTable("main", path)) {
+        sqlite3_close(connection);
+        connection = nullptr;
         return false;
     }
 
+    // Virtual tables live in the temp schema, so they have to be recreated on reconnect
+    for (const auto &csvPath : attachedCsvFiles) {
+        createCsvTable("temp", csvPath);
+    }
+
+    // Readers only help where they don't stall the writer: in WAL mode or on a read-only file
+    sqlite3_stmt *stmt = nullptr;
+    std::string journalMode;
+    if (sqlite3_prepare_v2(connection, "PRAGMA journal_mode", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        journalMode = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    {
+        std::lock_guard<std::mutex> readerLock(readerMutex);
+        readersEnabled = !isCsv && (profile.isReadOnly() || journalMode == "wal");
+        readerProfile = profile;
+        readerProfile.readOnly = true;
+    }
+    updateWriterState();
+
     std::cout << "Successfully connected to database: " << path << std::endl;
     connected = true;
     return true;
 }
 
+bool SQLiteDatabase::attachCsv(const std::string &csvPath) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    if (!connect() || !createCsvTable("temp", csvPath)) {
+        return false;
+    }
+    attachedCsvFiles.push_back(csvPath);
+    updateWriterState();
+    return true;
+}
+
+const SqliteProfile &SQLiteDatabase::getProfile() const {
+    return profile;
+}
+
+void SQLiteDatabase::setProfile(const SqliteProfile &newProfile) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    profile = newProfile;
+}
+
+bool SQLiteDatabase::createCsvTable(const std::string &schema, const std::string &csvPath) {
+    const std::string sql =
+        CsvTable::createTableSql(schema, CsvTable::tableNameFor(csvPath), csvPath);
+    char *errorMessage = nullptr;
+    if (sqlite3_exec(connection, sql.c_str(), nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+        std::cerr << "Failed to open CSV file " << csvPath << ": "
+                  << (errorMessage ? errorMessage : "unknown error") << std::endl;
+        sqlite3_free(errorMessage);
+        return false;
+    }
+    return true;
+}
+
+sqlite3 *SQLiteDatabase::acquireReader() {
+    // A transaction open on the main connection holds changes no reader can see yet
+    if (writerInTransaction) {
+        return nullptr;
+    }
+
+    SqliteProfile openProfile;
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        if (!readersEnabled) {
+            return nullptr;
+        }
+        if (!idleReaders.empty()) {
+            sqlite3 *reader = idleReaders.back();
+            idleReaders.pop_back();
+            return reader;
+        }
+        if (openReaders >= kMaxReaders) {
+            return nullptr;
+        }
+        openReaders++;
+        openProfile = readerProfile;
+    }
+
+    // Each reader is only ever used by one thread at a time
+    sqlite3 *reader = nullptr;
+    if (sqlite3_open_v2(fileUri(path, openProfile).c_str(), &reader,
+                        openFlags(openProfile) | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to open reader for " << path << ": " << sqlite3_errmsg(reader)
+                  << std::endl;
+        sqlite3_close(reader);
+        std::lock_guard<std::mutex> lock(readerMutex);
+        openReaders--;
+        return nullptr;
+    }
+    applyProfile(reader, openProfile);
+    sqlite3_busy_timeout(reader, 5000);
+    TableDiff::registerFunctions(reader);
+    return reader;
+}
+
+void SQLiteDatabase::releaseReader(sqlite3 *reader) {
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        if (readersEnabled) {
+            idleReaders.push_back(reader);
+            return;
+        }
+        openReaders--;
+    }
+    sqlite3_close(reader);
+}
+
+bool SQLiteDatabase::prepareOnReader(sqlite3 *reader, const std::string &sql,
+                                     sqlite3_stmt *&stmt) {
+    ReaderCheck check;
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        check.tempNames = tempNames;
+    }
+    sqlite3_set_authorizer(reader, checkReaderAccess, &check);
+    const int rc = sqlite3_prepare_v2(reader, sql.c_str(), -1, &stmt, nullptr);
+    sqlite3_set_authorizer(reader, nullptr, nullptr);
+    if (rc != SQLITE_OK || (stmt && !sqlite3_stmt_readonly(stmt)) || check.needsWriter) {
+        sqlite3_finalize(stmt);
+        stmt = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void SQLiteDatabase::updateWriterState() {
+    writerInTransaction = sqlite3_get_autocommit(connection) == 0;
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        if (!readersEnabled) {
+            return;
+        }
+    }
+
+    std::unordered_set<std::string> names;
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(connection, "SELECT name FROM temp.sqlite_master", -1, &stmt,
+                           nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            names.insert(lowerCase(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0))));
+        }
+    }
+    sqlite3_finalize(stmt);
+    std::lock_guard<std::mutex> lock(readerMutex);
+    tempNames.swap(names);
+}
+
+void SQLiteDatabase::closeReaders() {
+    // Readers still lent out are closed when they come back
+    std::vector<sqlite3 *> idle;
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        readersEnabled = false;
+        idle.swap(idleReaders);
+        openReaders -= idle.size();
+    }
+    for (sqlite3 *reader : idle) {
+        sqlite3_close(reader);
+    }
+}
+
 void SQLiteDatabase::disconnect() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    closeReaders();
     if (connection) {
         sqlite3_close(connection);
         connection = nullptr;
@@ -55,6 +758,7 @@ DatabaseType SQLiteDatabase::getType() const {
 }
 
 void SQLiteDatabase::refreshTables() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     std::cout << "Refreshing tables for database: " << name << std::endl;
     if (!connect()) {
         std::cout << "Failed to connect to database" << std::endl;
@@ -63,18 +767,24 @@ void SQLiteDatabase::refreshTables() {
     }
 
     tables.clear();
-    std::vector<std::string> tableNames = getTableNames();
-    std::cout << "Found " << tableNames.size() << " tables" << std::endl;
+    std::vector<Definition> definitions;
+    readDefinitions(definitions);
+    std::cout << "Found " << definitions.size() << " tables" << std::endl;
 
-    for (const auto &tableName : tableNames) {
-        std::cout << "Adding table: " << tableName << std::endl;
+    std::lock_guard<std::mutex> signaturesLock(signaturesMutex);
+    signatures.clear();
+    for (const auto &definition : definitions) {
+        std::cout << "Adding table: " << definition.name << std::endl;
         Table table;
-        table.name = tableName;
-        table.columns = getTableColumns(tableName);
+        table.name = definition.name;
+        table.kind = definition.isView ? TableKind::VIEW : TableKind::TABLE;
+        table.columns = getTableColumns(definition.name);
         tables.push_back(table);
+        signatures[definition.name] = definition.sql;
     }
     std::cout << "Finished refreshing tables. Total tables: " << tables.size() << std::endl;
     tablesLoaded = true;
+    schemaGeneration++;
 }
 
 const std::vector<Table> &SQLiteDatabase::getTables() const {
@@ -93,71 +803,324 @@ void SQLiteDatabase::setTablesLoaded(bool loaded) {
     tablesLoaded = loaded;
 }
 
+uint64_t SQLiteDatabase::getSchemaGeneration() const {
+    return schemaGeneration;
+}
+
+const std::vector<Schema> &SQLiteDatabase::getSchemas() const {
+    // Every table is listed up front, temp and attached CSV tables included
+    static const std::vector<Schema> none;
+    return none;
+}
+
+SchemaPatch SQLiteDatabase::fetchSchema(const std::string &) {
+    SchemaPatch patch;
+    patch.generation = schemaGeneration;
+    return patch;
+}
+
+bool SQLiteDatabase::loadTableColumns(const std::string &tableName) {
+    // Columns are read with the table list
+    return std::any_of(tables.begin(), tables.end(),
+                       [&tableName](const Table &table) { return table.name == tableName; });
+}
+
+std::string SQLiteDatabase::quoteTableName(const std::string &tableName) const {
+    return SqlScript::quoteIdentifier(tableName);
+}
+
+std::string SQLiteDatabase::getSchemaToken() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    if (!connect()) {
+        return "";
+    }
+
+    // Every DDL statement bumps the schema cookie, whichever connection runs it; temp tables have
+    // a cookie of their own
+    const std::string mainVersion = pragmaValue(connection, "PRAGMA main.schema_version");
+    const std::string tempVersion = pragmaValue(connection, "PRAGMA temp.schema_version");
+    if (mainVersion.empty()) {
+        return "";
+    }
+    return mainVersion + ":" + tempVersion;
+}
+
+SchemaPatch SQLiteDatabase::diffSchema() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    SchemaPatch patch;
+    patch.generation = schemaGeneration;
+    if (!connect()) {
+        patch.error = "Not connected";
+        return patch;
+    }
+
+    std::unordered_map<std::string, std::string> known;
+    {
+        std::lock_guard<std::mutex> signaturesLock(signaturesMutex);
+        known = signatures;
+    }
+
+    std::vector<Definition> definitions;
+    if (!readDefinitions(definitions)) {
+        patch.error = sqlite3_errmsg(connection);
+        return patch;
+    }
+
+    // ALTER TABLE rewrites the stored CREATE statement, so comparing those finds every change
+    for (auto &definition : definitions) {
+        const auto it = known.find(definition.name);
+        const bool unchanged = it != known.end() && it->second == definition.sql;
+        if (it != known.end()) {
+            known.erase(it);
+        }
+        if (unchanged) {
+            continue;
+        }
+        Table table;
+        table.name = definition.name;
+        table.kind = definition.isView ? TableKind::VIEW : TableKind::TABLE;
+        table.columns = getTableColumns(definition.name);
+        patch.changed.push_back(std::move(table));
+        patch.signatures.push_back(std::move(definition.sql));
+    }
+    for (const auto &entry : known) {
+        patch.removed.push_back(entry.first);
+    }
+    return patch;
+}
+
+bool SQLiteDatabase::applySchemaPatch(SchemaPatch patch) {
+    if (patch.generation != schemaGeneration || !patch.error.empty()) {
+        return false;
+    }
+    if (patch.isEmpty()) {
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> signaturesLock(signaturesMutex);
+        for (const auto &tableName : patch.removed) {
+            signatures.erase(tableName);
+        }
+        for (size_t i = 0; i < patch.changed.size(); i++) {
+            signatures[patch.changed[i].name] = patch.signatures[i];
+        }
+    }
+
+    // Replaced tables stay expanded if they were
+    std::unordered_map<std::string, bool> replaced;
+    for (const auto &tableName : patch.removed) {
+        replaced[tableName] = false;
+    }
+    for (const auto &table : patch.changed) {
+        replaced[table.name] = false;
+    }
+    for (const auto &table : tables) {
+        const auto it = replaced.find(table.name);
+        if (it != replaced.end()) {
+            it->second = it->second || table.expanded;
+        }
+    }
+    tables.erase(std::remove_if(tables.begin(), tables.end(),
+                                [&replaced](const Table &table) {
+                                    return replaced.count(table.name) > 0;
+                                }),
+                 tables.end());
+    for (auto &table : patch.changed) {
+        table.expanded = replaced[table.name];
+        tables.push_back(std::move(table));
+    }
+    std::stable_sort(tables.begin(), tables.end(),
+                     [](const Table &a, const Table &b) { return a.name < b.name; });
+    schemaGeneration++;
+    return true;
+}
+
 std::string SQLiteDatabase::executeQuery(const std::string &query) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     if (!connect()) {
         return "Error: Failed to connect to database";
     }
 
-    std::stringstream result;
+    const auto started = std::chrono::steady_clock::now();
     sqlite3_stmt *stmt;
-
     if (sqlite3_prepare_v2(connection, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         return "Error: " + std::string(sqlite3_errmsg(connection));
     }
 
-    int columnCount = sqlite3_column_count(stmt);
-    if (columnCount > 0) {
-        for (int i = 0; i < columnCount; i++) {
-            result << sqlite3_column_name(stmt, i);
-            if (i < columnCount - 1)
-                result << " | ";
+    std::string output;
+    uint64_t rows = 0;
+    if (formatStatement(connection, stmt, output, &rows)) {
+        StatementStats::record(name, query, elapsedMs(started), rows);
+    }
+    sqlite3_finalize(stmt);
+    updateWriterState();
+    return output;
+}
+
+std::vector<StatementResult> SQLiteDatabase::executeScript(const std::string &script,
+                                                           QueryProgress *progress) {
+    // A script that only reads runs on a reader, provided every statement prepares there
+    const auto statements = SqlScript::splitStatements(script);
+    const bool readOnly =
+        !statements.empty() &&
+        std::all_of(statements.begin(), statements.end(), SqlScript::isReadOnly);
+    auto preparesOn = [this](sqlite3 *reader, const std::string &sql) {
+        sqlite3_stmt *stmt = nullptr;
+        const bool ok = prepareOnReader(reader, sql, stmt);
+        sqlite3_finalize(stmt);
+        return ok;
+    };
+    if (sqlite3 *reader = readOnly ? acquireReader() : nullptr) {
+        const bool fits = std::all_of(statements.begin(), statements.end(),
+                                      [&](const auto &sql) { return preparesOn(reader, sql); });
+        if (fits) {
+            auto results = runScript(reader, script, progress);
+            releaseReader(reader);
+            return results;
         }
-        result << "\n";
+        releaseReader(reader);
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    if (!connect()) {
+        StatementResult failure;
+        failure.sql = script;
+        failure.error = "Failed to connect to database";
+        return {failure};
+    }
+    auto results = runScript(connection, script, progress);
+    updateWriterState();
+    return results;
+}
 
-        for (int i = 0; i < columnCount; i++) {
-            result << "----------";
-            if (i < columnCount - 1)
-                result << "-+-";
+std::vector<StatementResult> SQLiteDatabase::runScript(sqlite3 *db, const std::string &script,
+                                                       QueryProgress *progress) {
+    std::vector<StatementResult> results;
+    auto skipRemaining = [&results](const std::vector<std::string> &statements, size_t from) {
+        for (size_t i = from; i < statements.size(); i++) {
+            StatementResult skipped;
+            skipped.sql = statements[i];
+            skipped.error = "Skipped: an earlier statement failed";
+            results.push_back(skipped);
         }
-        result << "\n";
+    };
+
+    const ProgressScope progressScope(*this, db, progress);
+
+    // Run the whole script in one transaction unless it manages its own
+    const bool ownTransaction =
+        sqlite3_get_autocommit(db) != 0 &&
+        !SqlScript::managesTransactions(SqlScript::splitStatements(script));
+    if (ownTransaction) {
+        sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
     }
 
-    int rowCount = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW && rowCount < 1000) {
-        for (int i = 0; i < columnCount; i++) {
-            const char *text = (const char *)sqlite3_column_text(stmt, i);
-            result << (text ? text : "NULL");
-            if (i < columnCount - 1)
-                result << " | ";
+    bool failed = false;
+    const char *tail = script.c_str();
+    while (tail && *tail) {
+        const char *head = tail;
+        const auto started = std::chrono::steady_clock::now();
+
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(db, head, -1, &stmt, &tail) != SQLITE_OK) {
+            // The tail isn't advanced past a statement that fails to prepare
+            const auto remaining = SqlScript::splitStatements(head);
+            StatementResult result;
+            result.sql = remaining.empty() ? SqlScript::trim(head) : remaining.front();
+            result.executed = true;
+            result.error = sqlite3_errmsg(db);
+            result.elapsedMs = elapsedMs(started);
+            results.push_back(result);
+            skipRemaining(remaining, 1);
+            failed = true;
+            break;
+        }
+        if (!stmt) {
+            continue; // Only whitespace or comments were left
+        }
+
+        StatementResult result;
+        result.sql = SqlScript::trim(sqlite3_sql(stmt));
+        result.executed = true;
+        uint64_t rows = 0;
+        result.success = formatStatement(db, stmt, result.output, &rows);
+        if (!result.success) {
+            result.error = sqlite3_errmsg(db);
+        }
+        sqlite3_finalize(stmt);
+        result.elapsedMs = elapsedMs(started);
+        if (result.success) {
+            StatementStats::record(name, result.sql, result.elapsedMs, rows);
+        }
+        results.push_back(result);
+
+        if (!result.success) {
+            skipRemaining(SqlScript::splitStatements(tail), 0);
+            failed = true;
+            break;
         }
-        result << "\n";
-        rowCount++;
     }
 
-    if (rowCount == 0 && columnCount == 0) {
-        result << "Query executed successfully. Rows affected: " << sqlite3_changes(connection);
-    } else if (rowCount == 1000) {
-        result << "\n... (showing first 1000 rows)";
+    if (ownTransaction) {
+        sqlite3_exec(db, failed ? "ROLLBACK" : "COMMIT", nullptr, nullptr, nullptr);
     }
+    return results;
+}
 
-    sqlite3_finalize(stmt);
-    return result.str();
+StatementResult SQLiteDatabase::streamQuery(const std::string &query, RowSink &sink,
+                                            QueryProgress *progress) {
+    StatementResult result;
+    result.sql = query;
+    const auto started = std::chrono::steady_clock::now();
+    const PooledStatement statement(*this, query, SqlScript::isReadOnly(query));
+    sqlite3 *db = statement.getConnection();
+    if (!db) {
+        result.error = "Failed to connect to database";
+        return result;
+    }
+
+    const ProgressScope progressScope(*this, db, progress);
+    sqlite3_stmt *stmt = statement.get();
+    result.executed = true;
+    if (!stmt) {
+        result.error = sqlite3_errmsg(db);
+        return result;
+    }
+
+    const int columnCount = sqlite3_column_count(stmt);
+    uint64_t rowCount = 0;
+    const int rc = emitRows(stmt, sink, progress, rowCount);
+    if (rc != SQLITE_DONE) {
+        result.error = sqlite3_errmsg(db);
+    } else {
+        result.success = true;
+        if (columnCount == 0) {
+            rowCount = sqlite3_changes(db);
+            result.output = "Query executed successfully. Rows affected: " +
+                            std::to_string(rowCount);
+        }
+    }
+
+    result.elapsedMs = elapsedMs(started);
+    if (result.success) {
+        StatementStats::record(name, query, result.elapsedMs, rowCount);
+    }
+    return result;
 }
 
 std::vector<std::vector<std::string>>
 SQLiteDatabase::getTableData(const std::string &tableName, const int limit, const int offset) {
     std::vector<std::vector<std::string>> data;
-    if (!connect()) {
-        return data;
-    }
-
-    std::string sql = "SELECT * FROM " + tableName + " LIMIT " + std::to_string(limit) +
-                      " OFFSET " + std::to_string(offset);
+    std::string sql = "SELECT * FROM " + quoteTableName(tableName) + " LIMIT " +
+                      std::to_string(limit) + " OFFSET " + std::to_string(offset);
 
-    sqlite3_stmt *stmt;
-    if (sqlite3_prepare_v2(connection, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    const auto started = std::chrono::steady_clock::now();
+    const PooledStatement statement(*this, sql, true);
+    if (sqlite3_stmt *stmt = statement.get()) {
         int columnCount = sqlite3_column_count(stmt);
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
             std::vector<std::string> row;
             for (int i = 0; i < columnCount; i++) {
                 auto text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, i));
@@ -165,18 +1128,21 @@ SQLiteDatabase::getTableData(const std::string &tableName, const int limit, cons
             }
             data.push_back(row);
         }
+        if (rc == SQLITE_DONE) {
+            StatementStats::record(name, sql, elapsedMs(started), data.size());
+        }
     }
-    sqlite3_finalize(stmt);
     return data;
 }
 
 std::vector<std::string> SQLiteDatabase::getColumnNames(const std::string &tableName) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     std::vector<std::string> columnNames;
     if (!connect()) {
         return columnNames;
     }
 
-    const std::string sql = "PRAGMA table_info(" + tableName + ");";
+    const std::string sql = "PRAGMA table_info(" + quoteTableName(tableName) + ");";
     sqlite3_stmt *stmt;
 
     if (sqlite3_prepare_v2(connection, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
@@ -189,23 +1155,34 @@ std::vector<std::string> SQLiteDatabase::getColumnNames(const std::string &table
 }
 
 int SQLiteDatabase::getRowCount(const std::string &tableName) {
-    if (!connect()) {
-        return 0;
-    }
-
-    const std::string sql = "SELECT COUNT(*) FROM " + tableName;
-    sqlite3_stmt *stmt;
+    const std::string sql = "SELECT COUNT(*) FROM " + quoteTableName(tableName);
+    const PooledStatement statement(*this, sql, true);
     int count = 0;
-
-    if (sqlite3_prepare_v2(connection, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    if (sqlite3_stmt *stmt = statement.get()) {
         if (sqlite3_step(stmt) == SQLITE_ROW) {
             count = sqlite3_column_int(stmt, 0);
         }
     }
-    sqlite3_finalize(stmt);
     return count;
 }
 
+std::string SQLiteDatabase::getChangeToken() {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    if (!connect()) {
+        return "";
+    }
+
+    // data_version moves when another connection commits, total_changes when this one writes
+    // and schema_version on DDL, which total_changes does not count
+    const std::string dataVersion = pragmaValue(connection, "PRAGMA data_version");
+    const std::string schemaVersion = pragmaValue(connection, "PRAGMA schema_version");
+    if (dataVersion.empty() || schemaVersion.empty()) {
+        return "";
+    }
+    return dataVersion + ":" + schemaVersion + ":" +
+           std::to_string(sqlite3_total_changes(connection));
+}
+
 bool SQLiteDatabase::isExpanded() const {
     return expanded;
 }
@@ -218,33 +1195,198 @@ void *SQLiteDatabase::getConnection() const {
     return connection;
 }
 
-std::vector<std::string> SQLiteDatabase::getTableNames() {
-    std::vector<std::string> tableNames;
+QueryPlan SQLiteDatabase::explainQuery(const std::string &query, bool) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    QueryPlan plan;
+    plan.sql = query;
+    if (!connect()) {
+        plan.error = "Failed to connect to database";
+        return plan;
+    }
+
+    // SQLite has no per-node timings or costs, so there is nothing extra to analyze
+    sqlite3_stmt *stmt;
+    const std::string sql = "EXPLAIN QUERY PLAN " + query;
+    if (sqlite3_prepare_v2(connection, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        plan.error = sqlite3_errmsg(connection);
+        return plan;
+    }
+
+    std::vector<QueryPlanParser::SqliteRow> rows;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        QueryPlanParser::SqliteRow row;
+        row.id = sqlite3_column_int(stmt, 0);
+        row.parent = sqlite3_column_int(stmt, 1);
+        const auto detail = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+        row.detail = detail ? detail : "";
+        rows.push_back(std::move(row));
+    }
+    sqlite3_finalize(stmt);
+
+    plan = QueryPlanParser::fromSqlite(rows);
+    plan.sql = query;
+
+    // The largest rowid is a cheap upper bound on the row count
+    QueryPlanParser::annotate(plan, [this, &query](const std::string &relation) {
+        std::string quoted = tableForAlias(query, relation);
+        for (size_t pos = 0; (pos = quoted.find('"', pos)) != std::string::npos; pos += 2) {
+            quoted.insert(pos, 1, '"');
+        }
+        const std::string countSql = "SELECT MAX(rowid) FROM \"" + quoted + "\"";
+        sqlite3_stmt *countStmt;
+        double rowCount = -1.0;
+        if (sqlite3_prepare_v2(connection, countSql.c_str(), -1, &countStmt, nullptr) ==
+                SQLITE_OK &&
+            sqlite3_step(countStmt) == SQLITE_ROW &&
+            sqlite3_column_type(countStmt, 0) != SQLITE_NULL) {
+            rowCount = sqlite3_column_double(countStmt, 0);
+        }
+        sqlite3_finalize(countStmt);
+        return rowCount;
+    });
+    return plan;
+}
+
+std::unique_ptr<ParallelReader> SQLiteDatabase::beginParallelRead(const std::string &tableName,
+                                                                  const size_t minChunks,
+                                                                  std::string &error) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    if (path == ":memory:" || CsvTable::isCsvPath(path)) {
+        error = "In-memory databases can only be read through their own connection";
+        return nullptr;
+    }
+    if (!connect()) {
+        error = "Failed to connect to database";
+        return nullptr;
+    }
+
+    const std::string table = SqlScript::quoteIdentifier(tableName);
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(connection, ("SELECT min(rowid), max(rowid) FROM " + table).c_str(), -1,
+                           &stmt, nullptr) != SQLITE_OK) {
+        // Views and WITHOUT ROWID tables have no rowid to split on
+        error = sqlite3_errmsg(connection);
+        return nullptr;
+    }
+
+    std::vector<std::string> queries;
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+        const auto first = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+        const auto last = static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+        const uint64_t span = last - first + 1;
+        const uint64_t chunks = std::min<uint64_t>(
+            span,
+            std::max<uint64_t>({minChunks, (span + kMaxChunkRowids - 1) / kMaxChunkRowids, 1}));
+
+        // Equal slices of the rowid range; the first span % chunks slices get one extra rowid
+        uint64_t low = first;
+        for (uint64_t i = 0; i < chunks; i++) {
+            const uint64_t size = span / chunks + (i < span % chunks ? 1 : 0);
+            const uint64_t high = low + size - 1;
+            queries.push_back("SELECT * FROM " + table + " WHERE rowid BETWEEN " +
+                              std::to_string(static_cast<sqlite3_int64>(low)) + " AND " +
+                              std::to_string(static_cast<sqlite3_int64>(high)));
+            low = high + 1;
+        }
+    } else {
+        // Empty table: one chunk, so the column names still come through
+        queries.push_back("SELECT * FROM " + table);
+    }
+    sqlite3_finalize(stmt);
+
+    return std::make_unique<SqliteParallelReader>(path, profile, std::move(queries));
+}
+
+std::unique_ptr<TableWriter> SQLiteDatabase::beginTableWrite(const std::string &tableName,
+                                                             const std::vector<Column> &columns,
+                                                             std::string &error) {
+    std::unique_lock<std::recursive_mutex> lock(connectionMutex);
+    if (!connect()) {
+        error = "Failed to connect to database";
+        return nullptr;
+    }
+
+    std::unique_ptr<SqliteTableWriter> writer;
+    if (path == ":memory:" || CsvTable::isCsvPath(path)) {
+        writer = std::make_unique<SqliteTableWriter>(connection, std::move(lock));
+    } else {
+        lock.unlock();
+        sqlite3 *db = nullptr;
+        if (sqlite3_open_v2(fileUri(path, profile).c_str(), &db,
+                            openFlags(profile) | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+            error = "Failed to open " + path + ": " + sqlite3_errmsg(db);
+            sqlite3_close(db);
+            return nullptr;
+        }
+        applyProfile(db, profile);
+        sqlite3_busy_timeout(db, 5000);
+        writer = std::make_unique<SqliteTableWriter>(db, std::unique_lock<std::recursive_mutex>());
+    }
+    if (!writer->begin(tableName, columns)) {
+        error = writer->getError();
+        return nullptr;
+    }
+    return writer;
+}
+
+bool SQLiteDatabase::isBusy() const {
+    if (!connectionMutex.try_lock()) {
+        return true;
+    }
+    connectionMutex.unlock();
+    return false;
+}
+
+std::string SQLiteDatabase::pollProgress(QueryProgress &) {
+    // The progress handler counts steps and checks for cancellation itself
+    return "";
+}
+
+void SQLiteDatabase::cancel(QueryProgress &progress) {
+    // The progress handler stops a statement that hasn't started yet; one that is running is
+    // interrupted on whichever connection it is using
+    progress.cancelRequested = true;
+    std::lock_guard<std::mutex> lock(runningMutex);
+    const auto it = runningStatements.find(&progress);
+    if (it != runningStatements.end()) {
+        sqlite3_interrupt(it->second);
+    }
+}
+
+bool SQLiteDatabase::readDefinitions(std::vector<Definition> &definitions) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
+    // A temp table hides a main one of the same name, so only the temp one is listed; it sorts
+    // first among names that differ only in case, which SQLite treats as the same
     const char *sql =
-        "SELECT name FROM sqlite_master WHERE type IN ('table', 'view') ORDER BY name;";
+        "SELECT name, type, sql, 0 FROM sqlite_master WHERE type IN ('table', 'view') UNION ALL "
+        "SELECT name, type, sql, 1 FROM sqlite_temp_master WHERE type IN ('table', 'view') "
+        "ORDER BY 1 COLLATE NOCASE, 4 DESC;";
     sqlite3_stmt *stmt;
 
-    std::cout << "Executing query to get table names..." << std::endl;
+    std::unordered_set<std::string> seen;
     int rc = sqlite3_prepare_v2(connection, sql, -1, &stmt, nullptr);
     if (rc == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            auto tableName = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-            if (tableName) {
-                std::cout << "Found table: " << tableName << std::endl;
-                tableNames.emplace_back(tableName);
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const auto name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+            const auto type = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+            const auto text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+            if (name && seen.insert(lowerCase(name)).second) {
+                definitions.push_back(
+                    {name, text ? text : "", type && std::string(type) == "view"});
             }
         }
-    } else {
-        std::cerr << "Failed to prepare SQL statement: " << sqlite3_errmsg(connection) << std::endl;
+    }
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Failed to read the schema: " << sqlite3_errmsg(connection) << std::endl;
     }
     sqlite3_finalize(stmt);
-    std::cout << "Query completed. Found " << tableNames.size() << " tables." << std::endl;
-    return tableNames;
+    return rc == SQLITE_DONE;
 }
 
 std::vector<Column> SQLiteDatabase::getTableColumns(const std::string &tableName) {
+    std::lock_guard<std::recursive_mutex> lock(connectionMutex);
     std::vector<Column> columns;
-    std::string sql = "PRAGMA table_info(" + tableName + ");";
+    std::string sql = "PRAGMA table_info(" + SqlScript::quoteIdentifier(tableName) + ");";
     sqlite3_stmt *stmt;
 
     if (sqlite3_prepare_v2(connection, sql.c_str(), -1, &stmt, NULL) == SQLITE_OK) {
@@ -253,7 +1395,8 @@ std::vector<Column> SQLiteDatabase::getTableColumns(const std::string &tableName
             col.name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
             col.type = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
             col.isNotNull = sqlite3_column_int(stmt, 3) == 1;
-            col.isPrimaryKey = sqlite3_column_int(stmt, 5) == 1;
+            // pk is the column's position in the key, 0 if it isn't part of it
+            col.isPrimaryKey = sqlite3_column_int(stmt, 5) > 0;
             columns.push_back(col);
         }
     }
@@ -0,0 +1,121 @@
+#include "database/sqlite_profile.hpp"
+#include "utils/app_paths.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <nlohmann/json.hpp>
+
+namespace {
+    using json = nlohmann::json;
+
+    // Serializes the read-modify-write of the profile file
+    std::mutex profilesMutex;
+
+    std::string profilesPath() {
+        return AppPaths::dataFile("sqlite_profiles.json");
+    }
+
+    // Profiles are keyed by absolute path, so the same file opened two ways shares one
+    std::string profileKey(const std::string &path) {
+        std::error_code error;
+        const std::filesystem::path absolute = std::filesystem::absolute(path, error);
+        return error ? path : absolute.lexically_normal().string();
+    }
+
+    json readProfiles(const std::string &file) {
+        std::ifstream in(file);
+        if (!in) {
+            return json::object();
+        }
+        json profiles = json::parse(in, nullptr, false);
+        return profiles.is_object() ? profiles : json::object();
+    }
+} // namespace
+
+SqliteProfile SqliteProfile::defaultsFor(const std::string &path) {
+    SqliteProfile profile;
+    std::error_code error;
+    const auto status = std::filesystem::status(path, error);
+    if (error || !std::filesystem::is_regular_file(status)) {
+        return profile;
+    }
+
+    // Nothing can be written anyway, and mapping the file lets large read-only databases be
+    // browsed without copying every page through the cache
+    using std::filesystem::perms;
+    const perms writable = perms::owner_write | perms::group_write | perms::others_write;
+    if ((status.permissions() & writable) == perms::none) {
+        profile.readOnly = true;
+        profile.mmapSize = static_cast<int64_t>(std::filesystem::file_size(path, error));
+        if (error) {
+            profile.mmapSize = 0;
+        }
+    }
+    return profile;
+}
+
+SqliteProfile SqliteProfile::load(const std::string &path) {
+    SqliteProfile profile = defaultsFor(path);
+    const std::string file = profilesPath();
+    if (file.empty()) {
+        return profile;
+    }
+
+    json profiles;
+    {
+        std::lock_guard<std::mutex> lock(profilesMutex);
+        profiles = readProfiles(file);
+    }
+    const auto it = profiles.find(profileKey(path));
+    if (it == profiles.end() || !it->is_object()) {
+        return profile;
+    }
+
+    const json &saved = *it;
+    profile.readOnly = saved.value("readOnly", profile.readOnly);
+    profile.immutable = saved.value("immutable", profile.immutable);
+    profile.mmapSize = saved.value("mmapSize", profile.mmapSize);
+    profile.cacheSizeKb = saved.value("cacheSizeKb", profile.cacheSizeKb);
+    profile.wal = saved.value("wal", profile.wal);
+    profile.tempStoreMemory = saved.value("tempStoreMemory", profile.tempStoreMemory);
+    profile.noMutex = saved.value("noMutex", profile.noMutex);
+    return profile;
+}
+
+bool SqliteProfile::save(const std::string &path, const SqliteProfile &profile) {
+    const std::string file = profilesPath();
+    if (file.empty()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profilesMutex);
+    json profiles = readProfiles(file);
+    profiles[profileKey(path)] = {
+        {"readOnly", profile.readOnly},
+        {"immutable", profile.immutable},
+        {"mmapSize", profile.mmapSize},
+        {"cacheSizeKb", profile.cacheSizeKb},
+        {"wal", profile.wal},
+        {"tempStoreMemory", profile.tempStoreMemory},
+        {"noMutex", profile.noMutex},
+    };
+
+    // Written aside and renamed over, so a crash never leaves half a file
+    const std::string temporary = file + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << profiles.dump(2);
+        if (!out) {
+            std::cerr << "Failed to write " << temporary << std::endl;
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, file, error);
+    if (error) {
+        std::cerr << "Failed to save SQLite profiles: " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,273 @@
+#include "database/statement_stats.hpp"
+#include "database/sql_script.hpp"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+    constexpr int kBucketsPerOctave = 4;
+
+    struct Slot {
+        StatementStats::Entry entry;
+        bool dirty = false;
+    };
+
+    // Aggregates, touched by every backend call
+    std::mutex statsMutex;
+    std::unordered_map<std::string, Slot> slots;
+    std::vector<std::pair<std::string, std::string>> evicted;
+    bool clearStore = false;
+    uint64_t generation = 0;
+
+    // The store is only written by flush(), which may run on a worker
+    std::mutex storeMutex;
+    sqlite3 *store = nullptr;
+
+    std::string slotKey(const std::string &database, const std::string &fingerprint) {
+        return database + '\n' + fingerprint;
+    }
+
+    size_t bucketFor(const double elapsedMs) {
+        const double micros = elapsedMs * 1000.0;
+        if (micros < 1.0) {
+            return 0;
+        }
+        const auto bucket = static_cast<size_t>(std::log2(micros) * kBucketsPerOctave) + 1;
+        return std::min(bucket, StatementStats::kHistogramBuckets - 1);
+    }
+
+    bool exec(const char *sql) {
+        char *error = nullptr;
+        if (sqlite3_exec(store, sql, nullptr, nullptr, &error) != SQLITE_OK) {
+            std::cerr << "Statement stats store: " << (error ? error : "unknown error")
+                      << std::endl;
+            sqlite3_free(error);
+            return false;
+        }
+        return true;
+    }
+
+    void load() {
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(store,
+                               "SELECT database, fingerprint, calls, total_ms, min_ms, max_ms, "
+                               "rows, last_seen, histogram FROM statement_stats",
+                               -1, &stmt, nullptr) != SQLITE_OK) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            StatementStats::Entry entry;
+            entry.database = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+            entry.fingerprint = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+            entry.calls = static_cast<uint64_t>(sqlite3_column_int64(stmt, 2));
+            entry.totalMs = sqlite3_column_double(stmt, 3);
+            entry.minMs = sqlite3_column_double(stmt, 4);
+            entry.maxMs = sqlite3_column_double(stmt, 5);
+            entry.rows = static_cast<uint64_t>(sqlite3_column_int64(stmt, 6));
+            entry.lastSeen = sqlite3_column_int64(stmt, 7);
+            const size_t bytes = std::min<size_t>(sqlite3_column_bytes(stmt, 8),
+                                                  sizeof(entry.histogram));
+            if (bytes > 0) {
+                memcpy(entry.histogram.data(), sqlite3_column_blob(stmt, 8), bytes);
+            }
+
+            // Statements recorded before the store was opened win over stale totals
+            const std::string key = slotKey(entry.database, entry.fingerprint);
+            if (slots.find(key) == slots.end()) {
+                slots[key].entry = std::move(entry);
+            }
+        }
+        sqlite3_finalize(stmt);
+        generation++;
+    }
+} // namespace
+
+double StatementStats::Entry::percentileMs(const double fraction) const {
+    if (calls == 0) {
+        return 0.0;
+    }
+
+    const auto target = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(calls)));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < kHistogramBuckets; bucket++) {
+        seen += histogram[bucket];
+        if (seen >= target && histogram[bucket] > 0) {
+            // Geometric middle of the bucket, kept within what was actually observed
+            const double micros =
+                bucket == 0 ? 0.5
+                            : std::exp2((static_cast<double>(bucket) - 0.5) / kBucketsPerOctave);
+            return std::clamp(micros / 1000.0, minMs, maxMs);
+        }
+    }
+    return maxMs;
+}
+
+bool StatementStats::open(const std::string &path) {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    if (store) {
+        sqlite3_close(store);
+        store = nullptr;
+    }
+    if (sqlite3_open_v2(path.c_str(), &store, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                        nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to open statement stats at " << path << ": "
+                  << sqlite3_errmsg(store) << std::endl;
+        sqlite3_close(store);
+        store = nullptr;
+        return false;
+    }
+
+    // Another instance may be flushing at the same moment
+    sqlite3_busy_timeout(store, 1000);
+    if (!exec("CREATE TABLE IF NOT EXISTS statement_stats ("
+              "database TEXT NOT NULL, fingerprint TEXT NOT NULL, calls INTEGER NOT NULL, "
+              "total_ms REAL NOT NULL, min_ms REAL NOT NULL, max_ms REAL NOT NULL, "
+              "rows INTEGER NOT NULL, last_seen INTEGER NOT NULL, histogram BLOB, "
+              "PRIMARY KEY (database, fingerprint))")) {
+        sqlite3_close(store);
+        store = nullptr;
+        return false;
+    }
+
+    load();
+    return true;
+}
+
+void StatementStats::record(const std::string &database, const std::string &sql,
+                            const double elapsedMs, const uint64_t rows) {
+    const std::string fingerprint = SqlScript::fingerprint(sql);
+    if (fingerprint.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    auto [it, inserted] = slots.try_emplace(slotKey(database, fingerprint));
+    Entry &entry = it->second.entry;
+    if (inserted) {
+        entry.database = database;
+        entry.fingerprint = fingerprint;
+        entry.minMs = elapsedMs;
+    }
+
+    entry.calls++;
+    entry.totalMs += elapsedMs;
+    entry.minMs = std::min(entry.minMs, elapsedMs);
+    entry.maxMs = std::max(entry.maxMs, elapsedMs);
+    entry.rows += rows;
+    entry.lastSeen = static_cast<int64_t>(std::time(nullptr));
+    entry.histogram[bucketFor(elapsedMs)]++;
+    it->second.dirty = true;
+    generation++;
+
+    if (slots.size() > kMaxEntries) {
+        auto victim = slots.end();
+        for (auto candidate = slots.begin(); candidate != slots.end(); ++candidate) {
+            if (candidate != it && (victim == slots.end() || candidate->second.entry.calls <
+                                                                 victim->second.entry.calls)) {
+                victim = candidate;
+            }
+        }
+        evicted.emplace_back(victim->second.entry.database, victim->second.entry.fingerprint);
+        slots.erase(victim);
+    }
+}
+
+std::vector<StatementStats::Entry> StatementStats::snapshot() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    std::vector<Entry> result;
+    result.reserve(slots.size());
+    for (const auto &[key, slot] : slots) {
+        result.push_back(slot.entry);
+    }
+    return result;
+}
+
+uint64_t StatementStats::getGeneration() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return generation;
+}
+
+void StatementStats::flush() {
+    std::lock_guard<std::mutex> storeLock(storeMutex);
+
+    std::vector<Entry> changed;
+    std::vector<std::pair<std::string, std::string>> removed;
+    bool clear = false;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        for (auto &[key, slot] : slots) {
+            if (slot.dirty) {
+                changed.push_back(slot.entry);
+                slot.dirty = false;
+            }
+        }
+        removed.swap(evicted);
+        std::swap(clear, clearStore);
+    }
+    if (!store || (changed.empty() && removed.empty() && !clear)) {
+        return;
+    }
+
+    exec("BEGIN");
+    if (clear) {
+        exec("DELETE FROM statement_stats");
+    }
+
+    sqlite3_stmt *remove = nullptr;
+    sqlite3_prepare_v2(store, "DELETE FROM statement_stats WHERE database = ? AND fingerprint = ?",
+                       -1, &remove, nullptr);
+    for (const auto &[database, fingerprint] : removed) {
+        sqlite3_bind_text(remove, 1, database.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(remove, 2, fingerprint.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(remove);
+        sqlite3_reset(remove);
+    }
+    sqlite3_finalize(remove);
+
+    sqlite3_stmt *upsert = nullptr;
+    sqlite3_prepare_v2(store,
+                       "INSERT INTO statement_stats (database, fingerprint, calls, total_ms, "
+                       "min_ms, max_ms, rows, last_seen, histogram) "
+                       "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?) "
+                       "ON CONFLICT (database, fingerprint) DO UPDATE SET calls = excluded.calls, "
+                       "total_ms = excluded.total_ms, min_ms = excluded.min_ms, "
+                       "max_ms = excluded.max_ms, rows = excluded.rows, "
+                       "last_seen = excluded.last_seen, histogram = excluded.histogram",
+                       -1, &upsert, nullptr);
+    for (const auto &entry : changed) {
+        sqlite3_bind_text(upsert, 1, entry.database.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(upsert, 2, entry.fingerprint.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(upsert, 3, static_cast<sqlite3_int64>(entry.calls));
+        sqlite3_bind_double(upsert, 4, entry.totalMs);
+        sqlite3_bind_double(upsert, 5, entry.minMs);
+        sqlite3_bind_double(upsert, 6, entry.maxMs);
+        sqlite3_bind_int64(upsert, 7, static_cast<sqlite3_int64>(entry.rows));
+        sqlite3_bind_int64(upsert, 8, entry.lastSeen);
+        sqlite3_bind_blob(upsert, 9, entry.histogram.data(), sizeof(entry.histogram),
+                          SQLITE_TRANSIENT);
+        if (sqlite3_step(upsert) != SQLITE_DONE) {
+            std::cerr << "Failed to save statement stats: " << sqlite3_errmsg(store) << std::endl;
+        }
+        sqlite3_reset(upsert);
+    }
+    sqlite3_finalize(upsert);
+    exec("COMMIT");
+}
+
+void StatementStats::reset() {
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        slots.clear();
+        evicted.clear();
+        clearStore = true;
+        generation++;
+    }
+    flush();
+}
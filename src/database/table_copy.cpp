@@ -0,0 +1,330 @@
+#include "database/table_copy.hpp"
+#include "utils/bounded_queue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace {
+    // Rows packed into one buffer, so a batch costs a handful of allocations
+    struct RowBatch {
+        std::string bytes;
+        std::vector<size_t> ends;
+        std::vector<bool> nulls;
+
+        void add(const std::optional<std::string_view> &value) {
+            if (value) {
+                bytes.append(*value);
+            }
+            ends.push_back(bytes.size());
+            nulls.push_back(!value);
+        }
+
+        std::optional<std::string_view> cell(const size_t index) const {
+            if (nulls[index]) {
+                return std::nullopt;
+            }
+            const size_t start = index > 0 ? ends[index - 1] : 0;
+            return std::string_view(bytes).substr(start, ends[index] - start);
+        }
+    };
+
+    // Value rewrites needed where the two backends spell a type differently
+    enum class Conversion {
+        NONE,
+        BLOB_TO_BYTEA, // raw bytes -> \x hex text
+        BYTEA_TO_BLOB, // \x hex text -> raw bytes
+        BOOL_TO_INTEGER // t/f -> 1/0
+    };
+
+    std::string toUpper(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), ::toupper);
+        return text;
+    }
+
+    int hexDigit(const char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    void convertValue(const Conversion conversion, const std::string_view value,
+                      std::string &out) {
+        static constexpr char kHex[] = "0123456789abcdef";
+        switch (conversion) {
+        case Conversion::BLOB_TO_BYTEA:
+            out += "\\x";
+            for (const char c : value) {
+                out += kHex[static_cast<unsigned char>(c) >> 4];
+                out += kHex[static_cast<unsigned char>(c) & 0xf];
+            }
+            break;
+        case Conversion::BYTEA_TO_BLOB:
+            if (value.size() < 2 || value.substr(0, 2) != "\\x") {
+                out.append(value); // escape format, left as text
+                break;
+            }
+            for (size_t i = 2; i + 1 < value.size(); i += 2) {
+                const int high = hexDigit(value[i]);
+                const int low = hexDigit(value[i + 1]);
+                out += static_cast<char>(high < 0 || low < 0 ? 0 : high << 4 | low);
+            }
+            break;
+        case Conversion::BOOL_TO_INTEGER:
+            out += value == "t" ? "1" : value == "f" ? "0" : std::string(value);
+            break;
+        case Conversion::NONE:
+            out.append(value);
+            break;
+        }
+    }
+
+    // Rewrite every cell of a batch whose column needs a conversion
+    RowBatch convertBatch(const RowBatch &batch, const std::vector<Conversion> &conversions) {
+        RowBatch converted;
+        converted.bytes.reserve(batch.bytes.size());
+        converted.ends.reserve(batch.ends.size());
+        converted.nulls.reserve(batch.nulls.size());
+        for (size_t i = 0; i < batch.ends.size(); i++) {
+            const auto value = batch.cell(i);
+            if (value) {
+                convertValue(conversions[i % conversions.size()], *value, converted.bytes);
+            }
+            converted.ends.push_back(converted.bytes.size());
+            converted.nulls.push_back(!value);
+        }
+        return converted;
+    }
+
+    // First stage: packs rows from the source cursor into batches
+    class BatchSink : public RowSink {
+    public:
+        BatchSink(BoundedQueue<RowBatch> &queue, const size_t columnCount, CopyProgress *progress)
+            : queue(queue), columnCount(columnCount), progress(progress) {}
+
+        void begin(const std::vector<std::string> &columnNames) override {
+            if (columnNames.size() != columnCount) {
+                error = "Table has " + std::to_string(columnNames.size()) + " columns, expected " +
+                        std::to_string(columnCount) + "; refresh the table list and try again";
+            }
+        }
+
+        bool row(const RowValues &values) override {
+            if (!error.empty() || (progress && progress->cancelRequested)) {
+                return false;
+            }
+            for (const auto &value : values) {
+                batch.add(value);
+            }
+            if (progress) {
+                progress->rows++;
+            }
+            if (batch.ends.size() >= TableCopy::kBatchRows * columnCount) {
+                return flush();
+            }
+            return true;
+        }
+
+        void end() override {
+            if (error.empty()) {
+                flush();
+            }
+        }
+
+        const std::string &getError() const {
+            return error;
+        }
+
+    private:
+        BoundedQueue<RowBatch> &queue;
+        size_t columnCount;
+        CopyProgress *progress;
+        RowBatch batch;
+        std::string error;
+
+        bool flush() {
+            if (batch.ends.empty()) {
+                return true;
+            }
+            const bool accepted = queue.push(std::move(batch));
+            batch = RowBatch();
+            return accepted;
+        }
+    };
+} // namespace
+
+std::string TableCopy::mapType(const std::string &type, const DatabaseType from,
+                               const DatabaseType to) {
+    if (from == to) {
+        return type;
+    }
+
+    if (from == DatabaseType::SQLITE) {
+        // SQLite's own affinity rules, then the common date spellings
+        const std::string upper = toUpper(type);
+        const auto has = [&](const char *part) { return upper.find(part) != std::string::npos; };
+        if (has("INT")) {
+            return "bigint";
+        }
+        if (upper.empty() || has("CHAR") || has("CLOB") || has("TEXT")) {
+            return "text";
+        }
+        if (has("BLOB")) {
+            return "bytea";
+        }
+        if (has("REAL") || has("FLOA") || has("DOUB")) {
+            return "double precision";
+        }
+        if (has("BOOL")) {
+            return "boolean";
+        }
+        if (has("DATETIME") || has("TIMESTAMP")) {
+            return "timestamp";
+        }
+        if (has("DATE")) {
+            return "date";
+        }
+        // JSON, UUID, ANY, ENUM and other spellings SQLite stores as given; text takes them all
+        return "text";
+    }
+
+    // PostgreSQL's format_type() names, with any modifier such as numeric(10,2) dropped
+    const std::string base = type.substr(0, type.find('('));
+    if (base == "smallint" || base == "integer" || base == "bigint" || base == "boolean") {
+        return "INTEGER";
+    }
+    if (base == "real" || base == "double precision") {
+        return "REAL";
+    }
+    if (base == "numeric") {
+        return "NUMERIC";
+    }
+    if (base == "bytea") {
+        return "BLOB";
+    }
+    return "TEXT";
+}
+
+CopyResult TableCopy::copyTable(DatabaseInterface &source, const Table &table,
+                                DatabaseInterface &target, CopyProgress *progress) {
+    const auto started = std::chrono::steady_clock::now();
+    CopyResult result;
+    if (&source == &target) {
+        result.error = "Source and target are the same database";
+        return result;
+    }
+    if (table.columns.empty()) {
+        result.error = "Columns of " + table.name + " are not loaded";
+        return result;
+    }
+
+    const DatabaseType from = source.getType();
+    const DatabaseType to = target.getType();
+    std::vector<Column> columns = table.columns;
+    std::vector<Conversion> conversions;
+    bool convert = false;
+    for (auto &column : columns) {
+        const std::string sourceType = toUpper(column.type);
+        column.type = mapType(column.type, from, to);
+
+        Conversion conversion = Conversion::NONE;
+        if (from == DatabaseType::SQLITE && to == DatabaseType::POSTGRESQL &&
+            column.type == "bytea") {
+            conversion = Conversion::BLOB_TO_BYTEA;
+        } else if (from == DatabaseType::POSTGRESQL && to == DatabaseType::SQLITE) {
+            if (sourceType == "BYTEA") {
+                conversion = Conversion::BYTEA_TO_BLOB;
+            } else if (sourceType == "BOOLEAN") {
+                conversion = Conversion::BOOL_TO_INTEGER;
+            }
+        }
+        conversions.push_back(conversion);
+        convert = convert || conversion != Conversion::NONE;
+    }
+
+    BoundedQueue<RowBatch> readQueue(kQueueBatches);
+    BoundedQueue<RowBatch> writeQueue(kQueueBatches);
+    const auto stopPipeline = [&] {
+        readQueue.close();
+        writeQueue.close();
+    };
+
+    std::string readError;
+    std::thread reader([&] {
+        BatchSink sink(readQueue, columns.size(), progress);
+        const std::string query =
+            "SELECT * FROM " + source.quoteTableName(table.getQualifiedName());
+        const StatementResult read = source.streamQuery(query, sink);
+        if (!sink.getError().empty()) {
+            readError = sink.getError();
+        } else if (!read.success) {
+            readError = read.error.empty() ? "Failed to read " + table.name : read.error;
+        }
+        readQueue.close();
+    });
+
+    std::thread converter([&] {
+        RowBatch batch;
+        while (readQueue.pop(batch)) {
+            if (!writeQueue.push(convert ? convertBatch(batch, conversions) : std::move(batch))) {
+                break;
+            }
+        }
+        writeQueue.close();
+    });
+
+    // Last stage on this thread, since the writer's connection must stay with one thread
+    std::string writeError;
+    auto writer = target.beginTableWrite(table.name, columns, writeError);
+    if (writer) {
+        RowBatch batch;
+        RowValues values(columns.size());
+        while (writeError.empty() && writeQueue.pop(batch)) {
+            if (progress && progress->cancelRequested) {
+                break;
+            }
+            for (size_t cell = 0; cell < batch.ends.size(); cell += columns.size()) {
+                for (size_t i = 0; i < columns.size(); i++) {
+                    values[i] = batch.cell(cell + i);
+                }
+                if (!writer->writeRow(values)) {
+                    writeError = writer->getError();
+                    break;
+                }
+                result.rows++;
+            }
+            if (progress) {
+                progress->rowsWritten = result.rows;
+            }
+        }
+    }
+    stopPipeline();
+    reader.join();
+    converter.join();
+
+    if (progress && progress->cancelRequested) {
+        result.error = "Copy cancelled";
+    } else if (!writeError.empty()) {
+        result.error = writeError;
+    } else if (!writer) {
+        result.error = "Failed to open writer for " + table.name;
+    } else if (!readError.empty()) {
+        result.error = readError;
+    } else if (!writer->commit()) {
+        result.error = writer->getError();
+    } else {
+        result.success = true;
+    }
+    writer.reset();
+
+    result.elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started)
+            .count();
+    return result;
+}
@@ -0,0 +1,437 @@
+#include "database/table_diff.hpp"
+#include "database/sql_script.hpp"
+#include "utils/md5.hpp"
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+namespace {
+    using Cells = std::vector<std::optional<std::string>>;
+
+    // Separates cells in a row's compared text; NULL is written as \N
+    constexpr char kSeparator = '\x1f';
+    constexpr const char *kNullMarker = "\\N";
+
+    std::string toUpper(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), ::toupper);
+        return text;
+    }
+
+    // Literal for SQL, parenthesized so a negative value can follow a minus sign
+    std::string literal(const int64_t value) {
+        return "(" + std::to_string(value) + ")";
+    }
+
+    bool isIntegerType(const std::string &type, const DatabaseType backend) {
+        if (backend == DatabaseType::POSTGRESQL) {
+            return type == "smallint" || type == "integer" || type == "bigint";
+        }
+        return toUpper(type).find("INT") != std::string::npos;
+    }
+
+    // Text form of one column that both backends render the same way
+    std::string canonicalValue(const Column &column, const DatabaseType backend) {
+        const std::string name = SqlScript::quoteIdentifier(column.name);
+        if (backend == DatabaseType::POSTGRESQL) {
+            if (column.type == "bytea") {
+                return "encode(" + name + ", 'hex')";
+            }
+            if (column.type == "boolean") {
+                return name + "::int::text";
+            }
+            return name + "::text";
+        }
+
+        const std::string upper = toUpper(column.type);
+        if (upper.find("BLOB") != std::string::npos) {
+            // hex(NULL) is an empty string rather than NULL
+            return "CASE WHEN " + name + " IS NOT NULL THEN lower(hex(" + name + ")) END";
+        }
+        if (upper.find("REAL") != std::string::npos || upper.find("FLOA") != std::string::npos ||
+            upper.find("DOUB") != std::string::npos) {
+            // 2.0 reads back as "2.0" from SQLite but "2" from PostgreSQL
+            return "CASE WHEN " + name + " = CAST(" + name + " AS INTEGER) THEN CAST(CAST(" +
+                   name + " AS INTEGER) AS TEXT) ELSE CAST(" + name + " AS TEXT) END";
+        }
+        return "CAST(" + name + " AS TEXT)";
+    }
+
+    // Parse a decimal integer of any size modulo 2^64; PostgreSQL's sum() is exact numeric
+    uint64_t parseWrapped(const std::string &text) {
+        uint64_t value = 0;
+        bool negative = false;
+        for (const char c : text) {
+            if (c == '-') {
+                negative = true;
+            } else if (c >= '0' && c <= '9') {
+                value = value * 10 + static_cast<uint64_t>(c - '0');
+            } else if (c == '.') {
+                break;
+            }
+        }
+        return negative ? 0 - value : value;
+    }
+
+    Cells splitCells(const std::string &text) {
+        Cells cells;
+        size_t start = 0;
+        while (true) {
+            const size_t end = text.find(kSeparator, start);
+            const std::string cell = text.substr(start, end - start);
+            if (cell == kNullMarker) {
+                cells.emplace_back();
+            } else {
+                cells.emplace_back(cell);
+            }
+            if (end == std::string::npos) {
+                return cells;
+            }
+            start = end + 1;
+        }
+    }
+
+    // Collects a small result as owned strings
+    class RowCollector : public RowSink {
+    public:
+        std::vector<Cells> rows;
+
+        void begin(const std::vector<std::string> &) override {}
+        bool row(const RowValues &values) override {
+            Cells cells;
+            for (const auto &value : values) {
+                if (value) {
+                    cells.emplace_back(std::string(*value));
+                } else {
+                    cells.emplace_back();
+                }
+            }
+            rows.push_back(std::move(cells));
+            return true;
+        }
+        void end() override {}
+    };
+
+    // One table of the comparison and the SQL fragments to query it
+    struct Side {
+        DatabaseInterface *db = nullptr;
+        DatabaseType backend = DatabaseType::SQLITE;
+        std::string table;
+        std::string key;
+        std::string canonical;
+
+        std::vector<Cells> query(const std::string &sql) const {
+            RowCollector collector;
+            const StatementResult result = db->streamQuery(sql, collector);
+            if (!result.success) {
+                throw std::runtime_error(result.error.empty() ? "Query failed: " + sql
+                                                              : result.error);
+            }
+            return std::move(collector.rows);
+        }
+
+        std::string hashAggregate() const {
+            if (backend == DatabaseType::POSTGRESQL) {
+                return "sum(('x' || substr(md5(" + canonical + "), 1, 16))::bit(64)::bigint)";
+            }
+            return std::string(TableDiff::kSqliteHashFunction) + "(" + canonical + ")";
+        }
+
+        // Key as a 64-bit value for bucket arithmetic
+        std::string keyValue() const {
+            return backend == DatabaseType::POSTGRESQL ? key + "::bigint" : key;
+        }
+
+        std::string keyRange(const int64_t low, const int64_t high) const {
+            return " WHERE " + key + " BETWEEN " + literal(low) + " AND " + literal(high);
+        }
+    };
+
+    struct RangeStats {
+        uint64_t count = 0;
+        uint64_t hash = 0;
+
+        bool operator!=(const RangeStats &other) const {
+            return count != other.count || hash != other.hash;
+        }
+    };
+
+    struct Range {
+        int64_t low;
+        int64_t high;
+        uint64_t leftCount;
+        uint64_t rightCount;
+    };
+
+    // Run the same kind of query on both sides at once
+    template <typename F> auto onBothSides(const Side &left, const Side &right, F query) {
+        auto leftResult = std::async(std::launch::async, [&] { return query(left); });
+        auto rightResult = query(right);
+        return std::make_pair(leftResult.get(), std::move(rightResult));
+    }
+
+    class Differ {
+    public:
+        Differ(Side left, Side right, TableDiffResult &result, TableDiffProgress *progress)
+            : left(std::move(left)), right(std::move(right)), result(result),
+              progress(progress) {}
+
+        void run() {
+            const auto [leftBounds, rightBounds] = onBothSides(left, right, [](const Side &side) {
+                return side.query("SELECT min(" + side.key + "), max(" + side.key +
+                                  "), count(" + side.key + ") FROM " + side.table);
+            });
+            result.leftRows = boundsCount(leftBounds);
+            result.rightRows = boundsCount(rightBounds);
+            if (result.leftRows == 0 && result.rightRows == 0) {
+                return;
+            }
+
+            int64_t low = std::numeric_limits<int64_t>::max();
+            int64_t high = std::numeric_limits<int64_t>::min();
+            for (const auto *bounds : {&leftBounds, &rightBounds}) {
+                if (boundsCount(*bounds) > 0) {
+                    low = std::min<int64_t>(low, std::stoll(*(*bounds)[0][0]));
+                    high = std::max<int64_t>(high, std::stoll(*(*bounds)[0][1]));
+                }
+            }
+            if (static_cast<uint64_t>(high) - static_cast<uint64_t>(low) >
+                static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                throw std::runtime_error("Key range is too wide to split");
+            }
+
+            // Depth first, low keys first, so differences come out in key order
+            std::vector<Range> pending{{low, high, result.leftRows, result.rightRows}};
+            while (!pending.empty() && !result.truncated) {
+                if (progress && progress->cancelRequested) {
+                    throw std::runtime_error("Diff cancelled");
+                }
+                const Range range = pending.back();
+                pending.pop_back();
+                if (std::max(range.leftCount, range.rightCount) <= TableDiff::kLeafRows ||
+                    range.low == range.high) {
+                    compareRows(range);
+                } else {
+                    split(range, pending);
+                }
+            }
+        }
+
+    private:
+        Side left;
+        Side right;
+        TableDiffResult &result;
+        TableDiffProgress *progress;
+
+        static uint64_t boundsCount(const std::vector<Cells> &bounds) {
+            return bounds.empty() || !bounds[0][2] ? 0 : std::stoull(*bounds[0][2]);
+        }
+
+        void split(const Range &range, std::vector<Range> &pending) {
+            const uint64_t span =
+                static_cast<uint64_t>(range.high) - static_cast<uint64_t>(range.low) + 1;
+            const uint64_t width = (span + TableDiff::kFanout - 1) / TableDiff::kFanout;
+
+            const auto bucketQuery = [&](const Side &side) {
+                const std::string sql = "SELECT (" + side.keyValue() + " - " + literal(range.low) +
+                                        ") / " + std::to_string(width) + ", count(*), " +
+                                        side.hashAggregate() + " FROM " + side.table +
+                                        side.keyRange(range.low, range.high) + " GROUP BY 1";
+                std::map<uint64_t, RangeStats> buckets;
+                for (const auto &row : side.query(sql)) {
+                    buckets[std::stoull(*row[0])] = {std::stoull(*row[1]),
+                                                     row[2] ? parseWrapped(*row[2]) : 0};
+                }
+                return buckets;
+            };
+            const auto [leftBuckets, rightBuckets] = onBothSides(left, right, bucketQuery);
+            result.rangesHashed += TableDiff::kFanout;
+            if (progress) {
+                progress->rangesHashed = result.rangesHashed;
+            }
+
+            for (uint64_t bucket = TableDiff::kFanout; bucket-- > 0;) {
+                const uint64_t offset = bucket * width;
+                if (offset >= span) {
+                    continue;
+                }
+                const auto leftIt = leftBuckets.find(bucket);
+                const auto rightIt = rightBuckets.find(bucket);
+                const RangeStats leftStats = leftIt != leftBuckets.end() ? leftIt->second
+                                                                         : RangeStats{};
+                const RangeStats rightStats = rightIt != rightBuckets.end() ? rightIt->second
+                                                                            : RangeStats{};
+                if (leftStats != rightStats) {
+                    const auto low = static_cast<int64_t>(static_cast<uint64_t>(range.low) +
+                                                          offset);
+                    const auto high = static_cast<int64_t>(
+                        static_cast<uint64_t>(low) + std::min(width, span - offset) - 1);
+                    pending.push_back({low, high, leftStats.count, rightStats.count});
+                }
+            }
+        }
+
+        void compareRows(const Range &range) {
+            const auto [leftRows, rightRows] = onBothSides(left, right, [&](const Side &side) {
+                return side.query("SELECT " + side.key + ", " + side.canonical + " FROM " +
+                                  side.table + side.keyRange(range.low, range.high) +
+                                  " ORDER BY " + side.key);
+            });
+            result.rowsFetched += leftRows.size() + rightRows.size();
+            if (progress) {
+                progress->rows = result.rowsFetched;
+            }
+
+            // Both sides are sorted by key: merge
+            size_t i = 0, j = 0;
+            while ((i < leftRows.size() || j < rightRows.size()) && !result.truncated) {
+                const int64_t leftKey =
+                    i < leftRows.size() ? std::stoll(*leftRows[i][0])
+                                        : std::numeric_limits<int64_t>::max();
+                const int64_t rightKey =
+                    j < rightRows.size() ? std::stoll(*rightRows[j][0])
+                                         : std::numeric_limits<int64_t>::max();
+
+                TableDiffRow row;
+                if (j >= rightRows.size() || (i < leftRows.size() && leftKey < rightKey)) {
+                    row.kind = TableDiffRow::Kind::ONLY_LEFT;
+                    row.key = leftKey;
+                    row.left = splitCells(*leftRows[i++][1]);
+                } else if (i >= leftRows.size() || rightKey < leftKey) {
+                    row.kind = TableDiffRow::Kind::ONLY_RIGHT;
+                    row.key = rightKey;
+                    row.right = splitCells(*rightRows[j++][1]);
+                } else {
+                    const std::string &leftText = *leftRows[i++][1];
+                    const std::string &rightText = *rightRows[j++][1];
+                    if (leftText == rightText) {
+                        continue;
+                    }
+                    row.kind = TableDiffRow::Kind::CHANGED;
+                    row.key = leftKey;
+                    row.left = splitCells(leftText);
+                    row.right = splitCells(rightText);
+                }
+
+                result.rows.push_back(std::move(row));
+                if (progress) {
+                    progress->differences = result.rows.size();
+                }
+                result.truncated = result.rows.size() >= TableDiff::kMaxDifferences;
+            }
+        }
+    };
+
+    void hashStep(sqlite3_context *context, int, sqlite3_value **argv) {
+        auto *sum = static_cast<uint64_t *>(sqlite3_aggregate_context(context, sizeof(uint64_t)));
+        if (!sum) {
+            sqlite3_result_error_nomem(context);
+            return;
+        }
+        if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+            return;
+        }
+        const auto *text = reinterpret_cast<const char *>(sqlite3_value_text(argv[0]));
+        *sum += Md5::prefix64(std::string_view(text, sqlite3_value_bytes(argv[0])));
+    }
+
+    void hashFinal(sqlite3_context *context) {
+        const auto *sum = static_cast<uint64_t *>(sqlite3_aggregate_context(context, 0));
+        sqlite3_result_int64(context, sum ? static_cast<sqlite3_int64>(*sum) : 0);
+    }
+} // namespace
+
+bool TableDiff::registerFunctions(sqlite3 *db) {
+    return sqlite3_create_function(db, kSqliteHashFunction, 1,
+                                   SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr, nullptr,
+                                   hashStep, hashFinal) == SQLITE_OK;
+}
+
+TableDiffResult TableDiff::compare(DatabaseInterface &left, const Table &leftTable,
+                                   DatabaseInterface &right, const Table &rightTable,
+                                   TableDiffProgress *progress) {
+    const auto started = std::chrono::steady_clock::now();
+    TableDiffResult result;
+
+    const auto keyIt = std::find_if(leftTable.columns.begin(), leftTable.columns.end(),
+                                    [](const Column &column) { return column.isPrimaryKey; });
+    const auto keyCount = std::count_if(leftTable.columns.begin(), leftTable.columns.end(),
+                                        [](const Column &column) { return column.isPrimaryKey; });
+    if (keyIt == leftTable.columns.end() || keyCount != 1 ||
+        !isIntegerType(keyIt->type, left.getType())) {
+        result.error = leftTable.name + " needs a single-column integer primary key";
+        return result;
+    }
+
+    // Columns are matched by name, ignoring case, since PostgreSQL folds unquoted names
+    const auto findRight = [&](const std::string &name) {
+        return std::find_if(rightTable.columns.begin(), rightTable.columns.end(),
+                            [&](const Column &column) {
+                                return toUpper(column.name) == toUpper(name);
+                            });
+    };
+    const auto rightKey = findRight(keyIt->name);
+    if (rightKey == rightTable.columns.end() || !isIntegerType(rightKey->type, right.getType())) {
+        result.error = rightTable.name + " has no integer column " + keyIt->name;
+        return result;
+    }
+
+    std::vector<const Column *> leftColumns{&*keyIt};
+    std::vector<const Column *> rightColumns{&*rightKey};
+    for (const auto &column : leftTable.columns) {
+        if (&column == &*keyIt) {
+            continue;
+        }
+        const auto match = findRight(column.name);
+        if (match == rightTable.columns.end()) {
+            result.skippedColumns.push_back(column.name);
+        } else {
+            leftColumns.push_back(&column);
+            rightColumns.push_back(&*match);
+        }
+    }
+    for (const auto &column : rightTable.columns) {
+        if (std::none_of(leftTable.columns.begin(), leftTable.columns.end(),
+                         [&](const Column &other) {
+                             return toUpper(other.name) == toUpper(column.name);
+                         })) {
+            result.skippedColumns.push_back(column.name);
+        }
+    }
+    for (const Column *column : leftColumns) {
+        result.columns.push_back(column->name);
+    }
+
+    const auto makeSide = [](DatabaseInterface &db, const Table &table,
+                             const std::vector<const Column *> &columns) {
+        Side side;
+        side.db = &db;
+        side.backend = db.getType();
+        side.table = db.quoteTableName(table.getQualifiedName());
+        side.key = SqlScript::quoteIdentifier(columns[0]->name);
+        const std::string separator =
+            side.backend == DatabaseType::POSTGRESQL ? " || chr(31) || " : " || char(31) || ";
+        for (size_t i = 0; i < columns.size(); i++) {
+            side.canonical += (i > 0 ? separator : "") + std::string("coalesce(") +
+                              canonicalValue(*columns[i], side.backend) + ", '" + kNullMarker +
+                              "')";
+        }
+        return side;
+    };
+
+    try {
+        Differ(makeSide(left, leftTable, leftColumns), makeSide(right, rightTable, rightColumns),
+               result, progress)
+            .run();
+        result.success = true;
+    } catch (const std::exception &e) {
+        result.error = e.what();
+    }
+
+    result.elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started)
+            .count();
+    return result;
+}
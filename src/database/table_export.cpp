@@ -0,0 +1,358 @@
+#include "database/table_export.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+    // First error wins; any error stops every worker and the writer
+    class ExportState {
+    public:
+        std::atomic<bool> stop{false};
+
+        void fail(const std::string &message) {
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (error.empty()) {
+                    error = message;
+                }
+            }
+            stop = true;
+            if (onStop) {
+                onStop();
+            }
+        }
+
+        std::string getError() {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            return error;
+        }
+
+        std::function<void()> onStop;
+
+    private:
+        std::mutex errorMutex;
+        std::string error;
+    };
+
+    void appendField(std::string &out, const std::string_view value) {
+        if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+            out.append(value);
+            return;
+        }
+        out += '"';
+        for (const char c : value) {
+            if (c == '"') {
+                out += '"';
+            }
+            out += c;
+        }
+        out += '"';
+    }
+
+    // Formats rows as CSV (NULL as an empty field) into blocks that are handed to emit
+    class CsvSink : public RowSink {
+    public:
+        using Emit = std::function<bool(std::string &&)>;
+
+        CsvSink(const bool writeHeader, Emit emit, ExportState &state, ExportProgress *progress)
+            : writeHeader(writeHeader), emit(std::move(emit)), state(state), progress(progress) {
+            block.reserve(TableExport::kBlockBytes + 64 * 1024);
+        }
+
+        void begin(const std::vector<std::string> &columnNames) override {
+            if (!writeHeader) {
+                return;
+            }
+            for (size_t i = 0; i < columnNames.size(); i++) {
+                if (i > 0) {
+                    block += ',';
+                }
+                appendField(block, columnNames[i]);
+            }
+            block += '\n';
+        }
+
+        bool row(const RowValues &values) override {
+            if (state.stop) {
+                return false;
+            }
+            if (progress && progress->cancelRequested) {
+                state.fail("Export cancelled");
+                return false;
+            }
+
+            for (size_t i = 0; i < values.size(); i++) {
+                if (i > 0) {
+                    block += ',';
+                }
+                if (values[i]) {
+                    appendField(block, *values[i]);
+                }
+            }
+            block += '\n';
+
+            if (++unreportedRows == JobProgress::kRowBatch) {
+                reportRows();
+            }
+            return block.size() < TableExport::kBlockBytes || flush();
+        }
+
+        // Hand over what is left; false if the export was stopped
+        bool flush() {
+            reportRows();
+            if (block.empty()) {
+                return !state.stop;
+            }
+            const bool accepted = emit(std::move(block));
+            block.clear();
+            block.reserve(TableExport::kBlockBytes + 64 * 1024);
+            return accepted;
+        }
+
+    private:
+        bool writeHeader;
+        Emit emit;
+        ExportState &state;
+        ExportProgress *progress;
+        std::string block;
+        uint64_t unreportedRows = 0;
+
+        void reportRows() {
+            if (progress && unreportedRows > 0) {
+                progress->rows += unreportedRows;
+            }
+            unreportedRows = 0;
+        }
+    };
+
+    // Writes the blocks of every chunk to one file in chunk order. Blocks of later chunks queue
+    // up in memory until their turn; once kMaxBufferedBytes are queued their producers wait,
+    // except the producer of the chunk being written, so the export can always move forward.
+    class OrderedWriter {
+    public:
+        OrderedWriter(std::ofstream &file, const size_t chunkCount, ExportState &state)
+            : file(file), pending(chunkCount), finished(chunkCount, false), state(state) {}
+
+        bool append(const size_t chunk, std::string &&block) {
+            std::unique_lock<std::mutex> lock(mutex);
+            spaceFree.wait(lock, [&] {
+                return chunk == next || buffered < TableExport::kMaxBufferedBytes || state.stop;
+            });
+            if (state.stop) {
+                return false;
+            }
+            buffered += block.size();
+            pending[chunk].push_back(std::move(block));
+            ready.notify_one();
+            return true;
+        }
+
+        void finish(const size_t chunk) {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished[chunk] = true;
+            ready.notify_one();
+        }
+
+        void wake() {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.notify_all();
+            spaceFree.notify_all();
+        }
+
+        // Writer thread body; returns when every chunk is written or the export stopped
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (next < pending.size()) {
+                ready.wait(lock, [&] {
+                    return !pending[next].empty() || finished[next] || state.stop;
+                });
+                if (state.stop) {
+                    return;
+                }
+                if (pending[next].empty()) {
+                    next++;
+                    spaceFree.notify_all();
+                    continue;
+                }
+
+                std::string block = std::move(pending[next].front());
+                pending[next].pop_front();
+                lock.unlock();
+                file.write(block.data(), static_cast<std::streamsize>(block.size()));
+                const bool written = static_cast<bool>(file);
+                lock.lock();
+
+                buffered -= block.size();
+                spaceFree.notify_all();
+                if (!written) {
+                    lock.unlock();
+                    state.fail("Failed to write the export file");
+                    return;
+                }
+            }
+        }
+
+    private:
+        std::ofstream &file;
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::condition_variable spaceFree;
+        std::vector<std::deque<std::string>> pending;
+        std::vector<bool> finished;
+        size_t next = 0;
+        size_t buffered = 0;
+        ExportState &state;
+    };
+} // namespace
+
+std::string TableExport::partitionPath(const std::string &path, const size_t index) {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".part%04zu", index + 1);
+
+    const size_t slash = path.find_last_of("/\\");
+    const size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return path + suffix;
+    }
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
+ExportResult TableExport::exportCsv(DatabaseInterface &db, const std::string &tableName,
+                                    const std::string &path, const ExportOptions &options,
+                                    ExportProgress *progress) {
+    const auto started = std::chrono::steady_clock::now();
+    ExportResult result;
+    ExportProgress localProgress;
+    if (!progress) {
+        progress = &localProgress;
+    }
+
+    size_t workers = options.workers;
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::string splitError;
+    std::unique_ptr<ParallelReader> reader =
+        db.beginParallelRead(tableName, workers * kChunksPerWorker, splitError);
+    if (!reader) {
+        std::cout << "Exporting " << tableName << " on a single connection: " << splitError
+                  << std::endl;
+        const std::string query = "SELECT * FROM " + db.quoteTableName(tableName);
+        reader = std::make_unique<SingleQueryReader>(db, query);
+    }
+    const size_t chunkCount = reader->getChunkCount();
+    workers = std::min(workers, chunkCount);
+    progress->chunkCount = chunkCount;
+
+    ExportState state;
+    std::ofstream file;
+    std::unique_ptr<OrderedWriter> writer;
+    if (options.partitioned) {
+        for (size_t i = 0; i < chunkCount; i++) {
+            result.files.push_back(partitionPath(path, i));
+        }
+    } else {
+        result.files.push_back(path);
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            result.error = "Failed to create " + path;
+            return result;
+        }
+        writer = std::make_unique<OrderedWriter>(file, chunkCount, state);
+        state.onStop = [&writer] { writer->wake(); };
+    }
+
+    std::atomic<size_t> nextChunk{0};
+    auto work = [&]() {
+        while (!state.stop) {
+            const size_t chunk = nextChunk++;
+            if (chunk >= chunkCount) {
+                return;
+            }
+
+            std::ofstream partition;
+            CsvSink::Emit emit;
+            if (options.partitioned) {
+                partition.open(result.files[chunk], std::ios::binary | std::ios::trunc);
+                if (!partition) {
+                    state.fail("Failed to create " + result.files[chunk]);
+                    return;
+                }
+                emit = [&](std::string &&block) {
+                    partition.write(block.data(), static_cast<std::streamsize>(block.size()));
+                    if (!partition) {
+                        state.fail("Failed to write " + result.files[chunk]);
+                    }
+                    return !state.stop;
+                };
+            } else {
+                emit = [&, chunk](std::string &&block) {
+                    return writer->append(chunk, std::move(block));
+                };
+            }
+
+            // A single file only gets the header once, at the front of the first chunk
+            CsvSink sink(options.partitioned || chunk == 0, emit, state, progress);
+            const StatementResult chunkResult = reader->readChunk(chunk, sink);
+            if (!chunkResult.success) {
+                state.fail(chunkResult.error);
+                return;
+            }
+            if (!sink.flush()) {
+                return;
+            }
+            if (writer) {
+                writer->finish(chunk);
+            }
+            progress->chunksDone++;
+        }
+    };
+
+    std::thread writerThread;
+    if (writer) {
+        writerThread = std::thread([&writer] { writer->run(); });
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers; i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+    if (file.is_open()) {
+        file.close();
+        if (!file && !state.stop) {
+            state.fail("Failed to finish " + path);
+        }
+    }
+
+    result.chunks = chunkCount;
+    result.workers = workers;
+    result.rows = progress->rows;
+    result.elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started)
+            .count();
+    if (state.stop) {
+        result.error = state.getError();
+        for (const auto &written : result.files) {
+            std::remove(written.c_str());
+        }
+        result.files.clear();
+        return result;
+    }
+    result.success = true;
+    return result;
+}
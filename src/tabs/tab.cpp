@@ -2,321 +2,2589 @@
 #include "application.hpp"
 #include "database/db.hpp"
 #include "database/db_interface.hpp"
+#include "database/query_cache.hpp"
+#include "database/row_diff.hpp"
+#include "database/sql_script.hpp"
+#include "utils/file_dialog.hpp"
 #include "imgui.h"
+#include "imgui_internal.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
 #include <iostream>
+#include <optional>
 
-// Base Tab class
-Tab::Tab(const std::string &name, const TabType type) : name(name), type(type) {}
-
-// SQLEditorTab implementation
-SQLEditorTab::SQLEditorTab(const std::string &name) : Tab(name, TabType::SQL_EDITOR) {}
+namespace {
+    size_t stringBytes(const std::string &value) {
+        // Short strings live inside the object
+        return sizeof(std::string) + (value.capacity() > 15 ? value.capacity() + 1 : 0);
+    }
 
-void SQLEditorTab::render() {
-    auto &app = Application::getInstance();
+    size_t tableBytes(const std::vector<std::vector<std::string>> &rows) {
+        size_t bytes = rows.capacity() * sizeof(std::vector<std::string>);
+        for (const auto &row : rows) {
+            for (const auto &cell : row) {
+                bytes += stringBytes(cell);
+            }
+        }
+        return bytes;
+    }
 
-    ImGui::Text("SQL Editor");
-    ImGui::Separator();
+    std::string clockTime() {
+        const std::time_t now = std::time(nullptr);
+        char buffer[16];
+        std::strftime(buffer, sizeof(buffer), "%H:%M:%S", std::localtime(&now));
+        return buffer;
+    }
 
-    // SQL input
-    ImGui::InputTextMultiline("##SQL", sqlBuffer, sizeof(sqlBuffer),
-                              ImVec2(-1, ImGui::GetContentRegionAvail().y * 0.3f));
-    sqlQuery = sqlBuffer;
-
-    if (ImGui::Button("Execute Query")) {
-        int selectedDb = app.getSelectedDatabase();
-        auto &databases = app.getDatabases();
-
-        if (selectedDb >= 0 && selectedDb < (int)databases.size()) {
-            auto &db = databases[selectedDb];
-            if (db->connect()) {
-                queryResult = db->executeQuery(sqlQuery);
-                strncpy(resultBuffer, queryResult.c_str(), sizeof(resultBuffer) - 1);
-                resultBuffer[sizeof(resultBuffer) - 1] = '\0';
-            }
+    std::string watchSummary(const RowDiff::Result &diff) {
+        if (diff.isIdentical()) {
+            return clockTime() + ": rows reordered";
         }
+        return clockTime() + ": " + std::to_string(diff.changedCount) + " new or changed, " +
+               std::to_string(diff.removedCount) + " gone";
     }
 
-    ImGui::SameLine();
-    if (ImGui::Button("Clear")) {
-        memset(sqlBuffer, 0, sizeof(sqlBuffer));
-        sqlQuery.clear();
+    ImU32 changedRowColor() {
+        return ImGui::GetColorU32(ImVec4(0.3f, 0.75f, 0.3f, 0.3f));
     }
 
-    ImGui::Separator();
-    ImGui::Text("Results:");
+    ImU32 tokenColor(const SqlHighlighter::TokenKind kind) {
+        const bool dark = Application::getInstance().isDarkTheme();
+        switch (kind) {
+        case SqlHighlighter::TokenKind::KEYWORD:
+            return ImGui::GetColorU32(dark ? ImVec4(0.40f, 0.65f, 0.95f, 1.0f)
+                                           : ImVec4(0.05f, 0.30f, 0.75f, 1.0f));
+        case SqlHighlighter::TokenKind::STRING:
+            return ImGui::GetColorU32(dark ? ImVec4(0.85f, 0.60f, 0.40f, 1.0f)
+                                           : ImVec4(0.65f, 0.25f, 0.10f, 1.0f));
+        case SqlHighlighter::TokenKind::NUMBER:
+            return ImGui::GetColorU32(dark ? ImVec4(0.60f, 0.85f, 0.60f, 1.0f)
+                                           : ImVec4(0.10f, 0.50f, 0.20f, 1.0f));
+        case SqlHighlighter::TokenKind::COMMENT:
+            return ImGui::GetColorU32(dark ? ImVec4(0.50f, 0.55f, 0.50f, 1.0f)
+                                           : ImVec4(0.45f, 0.50f, 0.45f, 1.0f));
+        case SqlHighlighter::TokenKind::IDENTIFIER:
+            return ImGui::GetColorU32(dark ? ImVec4(0.80f, 0.70f, 0.95f, 1.0f)
+                                           : ImVec4(0.45f, 0.20f, 0.60f, 1.0f));
+        }
+        return ImGui::GetColorU32(ImGuiCol_Text);
+    }
+} // namespace
 
-    // Results display
-    ImGui::InputTextMultiline("##Results", resultBuffer, sizeof(resultBuffer), ImVec2(-1, -1),
-                              ImGuiInputTextFlags_ReadOnly);
-}
+// Base Tab class
+Tab::Tab(const std::string &name, const TabType type) : name(name), type(type) {}
 
-// TableViewerTab implementation
-TableViewerTab::TableViewerTab(const std::string &name, const std::string &databasePath,
-                               const std::string &tableName)
-    : Tab(name, TabType::TABLE_VIEWER), databasePath(databasePath), tableName(tableName) {
-    loadData();
+void Tab::activate(const int frame) {
+    if (hibernated) {
+        restoreData();
+        hibernated = false;
+    }
+    lastActiveFrame = frame;
 }
 
-void TableViewerTab::render() {
-    ImGui::Text("Table: %s", tableName.c_str());
-    ImGui::Separator();
+void Tab::hibernate() {
+    if (!hibernated && releaseData()) {
+        hibernated = true;
+    }
+}
 
-    // Pagination controls
-    int totalPages = (totalRows + rowsPerPage - 1) / rowsPerPage;
+void Tab::updateWatch(const double now, const bool visible) {
+    if (!watchEnabled || hibernated) {
+        return;
+    }
 
-    if (ImGui::Button("<<") && currentPage > 0) {
-        firstPage();
+    // A statement running on a worker holds the connection; try again next frame
+    const auto db = getWatchDatabase();
+    if (db && db->isBusy()) {
+        return;
     }
-    ImGui::SameLine();
 
-    if (ImGui::Button("<") && currentPage > 0) {
-        previousPage();
+    // Coming back into view cancels the backoff so the tab catches up right away
+    if (visible && watchBackoff > 1.0) {
+        watchBackoff = 1.0;
+        nextWatchRun = std::min(nextWatchRun, now);
+    }
+    if (now < nextWatchRun) {
+        return;
     }
-    ImGui::SameLine();
 
-    ImGui::Text("Page %d of %d (%d rows total)", currentPage + 1, totalPages, totalRows);
-    ImGui::SameLine();
+    const double interval = watchTrigger == WatchTrigger::INTERVAL ? watchIntervalSeconds
+                                                                   : kDataChangePollSeconds;
+    nextWatchRun = now + interval * watchBackoff;
+    if (!visible) {
+        watchBackoff = std::min(watchBackoff * 2.0, kMaxWatchBackoff);
+    }
 
-    if (ImGui::Button(">") && currentPage < totalPages - 1) {
-        nextPage();
+    if (watchTrigger == WatchTrigger::DATA_CHANGE) {
+        if (!db || !db->isConnected()) {
+            return;
+        }
+        // The first poll only records where the data stands
+        const std::string token = db->getChangeToken();
+        if (token.empty() || token == watchToken) {
+            return;
+        }
+        const bool firstPoll = watchToken.empty();
+        watchToken = token;
+        if (firstPoll) {
+            return;
+        }
     }
-    ImGui::SameLine();
 
-    if (ImGui::Button(">>") && currentPage < totalPages - 1) {
-        lastPage();
+    watchRefresh();
+}
+
+void Tab::renderWatchControls() {
+    if (ImGui::Checkbox("Watch", &watchEnabled)) {
+        if (watchEnabled) {
+            nextWatchRun = 0.0;
+            watchBackoff = 1.0;
+            watchToken.clear();
+            watchStatus.clear();
+            onWatchEnabled();
+        } else {
+            onWatchDisabled();
+        }
+    }
+    if (!watchEnabled) {
+        return;
     }
 
-    // Action buttons next to pagination
-    ImGui::SameLine();
-    ImGui::Dummy(ImVec2(20, 0)); // Add some spacing
     ImGui::SameLine();
+    int trigger = (int)watchTrigger;
+    ImGui::SetNextItemWidth(100.0f);
+    if (ImGui::Combo("##WatchTrigger", &trigger, "Interval\0On change\0")) {
+        watchTrigger = (WatchTrigger)trigger;
+        watchToken.clear();
+        nextWatchRun = 0.0;
+    }
+    if (watchTrigger == WatchTrigger::INTERVAL) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(70.0f);
+        ImGui::DragFloat("##WatchInterval", &watchIntervalSeconds, 0.5f, 1.0f, 3600.0f, "%.0f s");
+    }
+    if (!watchStatus.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", watchStatus.c_str());
+    }
+}
 
-    if (ImGui::Button("Refresh")) {
-        refreshData();
+// SQLEditorTab implementation
+// A statement or script running on a worker. The worker fills in the result and posts back to
+// the main thread; owner is cleared there if the tab is closed in the meantime.
+struct SQLEditorTab::QueryRun {
+    SQLEditorTab *owner = nullptr;
+    std::shared_ptr<DatabaseInterface> db;
+    std::string sql;
+    bool script = false;
+    bool watch = false;
+    bool cacheable = false;
+    // Hash the rows as they stream in; only while watching
+    bool hashRows = false;
+    // Result to hash on the worker first, when its hashes were dropped or never taken
+    std::shared_ptr<ResultStore> baseline;
+    QueryProgress progress;
+
+    // Main thread only
+    std::string phase;
+    bool polling = false;
+    double nextPoll = 0.0;
+
+    // Written by the worker before it posts back
+    std::string changeToken;
+    std::optional<QueryCache::Entry> cached;
+    StatementResult result;
+    std::vector<StatementResult> scriptResults;
+    std::shared_ptr<ResultStore> store;
+    std::vector<uint64_t> hashes;
+    std::vector<uint64_t> baselineHashes;
+};
+
+SQLEditorTab::SQLEditorTab(const std::string &name) : Tab(name, TabType::SQL_EDITOR) {}
+
+SQLEditorTab::~SQLEditorTab() {
+    // Stop a run still in flight right away, so closing the tab (or quitting) doesn't wait
+    // for a long statement to reach its next check; its result is dropped
+    if (activeRun) {
+        activeRun->owner = nullptr;
+        activeRun->db->cancel(activeRun->progress);
     }
-    ImGui::SameLine();
+    if (snapshotSave) {
+        snapshotSave->progress.cancelRequested = true;
+    }
+}
 
-    if (hasChanges) {
-        if (ImGui::Button("Save")) {
-            saveChanges();
-        }
+void SQLEditorTab::render() {
+    ImGui::Text("SQL Editor");
+    ImGui::Separator();
+
+    // SQL input, edited in place and grown through the resize callback. Tab and the arrow keys
+    // belong to the completion list while it is open. The widget draws its text and caret
+    // transparent; renderHighlighting() draws them again in colour.
+    ImGuiInputTextFlags editorFlags = ImGuiInputTextFlags_CallbackAlways |
+                                      ImGuiInputTextFlags_CallbackEdit |
+                                      ImGuiInputTextFlags_CallbackResize;
+    if (!completion.matches.empty()) {
+        editorFlags |= ImGuiInputTextFlags_CallbackCompletion | ImGuiInputTextFlags_CallbackHistory;
+    }
+    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.0f, 0.0f, 0.0f, 0.0f));
+    if (ImGui::InputTextMultiline("##SQL", sqlQuery.data(), sqlQuery.capacity() + 1,
+                                  ImVec2(-1, ImGui::GetContentRegionAvail().y * 0.3f), editorFlags,
+                                  editorCallback, this)) {
+        highlighter.update(sqlQuery);
+    }
+    ImGui::PopStyleColor();
+    const bool editorActive = ImGui::IsItemActive();
+    renderHighlighting(editorActive);
+    if (editorActive) {
+        renderCompletion();
     } else {
+        completion.matches.clear();
+        completionCursor = -1;
+    }
+
+    if (activeRun) {
         ImGui::BeginDisabled();
-        ImGui::Button("Save");
+        ImGui::Button("Execute Query");
         ImGui::EndDisabled();
+    } else if (ImGui::Button("Execute Query")) {
+        runQuery();
     }
 
     ImGui::SameLine();
-    if (hasChanges) {
-        if (ImGui::Button("Cancel")) {
-            cancelChanges();
+    if (ImGui::Button("Explain")) {
+        explain(false);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Explain Analyze")) {
+        explain(true);
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Clear")) {
+        sqlQuery.clear();
+        highlighter.update(sqlQuery);
+    }
+
+    ImGui::SameLine();
+    ImGui::Checkbox("Cache Results", &useCache);
+
+    ImGui::SameLine();
+    renderWatchControls();
+
+    if (resultStore) {
+        ImGui::SameLine();
+        const bool saving = snapshotSave && !snapshotSave->finished;
+        ImGui::BeginDisabled(saving);
+        if (ImGui::Button("Save Snapshot")) {
+            saveSnapshot();
         }
-    } else {
-        ImGui::BeginDisabled();
-        ImGui::Button("Cancel");
         ImGui::EndDisabled();
+        ImGui::SameLine();
+        if (ImGui::Button("Chart")) {
+            Application::getInstance().getTabManager()->createChartTab(name, resultStore);
+        }
     }
 
-    if (hasChanges) {
-        ImGui::SameLine();
-        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f), "Unsaved changes");
+    if (snapshotSave) {
+        if (!snapshotSave->finished) {
+            ImGui::Text("Saving snapshot: %llu rows",
+                        (unsigned long long)snapshotSave->progress.rows.load());
+            ImGui::SameLine();
+            if (snapshotSave->progress.cancelRequested) {
+                ImGui::TextDisabled("Cancelling...");
+            } else if (ImGui::SmallButton("Cancel##Snapshot")) {
+                snapshotSave->progress.cancelRequested = true;
+            }
+        } else if (!snapshotSave->error.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Snapshot failed: %s",
+                               snapshotSave->error.c_str());
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Dismiss##Snapshot")) {
+                snapshotSave.reset();
+            }
+        }
     }
 
     ImGui::Separator();
+    ImGui::Text("Results:");
 
-    // Table display
-    if (!columnNames.empty() && !tableData.empty()) {
-        if (ImGui::BeginTable("TableData", columnNames.size(),
-                              ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
-                                  ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY)) {
-            // Headers
-            for (const auto &colName : columnNames) {
-                ImGui::TableSetupColumn(colName.c_str());
-            }
-            ImGui::TableHeadersRow();
-
-            // Data rows
-            for (size_t rowIdx = 0; rowIdx < tableData.size(); rowIdx++) {
-                const auto &row = tableData[rowIdx];
-                ImGui::TableNextRow();
+    if (activeRun) {
+        renderProgress();
+    }
 
-                for (size_t colIdx = 0; colIdx < row.size() && colIdx < columnNames.size();
-                     colIdx++) {
-                    ImGui::TableNextColumn();
+    if (!scriptResults.empty()) {
+        renderScriptResults();
+    }
 
-                    // Check if this cell is being edited
-                    if (editingRow == (int)rowIdx && editingCol == (int)colIdx) {
-                        // Edit mode - show input field
-                        ImGui::SetKeyboardFocusHere();
-                        if (ImGui::InputText("##edit", editBuffer, sizeof(editBuffer),
-                                             ImGuiInputTextFlags_EnterReturnsTrue)) {
-                            exitEditMode(true);
-                        }
-                        // Exit edit mode on Escape
-                        if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
-                            exitEditMode(false);
-                        }
-                    } else {
-                        // Display mode - show cell content
-                        ImGui::PushID((int)(rowIdx * columnNames.size() + colIdx));
-
-                        // Check for cell selection highlighting
-                        bool isSelected =
-                            (selectedRow == (int)rowIdx && selectedCol == (int)colIdx);
-                        if (isSelected) {
-                            ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg,
-                                                   ImGui::GetColorU32(ImGuiCol_ButtonActive));
-                        }
+    if (resultStore) {
+        renderResultGrid();
+        return;
+    }
 
-                        // Use a simple selectable text
-                        if (ImGui::Selectable(row[colIdx].c_str(), isSelected,
-                                              ImGuiSelectableFlags_AllowDoubleClick)) {
-                            // Single click - select cell
-                            selectCell((int)rowIdx, (int)colIdx);
+    // Results display
+    ImGui::InputTextMultiline("##Results", resultBuffer, sizeof(resultBuffer), ImVec2(-1, -1),
+                              ImGuiInputTextFlags_ReadOnly);
+}
 
-                            // Double click - enter edit mode
-                            if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
-                                enterEditMode((int)rowIdx, (int)colIdx);
-                            }
-                        }
+void SQLEditorTab::setQuery(const std::string &query) {
+    sqlQuery = query;
+    highlighter.update(sqlQuery);
+}
 
-                        ImGui::PopID();
-                    }
-                }
-            }
+size_t SQLEditorTab::getMemoryUsage() const {
+    size_t bytes = stringBytes(queryResult) + highlighter.getMemoryUsage();
+    for (const auto &result : scriptResults) {
+        bytes += stringBytes(result.sql) + stringBytes(result.output) + stringBytes(result.error);
+    }
+    if (resultStore) {
+        bytes += resultStore->getMemoryUsage();
+    }
+    bytes += resultHashes.capacity() * sizeof(uint64_t);
+    return bytes;
+}
 
-            ImGui::EndTable();
-        }
-    } else {
-        ImGui::Text("No data to display");
+bool SQLEditorTab::releaseData() {
+    // The result stays browsable through the spill file, so there is nothing to restore. A
+    // chart reading the result on a worker holds it; waiting for that would stall the UI.
+    bool busy = false;
+    if (resultStore && !resultStore->trySpill(busy)) {
+        std::cerr << "Failed to spill query result of " << name << std::endl;
     }
+    if (!busy) {
+        // Taken again on the worker by the next watch refresh
+        std::vector<uint64_t>().swap(resultHashes);
+    }
+    return !busy;
 }
 
-void TableViewerTab::loadData() {
+std::shared_ptr<DatabaseInterface> SQLEditorTab::getDatabase() const {
     auto &app = Application::getInstance();
+    const int selectedDb = app.getSelectedDatabase();
     auto &databases = app.getDatabases();
 
-    // Find database
-    std::shared_ptr<DatabaseInterface> db = nullptr;
-    for (auto &database : databases) {
-        if (database->getPath() == databasePath && database->isConnected()) {
-            db = database;
-            break;
+    if (selectedDb < 0 || selectedDb >= (int)databases.size()) {
+        return nullptr;
+    }
+    return databases[selectedDb];
+}
+
+int SQLEditorTab::editorCallback(ImGuiInputTextCallbackData *data) {
+    auto &tab = *static_cast<SQLEditorTab *>(data->UserData);
+    switch (data->EventFlag) {
+    case ImGuiInputTextFlags_CallbackResize:
+        // The widget edits sqlQuery's own buffer; give it room for the new length
+        tab.sqlQuery.resize(data->BufTextLen);
+        data->Buf = tab.sqlQuery.data();
+        break;
+    case ImGuiInputTextFlags_CallbackCompletion:
+        tab.acceptCompletion(*data);
+        break;
+    case ImGuiInputTextFlags_CallbackHistory: {
+        // The key already moved the cursor; put it back and move the selection instead
+        const int count = static_cast<int>(tab.completion.matches.size());
+        const int step = data->EventKey == ImGuiKey_UpArrow ? count - 1 : 1;
+        tab.completionSelected = (tab.completionSelected + step) % count;
+        data->CursorPos = data->SelectionStart = data->SelectionEnd = tab.completionCursor;
+        break;
+    }
+    default:
+        tab.editorCursor = data->CursorPos;
+        if (data->EventFlag == ImGuiInputTextFlags_CallbackEdit ||
+            data->CursorPos != tab.completionCursor) {
+            tab.updateCompletion(std::string_view(data->Buf, data->BufTextLen), data->CursorPos);
         }
+        break;
     }
+    return 0;
+}
 
-    if (!db)
+void SQLEditorTab::updateCompletion(const std::string_view text, const int cursor) {
+    completionCursor = cursor;
+    completionSelected = 0;
+    completion.matches.clear();
+    const auto db = getDatabase();
+    if (!db) {
         return;
+    }
 
-    // Get total row count
-    totalRows = db->getRowCount(tableName);
-
-    // Get column names
-    columnNames = db->getColumnNames(tableName);
+    auto &index = Application::getInstance().getSchemaIndex(*db);
+    completion = index.complete(text, static_cast<size_t>(cursor), kMaxCompletions);
+    // Nothing left to offer once the word is typed out
+    const std::string_view word = text.substr(completion.wordStart, cursor - completion.wordStart);
+    if (completion.matches.size() == 1 && completion.matches.front().name == word) {
+        completion.matches.clear();
+    }
+}
 
-    // Get data with pagination
-    int offset = currentPage * rowsPerPage;
-    tableData = db->getTableData(tableName, rowsPerPage, offset);
+void SQLEditorTab::acceptCompletion(ImGuiInputTextCallbackData &data) {
+    if (completion.matches.empty()) {
+        return;
+    }
+    const SchemaIndex::Match &match = completion.matches[completionSelected];
+    std::string text = match.name;
+    if (match.kind != SchemaIndex::MatchKind::KEYWORD) {
+        // PostgreSQL folds unquoted names to lower case
+        const auto db = getDatabase();
+        const bool foldsCase = db && db->getType() == DatabaseType::POSTGRESQL;
+        const bool plain =
+            !text.empty() && !std::isdigit(static_cast<unsigned char>(text[0])) &&
+            std::all_of(text.begin(), text.end(), [foldsCase](char c) {
+                return c == '_' || std::isdigit(static_cast<unsigned char>(c)) ||
+                       (foldsCase ? std::islower(static_cast<unsigned char>(c))
+                                  : std::isalpha(static_cast<unsigned char>(c)));
+            });
+        if (!plain) {
+            text = "\"" + text + "\"";
+        }
+    }
 
-    // Store original data for change tracking
-    originalData = tableData;
-    hasChanges = false;
+    const int start = static_cast<int>(completion.wordStart);
+    data.DeleteChars(start, data.CursorPos - start);
+    data.InsertChars(start, text.c_str());
+    completion.matches.clear();
+    completionCursor = data.CursorPos;
 }
 
-void TableViewerTab::nextPage() {
-    int totalPages = (totalRows + rowsPerPage - 1) / rowsPerPage;
-    if (currentPage < totalPages - 1) {
-        currentPage++;
-        loadData();
+void SQLEditorTab::renderCompletion() {
+    if (completion.matches.empty()) {
+        return;
     }
+    // ImGui does not expose the caret position, so the list opens below the editor
+    ImGui::SetNextWindowPos(ImVec2(ImGui::GetItemRectMin().x + 8.0f, ImGui::GetItemRectMax().y));
+    ImGui::BeginTooltip();
+    for (size_t i = 0; i < completion.matches.size(); i++) {
+        const SchemaIndex::Match &match = completion.matches[i];
+        const char *kind = match.kind == SchemaIndex::MatchKind::TABLE    ? "T"
+                           : match.kind == SchemaIndex::MatchKind::COLUMN ? "C"
+                                                                          : "K";
+        ImGui::PushID(static_cast<int>(i));
+        ImGui::TextDisabled("%s", kind);
+        ImGui::SameLine();
+        ImGui::Selectable(match.name.c_str(), static_cast<int>(i) == completionSelected);
+        if (!match.detail.empty()) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("%s", match.detail.c_str());
+        }
+        ImGui::PopID();
+    }
+    ImGui::TextDisabled("Tab to insert, Up/Down to choose");
+    ImGui::EndTooltip();
 }
 
-void TableViewerTab::previousPage() {
-    if (currentPage > 0) {
-        currentPage--;
-        loadData();
+void SQLEditorTab::renderHighlighting(const bool active) {
+    // InputTextMultiline scrolls its text in a child window, the one it has just ended; the
+    // horizontal scroll lives in the widget's edit state while it is active
+    ImGuiWindow *window = ImGui::GetCurrentWindow();
+    if (window->DC.ChildWindows.empty()) {
+        return;
     }
-}
+    ImGuiWindow *editor = window->DC.ChildWindows.back();
+    const ImGuiInputTextState *state = ImGui::GetInputTextState(ImGui::GetID("##SQL"));
+    const float scrollX = active && state ? state->Scroll.x : 0.0f;
+    const ImVec2 padding = ImGui::GetStyle().FramePadding;
+    const ImVec2 origin(editor->Pos.x + padding.x - scrollX,
+                        editor->Pos.y + padding.y - editor->Scroll.y);
 
-void TableViewerTab::firstPage() {
-    currentPage = 0;
-    loadData();
+    ImFont *font = ImGui::GetFont();
+    const float lineHeight = ImGui::GetFontSize();
+    const ImU32 textColor = ImGui::GetColorU32(ImGuiCol_Text);
+    ImDrawList *drawList = editor->DrawList;
+    drawList->PushClipRect(editor->InnerClipRect.Min, editor->InnerClipRect.Max, true);
+
+    // Only the lines on screen are tokenized
+    const size_t firstLine = static_cast<size_t>(std::max(0.0f, editor->Scroll.y / lineHeight));
+    const size_t lastLine = std::min(
+        highlighter.getLineCount(),
+        firstLine + static_cast<size_t>(editor->Size.y / lineHeight) + 2);
+    const char *text = sqlQuery.data();
+    for (size_t line = firstLine; line < lastLine; line++) {
+        lineTokens.clear();
+        highlighter.tokenizeLine(line, lineTokens);
+        ImVec2 pos(origin.x, origin.y + line * lineHeight);
+        size_t offset = highlighter.getLineStart(line);
+        const auto draw = [&](const size_t end, const ImU32 color) {
+            if (end > offset) {
+                drawList->AddText(font, lineHeight, pos, color, text + offset, text + end);
+                pos.x +=
+                    font->CalcTextSizeA(lineHeight, FLT_MAX, 0.0f, text + offset, text + end).x;
+                offset = end;
+            }
+        };
+        for (const auto &token : lineTokens) {
+            draw(token.begin, textColor);
+            draw(token.end, tokenColor(token.kind));
+        }
+        draw(highlighter.getLineEnd(line), textColor);
+    }
+
+    if (active && static_cast<size_t>(editorCursor) <= sqlQuery.size()) {
+        const size_t line = highlighter.findLine(editorCursor);
+        const char *lineStart = text + highlighter.getLineStart(line);
+        const char *cursor = text + editorCursor;
+        const float x =
+            origin.x + font->CalcTextSizeA(lineHeight, FLT_MAX, 0.0f, lineStart, cursor).x;
+        const float y = origin.y + line * lineHeight;
+        drawList->AddLine(ImVec2(x, y), ImVec2(x, y + lineHeight), textColor);
+    }
+    drawList->PopClipRect();
 }
 
-void TableViewerTab::lastPage() {
-    int totalPages = (totalRows + rowsPerPage - 1) / rowsPerPage;
-    currentPage = totalPages - 1;
-    loadData();
+void SQLEditorTab::runQuery() {
+    startRun(false);
 }
 
-void TableViewerTab::refreshData() {
-    // Reset edit state
-    editingRow = -1;
-    editingCol = -1;
-    selectedRow = -1;
-    selectedCol = -1;
-    hasChanges = false;
+void SQLEditorTab::onWatchEnabled() {
+    // The current result is the baseline, so watch re-runs whatever produced it
+    if (resultStore && !resultSql.empty()) {
+        watchSql = resultSql;
+        watchDb = resultDb;
+    } else {
+        watchSql = sqlQuery;
+        watchDb = getDatabase();
+    }
+}
 
-    // Reload data from database
-    loadData();
+void SQLEditorTab::onWatchDisabled() {
+    std::vector<uint64_t>().swap(resultHashes);
 }
 
-void TableViewerTab::saveChanges() {
-    // For now, just mark as no changes (would need database update logic)
-    hasChanges = false;
-    originalData = tableData;
+void SQLEditorTab::watchRefresh() {
+    // The previous run has not come back yet
+    if (activeRun) {
+        return;
+    }
 
-    // TODO: Implement actual database update logic
-    // This would require UPDATE SQL statements for each modified cell
+    // Re-running anything that writes on a timer would repeat the write
+    if (SqlScript::splitStatements(watchSql).size() != 1 || !SqlScript::isReadOnly(watchSql)) {
+        watchEnabled = false;
+        watchStatus = "Watch only re-runs a single read-only statement";
+        onWatchDisabled();
+        return;
+    }
+    const auto db = watchDb.lock();
+    if (!db || !db->isConnected()) {
+        watchEnabled = false;
+        watchStatus = "Watch stopped: its connection was closed";
+        onWatchDisabled();
+        return;
+    }
+
+    startRun(true);
 }
 
-void TableViewerTab::cancelChanges() {
-    // Restore original data
-    tableData = originalData;
-    hasChanges = false;
+void SQLEditorTab::explain(const bool analyze) {
+    const auto statements = SqlScript::splitStatements(sqlQuery);
+    if (statements.size() != 1) {
+        setResultText("Explain needs exactly one statement");
+        return;
+    }
 
-    // Reset edit state
-    editingRow = -1;
-    editingCol = -1;
-    selectedRow = -1;
-    selectedCol = -1;
-}
+    const auto db = getDatabase();
+    if (!db) {
+        return;
+    }
 
-void TableViewerTab::enterEditMode(int row, int col) {
-    if (row >= 0 && row < (int)tableData.size() && col >= 0 && col < (int)columnNames.size()) {
+    // ANALYZE executes the statement, so the plan is built on a worker like any other run
+    auto &jobs = Application::getInstance().getJobRunner();
+    jobs.submit([db, sql = statements.front(), analyze, sourceName = name, &jobs] {
+        auto plan = std::make_shared<QueryPlan>(db->explainQuery(sql, analyze));
+        jobs.post([plan, sourceName] {
+            Application::getInstance().getTabManager()->createQueryPlanTab(sourceName,
+                                                                           std::move(*plan));
+        });
+    });
+}
+
+void SQLEditorTab::startRun(const bool watchRun) {
+    // One run at a time per tab
+    if (activeRun) {
+        return;
+    }
+
+    // Watch refreshes re-run the pinned statement, never whatever the editor holds now
+    const auto db = watchRun ? watchDb.lock() : getDatabase();
+    if (!db) {
+        return;
+    }
+    const std::string &sql = watchRun ? watchSql : sqlQuery;
+
+    auto run = std::make_shared<QueryRun>();
+    run->owner = this;
+    run->db = db;
+    run->sql = sql;
+    run->script = SqlScript::splitStatements(sql).size() > 1;
+    run->watch = watchRun;
+    // Watch refreshes always need fresh rows to diff against
+    run->cacheable = !watchRun && useCache && QueryCache::isCacheable(sql);
+    run->hashRows = watchEnabled;
+    // Results from the cache, from before watch was on, or hibernated have no hashes; they are
+    // taken on the worker rather than by replaying the result here
+    if (watchRun && resultStore && resultHashes.size() != resultStore->getRowCount()) {
+        run->baseline = resultStore;
+    }
+    activeRun = run;
+
+    auto &jobs = Application::getInstance().getJobRunner();
+    jobs.submit([run, &jobs] {
+        executeRun(*run);
+        jobs.post([run] {
+            if (run->owner) {
+                run->owner->finishRun(*run);
+            }
+        });
+    });
+}
+
+void SQLEditorTab::executeRun(QueryRun &run) {
+    if (run.script) {
+        run.scriptResults = run.db->executeScript(run.sql, &run.progress);
+        return;
+    }
+
+    // The token is read before the query runs, so a write that lands meanwhile makes the
+    // stored entry stale rather than hiding it
+    if (run.cacheable) {
+        run.changeToken = run.db->getChangeToken();
+        run.cached = Application::getInstance().getQueryCache().lookup(
+            run.db->getConnectionString(), run.sql, run.changeToken);
+        if (run.cached) {
+            return;
+        }
+    }
+
+    if (run.baseline) {
+        RowDiff::HashingSink hasher;
+        run.baseline->replay(hasher);
+        run.baselineHashes = std::move(hasher.getHashes());
+    }
+
+    // Stream the rows into a result store instead of a capped text dump. While watching, the
+    // row hashes are the baseline for the next refresh.
+    run.store = std::make_shared<ResultStore>();
+    if (!run.hashRows) {
+        run.result = run.db->streamQuery(run.sql, *run.store, &run.progress);
+        return;
+    }
+    RowDiff::HashingSink sink(run.store.get());
+    run.result = run.db->streamQuery(run.sql, sink, &run.progress);
+    run.hashes = std::move(sink.getHashes());
+}
+
+void SQLEditorTab::finishRun(QueryRun &run) {
+    activeRun.reset();
+
+    auto &cache = Application::getInstance().getQueryCache();
+    const std::string &connectionKey = run.db->getConnectionString();
+
+    if (run.script) {
+        for (const auto &result : run.scriptResults) {
+            if (result.executed && !SqlScript::isReadOnly(result.sql)) {
+                cache.invalidate(connectionKey);
+                break;
+            }
+        }
+
+        clearResults();
+        scriptResults = std::move(run.scriptResults);
+
+        // Show the first failure, or the last statement when everything succeeded
+        int index = (int)scriptResults.size() - 1;
+        for (size_t i = 0; i < scriptResults.size(); i++) {
+            if (scriptResults[i].executed && !scriptResults[i].success) {
+                index = (int)i;
+                break;
+            }
+        }
+        showStatementResult(index);
+        return;
+    }
+
+    if (!SqlScript::isReadOnly(run.sql)) {
+        cache.invalidate(connectionKey);
+    }
+
+    if (run.watch) {
+        if (run.baseline && run.baseline == resultStore) {
+            resultHashes = std::move(run.baselineHashes);
+        }
+        if (!run.result.success) {
+            // The last good result stays on screen
+            watchStatus = clockTime() + ": " + run.result.error;
+            return;
+        }
+        if (run.store->getColumnCount() == 0) {
+            return;
+        }
+
+        // Unchanged results keep the current store, so the grid has nothing to redraw
+        if (resultStore && resultStore->getColumnNames() == run.store->getColumnNames() &&
+            resultHashes == run.hashes) {
+            watchStatus = "No changes at " + clockTime();
+            return;
+        }
+
+        RowDiff::Result diff = RowDiff::compare(resultHashes, run.hashes);
+        watchStatus = watchSummary(diff);
+        clearResults();
+        resultStore = std::move(run.store);
+        if (watchEnabled) {
+            resultHashes = std::move(run.hashes);
+        }
+        resultSql = run.sql;
+        resultDb = run.db;
+        changedRows = std::move(diff.changed);
+        resultElapsedMs = run.result.elapsedMs;
+        return;
+    }
+
+    clearResults();
+    if (run.cached || (run.result.success && run.store->getColumnCount() > 0)) {
+        resultSql = run.sql;
+        resultDb = run.db;
+        // A new baseline; watch follows it
+        if (watchEnabled) {
+            watchSql = run.sql;
+            watchDb = run.db;
+        }
+    }
+    if (run.cached) {
+        resultStore = run.cached->result;
+        resultElapsedMs = run.cached->elapsedMs;
+        resultCachedAt = run.cached->storedAt;
+        resultFromCache = true;
+    } else if (!run.result.success) {
+        setResultText(run.progress.cancelRequested ? "Query cancelled"
+                                                   : "Error: " + run.result.error);
+    } else if (run.store->getColumnCount() > 0) {
+        resultStore = run.store;
+        if (watchEnabled) {
+            resultHashes = std::move(run.hashes);
+        }
+        resultElapsedMs = run.result.elapsedMs;
+        if (run.cacheable) {
+            // PostgreSQL counters lag behind commits, so its entries also expire
+            const auto ttl = run.db->getType() == DatabaseType::POSTGRESQL
+                                 ? QueryCache::kPostgresTtl
+                                 : std::chrono::seconds(0);
+            cache.store(connectionKey, run.sql, run.changeToken, run.store,
+                        run.result.elapsedMs, ttl);
+        }
+    } else {
+        setResultText(run.result.output);
+    }
+}
+
+void SQLEditorTab::clearResults() {
+    scriptResults.clear();
+    selectedStatement = -1;
+    resultStore.reset();
+    resultHashes.clear();
+    changedRows.clear();
+    resultSql.clear();
+    resultDb.reset();
+    resultFromCache = false;
+}
+
+void SQLEditorTab::renderProgress() {
+    QueryRun &run = *activeRun;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                         run.progress.startedAt)
+                               .count();
+    ImGui::Text("Running for %.1f s", seconds);
+
+    const uint64_t rows = run.progress.rows;
+    if (rows > 0) {
+        ImGui::SameLine();
+        ImGui::Text("%llu rows", (unsigned long long)rows);
+    }
+    const uint64_t steps = run.progress.steps;
+    if (steps > 0) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%.1fM VM steps", (double)steps / 1e6);
+    }
+    if (!run.phase.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", run.phase.c_str());
+    }
+
+    ImGui::SameLine();
+    if (run.progress.cancelRequested) {
+        ImGui::TextDisabled("Cancelling...");
+    } else if (ImGui::Button("Cancel")) {
+        run.progress.cancelRequested = true;
+        run.nextPoll = 0.0;
+    }
+
+    // Server-side progress is fetched on a worker and posted back, never waited for here
+    const double now = ImGui::GetTime();
+    if (run.polling || now < run.nextPoll) {
+        return;
+    }
+    run.polling = true;
+    run.nextPoll = now + kProgressPollSeconds;
+
+    auto shared = activeRun;
+    auto &jobs = Application::getInstance().getJobRunner();
+    jobs.submit([shared, &jobs] {
+        std::string phase = shared->db->pollProgress(shared->progress);
+        jobs.post([shared, phase = std::move(phase)] {
+            shared->phase = phase;
+            shared->polling = false;
+        });
+    });
+}
+
+void SQLEditorTab::saveSnapshot() {
+    const std::string path = FileDialog::saveSnapshotFile("result.dsnap");
+    if (path.empty()) {
+        return;
+    }
+
+    snapshotSave = std::make_shared<SnapshotSave>();
+    snapshotSave->sourceName = name;
+    snapshotSave->path = path;
+
+    // Written from the stored rows on a worker, so the query does not run again
+    auto &jobs = Application::getInstance().getJobRunner();
+    jobs.submit([job = snapshotSave, store = resultStore, &jobs] {
+        SnapshotWriter writer(job->path, &job->progress);
+        store->replay(writer);
+        std::string error = writer.getError();
+        if (!error.empty()) {
+            std::remove(job->path.c_str());
+        }
+        jobs.post([job, error, rows = writer.getRowCount()] {
+            job->error = error;
+            job->rows = rows;
+            job->finished = true;
+            if (error.empty()) {
+                Application::getInstance().getTabManager()->createSnapshotTab(job->path);
+            }
+        });
+    });
+}
+
+void SQLEditorTab::renderResultGrid() {
+    ImGui::Text("%zu rows in %.1f ms", resultStore->getRowCount(), resultElapsedMs);
+    if (resultFromCache) {
+        const auto age = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - resultCachedAt);
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(0.4f, 0.8f, 0.4f, 1.0f), "(cached, %llds old)",
+                           (long long)age.count());
+    }
+    if (resultStore->isSpilled()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(%.1f MB spilled to disk)",
+                            (double)resultStore->getSpilledBytes() / (1024.0 * 1024.0));
+    }
+
+    const auto &columns = resultStore->getColumnNames();
+    if (ImGui::BeginTable("QueryResult", (int)columns.size(),
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                              ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY |
+                              ImGuiTableFlags_Resizable)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        for (const auto &column : columns) {
+            ImGui::TableSetupColumn(column.c_str());
+        }
+        ImGui::TableHeadersRow();
+
+        // Only the visible rows are read, so a spilled result pages in from the mapping
+        ImGuiListClipper clipper;
+        clipper.Begin((int)resultStore->getRowCount());
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                ImGui::TableNextRow();
+                if ((size_t)row < changedRows.size() && changedRows[row]) {
+                    ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, changedRowColor());
+                }
+                for (size_t col = 0; col < columns.size(); col++) {
+                    ImGui::TableNextColumn();
+                    if (resultStore->isNull(row, col)) {
+                        ImGui::TextDisabled("NULL");
+                    } else {
+                        const std::string_view cell = resultStore->getCell(row, col);
+                        ImGui::TextUnformatted(cell.data(), cell.data() + cell.size());
+                    }
+                }
+            }
+        }
+
+        ImGui::EndTable();
+    }
+}
+
+void SQLEditorTab::renderScriptResults() {
+    const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    const float height = std::min(rowHeight * (float)(scriptResults.size() + 1) + 4.0f,
+                                  ImGui::GetContentRegionAvail().y * 0.4f);
+
+    if (ImGui::BeginTable("ScriptResults", 4,
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                              ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable,
+                          ImVec2(-1, height))) {
+        ImGui::TableSetupColumn("#", ImGuiTableColumnFlags_WidthFixed, 40.0f);
+        ImGui::TableSetupColumn("Status", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+        ImGui::TableSetupColumn("Time (ms)", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+        ImGui::TableSetupColumn("Statement", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
+
+        ImGuiListClipper clipper;
+        clipper.Begin((int)scriptResults.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                const auto &result = scriptResults[i];
+                ImGui::TableNextRow();
+
+                ImGui::TableNextColumn();
+                char label[32];
+                snprintf(label, sizeof(label), "%d", i + 1);
+                if (ImGui::Selectable(label, selectedStatement == i,
+                                      ImGuiSelectableFlags_SpanAllColumns)) {
+                    showStatementResult(i);
+                }
+
+                ImGui::TableNextColumn();
+                if (!result.executed) {
+                    ImGui::TextDisabled("Skipped");
+                } else if (result.success) {
+                    ImGui::TextColored(ImVec4(0.4f, 0.8f, 0.4f, 1.0f), "OK");
+                } else {
+                    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Error");
+                }
+
+                ImGui::TableNextColumn();
+                if (result.executed) {
+                    ImGui::Text("%.2f", result.elapsedMs);
+                }
+
+                // First line of the statement only
+                ImGui::TableNextColumn();
+                const char *sqlBegin = result.sql.c_str();
+                const char *sqlEnd = strchr(sqlBegin, '\n');
+                ImGui::TextUnformatted(sqlBegin, sqlEnd);
+            }
+        }
+
+        ImGui::EndTable();
+    }
+}
+
+void SQLEditorTab::showStatementResult(int index) {
+    if (index < 0 || index >= (int)scriptResults.size()) {
+        return;
+    }
+
+    selectedStatement = index;
+    const auto &result = scriptResults[index];
+    if (result.success) {
+        setResultText(result.output);
+    } else if (result.executed) {
+        setResultText("Error: " + result.error);
+    } else {
+        setResultText(result.error);
+    }
+}
+
+void SQLEditorTab::setResultText(const std::string &text) {
+    queryResult = text;
+    strncpy(resultBuffer, queryResult.c_str(), sizeof(resultBuffer) - 1);
+    resultBuffer[sizeof(resultBuffer) - 1] = '\0';
+}
+
+// TableViewerTab implementation
+// A page read on a worker and handed back on the main thread; owner is cleared there if the
+// tab is closed or a newer load starts in the meantime
+struct TableViewerTab::PageLoad {
+    TableViewerTab *owner = nullptr;
+    bool watch = false;
+    std::vector<std::string> columnNames;
+    int totalRows = 0;
+    std::vector<std::vector<std::string>> rows;
+};
+
+TableViewerTab::TableViewerTab(const std::string &name, const std::string &databasePath,
+                               const std::string &tableName)
+    : Tab(name, TabType::TABLE_VIEWER), databasePath(databasePath), tableName(tableName) {
+    loadData();
+}
+
+TableViewerTab::~TableViewerTab() {
+    if (pageLoad) {
+        pageLoad->owner = nullptr;
+    }
+}
+
+void TableViewerTab::render() {
+    followSchema();
+    ImGui::Text("Table: %s", tableName.c_str());
+    ImGui::Separator();
+
+    // Pagination controls
+    int totalPages = (totalRows + rowsPerPage - 1) / rowsPerPage;
+
+    if (ImGui::Button("<<") && currentPage > 0) {
+        firstPage();
+    }
+    ImGui::SameLine();
+
+    if (ImGui::Button("<") && currentPage > 0) {
+        previousPage();
+    }
+    ImGui::SameLine();
+
+    ImGui::Text("Page %d of %d (%d rows total)", currentPage + 1, totalPages, totalRows);
+    ImGui::SameLine();
+
+    if (ImGui::Button(">") && currentPage < totalPages - 1) {
+        nextPage();
+    }
+    ImGui::SameLine();
+
+    if (ImGui::Button(">>") && currentPage < totalPages - 1) {
+        lastPage();
+    }
+
+    // Action buttons next to pagination
+    ImGui::SameLine();
+    ImGui::Dummy(ImVec2(20, 0)); // Add some spacing
+    ImGui::SameLine();
+
+    if (ImGui::Button("Refresh")) {
+        refreshData();
+    }
+    ImGui::SameLine();
+    renderWatchControls();
+    ImGui::SameLine();
+
+    if (hasChanges) {
+        if (ImGui::Button("Save")) {
+            saveChanges();
+        }
+    } else {
+        ImGui::BeginDisabled();
+        ImGui::Button("Save");
+        ImGui::EndDisabled();
+    }
+
+    ImGui::SameLine();
+    if (hasChanges) {
+        if (ImGui::Button("Cancel")) {
+            cancelChanges();
+        }
+    } else {
+        ImGui::BeginDisabled();
+        ImGui::Button("Cancel");
+        ImGui::EndDisabled();
+    }
+
+    if (hasChanges) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f), "Unsaved changes");
+    }
+    if (!editJournal.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(%zu edited rows not on this page)", editJournal.size());
+    }
+    if (pageLoad && !pageLoad->watch) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Loading...");
+    }
+
+    ImGui::Separator();
+
+    // Table display
+    if (!columnNames.empty() && !tableData.empty()) {
+        // Until the page is measured, columns size themselves and cells show their full text
+        auto layout = gridLayout->get();
+        if (layout && !layout->matches(tableData.size(), columnNames.size())) {
+            layout.reset();
+        }
+
+        if (ImGui::BeginTable("TableData", columnNames.size(),
+                              ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                                  ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY)) {
+            // Headers
+            ImGui::TableSetupScrollFreeze(0, 1);
+            for (size_t colIdx = 0; colIdx < columnNames.size(); colIdx++) {
+                if (layout) {
+                    ImGui::TableSetupColumn(columnNames[colIdx].c_str(),
+                                            ImGuiTableColumnFlags_WidthFixed,
+                                            layout->columnWidths[colIdx]);
+                } else {
+                    ImGui::TableSetupColumn(columnNames[colIdx].c_str());
+                }
+            }
+            ImGui::TableHeadersRow();
+
+            // Data rows; only visible rows and columns are drawn
+            ImGuiListClipper clipper;
+            clipper.Begin((int)tableData.size());
+            while (clipper.Step()) {
+                for (int rowIdx = clipper.DisplayStart; rowIdx < clipper.DisplayEnd; rowIdx++) {
+                    const auto &row = tableData[rowIdx];
+                    ImGui::TableNextRow();
+                    if ((size_t)rowIdx < changedRows.size() && changedRows[rowIdx]) {
+                        ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, changedRowColor());
+                    }
+
+                    for (size_t colIdx = 0; colIdx < row.size() && colIdx < columnNames.size();
+                         colIdx++) {
+                        if (!ImGui::TableNextColumn()) {
+                            continue;
+                        }
+
+                        // Check if this cell is being edited
+                        if (editingRow == (int)rowIdx && editingCol == (int)colIdx) {
+                            // Edit mode - show input field
+                            ImGui::SetKeyboardFocusHere();
+                            if (ImGui::InputText("##edit", editBuffer, sizeof(editBuffer),
+                                                 ImGuiInputTextFlags_EnterReturnsTrue)) {
+                                exitEditMode(true);
+                            }
+                            // Exit edit mode on Escape
+                            if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+                                exitEditMode(false);
+                            }
+                        } else {
+                            // Display mode - show cell content
+                            ImGui::PushID((int)(rowIdx * columnNames.size() + colIdx));
+
+                            // Check for cell selection highlighting
+                            bool isSelected =
+                                (selectedRow == (int)rowIdx && selectedCol == (int)colIdx);
+                            if (isSelected) {
+                                ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg,
+                                                       ImGui::GetColorU32(ImGuiCol_ButtonActive));
+                            }
+
+                            // Use a simple selectable text
+                            const char *text = layout ? layout->getDisplayText(rowIdx, colIdx,
+                                                                               row[colIdx])
+                                                      : row[colIdx].c_str();
+                            if (ImGui::Selectable(text, isSelected,
+                                                  ImGuiSelectableFlags_AllowDoubleClick)) {
+                                // Single click - select cell
+                                selectCell((int)rowIdx, (int)colIdx);
+
+                                // Double click - enter edit mode
+                                if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+                                    enterEditMode((int)rowIdx, (int)colIdx);
+                                }
+                            }
+
+                            ImGui::PopID();
+                        }
+                    }
+                }
+            }
+
+            ImGui::EndTable();
+        }
+    } else if (!pageLoad) {
+        ImGui::Text("No data to display");
+    }
+}
+
+std::shared_ptr<DatabaseInterface> TableViewerTab::getDatabase() const {
+    for (auto &database : Application::getInstance().getDatabases()) {
+        if (database->getPath() == databasePath && database->isConnected()) {
+            return database;
+        }
+    }
+    return nullptr;
+}
+
+void TableViewerTab::loadData() {
+    startLoad(false);
+}
+
+void TableViewerTab::startLoad(const bool watch) {
+    const auto db = getDatabase();
+    if (!db)
+        return;
+
+    if (pageLoad) {
+        pageLoad->owner = nullptr;
+    }
+    pageLoad = std::make_shared<PageLoad>();
+    pageLoad->owner = this;
+    pageLoad->watch = watch;
+
+    auto &jobs = Application::getInstance().getJobRunner();
+    jobs.submit([load = pageLoad, db, tableName = tableName, limit = rowsPerPage,
+                 offset = currentPage * rowsPerPage, &jobs] {
+        load->columnNames = db->getColumnNames(tableName);
+        if (!load->columnNames.empty()) {
+            load->totalRows = db->getRowCount(tableName);
+            load->rows = db->getTableData(tableName, limit, offset);
+        }
+        jobs.post([load] {
+            if (load->owner) {
+                load->owner->finishLoad(*load);
+            }
+        });
+    });
+}
+
+void TableViewerTab::finishLoad(PageLoad &load) {
+    // The posted callback keeps load alive
+    pageLoad.reset();
+
+    // Hibernated while the page was read; waking loads it again
+    if (hibernated) {
+        return;
+    }
+    // No columns means the table is gone or couldn't be read; journaled edits wait for a
+    // load that works
+    if (load.columnNames.empty()) {
+        return;
+    }
+
+    if (load.watch) {
+        // Never overwrite cells the user started editing while the page was read
+        if (hasChanges || editingRow >= 0) {
+            watchStatus = "Paused while there are unsaved changes";
+            return;
+        }
+        if (load.columnNames == columnNames) {
+            applyWatchRows(load.totalRows, std::move(load.rows));
+            return;
+        }
+        watchStatus = clockTime() + ": columns changed, page reloaded";
+    }
+
+    // An edit started on the page being replaced goes with it
+    editingRow = -1;
+    editingCol = -1;
+    columnNames = std::move(load.columnNames);
+    totalRows = load.totalRows;
+    tableData = std::move(load.rows);
+
+    // Store original data for change tracking
+    originalData = tableData;
+    hasChanges = false;
+    changedRows.clear();
+    applyEditJournal();
+    updateDataBytes();
+    gridLayout->request(columnNames, tableData);
+}
+
+std::vector<std::string> TableViewerTab::journalRowKey(const size_t row) const {
+    const auto &values = originalData[row];
+    std::vector<std::string> key;
+    for (const auto &name : journalKeyColumns) {
+        const auto it = std::find(columnNames.begin(), columnNames.end(), name);
+        if (it == columnNames.end()) {
+            return values; // The key column was dropped
+        }
+        key.push_back(values[static_cast<size_t>(it - columnNames.begin())]);
+    }
+    return journalKeyColumns.empty() ? values : key;
+}
+
+void TableViewerTab::applyEditJournal() {
+    for (size_t row = 0; row < tableData.size() && !editJournal.empty(); row++) {
+        const auto entry = editJournal.find(journalRowKey(row));
+        if (entry == editJournal.end()) {
+            continue;
+        }
+        for (auto cell = entry->second.begin(); cell != entry->second.end();) {
+            const auto it = std::find(columnNames.begin(), columnNames.end(), cell->first);
+            const size_t col = static_cast<size_t>(it - columnNames.begin());
+            if (it == columnNames.end() || col >= tableData[row].size()) {
+                ++cell;
+                continue;
+            }
+            tableData[row][col] = cell->second;
+            hasChanges = true;
+            cell = entry->second.erase(cell);
+        }
+        if (entry->second.empty()) {
+            editJournal.erase(entry);
+        }
+    }
+}
+
+void TableViewerTab::followSchema() {
+    // Checked again once the user's edits are saved or dropped
+    if (hasChanges || editingRow >= 0) {
+        return;
+    }
+    const auto db = getDatabase();
+    if (!db || db->getSchemaGeneration() == schemaGeneration || db->isBusy()) {
+        return;
+    }
+    schemaGeneration = db->getSchemaGeneration();
+
+    for (const auto &table : db->getTables()) {
+        if (table.getQualifiedName() != tableName || !table.columnsLoaded) {
+            continue;
+        }
+        std::vector<std::string> names;
+        names.reserve(table.columns.size());
+        for (const auto &column : table.columns) {
+            names.push_back(column.name);
+        }
+        if (names != columnNames) {
+            loadData();
+        }
+        return;
+    }
+}
+
+void TableViewerTab::watchRefresh() {
+    // Never overwrite cells the user is editing
+    if (hasChanges || editingRow >= 0) {
+        watchStatus = "Paused while there are unsaved changes";
+        return;
+    }
+    // The previous read is still running
+    if (pageLoad) {
+        return;
+    }
+    startLoad(true);
+}
+
+void TableViewerTab::applyWatchRows(const int rowCount,
+                                    std::vector<std::vector<std::string>> rows) {
+    totalRows = rowCount;
+
+    std::vector<uint64_t> previous;
+    previous.reserve(tableData.size());
+    for (const auto &row : tableData) {
+        previous.push_back(RowDiff::hashRow(row));
+    }
+    std::vector<uint64_t> current;
+    current.reserve(rows.size());
+    for (const auto &row : rows) {
+        current.push_back(RowDiff::hashRow(row));
+    }
+
+    if (previous == current) {
+        watchStatus = "No changes at " + clockTime();
+        return;
+    }
+
+    // Only rows that differ at their position are replaced; the others keep their strings
+    RowDiff::Result diff = RowDiff::compare(previous, current);
+    watchStatus = watchSummary(diff);
+    tableData.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (previous.size() <= i || previous[i] != current[i]) {
+            tableData[i] = std::move(rows[i]);
+        }
+    }
+    originalData = tableData;
+    changedRows = std::move(diff.changed);
+    updateDataBytes();
+    gridLayout->request(columnNames, tableData);
+}
+
+bool TableViewerTab::releaseData() {
+    if (editingRow >= 0) {
+        exitEditMode(true);
+    }
+
+    // Only the edited cells survive; everything else is reloaded from the database on wake.
+    // Entries left from an earlier wake whose rows weren't on the page are kept too.
+    if (editJournal.empty()) {
+        journalKeyColumns.clear();
+        if (const auto db = getDatabase()) {
+            for (const auto &table : db->getTables()) {
+                if (table.getQualifiedName() != tableName || !table.columnsLoaded) {
+                    continue;
+                }
+                for (const auto &column : table.columns) {
+                    if (column.isPrimaryKey) {
+                        journalKeyColumns.push_back(column.name);
+                    }
+                }
+                break;
+            }
+        }
+    }
+    for (size_t row = 0; row < tableData.size() && row < originalData.size(); row++) {
+        const size_t columns = std::min(columnNames.size(), originalData[row].size());
+        for (size_t col = 0; col < tableData[row].size() && col < columns; col++) {
+            if (tableData[row][col] != originalData[row][col]) {
+                editJournal[journalRowKey(row)][columnNames[col]] = tableData[row][col];
+            }
+        }
+    }
+
+    std::vector<std::vector<std::string>>().swap(tableData);
+    std::vector<std::vector<std::string>>().swap(originalData);
+    std::vector<std::string>().swap(columnNames);
+    dataBytes = 0;
+    gridLayout->invalidate();
+    return true;
+}
+
+void TableViewerTab::restoreData() {
+    // Same page as before; a recently read page is usually still in the OS page cache. The
+    // load reapplies the journal to whichever of its rows it finds.
+    loadData();
+}
+
+void TableViewerTab::updateDataBytes() {
+    dataBytes = tableBytes(tableData) + tableBytes(originalData);
+    for (const auto &column : columnNames) {
+        dataBytes += stringBytes(column);
+    }
+}
+
+void TableViewerTab::nextPage() {
+    int totalPages = (totalRows + rowsPerPage - 1) / rowsPerPage;
+    if (currentPage < totalPages - 1) {
+        currentPage++;
+        loadData();
+    }
+}
+
+void TableViewerTab::previousPage() {
+    if (currentPage > 0) {
+        currentPage--;
+        loadData();
+    }
+}
+
+void TableViewerTab::firstPage() {
+    currentPage = 0;
+    loadData();
+}
+
+void TableViewerTab::lastPage() {
+    int totalPages = (totalRows + rowsPerPage - 1) / rowsPerPage;
+    currentPage = totalPages - 1;
+    loadData();
+}
+
+void TableViewerTab::refreshData() {
+    // Reset edit state
+    editingRow = -1;
+    editingCol = -1;
+    selectedRow = -1;
+    selectedCol = -1;
+    hasChanges = false;
+    editJournal.clear();
+
+    // Reload data from database
+    loadData();
+}
+
+void TableViewerTab::saveChanges() {
+    // For now, just mark as no changes (would need database update logic)
+    hasChanges = false;
+    originalData = tableData;
+
+    // TODO: Implement actual database update logic
+    // This would require UPDATE SQL statements for each modified cell
+}
+
+void TableViewerTab::cancelChanges() {
+    // Restore original data
+    tableData = originalData;
+    hasChanges = false;
+    editJournal.clear();
+    updateDataBytes();
+    gridLayout->request(columnNames, tableData);
+
+    // Reset edit state
+    editingRow = -1;
+    editingCol = -1;
+    selectedRow = -1;
+    selectedCol = -1;
+}
+
+void TableViewerTab::enterEditMode(int row, int col) {
+    if (row >= 0 && row < (int)tableData.size() && col >= 0 && col < (int)columnNames.size()) {
 
         editingRow = row;
         editingCol = col;
 
-        // Copy current cell value to edit buffer
-        strncpy(editBuffer, tableData[row][col].c_str(), sizeof(editBuffer) - 1);
-        editBuffer[sizeof(editBuffer) - 1] = '\0';
+        // Copy current cell value to edit buffer
+        strncpy(editBuffer, tableData[row][col].c_str(), sizeof(editBuffer) - 1);
+        editBuffer[sizeof(editBuffer) - 1] = '\0';
+    }
+}
+
+void TableViewerTab::exitEditMode(bool saveEdit) {
+    if (editingRow >= 0 && editingCol >= 0) {
+        if (saveEdit) {
+            // Save the edited value
+            std::string newValue = editBuffer;
+            if (newValue != tableData[editingRow][editingCol]) {
+                tableData[editingRow][editingCol] = newValue;
+                hasChanges = true;
+                updateDataBytes();
+                gridLayout->request(columnNames, tableData);
+            }
+        }
+
+        // Clear edit state
+        editingRow = -1;
+        editingCol = -1;
+        memset(editBuffer, 0, sizeof(editBuffer));
+    }
+}
+
+void TableViewerTab::selectCell(int row, int col) {
+    if (row >= 0 && row < (int)tableData.size() && col >= 0 && col < (int)columnNames.size()) {
+
+        selectedRow = row;
+        selectedCol = col;
+    }
+}
+
+// SnapshotTab implementation
+SnapshotTab::SnapshotTab(const std::string &name, const std::string &snapshotPath)
+    : Tab(name, TabType::SNAPSHOT), snapshotPath(snapshotPath) {
+    loaded = snapshot.open(snapshotPath, loadError);
+}
+
+void SnapshotTab::render() {
+    ImGui::Text("Snapshot: %s", snapshotPath.c_str());
+    ImGui::Separator();
+
+    if (!loaded) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", loadError.c_str());
+        return;
+    }
+
+    ImGui::Text("%llu rows, %zu columns", (unsigned long long)snapshot.getRowCount(),
+                snapshot.getColumnCount());
+    ImGui::SameLine();
+    ImGui::TextDisabled("(%.1f MB on disk)",
+                        (double)snapshot.getFileSize() / (1024.0 * 1024.0));
+
+    const size_t columnCount = snapshot.getColumnCount();
+    if (columnCount == 0) {
+        return;
+    }
+
+    if (ImGui::BeginTable("SnapshotData", (int)columnCount,
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                              ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY |
+                              ImGuiTableFlags_Resizable)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        for (const auto &column : snapshot.getColumnNames()) {
+            ImGui::TableSetupColumn(column.c_str());
+        }
+        ImGui::TableHeadersRow();
+
+        // Cells are read straight from the mapping; only visible rows are touched
+        char scratch[ColumnarBatchView::kScratchSize];
+        ImGuiListClipper clipper;
+        clipper.Begin((int)snapshot.getRowCount());
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                ImGui::TableNextRow();
+                for (size_t col = 0; col < columnCount; col++) {
+                    ImGui::TableNextColumn();
+                    if (snapshot.isNull(row, col)) {
+                        ImGui::TextDisabled("NULL");
+                    } else {
+                        const std::string_view cell = snapshot.getDisplayText(row, col, scratch);
+                        ImGui::TextUnformatted(cell.data(), cell.data() + cell.size());
+                    }
+                }
+            }
+        }
+
+        ImGui::EndTable();
+    }
+}
+
+// QueryPlanTab implementation
+QueryPlanTab::QueryPlanTab(const std::string &name, QueryPlan plan)
+    : Tab(name, TabType::QUERY_PLAN), plan(std::move(plan)) {}
+
+void QueryPlanTab::render() {
+    ImGui::TextWrapped("%s", plan.sql.c_str());
+    ImGui::Separator();
+
+    if (!plan.error.empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Error: %s", plan.error.c_str());
+        return;
+    }
+    if (plan.analyzed) {
+        ImGui::Text("Planning %.2f ms, execution %.2f ms", plan.planningMs, plan.executionMs);
+    } else if (!plan.hasCosts) {
+        ImGui::TextDisabled("SQLite reports plan steps only, without costs or timings");
+    }
+
+    const int columnCount = plan.analyzed ? 6 : (plan.hasCosts ? 3 : 1);
+    if (ImGui::BeginTable("QueryPlan", columnCount,
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                              ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Node", ImGuiTableColumnFlags_WidthStretch);
+        if (plan.hasCosts) {
+            ImGui::TableSetupColumn("Cost", ImGuiTableColumnFlags_WidthFixed, 130.0f);
+            ImGui::TableSetupColumn(plan.analyzed ? "Rows (est / actual)" : "Rows (est)",
+                                    ImGuiTableColumnFlags_WidthFixed, 140.0f);
+        }
+        if (plan.analyzed) {
+            ImGui::TableSetupColumn("Time (ms)", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+            ImGui::TableSetupColumn("Self", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+            ImGui::TableSetupColumn("Buffers (hit / read)", ImGuiTableColumnFlags_WidthFixed,
+                                    140.0f);
+        }
+        ImGui::TableHeadersRow();
+
+        int nodeId = 0;
+        for (const auto &root : plan.roots) {
+            renderNode(root, nodeId);
+        }
+        ImGui::EndTable();
+    }
+}
+
+void QueryPlanTab::renderNode(const PlanNode &node, int &nodeId) {
+    ImGui::TableNextRow();
+    // Hot nodes get a red background that deepens with their share of the plan
+    if (node.hot) {
+        const float alpha = 0.15f + 0.45f * (float)std::min(node.selfShare, 1.0);
+        ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1,
+                               ImGui::GetColorU32(ImVec4(0.9f, 0.25f, 0.2f, alpha)));
+    }
+
+    ImGui::TableNextColumn();
+    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_SpanFullWidth;
+    if (node.children.empty()) {
+        flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+    }
+    const bool open =
+        ImGui::TreeNodeEx((void *)(intptr_t)nodeId++, flags, "%s", node.label.c_str());
+    if (!node.detail.empty() && ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("%s", node.detail.c_str());
+    }
+    if (!node.warning.empty()) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.2f, 1.0f), "(%s)", node.warning.c_str());
+    }
+
+    if (plan.hasCosts) {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f..%.2f", node.startupCost, node.totalCost);
+        ImGui::TableNextColumn();
+        if (plan.analyzed) {
+            ImGui::Text("%.0f / %.0f", node.planRows, node.actualRows);
+            if (node.actualLoops > 1.0) {
+                ImGui::SameLine();
+                ImGui::TextDisabled("x%.0f", node.actualLoops);
+            }
+        } else {
+            ImGui::Text("%.0f", node.planRows);
+        }
+    }
+    if (plan.analyzed) {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", node.actualTotalMs);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f%%", node.selfShare * 100.0);
+        ImGui::TableNextColumn();
+        ImGui::Text("%lld / %lld", (long long)node.sharedHitBlocks,
+                    (long long)node.sharedReadBlocks);
+    }
+
+    if (open && !node.children.empty()) {
+        for (const auto &child : node.children) {
+            renderNode(child, nodeId);
+        }
+        ImGui::TreePop();
     }
 }
 
-void TableViewerTab::exitEditMode(bool saveEdit) {
-    if (editingRow >= 0 && editingCol >= 0) {
-        if (saveEdit) {
-            // Save the edited value
-            std::string newValue = editBuffer;
-            if (newValue != tableData[editingRow][editingCol]) {
-                tableData[editingRow][editingCol] = newValue;
-                hasChanges = true;
+// StatementStatsTab implementation
+StatementStatsTab::StatementStatsTab(const std::string &name)
+    : Tab(name, TabType::STATEMENT_STATS) {}
+
+void StatementStatsTab::refresh() {
+    entries = StatementStats::snapshot();
+    generation = StatementStats::getGeneration();
+    lastRefresh = ImGui::GetTime();
+    needsSort = true;
+}
+
+void StatementStatsTab::sortEntries(const int column, const bool ascending) {
+    auto key = [column](const StatementStats::Entry &entry) -> double {
+        switch (column) {
+        case 2:
+            return static_cast<double>(entry.calls);
+        case 3:
+            return entry.totalMs;
+        case 4:
+            return entry.meanMs();
+        case 5:
+            return entry.percentileMs(0.95);
+        case 6:
+            return entry.maxMs;
+        default:
+            return static_cast<double>(entry.rows);
+        }
+    };
+
+    std::stable_sort(entries.begin(), entries.end(),
+                     [&](const StatementStats::Entry &a, const StatementStats::Entry &b) {
+                         if (column == 0 || column == 1) {
+                             const std::string &left = column == 0 ? a.database : a.fingerprint;
+                             const std::string &right = column == 0 ? b.database : b.fingerprint;
+                             return ascending ? left < right : right < left;
+                         }
+                         return ascending ? key(a) < key(b) : key(b) < key(a);
+                     });
+}
+
+void StatementStatsTab::updateVisibleRows() {
+    std::string needle = filter;
+    std::transform(needle.begin(), needle.end(), needle.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    // Fingerprints are already lower-cased outside quotes
+    visibleRows.clear();
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (needle.empty() || entries[i].fingerprint.find(needle) != std::string::npos ||
+            entries[i].database.find(filter) != std::string::npos) {
+            visibleRows.push_back(i);
+        }
+    }
+}
+
+void StatementStatsTab::render() {
+    const double now = ImGui::GetTime();
+    if (lastRefresh < 0.0 ||
+        (StatementStats::getGeneration() != generation && now - lastRefresh >= kRefreshSeconds)) {
+        refresh();
+    }
+
+    ImGui::SetNextItemWidth(300.0f);
+    const bool filterChanged =
+        ImGui::InputTextWithHint("##StatementFilter", "Filter statements", filter, sizeof(filter));
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) {
+        StatementStats::reset();
+        refresh();
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("%zu statements", entries.size());
+
+    if (ImGui::BeginTable("StatementStats", 8,
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                              ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable |
+                              ImGuiTableFlags_Sortable)) {
+        const auto numeric =
+            ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_PreferSortDescending;
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Database", ImGuiTableColumnFlags_WidthFixed, 110.0f);
+        ImGui::TableSetupColumn("Statement", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Calls", numeric, 70.0f);
+        ImGui::TableSetupColumn("Total (ms)", numeric | ImGuiTableColumnFlags_DefaultSort,
+                                90.0f);
+        ImGui::TableSetupColumn("Mean (ms)", numeric, 80.0f);
+        ImGui::TableSetupColumn("p95 (ms)", numeric, 80.0f);
+        ImGui::TableSetupColumn("Max (ms)", numeric, 80.0f);
+        ImGui::TableSetupColumn("Rows", numeric, 80.0f);
+        ImGui::TableHeadersRow();
+
+        ImGuiTableSortSpecs *specs = ImGui::TableGetSortSpecs();
+        if (specs && specs->SpecsCount > 0 && (specs->SpecsDirty || needsSort)) {
+            sortEntries(specs->Specs[0].ColumnIndex,
+                        specs->Specs[0].SortDirection == ImGuiSortDirection_Ascending);
+            specs->SpecsDirty = false;
+            needsSort = false;
+            updateVisibleRows();
+        } else if (filterChanged || needsSort) {
+            needsSort = false;
+            updateVisibleRows();
+        }
+
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(visibleRows.size()));
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                const auto &entry = entries[visibleRows[row]];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(entry.database.c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(entry.fingerprint.c_str());
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("%s", entry.fingerprint.c_str());
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)entry.calls);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", entry.totalMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", entry.meanMs());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", entry.percentileMs(0.95));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", entry.maxMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)entry.rows);
             }
         }
+        ImGui::EndTable();
+    }
+}
 
-        // Clear edit state
-        editingRow = -1;
-        editingCol = -1;
-        memset(editBuffer, 0, sizeof(editBuffer));
+// ActivityDashboardTab implementation
+ActivityDashboardTab::ActivityDashboardTab(const std::string &name,
+                                           std::shared_ptr<DatabaseInterface> database)
+    : Tab(name, TabType::ACTIVITY_DASHBOARD), database(std::move(database)),
+      monitor(std::make_unique<ActivityMonitor>(this->database->getConnectionString(),
+                                                intervalSeconds)) {}
+
+void ActivityDashboardTab::render() {
+    ImGui::Text("Server activity: %s", database->getName().c_str());
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(160.0f);
+    if (ImGui::SliderFloat("Interval (s)", &intervalSeconds, 0.5f, 30.0f, "%.1f")) {
+        monitor->setInterval(intervalSeconds);
+    }
+
+    // Everything below reads what the monitor thread last stored, so a slow server only shows
+    // up as stale numbers
+    const std::string error = monitor->getError();
+    const double age = monitor->getSecondsSinceSample();
+    if (!error.empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Sampling failed: %s", error.c_str());
+    } else if (monitor->getGeneration() == 0) {
+        ImGui::TextDisabled("Connecting...");
+    } else if (age > 3.0 * intervalSeconds) {
+        ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.2f, 1.0f),
+                           "Server is slow to respond, last sample %.0f s ago", age);
+    } else {
+        ImGui::TextDisabled("Last sample took %.1f ms", monitor->getLastSampleMs());
+    }
+
+    if (ImGui::BeginTable("ActivityMetrics", 2, ImGuiTableFlags_SizingStretchProp)) {
+        ImGui::TableNextColumn();
+        renderMetric("Transactions/s", ActivityMetric::TPS, "%.1f", FLT_MAX);
+        ImGui::TableNextColumn();
+        renderMetric("Cache hit ratio", ActivityMetric::CACHE_HIT_RATIO, "%.2f%%", 100.0f);
+        ImGui::TableNextColumn();
+        renderMetric("Active sessions", ActivityMetric::ACTIVE_SESSIONS, "%.0f", FLT_MAX);
+        ImGui::TableNextColumn();
+        renderMetric("Waiting sessions", ActivityMetric::WAITING_SESSIONS, "%.0f", FLT_MAX);
+        ImGui::TableNextColumn();
+        renderMetric("Ungranted locks", ActivityMetric::LOCK_WAITS, "%.0f", FLT_MAX);
+        ImGui::EndTable();
+    }
+
+    if (monitor->getGeneration() != sessionsGeneration) {
+        sessionsGeneration = monitor->getGeneration();
+        sessions = monitor->getSessions();
+    }
+
+    ImGui::SeparatorText("Sessions");
+    if (ImGui::BeginTable("ActivitySessions", 7,
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                              ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("PID", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn("User", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+        ImGui::TableSetupColumn("State", ImGuiTableColumnFlags_WidthFixed, 130.0f);
+        ImGui::TableSetupColumn("Wait", ImGuiTableColumnFlags_WidthFixed, 150.0f);
+        ImGui::TableSetupColumn("Blocked by", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+        ImGui::TableSetupColumn("Running", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+        ImGui::TableSetupColumn("Query", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
+
+        for (const auto &session : sessions) {
+            ImGui::TableNextRow();
+            if (!session.blockedBy.empty()) {
+                ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1,
+                                       ImGui::GetColorU32(ImVec4(0.9f, 0.55f, 0.1f, 0.3f)));
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", session.pid);
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(session.user.c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(session.state.c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(session.wait.c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(session.blockedBy.c_str());
+            ImGui::TableNextColumn();
+            if (session.durationMs < 1000.0) {
+                ImGui::Text("%.0f ms", session.durationMs);
+            } else {
+                ImGui::Text("%.1f s", session.durationMs / 1000.0);
+            }
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(session.query.c_str());
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("%s", session.query.c_str());
+            }
+        }
+        ImGui::EndTable();
     }
 }
 
-void TableViewerTab::selectCell(int row, int col) {
-    if (row >= 0 && row < (int)tableData.size() && col >= 0 && col < (int)columnNames.size()) {
+void ActivityDashboardTab::renderMetric(const char *label, const ActivityMetric metric,
+                                        const char *format, const float maxValue) {
+    const size_t count = monitor->copySeries(metric, plotValues);
 
-        selectedRow = row;
-        selectedCol = col;
+    char value[32] = "-";
+    if (count > 0) {
+        snprintf(value, sizeof(value), format, plotValues[count - 1]);
+    }
+    char overlay[96];
+    snprintf(overlay, sizeof(overlay), "%s: %s", label, value);
+
+    ImGui::PushID(label);
+    ImGui::PlotLines("##Series", plotValues, static_cast<int>(count), 0, overlay, 0.0f, maxValue,
+                     ImVec2(-1, 80));
+    ImGui::PopID();
+}
+
+// TableDiffTab implementation
+TableDiffTab::TableDiffTab(const std::string &name,
+                           std::shared_ptr<DatabaseInterface> leftDatabase, Table leftTable,
+                           std::shared_ptr<DatabaseInterface> rightDatabase, Table rightTable)
+    : Tab(name, TabType::TABLE_DIFF), leftDatabase(std::move(leftDatabase)),
+      leftTable(std::move(leftTable)), rightDatabase(std::move(rightDatabase)),
+      rightTable(std::move(rightTable)) {
+    start();
+}
+
+TableDiffTab::~TableDiffTab() {
+    run->progress.cancelRequested = true;
+}
+
+void TableDiffTab::start() {
+    run = std::make_shared<DiffRun>();
+    lines.clear();
+    linesBuilt = false;
+
+    auto &jobs = Application::getInstance().getJobRunner();
+    jobs.submit([run = run, left = leftDatabase, leftTable = leftTable, right = rightDatabase,
+                 rightTable = rightTable, &jobs]() mutable {
+        // Views and partitions may still be listed without their columns
+        auto loadColumns = [](DatabaseInterface &db, Table &table) {
+            if (!table.columnsLoaded) {
+                table.columns = db.getTableColumns(table.getQualifiedName());
+                table.columnsLoaded = true;
+            }
+        };
+        loadColumns(*left, leftTable);
+        loadColumns(*right, rightTable);
+        TableDiffResult result =
+            TableDiff::compare(*left, leftTable, *right, rightTable, &run->progress);
+        jobs.post([run, result = std::move(result)]() mutable {
+            run->result = std::move(result);
+            run->finished = true;
+        });
+    });
+}
+
+void TableDiffTab::buildLines() {
+    // A changed row takes two lines, left above right
+    const auto &rows = run->result.rows;
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (rows[i].kind != TableDiffRow::Kind::ONLY_RIGHT) {
+            lines.emplace_back(i, false);
+        }
+        if (rows[i].kind != TableDiffRow::Kind::ONLY_LEFT) {
+            lines.emplace_back(i, true);
+        }
+    }
+    linesBuilt = true;
+}
+
+void TableDiffTab::render() {
+    ImGui::Text("%s.%s  vs  %s.%s", leftDatabase->getName().c_str(),
+                leftTable.getQualifiedName().c_str(), rightDatabase->getName().c_str(),
+                rightTable.getQualifiedName().c_str());
+
+    if (!run->finished) {
+        ImGui::Text("Comparing: %llu ranges hashed, %llu rows fetched, %llu differences",
+                    (unsigned long long)run->progress.rangesHashed.load(),
+                    (unsigned long long)run->progress.rows.load(),
+                    (unsigned long long)run->progress.differences.load());
+        if (run->progress.cancelRequested) {
+            ImGui::TextDisabled("Cancelling...");
+        } else if (ImGui::Button("Cancel")) {
+            run->progress.cancelRequested = true;
+        }
+        return;
+    }
+
+    if (ImGui::Button("Compare Again")) {
+        start();
+        return;
+    }
+    ImGui::SameLine();
+
+    const TableDiffResult &result = run->result;
+    if (!result.success) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Diff failed: %s",
+                           result.error.c_str());
+        return;
+    }
+
+    ImGui::Text("%llu rows left, %llu rows right: %zu%s differences in %.1f s (%llu ranges "
+                "hashed, %llu rows fetched)",
+                (unsigned long long)result.leftRows, (unsigned long long)result.rightRows,
+                result.rows.size(), result.truncated ? "+" : "", result.elapsedMs / 1000.0,
+                (unsigned long long)result.rangesHashed, (unsigned long long)result.rowsFetched);
+    if (!result.skippedColumns.empty()) {
+        std::string skipped;
+        for (const auto &column : result.skippedColumns) {
+            skipped += (skipped.empty() ? "" : ", ") + column;
+        }
+        ImGui::TextDisabled("Not compared, only on one side: %s", skipped.c_str());
+    }
+    if (result.rows.empty()) {
+        ImGui::Text("The tables are identical");
+        return;
+    }
+    if (!linesBuilt) {
+        buildLines();
+    }
+
+    // Dear ImGui caps the column count; the status column takes one
+    const int columnCount = static_cast<int>(std::min<size_t>(result.columns.size(), 63));
+    if (ImGui::BeginTable("TableDiff", columnCount + 1,
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                              ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY |
+                              ImGuiTableFlags_Resizable)) {
+        ImGui::TableSetupScrollFreeze(2, 1);
+        ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed, 20.0f);
+        for (int col = 0; col < columnCount; col++) {
+            ImGui::TableSetupColumn(result.columns[col].c_str());
+        }
+        ImGui::TableHeadersRow();
+
+        const ImU32 removedColor = ImGui::GetColorU32(ImVec4(0.8f, 0.2f, 0.2f, 0.25f));
+        const ImU32 addedColor = ImGui::GetColorU32(ImVec4(0.2f, 0.8f, 0.2f, 0.25f));
+        const ImU32 changedColor = ImGui::GetColorU32(ImVec4(0.9f, 0.7f, 0.1f, 0.35f));
+
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(lines.size()));
+        while (clipper.Step()) {
+            for (int line = clipper.DisplayStart; line < clipper.DisplayEnd; line++) {
+                const auto [index, rightSide] = lines[line];
+                const TableDiffRow &row = result.rows[index];
+                const auto &cells = rightSide ? row.right : row.left;
+                const auto &other = rightSide ? row.left : row.right;
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                if (row.kind == TableDiffRow::Kind::CHANGED) {
+                    ImGui::TextUnformatted(rightSide ? ">" : "<");
+                } else {
+                    ImGui::TextUnformatted(rightSide ? "+" : "-");
+                    ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1,
+                                           rightSide ? addedColor : removedColor);
+                }
+
+                for (int col = 0; col < columnCount; col++) {
+                    ImGui::TableNextColumn();
+                    if (static_cast<size_t>(col) >= cells.size()) {
+                        continue;
+                    }
+                    if (row.kind == TableDiffRow::Kind::CHANGED &&
+                        (static_cast<size_t>(col) >= other.size() || other[col] != cells[col])) {
+                        ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, changedColor);
+                    }
+                    if (cells[col]) {
+                        ImGui::TextUnformatted(cells[col]->c_str());
+                    } else {
+                        ImGui::TextDisabled("NULL");
+                    }
+                }
+            }
+        }
+        ImGui::EndTable();
+    }
+}
+
+// ColumnProfileTab implementation
+ColumnProfileTab::ColumnProfileTab(const std::string &name,
+                                   std::shared_ptr<DatabaseInterface> database,
+                                   std::string tableName)
+    : Tab(name, TabType::COLUMN_PROFILE), database(std::move(database)),
+      tableName(std::move(tableName)) {
+    start();
+}
+
+ColumnProfileTab::~ColumnProfileTab() {
+    run->progress.cancelRequested = true;
+}
+
+void ColumnProfileTab::start() {
+    run = std::make_shared<ProfileRun>();
+    ProfileOptions options;
+    if (sample) {
+        options.samplePercent = samplePercent;
     }
+
+    auto &jobs = Application::getInstance().getJobRunner();
+    jobs.submit([run = run, db = database, table = tableName, options, &jobs] {
+        ProfileResult result = ColumnProfiler::profile(*db, table, options, &run->progress);
+        jobs.post([run, result = std::move(result)]() mutable {
+            run->result = std::move(result);
+            run->finished = true;
+        });
+    });
+}
+
+void ColumnProfileTab::render() {
+    ImGui::Text("Profile of %s.%s", database->getName().c_str(), tableName.c_str());
+
+    if (!run->finished) {
+        const size_t chunks = run->progress.chunkCount;
+        ImGui::Text("Reading: %llu rows", (unsigned long long)run->progress.rows.load());
+        ImGui::ProgressBar(chunks ? static_cast<float>(run->progress.chunksDone) /
+                                        static_cast<float>(chunks)
+                                  : 0.0f,
+                           ImVec2(300.0f, 0));
+        ImGui::SameLine();
+        if (run->progress.cancelRequested) {
+            ImGui::TextDisabled("Cancelling...");
+        } else if (ImGui::Button("Cancel")) {
+            run->progress.cancelRequested = true;
+        }
+        return;
+    }
+
+    if (ImGui::Button("Profile Again")) {
+        start();
+        return;
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Sample", &sample);
+    if (sample) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(150.0f);
+        ImGui::SliderFloat("% of rows", &samplePercent, 0.01f, 100.0f, "%.2f",
+                           ImGuiSliderFlags_Logarithmic);
+    }
+
+    const ProfileResult &result = run->result;
+    if (!result.success) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Profile failed: %s",
+                           result.error.c_str());
+        return;
+    }
+    ImGui::Text("%llu rows%s in %.1f s (%zu chunks, %zu workers); distinct counts and top "
+                "values are estimates",
+                (unsigned long long)result.rows, result.sampled ? " sampled" : "",
+                result.elapsedMs / 1000.0, result.chunks, result.workers);
+
+    if (ImGui::BeginTable("ColumnProfile", 8,
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                              ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable)) {
+        ImGui::TableSetupScrollFreeze(1, 1);
+        ImGui::TableSetupColumn("Column", ImGuiTableColumnFlags_WidthFixed, 140.0f);
+        ImGui::TableSetupColumn("Null %", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn("Distinct", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+        ImGui::TableSetupColumn("Min", ImGuiTableColumnFlags_WidthFixed, 120.0f);
+        ImGui::TableSetupColumn("Max", ImGuiTableColumnFlags_WidthFixed, 120.0f);
+        ImGui::TableSetupColumn("Mean", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+        ImGui::TableSetupColumn("Top Values", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Histogram", ImGuiTableColumnFlags_WidthFixed, 200.0f);
+        ImGui::TableHeadersRow();
+
+        for (const auto &column : result.columns) {
+            renderColumn(column);
+        }
+        ImGui::EndTable();
+    }
+}
+
+void ColumnProfileTab::renderColumn(const ColumnProfile &column) const {
+    ImGui::PushID(column.name.c_str());
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(column.name.c_str());
+    ImGui::TableNextColumn();
+    ImGui::Text("%.1f", column.nullFraction() * 100.0);
+    ImGui::TableNextColumn();
+    ImGui::Text("~%.0f", column.distinct);
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(column.min.c_str());
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(column.max.c_str());
+    ImGui::TableNextColumn();
+    if (column.numeric) {
+        ImGui::Text("%.4g", column.mean);
+    }
+
+    // The first few inline, all of them with their error bounds on hover
+    ImGui::TableNextColumn();
+    std::string summary;
+    for (size_t i = 0; i < column.topValues.size() && i < 3; i++) {
+        char count[32];
+        snprintf(count, sizeof(count), " (%llu)", (unsigned long long)column.topValues[i].count);
+        summary += (i > 0 ? ", " : "") + column.topValues[i].value + count;
+    }
+    ImGui::TextUnformatted(summary.c_str());
+    if (ImGui::IsItemHovered() && !column.topValues.empty()) {
+        ImGui::BeginTooltip();
+        for (const auto &item : column.topValues) {
+            ImGui::Text("%llu (+/- %llu)  %s", (unsigned long long)item.count,
+                        (unsigned long long)item.error, item.value.c_str());
+        }
+        ImGui::EndTooltip();
+    }
+
+    ImGui::TableNextColumn();
+    if (!column.histogram.empty()) {
+        ImGui::PlotHistogram("##Histogram", column.histogram.data(),
+                             static_cast<int>(column.histogram.size()), 0, nullptr, 0.0f,
+                             FLT_MAX, ImVec2(-1, 40));
+    }
+    ImGui::PopID();
+}
+
+// ChartTab implementation
+namespace {
+    constexpr int kTickCount = 5;
+
+    ImVec4 seriesColor(const size_t index) {
+        static const ImVec4 palette[] = {
+            ImVec4(0.35f, 0.65f, 0.95f, 1.0f), ImVec4(0.95f, 0.55f, 0.25f, 1.0f),
+            ImVec4(0.45f, 0.80f, 0.40f, 1.0f), ImVec4(0.90f, 0.35f, 0.40f, 1.0f),
+            ImVec4(0.70f, 0.50f, 0.90f, 1.0f), ImVec4(0.90f, 0.80f, 0.30f, 1.0f),
+            ImVec4(0.40f, 0.85f, 0.85f, 1.0f), ImVec4(0.90f, 0.55f, 0.80f, 1.0f),
+        };
+        return palette[index % (sizeof(palette) / sizeof(palette[0]))];
+    }
+
+    // Timestamps are seconds since the epoch in UTC; the format follows the visible span
+    const char *axisLabel(const double value, const bool time, const double span) {
+        auto &arena = Application::getInstance().getFrameArena();
+        if (!time) {
+            return arena.format("%.4g", value);
+        }
+        const std::time_t seconds = static_cast<std::time_t>(std::floor(value));
+        const std::tm *utc = std::gmtime(&seconds);
+        if (!utc) {
+            return "";
+        }
+        const char *format = span >= 3 * 86400.0 ? "%Y-%m-%d"
+                             : span >= 3600.0    ? "%m-%d %H:%M"
+                                                 : "%H:%M:%S";
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), format, utc);
+        return arena.copy(buffer);
+    }
+} // namespace
+
+ChartTab::ChartTab(const std::string &name, std::shared_ptr<ResultStore> store)
+    : Tab(name, TabType::CHART), run(std::make_shared<ChartRun>()) {
+    // The columns are copied out, so the tab does not keep the result alive
+    auto &jobs = Application::getInstance().getJobRunner();
+    jobs.submit([run = run, store = std::move(store), &jobs] {
+        std::shared_ptr<const ChartColumns> columns =
+            ChartColumns::extract(*store, run->rowsRead, run->cancelRequested);
+        jobs.post([run, columns] { run->columns = columns; });
+    });
+}
+
+ChartTab::~ChartTab() {
+    run->cancelRequested = true;
+}
+
+size_t ChartTab::getMemoryUsage() const {
+    size_t bytes = run->columns ? run->columns->getMemoryUsage() : 0;
+    if (run->plot) {
+        bytes += run->plot->getMemoryUsage();
+    }
+    return bytes;
+}
+
+void ChartTab::buildPlot() {
+    std::vector<int> yColumns;
+    for (size_t col = 0; col < ySelected.size(); col++) {
+        if (ySelected[col] && static_cast<int>(col) != xColumn) {
+            yColumns.push_back(static_cast<int>(col));
+        }
+    }
+
+    const uint64_t generation = ++run->plotGeneration;
+    run->plot.reset();
+    run->sample.reset();
+    if (yColumns.empty()) {
+        return;
+    }
+
+    auto &jobs = Application::getInstance().getJobRunner();
+    jobs.submit([run = run, columns = run->columns, x = xColumn, yColumns, generation, &jobs] {
+        std::shared_ptr<const ChartPlot> plot = ChartPlot::build(*columns, x, yColumns);
+        jobs.post([run, plot, generation] {
+            if (run->plotGeneration == generation) {
+                run->plot = plot;
+            }
+        });
+    });
+}
+
+void ChartTab::requestSample() {
+    if (run->sampling || !run->plot || plotPixels == 0) {
+        return;
+    }
+    run->sampling = true;
+    sampleStale = false;
+
+    auto &jobs = Application::getInstance().getJobRunner();
+    jobs.submit([run = run, plot = run->plot, viewMin = viewMin, viewMax = viewMax,
+                 pixels = plotPixels, method = method, &jobs] {
+        std::shared_ptr<const ChartSample> sample =
+            ChartSample::compute(plot, viewMin, viewMax, pixels, method);
+        jobs.post([run, sample] {
+            run->sampling = false;
+            if (sample->plot == run->plot) {
+                run->sample = sample;
+            }
+        });
+    });
+}
+
+void ChartTab::resetView() {
+    const ChartPlot &plot = *run->plot;
+    viewMin = plot.minX;
+    viewMax = plot.maxX;
+    if (viewMax <= viewMin) {
+        viewMin -= 0.5;
+        viewMax += 0.5;
+    }
+    sampleStale = true;
+}
+
+void ChartTab::clampView() {
+    const ChartPlot &plot = *run->plot;
+    const double fullSpan = plot.maxX - plot.minX;
+    if (fullSpan <= 0.0) {
+        return;
+    }
+    // Zoom in no further than a billionth of the data, and out no further than all of it
+    const double span = std::clamp(viewMax - viewMin, fullSpan * 1e-9, fullSpan);
+    viewMin = std::clamp(viewMin, plot.minX, plot.maxX - span);
+    viewMax = viewMin + span;
+    sampleStale = true;
+}
+
+void ChartTab::render() {
+    if (!run->columns) {
+        ImGui::Text("Reading result: %llu rows", (unsigned long long)run->rowsRead.load());
+        return;
+    }
+
+    const ChartColumns &columns = *run->columns;
+    if (columns.names.empty()) {
+        ImGui::TextDisabled("The result has no numeric or date/time columns to chart");
+        return;
+    }
+    if (ySelected.empty()) {
+        // Start with the first column as x when it holds times, and every other column as y
+        ySelected.assign(columns.names.size(), 1);
+        if (columns.isTime[0] && columns.names.size() > 1) {
+            xColumn = 0;
+        }
+        buildPlot();
+    }
+
+    renderControls();
+
+    const ChartPlot *plot = run->plot.get();
+    if (!plot) {
+        const bool anySelected =
+            std::any_of(ySelected.begin(), ySelected.end(), [](uint8_t on) { return on != 0; });
+        ImGui::TextDisabled(anySelected ? "Preparing..." : "Select at least one column to plot");
+        return;
+    }
+    if (viewGeneration != run->plotGeneration) {
+        viewGeneration = run->plotGeneration;
+        resetView();
+    }
+
+    renderPlot();
+    if (sampleStale) {
+        requestSample();
+    }
+}
+
+void ChartTab::renderControls() {
+    const ChartColumns &columns = *run->columns;
+    bool changed = false;
+
+    ImGui::SetNextItemWidth(180.0f);
+    const char *xLabel = xColumn < 0 ? "Row number" : columns.names[xColumn].c_str();
+    if (ImGui::BeginCombo("X", xLabel)) {
+        if (ImGui::Selectable("Row number", xColumn < 0)) {
+            changed = xColumn != -1;
+            xColumn = -1;
+        }
+        for (size_t col = 0; col < columns.names.size(); col++) {
+            if (ImGui::Selectable(columns.names[col].c_str(), xColumn == static_cast<int>(col))) {
+                changed = xColumn != static_cast<int>(col);
+                xColumn = static_cast<int>(col);
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.0f);
+    const char *methods[] = {"LTTB", "Min/Max"};
+    int methodIndex = method == DownsampleMethod::LTTB ? 0 : 1;
+    if (ImGui::Combo("Downsampling", &methodIndex, methods, 2)) {
+        method = methodIndex == 0 ? DownsampleMethod::LTTB : DownsampleMethod::MIN_MAX;
+        sampleStale = true;
+    }
+
+    if (run->plot) {
+        ImGui::SameLine();
+        if (ImGui::Button("Reset View")) {
+            resetView();
+        }
+    }
+
+    ImGui::Text("Y:");
+    for (size_t col = 0; col < columns.names.size(); col++) {
+        if (static_cast<int>(col) == xColumn) {
+            continue;
+        }
+        ImGui::SameLine();
+        ImGui::PushStyleColor(ImGuiCol_CheckMark, seriesColor(col));
+        bool selected = ySelected[col] != 0;
+        if (ImGui::Checkbox(columns.names[col].c_str(), &selected)) {
+            ySelected[col] = selected;
+            changed = true;
+        }
+        ImGui::PopStyleColor();
+    }
+
+    if (changed) {
+        buildPlot();
+    }
+}
+
+void ChartTab::renderPlot() {
+    const ChartPlot &plot = *run->plot;
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImVec2 size = ImGui::GetContentRegionAvail();
+    size.y -= ImGui::GetTextLineHeightWithSpacing();
+    if (size.x < kAxisWidth * 2 || size.y < 80.0f) {
+        return;
+    }
+    ImGui::InvisibleButton("Plot", size);
+    const bool hovered = ImGui::IsItemHovered();
+    const bool dragging = ImGui::IsItemActive();
+
+    const float lineHeight = ImGui::GetTextLineHeight();
+    const ImVec2 plotMin(origin.x + kAxisWidth, origin.y + lineHeight * 0.5f);
+    const ImVec2 plotMax(origin.x + size.x - 10.0f, origin.y + size.y - lineHeight - 6.0f);
+    const float width = plotMax.x - plotMin.x;
+    const float height = plotMax.y - plotMin.y;
+
+    // A resize changes how many points are worth drawing
+    const size_t pixels = static_cast<size_t>(width);
+    if (pixels != plotPixels) {
+        plotPixels = pixels;
+        sampleStale = true;
+    }
+
+    // Wheel zooms around the cursor, dragging pans, double-click shows everything
+    ImGuiIO &io = ImGui::GetIO();
+    if (hovered && io.MouseWheel != 0.0f) {
+        const double span = viewMax - viewMin;
+        const double anchor = viewMin + (io.MousePos.x - plotMin.x) / width * span;
+        const double scale = std::pow(0.8, static_cast<double>(io.MouseWheel));
+        viewMin = anchor - (anchor - viewMin) * scale;
+        viewMax = anchor + (viewMax - anchor) * scale;
+        clampView();
+    }
+    if (dragging && io.MouseDelta.x != 0.0f) {
+        const double shift = -io.MouseDelta.x / width * (viewMax - viewMin);
+        viewMin += shift;
+        viewMax += shift;
+        clampView();
+    }
+    if (hovered && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+        resetView();
+    }
+
+    ImDrawList *drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilled(plotMin, plotMax, ImGui::GetColorU32(ImGuiCol_FrameBg));
+
+    // The sample may be for an older window; it is drawn where its points fall in this one
+    const ChartSample *sample = run->sample.get();
+    double minY = sample && sample->minY <= sample->maxY ? sample->minY : 0.0;
+    double maxY = sample && sample->minY <= sample->maxY ? sample->maxY : 1.0;
+    if (maxY <= minY) {
+        minY -= 1.0;
+        maxY += 1.0;
+    }
+    const double padding = (maxY - minY) * 0.05;
+    minY -= padding;
+    maxY += padding;
+
+    const double spanX = viewMax - viewMin;
+    const auto toScreenX = [&](double x) {
+        return plotMin.x + static_cast<float>((x - viewMin) / spanX) * width;
+    };
+    const auto toScreenY = [&](double y) {
+        return plotMax.y - static_cast<float>((y - minY) / (maxY - minY)) * height;
+    };
+
+    const ImU32 gridColor = ImGui::GetColorU32(ImGuiCol_Border);
+    const ImU32 textColor = ImGui::GetColorU32(ImGuiCol_TextDisabled);
+    for (int tick = 0; tick <= kTickCount; tick++) {
+        const float fraction = static_cast<float>(tick) / kTickCount;
+        const float screenX = plotMin.x + fraction * width;
+        const float screenY = plotMax.y - fraction * height;
+        drawList->AddLine(ImVec2(screenX, plotMin.y), ImVec2(screenX, plotMax.y), gridColor);
+        drawList->AddLine(ImVec2(plotMin.x, screenY), ImVec2(plotMax.x, screenY), gridColor);
+
+        const char *xText = axisLabel(viewMin + fraction * spanX, plot.timeX, spanX);
+        const float xTextWidth = ImGui::CalcTextSize(xText).x;
+        const float xTextLeft = std::clamp(screenX - xTextWidth * 0.5f, origin.x,
+                                           origin.x + size.x - xTextWidth);
+        drawList->AddText(ImVec2(xTextLeft, plotMax.y + 3.0f), textColor, xText);
+
+        const char *yText = axisLabel(minY + fraction * (maxY - minY), false, 0.0);
+        const float yTextWidth = ImGui::CalcTextSize(yText).x;
+        drawList->AddText(ImVec2(plotMin.x - yTextWidth - 4.0f, screenY - lineHeight * 0.5f),
+                          textColor, yText);
+    }
+
+    if (sample) {
+        auto &arena = Application::getInstance().getFrameArena();
+        drawList->PushClipRect(plotMin, plotMax, true);
+        for (size_t line = 0; line < sample->x.size(); line++) {
+            const std::vector<double> &xs = sample->x[line];
+            const std::vector<double> &ys = sample->y[line];
+            if (xs.empty()) {
+                continue;
+            }
+            ImVec2 *points = arena.allocateArray<ImVec2>(xs.size());
+            for (size_t i = 0; i < xs.size(); i++) {
+                points[i] = ImVec2(toScreenX(xs[i]), toScreenY(ys[i]));
+            }
+            drawList->AddPolyline(points, static_cast<int>(xs.size()),
+                                  ImGui::GetColorU32(seriesColor(plot.series[line].column)),
+                                  ImDrawFlags_None, 1.5f);
+        }
+        drawList->PopClipRect();
+    }
+
+    ImGui::Text("%zu of %zu points drawn (%s, %.1f ms)%s", sample ? sample->pointCount : 0,
+                plot.pointCount, method == DownsampleMethod::LTTB ? "LTTB" : "min/max",
+                sample ? sample->elapsedMs : 0.0, run->sampling ? ", updating..." : "");
 }
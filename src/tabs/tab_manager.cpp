@@ -1,4 +1,5 @@
 #include "tabs/tab_manager.hpp"
+#include "application.hpp"
 #include "imgui.h"
 #include <algorithm>
 #include <iostream>
@@ -10,6 +11,9 @@ void TabManager::addTab(std::shared_ptr<Tab> tab) {
 void TabManager::removeTab(std::shared_ptr<Tab> tab) {
     auto it = std::find(tabs.begin(), tabs.end(), tab);
     if (it != tabs.end()) {
+        if (activeTab == tab) {
+            activeTab.reset();
+        }
         tabs.erase(it);
     }
 }
@@ -20,12 +24,16 @@ void TabManager::closeTab(const std::string &name) {
     });
 
     if (it != tabs.end()) {
+        if (activeTab == *it) {
+            activeTab.reset();
+        }
         tabs.erase(it);
     }
 }
 
 void TabManager::closeAllTabs() {
     tabs.clear();
+    activeTab.reset();
 }
 
 std::shared_ptr<Tab> TabManager::findTab(const std::string &name) const {
@@ -40,8 +48,8 @@ std::shared_ptr<Tab> TabManager::findTableTab(const std::string &databasePath,
                                               const std::string &tableName) const {
     for (auto &tab : tabs) {
         if (tab->getType() == TabType::TABLE_VIEWER) {
-            auto tableTab = std::dynamic_pointer_cast<TableViewerTab>(tab);
-            if (tableTab && tableTab->getDatabasePath() == databasePath &&
+            const auto *tableTab = static_cast<const TableViewerTab *>(tab.get());
+            if (tableTab->getDatabasePath() == databasePath &&
                 tableTab->getTableName() == tableName) {
                 return tab;
             }
@@ -50,6 +58,18 @@ std::shared_ptr<Tab> TabManager::findTableTab(const std::string &databasePath,
     return nullptr;
 }
 
+std::shared_ptr<Tab> TabManager::findSnapshotTab(const std::string &snapshotPath) const {
+    for (auto &tab : tabs) {
+        if (tab->getType() == TabType::SNAPSHOT) {
+            const auto *snapshotTab = static_cast<const SnapshotTab *>(tab.get());
+            if (snapshotTab->getSnapshotPath() == snapshotPath) {
+                return tab;
+            }
+        }
+    }
+    return nullptr;
+}
+
 bool TabManager::hasTab(const std::string &name) const {
     return findTab(name) != nullptr;
 }
@@ -82,7 +102,117 @@ std::shared_ptr<Tab> TabManager::createTableViewerTab(const std::string &databas
     return tab;
 }
 
+std::shared_ptr<Tab> TabManager::createSnapshotTab(const std::string &snapshotPath) {
+    auto existingTab = findSnapshotTab(snapshotPath);
+    if (existingTab) {
+        existingTab->setShouldFocus(true);
+        return existingTab;
+    }
+
+    const size_t lastSlash = snapshotPath.find_last_of("/\\");
+    const std::string baseName =
+        (lastSlash != std::string::npos) ? snapshotPath.substr(lastSlash + 1) : snapshotPath;
+
+    // Snapshots with the same file name from different folders still need distinct tabs
+    std::string name = baseName;
+    for (int count = 2; hasTab(name); count++) {
+        name = baseName + " (" + std::to_string(count) + ")";
+    }
+
+    auto tab = std::make_shared<SnapshotTab>(name, snapshotPath);
+    tab->setShouldFocus(true);
+    addTab(tab);
+    return tab;
+}
+
+std::shared_ptr<Tab> TabManager::createQueryPlanTab(const std::string &sourceName,
+                                                    QueryPlan plan) {
+    const std::string baseName = "Plan: " + sourceName;
+    std::string name = baseName;
+    for (int count = 2; hasTab(name); count++) {
+        name = baseName + " (" + std::to_string(count) + ")";
+    }
+
+    auto tab = std::make_shared<QueryPlanTab>(name, std::move(plan));
+    tab->setShouldFocus(true);
+    addTab(tab);
+    return tab;
+}
+
+std::shared_ptr<Tab> TabManager::createStatementStatsTab() {
+    const std::string name = "Statement Statistics";
+    if (auto existingTab = findTab(name)) {
+        existingTab->setShouldFocus(true);
+        return existingTab;
+    }
+
+    auto tab = std::make_shared<StatementStatsTab>(name);
+    tab->setShouldFocus(true);
+    addTab(tab);
+    return tab;
+}
+
+std::shared_ptr<Tab> TabManager::createActivityDashboardTab(std::shared_ptr<DatabaseInterface> db) {
+    const std::string name = "Activity: " + db->getName();
+    if (auto existingTab = findTab(name)) {
+        existingTab->setShouldFocus(true);
+        return existingTab;
+    }
+
+    auto tab = std::make_shared<ActivityDashboardTab>(name, std::move(db));
+    tab->setShouldFocus(true);
+    addTab(tab);
+    return tab;
+}
+
+std::shared_ptr<Tab> TabManager::createTableDiffTab(std::shared_ptr<DatabaseInterface> leftDb,
+                                                    const Table &leftTable,
+                                                    std::shared_ptr<DatabaseInterface> rightDb,
+                                                    const Table &rightTable) {
+    const std::string name = "Diff: " + leftDb->getName() + "." + leftTable.getQualifiedName() +
+                             " / " + rightDb->getName() + "." + rightTable.getQualifiedName();
+    if (auto existingTab = findTab(name)) {
+        existingTab->setShouldFocus(true);
+        return existingTab;
+    }
+
+    auto tab = std::make_shared<TableDiffTab>(name, std::move(leftDb), leftTable,
+                                              std::move(rightDb), rightTable);
+    tab->setShouldFocus(true);
+    addTab(tab);
+    return tab;
+}
+
+std::shared_ptr<Tab> TabManager::createColumnProfileTab(std::shared_ptr<DatabaseInterface> db,
+                                                        const std::string &tableName) {
+    const std::string name = "Profile: " + db->getName() + "." + tableName;
+    if (auto existingTab = findTab(name)) {
+        existingTab->setShouldFocus(true);
+        return existingTab;
+    }
+
+    auto tab = std::make_shared<ColumnProfileTab>(name, std::move(db), tableName);
+    tab->setShouldFocus(true);
+    addTab(tab);
+    return tab;
+}
+
+std::shared_ptr<Tab> TabManager::createChartTab(const std::string &sourceName,
+                                                std::shared_ptr<ResultStore> store) {
+    const std::string baseName = "Chart: " + sourceName;
+    std::string name = baseName;
+    for (int count = 2; hasTab(name); count++) {
+        name = baseName + " (" + std::to_string(count) + ")";
+    }
+
+    auto tab = std::make_shared<ChartTab>(name, std::move(store));
+    tab->setShouldFocus(true);
+    addTab(tab);
+    return tab;
+}
+
 void TabManager::renderTabs() {
+    auto &arena = Application::getInstance().getFrameArena();
     if (ImGui::BeginTabBar("ContentTabs")) {
         for (auto it = tabs.begin(); it != tabs.end();) {
             auto &tab = *it;
@@ -94,8 +224,17 @@ void TabManager::renderTabs() {
                 tab->setShouldFocus(false); // Reset flag after use
             }
 
+            // The ID after ### stays the same whatever state the label shows
+            const char *state = tab->isHibernated() ? " (hibernated)"
+                                : tab->isWatching() ? " (watching)"
+                                                    : "";
+            const char *label =
+                arena.format("%s%s###%s", tab->getName().c_str(), state, tab->getName().c_str());
+
             bool isOpen = tab->isOpen();
-            if (isOpen && ImGui::BeginTabItem(tab->getName().c_str(), &isOpen, tabFlags)) {
+            if (isOpen && ImGui::BeginTabItem(label, &isOpen, tabFlags)) {
+                tab->activate(ImGui::GetFrameCount());
+                activeTab = tab;
                 tab->render();
                 ImGui::EndTabItem();
             }
@@ -104,6 +243,9 @@ void TabManager::renderTabs() {
             tab->setOpen(isOpen);
 
             if (!isOpen) {
+                if (activeTab == tab) {
+                    activeTab.reset();
+                }
                 it = tabs.erase(it);
             } else {
                 ++it;
@@ -111,6 +253,63 @@ void TabManager::renderTabs() {
         }
         ImGui::EndTabBar();
     }
+
+    // Watched tabs refresh on their own, hidden ones less and less often
+    const double now = ImGui::GetTime();
+    const int frame = ImGui::GetFrameCount();
+    for (auto &tab : tabs) {
+        tab->updateWatch(now, tab->getLastActiveFrame() == frame);
+    }
+
+    enforceMemoryBudget();
+}
+
+size_t TabManager::getMemoryUsage() const {
+    size_t usage = 0;
+    for (const auto &tab : tabs) {
+        usage += tab->getMemoryUsage();
+    }
+    return usage;
+}
+
+void TabManager::hibernateInactiveTabs() {
+    for (auto &tab : tabs) {
+        if (tab != activeTab) {
+            tab->hibernate();
+        }
+    }
+}
+
+void TabManager::enforceMemoryBudget() {
+    size_t usage = getMemoryUsage();
+    if (usage <= memoryBudget) {
+        return;
+    }
+
+    std::vector<std::shared_ptr<Tab>> candidates;
+    for (auto &tab : tabs) {
+        if (tab != activeTab && !tab->isHibernated() && tab->getMemoryUsage() > 0) {
+            candidates.push_back(tab);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const std::shared_ptr<Tab> &a, const std::shared_ptr<Tab> &b) {
+                  return a->getLastActiveFrame() < b->getLastActiveFrame();
+              });
+
+    for (auto &tab : candidates) {
+        if (usage <= memoryBudget) {
+            break;
+        }
+        const size_t before = tab->getMemoryUsage();
+        tab->hibernate();
+        if (!tab->isHibernated()) {
+            continue; // Tried again next frame
+        }
+        usage -= before - std::min(before, tab->getMemoryUsage());
+        std::cout << "Hibernated tab " << tab->getName() << ", released " << before / 1024
+                  << " KB" << std::endl;
+    }
 }
 
 void TabManager::renderEmptyState() {
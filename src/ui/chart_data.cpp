@@ -0,0 +1,296 @@
+#include "ui/chart_data.hpp"
+#include "database/result_store.hpp"
+#include "utils/downsample.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+namespace {
+    enum class ColumnKind { UNKNOWN, NUMBER, TIME, REJECTED };
+
+    // Longer cells are never numbers or timestamps worth plotting
+    constexpr size_t kMaxCellLength = 63;
+
+    // Days since 1970-01-01 of a proleptic Gregorian date
+    int64_t daysFromCivil(int64_t year, const unsigned month, const unsigned day) {
+        year -= month <= 2;
+        const int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+        const unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+    }
+
+    bool parseNumber(const char *text, double &value) {
+        char *end = nullptr;
+        value = std::strtod(text, &end);
+        return end != text && *end == '\0' && std::isfinite(value);
+    }
+
+    // "YYYY-MM-DD", optionally followed by " HH:MM[:SS[.fff]]" (or 'T') and a UTC offset, as
+    // both backends print dates and timestamps
+    bool parseTimestamp(const char *text, double &seconds) {
+        int year, month, day, consumed = 0;
+        if (std::sscanf(text, "%4d-%2d-%2d%n", &year, &month, &day, &consumed) != 3 ||
+            consumed != 10 || month < 1 || month > 12 || day < 1 || day > 31) {
+            return false;
+        }
+        seconds = static_cast<double>(daysFromCivil(year, month, day)) * 86400.0;
+        const char *rest = text + consumed;
+        if (*rest == '\0') {
+            return true;
+        }
+        if (*rest != ' ' && *rest != 'T') {
+            return false;
+        }
+
+        int hour, minute;
+        double second = 0.0;
+        if (std::sscanf(rest + 1, "%2d:%2d%n", &hour, &minute, &consumed) != 2) {
+            return false;
+        }
+        rest += 1 + consumed;
+        if (*rest == ':') {
+            char *end = nullptr;
+            second = std::strtod(rest + 1, &end);
+            if (end == rest + 1) {
+                return false;
+            }
+            rest = end;
+        }
+        seconds += hour * 3600.0 + minute * 60.0 + second;
+
+        if (*rest == 'Z') {
+            rest++;
+        } else if (*rest == '+' || *rest == '-') {
+            const int sign = *rest == '-' ? -1 : 1;
+            int offsetHours = 0, offsetMinutes = 0;
+            if (std::sscanf(rest + 1, "%2d%n", &offsetHours, &consumed) != 1) {
+                return false;
+            }
+            rest += 1 + consumed;
+            if (*rest == ':') {
+                rest++;
+            }
+            if (std::sscanf(rest, "%2d%n", &offsetMinutes, &consumed) == 1) {
+                rest += consumed;
+            }
+            seconds -= sign * (offsetHours * 3600.0 + offsetMinutes * 60.0);
+        }
+        return *rest == '\0';
+    }
+
+    class ColumnExtractor : public RowSink {
+    public:
+        ColumnExtractor(ChartColumns &columns, std::atomic<size_t> &rowsRead,
+                        const std::atomic<bool> &cancelRequested)
+            : columns(columns), rowsRead(rowsRead), cancelRequested(cancelRequested) {}
+
+        void begin(const std::vector<std::string> &columnNames) override {
+            names = columnNames;
+            kinds.assign(columnNames.size(), ColumnKind::UNKNOWN);
+            values.assign(columnNames.size(), {});
+        }
+
+        bool row(const RowValues &row) override {
+            for (size_t col = 0; col < kinds.size(); col++) {
+                if (kinds[col] == ColumnKind::REJECTED) {
+                    continue;
+                }
+                values[col].push_back(parse(col < row.size() ? row[col] : std::nullopt, col));
+            }
+            count++;
+            // Published in steps to keep the counter off the hot path
+            if ((count & 0xFFFF) == 0) {
+                rowsRead = count;
+                return !cancelRequested;
+            }
+            return true;
+        }
+
+        void end() override {
+            rowsRead = count;
+            columns.rowCount = count;
+            for (size_t col = 0; col < kinds.size(); col++) {
+                if (kinds[col] == ColumnKind::NUMBER || kinds[col] == ColumnKind::TIME) {
+                    columns.names.push_back(names[col]);
+                    columns.isTime.push_back(kinds[col] == ColumnKind::TIME);
+                    columns.values.push_back(std::move(values[col]));
+                }
+            }
+        }
+
+    private:
+        ChartColumns &columns;
+        std::atomic<size_t> &rowsRead;
+        const std::atomic<bool> &cancelRequested;
+        std::vector<std::string> names;
+        std::vector<ColumnKind> kinds;
+        std::vector<std::vector<double>> values;
+        size_t count = 0;
+
+        double parse(const std::optional<std::string_view> &cell, const size_t col) {
+            if (!cell) {
+                return NAN;
+            }
+            // The first value decides the kind; a value of any other kind drops the column
+            char text[kMaxCellLength + 1];
+            double value = NAN;
+            bool parsed = cell->size() <= kMaxCellLength;
+            if (parsed) {
+                memcpy(text, cell->data(), cell->size());
+                text[cell->size()] = '\0';
+                ColumnKind &kind = kinds[col];
+                if (kind != ColumnKind::TIME && parseNumber(text, value)) {
+                    kind = ColumnKind::NUMBER;
+                } else if (kind != ColumnKind::NUMBER && parseTimestamp(text, value)) {
+                    kind = ColumnKind::TIME;
+                } else {
+                    parsed = false;
+                }
+            }
+            if (!parsed) {
+                kinds[col] = ColumnKind::REJECTED;
+                values[col] = {};
+            }
+            return value;
+        }
+    };
+
+    size_t vectorBytes(const std::vector<double> &values) {
+        return values.capacity() * sizeof(double);
+    }
+} // namespace
+
+size_t ChartColumns::getMemoryUsage() const {
+    size_t bytes = 0;
+    for (const auto &column : values) {
+        bytes += vectorBytes(column);
+    }
+    return bytes;
+}
+
+std::shared_ptr<ChartColumns> ChartColumns::extract(const ResultStore &store,
+                                                    std::atomic<size_t> &rowsRead,
+                                                    const std::atomic<bool> &cancelRequested) {
+    auto columns = std::make_shared<ChartColumns>();
+    ColumnExtractor extractor(*columns, rowsRead, cancelRequested);
+    store.replay(extractor);
+    return columns;
+}
+
+size_t ChartPlot::getMemoryUsage() const {
+    size_t bytes = 0;
+    for (const auto &line : series) {
+        bytes += vectorBytes(line.x) + vectorBytes(line.y);
+    }
+    return bytes;
+}
+
+std::shared_ptr<ChartPlot> ChartPlot::build(const ChartColumns &columns, const int xColumn,
+                                            const std::vector<int> &yColumns) {
+    auto plot = std::make_shared<ChartPlot>();
+    plot->xColumn = xColumn;
+    plot->timeX = xColumn >= 0 && columns.isTime[xColumn];
+
+    std::vector<double> rowNumbers;
+    if (xColumn < 0) {
+        rowNumbers.resize(columns.rowCount);
+        std::iota(rowNumbers.begin(), rowNumbers.end(), 1.0);
+    }
+    const std::vector<double> &x = xColumn < 0 ? rowNumbers : columns.values[xColumn];
+
+    // Most time series come back ordered already; anything else is sorted once here
+    std::vector<size_t> order;
+    if (!std::is_sorted(x.begin(), x.end(), [](double a, double b) { return a < b; }) ||
+        std::any_of(x.begin(), x.end(), [](double value) { return std::isnan(value); })) {
+        for (size_t row = 0; row < x.size(); row++) {
+            if (!std::isnan(x[row])) {
+                order.push_back(row);
+            }
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&x](size_t a, size_t b) { return x[a] < x[b]; });
+    }
+    const bool sorted = order.empty();
+    const size_t count = sorted ? x.size() : order.size();
+
+    bool first = true;
+    for (const int yColumn : yColumns) {
+        const std::vector<double> &y = columns.values[yColumn];
+        ChartSeries line;
+        line.column = yColumn;
+        line.name = columns.names[yColumn];
+        line.x.reserve(count);
+        line.y.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            const size_t row = sorted ? i : order[i];
+            if (!std::isnan(x[row]) && !std::isnan(y[row])) {
+                line.x.push_back(x[row]);
+                line.y.push_back(y[row]);
+            }
+        }
+        if (!line.x.empty()) {
+            plot->minX = first ? line.x.front() : std::min(plot->minX, line.x.front());
+            plot->maxX = first ? line.x.back() : std::max(plot->maxX, line.x.back());
+            first = false;
+        }
+        plot->pointCount += line.x.size();
+        plot->series.push_back(std::move(line));
+    }
+    return plot;
+}
+
+std::shared_ptr<ChartSample> ChartSample::compute(std::shared_ptr<const ChartPlot> plot,
+                                                  const double viewMin, const double viewMax,
+                                                  const size_t pixels,
+                                                  const DownsampleMethod method) {
+    const auto start = std::chrono::steady_clock::now();
+    auto sample = std::make_shared<ChartSample>();
+    sample->viewMin = viewMin;
+    sample->viewMax = viewMax;
+    sample->minY = HUGE_VAL;
+    sample->maxY = -HUGE_VAL;
+
+    std::vector<size_t> kept;
+    for (const auto &line : plot->series) {
+        const auto lower = std::lower_bound(line.x.begin(), line.x.end(), viewMin);
+        const auto upper = std::upper_bound(line.x.begin(), line.x.end(), viewMax);
+        const size_t begin = static_cast<size_t>(lower - line.x.begin());
+        const size_t end = static_cast<size_t>(upper - line.x.begin());
+        const size_t from = begin > 0 ? begin - 1 : begin;
+        const size_t to = end < line.x.size() ? end + 1 : end;
+
+        // LTTB keeps one point per bucket, so it gets two buckets per pixel; min/max keeps two
+        kept.clear();
+        if (method == DownsampleMethod::LTTB) {
+            Downsample::lttb(line.x.data(), line.y.data(), from, to, pixels * 2, kept);
+        } else {
+            Downsample::minMax(line.x.data(), line.y.data(), from, to, pixels, kept);
+        }
+
+        std::vector<double> xs(kept.size());
+        std::vector<double> ys(kept.size());
+        for (size_t i = 0; i < kept.size(); i++) {
+            xs[i] = line.x[kept[i]];
+            ys[i] = line.y[kept[i]];
+        }
+        for (size_t i = begin; i < end; i++) {
+            sample->minY = std::min(sample->minY, line.y[i]);
+            sample->maxY = std::max(sample->maxY, line.y[i]);
+        }
+        sample->pointCount += kept.size();
+        sample->x.push_back(std::move(xs));
+        sample->y.push_back(std::move(ys));
+    }
+    sample->plot = std::move(plot);
+
+    sample->elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    return sample;
+}
@@ -1,6 +1,9 @@
 #include "ui/db_connection_dialog.hpp"
+#include "database/csv_table.hpp"
 #include "database/postgresql.hpp"
+#include "database/sqlite.hpp"
 #include "utils/file_dialog.hpp"
+#include <algorithm>
 #include <imgui.h>
 #include <iostream>
 
@@ -17,6 +20,8 @@ void DatabaseConnectionDialog::showDialog() {
         renderTypeSelection();
     } else if (showingPostgreSQLConnection) {
         renderPostgreSQLConnection();
+    } else if (showingSQLiteOptions) {
+        renderSQLiteOptions();
     }
 }
 
@@ -42,10 +47,21 @@ void DatabaseConnectionDialog::renderTypeSelection() {
 
         if (ImGui::Button("Next", ImVec2(100, 0))) {
             if (selectedDatabaseType == 0) {
-                // SQLite - directly open file dialog
-                result = createSQLiteDatabase();
-                ImGui::CloseCurrentPopup();
-                reset();
+                // SQLite - pick the file, then tune how it is opened. CSV files have nothing to
+                // tune: they are read into an in-memory database.
+                auto db = createSQLiteDatabase();
+                pendingSQLite = std::dynamic_pointer_cast<SQLiteDatabase>(db);
+                if (pendingSQLite && !CsvTable::isCsvPath(pendingSQLite->getPath())) {
+                    sqliteProfile = pendingSQLite->getProfile();
+                    mmapSizeMb = static_cast<int>(sqliteProfile.mmapSize / (1024 * 1024));
+                    showingTypeSelection = false;
+                    showingSQLiteOptions = true;
+                } else {
+                    result = db;
+                    pendingSQLite = nullptr;
+                    ImGui::CloseCurrentPopup();
+                    reset();
+                }
             } else {
                 // PostgreSQL - show connection dialog
                 showingTypeSelection = false;
@@ -113,6 +129,66 @@ void DatabaseConnectionDialog::renderPostgreSQLConnection() {
     }
 }
 
+void DatabaseConnectionDialog::renderSQLiteOptions() {
+    const ImVec2 center = ImGui::GetMainViewport()->GetCenter();
+    ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+
+    if (ImGui::BeginPopupModal("Connect to Database", nullptr,
+                               ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::Text("Connection options for %s", pendingSQLite->getName().c_str());
+        ImGui::Separator();
+        ImGui::Spacing();
+
+        ImGui::Checkbox("Read-only", &sqliteProfile.readOnly);
+        ImGui::Checkbox("Immutable", &sqliteProfile.immutable);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("No locking and no change detection; only for files nothing else "
+                              "writes to while they are open");
+        }
+        ImGui::InputInt("Memory map (MB)", &mmapSizeMb, 64, 1024);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Read this much of the file through a memory map instead of "
+                              "copying pages into the cache");
+        }
+        ImGui::InputInt("Page cache (KB)", &sqliteProfile.cacheSizeKb, 1024, 16384);
+        ImGui::BeginDisabled(sqliteProfile.isReadOnly());
+        ImGui::Checkbox("WAL journal", &sqliteProfile.wal);
+        ImGui::EndDisabled();
+        if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+            ImGui::SetTooltip("Readers and the writer stop blocking each other. The journal mode "
+                              "is stored in the file.");
+        }
+        ImGui::Checkbox("Temporary storage in memory", &sqliteProfile.tempStoreMemory);
+        ImGui::Checkbox("Skip SQLite's connection mutex", &sqliteProfile.noMutex);
+        mmapSizeMb = std::max(mmapSizeMb, 0);
+        sqliteProfile.cacheSizeKb = std::max(sqliteProfile.cacheSizeKb, 0);
+
+        ImGui::Spacing();
+        ImGui::Separator();
+
+        if (ImGui::Button("Open", ImVec2(100, 0))) {
+            sqliteProfile.mmapSize = static_cast<int64_t>(mmapSizeMb) * 1024 * 1024;
+            pendingSQLite->setProfile(sqliteProfile);
+            SqliteProfile::save(pendingSQLite->getPath(), sqliteProfile);
+            result = pendingSQLite;
+            ImGui::CloseCurrentPopup();
+            reset();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Back", ImVec2(100, 0))) {
+            showingSQLiteOptions = false;
+            showingTypeSelection = true;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel", ImVec2(100, 0))) {
+            ImGui::CloseCurrentPopup();
+            reset();
+        }
+
+        ImGui::EndPopup();
+    }
+}
+
 std::shared_ptr<DatabaseInterface> DatabaseConnectionDialog::getResult() {
     auto temp = result;
     result = nullptr; // Clear result after retrieval
@@ -123,6 +199,8 @@ void DatabaseConnectionDialog::reset() {
     isOpen = false;
     showingTypeSelection = false;
     showingPostgreSQLConnection = false;
+    showingSQLiteOptions = false;
+    pendingSQLite = nullptr;
 }
 
 std::shared_ptr<DatabaseInterface> DatabaseConnectionDialog::createSQLiteDatabase() {
@@ -1,10 +1,32 @@
 #include "ui/db_sidebar.hpp"
 #include "application.hpp"
 #include "database/db_interface.hpp"
+#include "database/snapshot.hpp"
+#include "database/sqlite.hpp"
 #include "imgui.h"
 #include "tabs/tab_manager.hpp"
+#include <cstdio>
 #include <iostream>
 
+namespace {
+    const char *tableKindLabel(const TableKind kind) {
+        switch (kind) {
+        case TableKind::VIEW:
+            return "view";
+        case TableKind::MATERIALIZED_VIEW:
+            return "materialized view";
+        case TableKind::PARTITIONED_TABLE:
+            return "partitioned";
+        case TableKind::PARTITION:
+            return "partition";
+        case TableKind::FOREIGN_TABLE:
+            return "foreign";
+        default:
+            return nullptr;
+        }
+    }
+} // namespace
+
 void DatabaseSidebar::render() {
     auto &app = Application::getInstance();
 
@@ -14,6 +36,17 @@ void DatabaseSidebar::render() {
         connectionDialog.showDialog();
     }
 
+    if (ImGui::Button("Open Snapshot", ImVec2(-1, 0))) {
+        const std::string path = FileDialog::openSnapshotFile();
+        if (!path.empty()) {
+            app.getTabManager()->createSnapshotTab(path);
+        }
+    }
+
+    if (ImGui::Button("Statement Statistics", ImVec2(-1, 0))) {
+        app.getTabManager()->createStatementStatsTab();
+    }
+
     // Always render the dialog to handle multi-frame interactions
     if (connectionDialog.isDialogOpen()) {
         connectionDialog.showDialog();
@@ -32,8 +65,15 @@ void DatabaseSidebar::render() {
         }
     }
 
+    renderExports();
+    renderCopies();
+    renderSnapshots();
     ImGui::Separator();
 
+    ImGui::SetNextItemWidth(-1);
+    ImGui::InputTextWithHint("##TableFilter", "Filter tables", tableFilterText,
+                             sizeof(tableFilterText));
+
     auto &databases = app.getDatabases();
     for (size_t i = 0; i < databases.size(); i++) {
         renderDatabaseNode(i);
@@ -61,8 +101,10 @@ void DatabaseSidebar::renderDatabaseNode(const size_t databaseIndex) {
         app.setSelectedTable(-1);
     }
 
-    // Load tables when the tree node is opened (expanded) and tables haven't been loaded yet
-    if (dbOpen && !db->areTablesLoaded()) {
+    // Load tables when the tree node is opened (expanded) and tables haven't been loaded yet.
+    // A statement running on a worker holds the connection; the list loads once it is done.
+    const bool busy = db->isBusy();
+    if (dbOpen && !db->areTablesLoaded() && !busy) {
         std::cout << "Database expanded and tables not loaded yet, attempting to load..."
                   << std::endl;
         if (!db->isConnected()) {
@@ -78,16 +120,103 @@ void DatabaseSidebar::renderDatabaseNode(const size_t databaseIndex) {
     handleDatabaseContextMenu(databaseIndex);
 
     if (dbOpen) {
-        // Tables
-        if (db->getTables().empty()) {
-            ImGui::Text("  No tables found");
+        if (!db->areTablesLoaded() && busy) {
+            ImGui::TextDisabled("Waiting for the running statement...");
+        }
+        const size_t schemaCount = db->getSchemas().size();
+        if (schemaCount == 0) {
+            renderTableList(databaseIndex, "");
+        }
+        for (size_t i = 0; i < schemaCount; i++) {
+            renderSchemaNode(databaseIndex, i);
+        }
+        ImGui::TreePop();
+    }
+}
+
+void DatabaseSidebar::renderSchemaNode(const size_t databaseIndex, const size_t schemaIndex) {
+    auto &app = Application::getInstance();
+    auto &db = app.getDatabases()[databaseIndex];
+    const Schema &schema = db->getSchemas()[schemaIndex];
+
+    ImGui::SetNextItemOpen(schema.name == "public", ImGuiCond_Once);
+    if (!ImGui::TreeNodeEx(schema.name.c_str(), ImGuiTreeNodeFlags_OpenOnArrow |
+                                                    ImGuiTreeNodeFlags_OpenOnDoubleClick)) {
+        return;
+    }
+
+    // The schema's tables and columns arrive in one catalog query on first expand, read on a
+    // worker. A read that lost a race with another catalog change is simply started again; a
+    // failed one waits for Retry.
+    const std::string name = schema.name;
+    if (!schema.loaded) {
+        auto &load = schemaLoads[{db.get(), name}];
+        if (!load || (load->finished && load->error.empty())) {
+            load = loadSchema(db, name);
+        }
+        if (!load->finished) {
+            ImGui::TextDisabled("  Loading...");
         } else {
-            for (size_t j = 0; j < db->getTables().size(); j++) {
-                renderTableNode(databaseIndex, j);
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "  %s", load->error.c_str());
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Retry")) {
+                load.reset();
             }
         }
         ImGui::TreePop();
+        return;
     }
+    renderTableList(databaseIndex, name);
+    ImGui::TreePop();
+}
+
+std::shared_ptr<DatabaseSidebar::SchemaLoad>
+DatabaseSidebar::loadSchema(const std::shared_ptr<DatabaseInterface> &db,
+                            const std::string &schema) {
+    auto load = std::make_shared<SchemaLoad>();
+    auto &jobs = Application::getInstance().getJobRunner();
+    jobs.submit([load, db, schema, &jobs] {
+        SchemaPatch patch = db->fetchSchema(schema);
+        jobs.post([load, db, patch = std::move(patch)]() mutable {
+            load->error = patch.error;
+            load->finished = true;
+            // The table indices of the selection move when the tables arrive
+            auto &app = Application::getInstance();
+            if (load->error.empty() && db->applySchemaPatch(std::move(patch))) {
+                const int selected = app.getSelectedDatabase();
+                const auto &databases = app.getDatabases();
+                if (selected >= 0 && selected < static_cast<int>(databases.size()) &&
+                    databases[selected] == db) {
+                    app.setSelectedTable(-1);
+                }
+            }
+        });
+    });
+    return load;
+}
+
+void DatabaseSidebar::renderTableList(const size_t databaseIndex, const std::string &schema) {
+    auto &db = Application::getInstance().getDatabases()[databaseIndex];
+
+    // Only the rows in view are submitted
+    const auto &matches = tableFilters[{db.get(), schema}].match(*db, schema, tableFilterText);
+    if (matches.empty()) {
+        if (tableFilterText[0] == '\0') {
+            ImGui::Text("  No tables found");
+        } else {
+            ImGui::TextDisabled("  No matching tables");
+        }
+        return;
+    }
+
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(matches.size()));
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            renderTableNode(databaseIndex, matches[row]);
+        }
+    }
+    clipper.End();
 }
 
 void DatabaseSidebar::renderTableNode(size_t databaseIndex, size_t tableIndex) {
@@ -111,11 +240,21 @@ void DatabaseSidebar::renderTableNode(size_t databaseIndex, size_t tableIndex) {
 
     // Double-click to open table viewer
     if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0)) {
-        app.getTabManager()->createTableViewerTab(db->getConnectionString(), table.name);
+        app.getTabManager()->createTableViewerTab(db->getConnectionString(),
+                                                  table.getQualifiedName());
     }
 
     // Context menu for table
     handleTableContextMenu(databaseIndex, tableIndex);
+
+    const char *kind = tableKindLabel(table.kind);
+    if (table.kind == TableKind::PARTITION && !table.parent.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("partition of %s", table.parent.c_str());
+    } else if (kind) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", kind);
+    }
 }
 
 void DatabaseSidebar::handleDatabaseContextMenu(size_t databaseIndex) {
@@ -124,14 +263,26 @@ void DatabaseSidebar::handleDatabaseContextMenu(size_t databaseIndex) {
     auto &db = databases[databaseIndex];
 
     if (ImGui::BeginPopupContextItem()) {
+        // Calls that need the connection are disabled while a worker holds it
+        const bool busy = db->isBusy();
         if (ImGui::MenuItem("Refresh")) {
-            db->setTablesLoaded(false); // Reset flag to allow refresh
-            db->refreshTables();
+            db->setTablesLoaded(false); // Reloaded by the tree node once the connection is free
+        }
+        if (db->getType() == DatabaseType::SQLITE &&
+            ImGui::MenuItem("Attach CSV...", nullptr, false, !busy)) {
+            const std::string csvPath = FileDialog::openCsvFile();
+            auto sqliteDb = std::dynamic_pointer_cast<SQLiteDatabase>(db);
+            if (!csvPath.empty() && sqliteDb && sqliteDb->attachCsv(csvPath)) {
+                db->setTablesLoaded(false);
+            }
         }
         if (ImGui::MenuItem("New SQL Editor")) {
             app.getTabManager()->createSQLEditorTab();
         }
-        if (ImGui::MenuItem("Disconnect")) {
+        if (db->getType() == DatabaseType::POSTGRESQL && ImGui::MenuItem("Activity Dashboard")) {
+            app.getTabManager()->createActivityDashboardTab(db);
+        }
+        if (ImGui::MenuItem("Disconnect", nullptr, false, !busy)) {
             db->disconnect();
         }
         ImGui::EndPopup();
@@ -146,7 +297,56 @@ void DatabaseSidebar::handleTableContextMenu(size_t databaseIndex, size_t tableI
 
     if (ImGui::BeginPopupContextItem()) {
         if (ImGui::MenuItem("View Data")) {
-            app.getTabManager()->createTableViewerTab(db->getConnectionString(), table.name);
+            app.getTabManager()->createTableViewerTab(db->getConnectionString(),
+                                                      table.getQualifiedName());
+        }
+        if (ImGui::MenuItem("Save Snapshot...")) {
+            saveTableSnapshot(databaseIndex, tableIndex);
+        }
+        if (ImGui::MenuItem("Export CSV...")) {
+            exportTableCsv(databaseIndex, tableIndex, false);
+        }
+        if (ImGui::MenuItem("Export CSV (File per Chunk)...")) {
+            exportTableCsv(databaseIndex, tableIndex, true);
+        }
+        if (ImGui::BeginMenu("Copy Table To", databases.size() > 1)) {
+            for (size_t i = 0; i < databases.size(); i++) {
+                if (i == databaseIndex) {
+                    continue;
+                }
+                ImGui::PushID(static_cast<int>(i));
+                if (ImGui::MenuItem(databases[i]->getName().c_str(), nullptr, false,
+                                    databases[i]->isConnected())) {
+                    copyTable(databaseIndex, tableIndex, i);
+                }
+                ImGui::PopID();
+            }
+            ImGui::EndMenu();
+        }
+        if (ImGui::MenuItem("Profile")) {
+            app.getTabManager()->createColumnProfileTab(db, table.getQualifiedName());
+        }
+        if (ImGui::BeginMenu("Compare With")) {
+            for (size_t i = 0; i < databases.size(); i++) {
+                ImGui::PushID(static_cast<int>(i));
+                if (ImGui::BeginMenu(databases[i]->getName().c_str(),
+                                     databases[i]->isConnected())) {
+                    const auto &others = databases[i]->getTables();
+                    for (size_t j = 0; j < others.size(); j++) {
+                        if (i == databaseIndex && j == tableIndex) {
+                            continue;
+                        }
+                        const std::string other = others[j].getQualifiedName();
+                        if (ImGui::MenuItem(other.c_str())) {
+                            app.getTabManager()->createTableDiffTab(db, table, databases[i],
+                                                                    others[j]);
+                        }
+                    }
+                    ImGui::EndMenu();
+                }
+                ImGui::PopID();
+            }
+            ImGui::EndMenu();
         }
         if (ImGui::MenuItem("Show Structure")) {
             // TODO: Show table structure in a tab
@@ -154,3 +354,209 @@ void DatabaseSidebar::handleTableContextMenu(size_t databaseIndex, size_t tableI
         ImGui::EndPopup();
     }
 }
+
+void DatabaseSidebar::saveTableSnapshot(size_t databaseIndex, size_t tableIndex) {
+    auto &app = Application::getInstance();
+    auto &db = app.getDatabases()[databaseIndex];
+    const std::string tableName = db->getTables()[tableIndex].getQualifiedName();
+
+    const std::string path = FileDialog::saveSnapshotFile(tableName + ".dsnap");
+    if (path.empty()) {
+        return;
+    }
+
+    auto job = std::make_shared<SnapshotSave>();
+    job->sourceName = tableName;
+    job->path = path;
+    snapshots.push_back(job);
+
+    // Rows stream from a cursor straight into the file, so the table never sits in memory
+    auto &jobs = app.getJobRunner();
+    jobs.submit([job, db, &jobs]() {
+        SnapshotWriter writer(job->path, &job->progress);
+        const StatementResult result =
+            db->streamQuery("SELECT * FROM " + db->quoteTableName(job->sourceName), writer);
+        std::string error = !writer.isOk() ? writer.getError() : result.error;
+        if (!result.success && writer.isOk() && error.empty()) {
+            error = "Query failed";
+        }
+        if (!error.empty()) {
+            std::remove(job->path.c_str());
+        }
+        jobs.post([job, error, rows = writer.getRowCount()] {
+            job->error = error;
+            job->rows = rows;
+            job->finished = true;
+            if (error.empty()) {
+                std::cout << "Saved " << rows << " rows of " << job->sourceName << " to "
+                          << job->path << std::endl;
+                Application::getInstance().getTabManager()->createSnapshotTab(job->path);
+            }
+        });
+    });
+}
+
+void DatabaseSidebar::exportTableCsv(size_t databaseIndex, size_t tableIndex,
+                                     const bool partitioned) {
+    auto &app = Application::getInstance();
+    auto db = app.getDatabases()[databaseIndex];
+    const std::string tableName = db->getTables()[tableIndex].getQualifiedName();
+
+    const std::string path = FileDialog::saveCsvFile(tableName + ".csv");
+    if (path.empty()) {
+        return;
+    }
+
+    auto job = std::make_shared<ExportJob>();
+    job->tableName = tableName;
+    exports.push_back(job);
+
+    auto &jobs = app.getJobRunner();
+    jobs.submit([job, db, path, partitioned, &jobs]() {
+        ExportOptions options;
+        options.partitioned = partitioned;
+        ExportResult result = TableExport::exportCsv(*db, job->tableName, path, options,
+                                                     &job->progress);
+        jobs.post([job, result = std::move(result)]() mutable {
+            job->result = std::move(result);
+            job->finished = true;
+        });
+    });
+}
+
+void DatabaseSidebar::copyTable(size_t databaseIndex, size_t tableIndex, size_t targetIndex) {
+    auto &app = Application::getInstance();
+    auto source = app.getDatabases()[databaseIndex];
+    auto target = app.getDatabases()[targetIndex];
+    Table table = source->getTables()[tableIndex];
+
+    auto job = std::make_shared<CopyJob>();
+    job->tableName = table.name;
+    job->targetName = target->getName();
+    copies.push_back(job);
+
+    auto &jobs = app.getJobRunner();
+    jobs.submit([job, source, target, table, &jobs]() mutable {
+        // Views and partitions may still be listed without their columns
+        if (!table.columnsLoaded) {
+            table.columns = source->getTableColumns(table.getQualifiedName());
+            table.columnsLoaded = true;
+        }
+        CopyResult result = TableCopy::copyTable(*source, table, *target, &job->progress);
+        jobs.post([job, target, result = std::move(result)]() mutable {
+            if (result.success) {
+                target->setTablesLoaded(false);
+            }
+            job->result = std::move(result);
+            job->finished = true;
+        });
+    });
+}
+
+void DatabaseSidebar::cancelExports() {
+    for (const auto &job : exports) {
+        job->progress.cancelRequested = true;
+    }
+    for (const auto &job : copies) {
+        job->progress.cancelRequested = true;
+    }
+    for (const auto &job : snapshots) {
+        job->progress.cancelRequested = true;
+    }
+}
+
+void DatabaseSidebar::renderExports() {
+    for (auto it = exports.begin(); it != exports.end();) {
+        const auto &job = *it;
+        ImGui::PushID(job.get());
+        bool dismiss = false;
+
+        if (!job->finished) {
+            const size_t chunks = job->progress.chunkCount;
+            const float fraction =
+                chunks ? static_cast<float>(job->progress.chunksDone) / static_cast<float>(chunks)
+                       : 0.0f;
+            ImGui::Text("Exporting %s: %llu rows", job->tableName.c_str(),
+                        (unsigned long long)job->progress.rows.load());
+            ImGui::ProgressBar(fraction, ImVec2(-1, 0));
+            if (job->progress.cancelRequested) {
+                ImGui::TextDisabled("Cancelling...");
+            } else if (ImGui::Button("Cancel", ImVec2(-1, 0))) {
+                job->progress.cancelRequested = true;
+            }
+        } else if (job->result.success) {
+            ImGui::TextWrapped("Exported %llu rows of %s in %.1f s (%zu chunks, %zu workers)",
+                               (unsigned long long)job->result.rows, job->tableName.c_str(),
+                               job->result.elapsedMs / 1000.0, job->result.chunks,
+                               job->result.workers);
+            dismiss = ImGui::SmallButton("Dismiss");
+        } else {
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Export of %s failed: %s",
+                               job->tableName.c_str(), job->result.error.c_str());
+            dismiss = ImGui::SmallButton("Dismiss");
+        }
+
+        ImGui::PopID();
+        it = dismiss ? exports.erase(it) : it + 1;
+    }
+}
+
+void DatabaseSidebar::renderSnapshots() {
+    for (auto it = snapshots.begin(); it != snapshots.end();) {
+        const auto &job = *it;
+        ImGui::PushID(job.get());
+        bool dismiss = false;
+
+        if (!job->finished) {
+            ImGui::Text("Saving snapshot of %s: %llu rows", job->sourceName.c_str(),
+                        (unsigned long long)job->progress.rows.load());
+            if (job->progress.cancelRequested) {
+                ImGui::TextDisabled("Cancelling...");
+            } else if (ImGui::Button("Cancel", ImVec2(-1, 0))) {
+                job->progress.cancelRequested = true;
+            }
+        } else if (job->error.empty()) {
+            // The snapshot opens in its own tab
+            dismiss = true;
+        } else {
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Snapshot of %s failed: %s",
+                               job->sourceName.c_str(), job->error.c_str());
+            dismiss = ImGui::SmallButton("Dismiss");
+        }
+
+        ImGui::PopID();
+        it = dismiss ? snapshots.erase(it) : it + 1;
+    }
+}
+
+void DatabaseSidebar::renderCopies() {
+    for (auto it = copies.begin(); it != copies.end();) {
+        const auto &job = *it;
+        ImGui::PushID(job.get());
+        bool dismiss = false;
+
+        if (!job->finished) {
+            ImGui::Text("Copying %s to %s: %llu rows", job->tableName.c_str(),
+                        job->targetName.c_str(),
+                        (unsigned long long)job->progress.rowsWritten.load());
+            if (job->progress.cancelRequested) {
+                ImGui::TextDisabled("Cancelling...");
+            } else if (ImGui::Button("Cancel", ImVec2(-1, 0))) {
+                job->progress.cancelRequested = true;
+            }
+        } else if (job->result.success) {
+            ImGui::TextWrapped("Copied %llu rows of %s to %s in %.1f s",
+                               (unsigned long long)job->result.rows, job->tableName.c_str(),
+                               job->targetName.c_str(), job->result.elapsedMs / 1000.0);
+            dismiss = ImGui::SmallButton("Dismiss");
+        } else {
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Copy of %s to %s failed: %s",
+                               job->tableName.c_str(), job->targetName.c_str(),
+                               job->result.error.c_str());
+            dismiss = ImGui::SmallButton("Dismiss");
+        }
+
+        ImGui::PopID();
+        it = dismiss ? copies.erase(it) : it + 1;
+    }
+}
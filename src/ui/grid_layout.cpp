@@ -0,0 +1,115 @@
+#include "ui/grid_layout.hpp"
+#include "application.hpp"
+#include "imgui.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+namespace {
+    // Since 1.92 fonts bake glyphs on demand while measuring, which is only safe on the UI
+    // thread; older atlases are immutable once built and can be read from any thread.
+#if IMGUI_VERSION_NUM >= 19200
+    constexpr bool kMeasureInBackground = false;
+#else
+    constexpr bool kMeasureInBackground = true;
+#endif
+
+    constexpr const char *kEllipsis = "...";
+} // namespace
+
+void GridLayoutCache::request(const std::vector<std::string> &columnNames,
+                              const std::vector<std::vector<std::string>> &rows) {
+    uint64_t requestGeneration;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requestGeneration = ++generation;
+        layout.reset();
+    }
+
+    ImFont *font = ImGui::GetFont();
+    const float fontSize = ImGui::GetFontSize();
+
+    if (!kMeasureInBackground) {
+        store(requestGeneration, measure(columnNames, rows, font, fontSize));
+        return;
+    }
+
+    // The worker measures a copy, since the page can be edited or reloaded meanwhile
+    auto self = shared_from_this();
+    Application::getInstance().getJobRunner().submit(
+        [self, requestGeneration, columnNames, rows, font, fontSize] {
+            self->store(requestGeneration, measure(columnNames, rows, font, fontSize));
+        });
+}
+
+void GridLayoutCache::invalidate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    generation++;
+    layout.reset();
+}
+
+std::shared_ptr<const GridLayout> GridLayoutCache::get() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return layout;
+}
+
+void GridLayoutCache::store(const uint64_t requestGeneration,
+                            std::shared_ptr<const GridLayout> result) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (requestGeneration == generation) {
+        layout = std::move(result);
+    }
+}
+
+std::shared_ptr<GridLayout>
+GridLayoutCache::measure(const std::vector<std::string> &columnNames,
+                         const std::vector<std::vector<std::string>> &rows, ImFont *font,
+                         const float fontSize) {
+    auto result = std::make_shared<GridLayout>();
+    result->rowCount = rows.size();
+    result->columnCount = columnNames.size();
+    result->columnWidths.resize(columnNames.size(), kMinColumnWidth);
+    result->truncatedIndex.assign(rows.size() * columnNames.size(), -1);
+
+    // Widths are content widths; the table adds its own cell padding
+    const float maxTextWidth = kMaxColumnWidth;
+    const float ellipsisWidth = font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, kEllipsis).x;
+
+    for (size_t col = 0; col < columnNames.size(); col++) {
+        const std::string &header = columnNames[col];
+        float width = font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, header.data(),
+                                          header.data() + header.size())
+                          .x;
+
+        for (size_t row = 0; row < rows.size(); row++) {
+            if (col >= rows[row].size()) {
+                continue;
+            }
+            const std::string &value = rows[row][col];
+            const char *begin = value.data();
+            const char *end = begin + value.size();
+            const char *lineEnd = static_cast<const char *>(memchr(begin, '\n', value.size()));
+            const bool multiLine = lineEnd != nullptr;
+            if (!multiLine) {
+                lineEnd = end;
+            }
+
+            float cellWidth = font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, begin, lineEnd).x;
+            if (multiLine || cellWidth > maxTextWidth) {
+                // Cut at the last character that leaves room for the ellipsis
+                const char *cut = lineEnd;
+                const float cutWidth = font->CalcTextSizeA(fontSize, maxTextWidth - ellipsisWidth,
+                                                           0.0f, begin, lineEnd, &cut)
+                                           .x;
+                result->truncatedIndex[row * columnNames.size() + col] =
+                    (int32_t)result->truncatedText.size();
+                result->truncatedText.push_back(std::string(begin, cut) + kEllipsis);
+                cellWidth = cutWidth + ellipsisWidth;
+            }
+            width = std::max(width, cellWidth);
+        }
+
+        result->columnWidths[col] = std::clamp(width, kMinColumnWidth, kMaxColumnWidth);
+    }
+    return result;
+}
@@ -0,0 +1,266 @@
+#include "ui/sql_highlighter.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+    // Sorted for the binary search
+    constexpr const char *kKeywords[] = {
+        "ADD", "ALL", "ALTER", "ANALYZE", "AND", "ANY", "AS", "ASC", "BEGIN", "BETWEEN", "BIGINT",
+        "BOOLEAN", "BY", "CASCADE", "CASE", "CAST", "CHECK", "COALESCE", "COLUMN", "COMMIT",
+        "CONFLICT", "CONSTRAINT", "CREATE", "CROSS", "CURRENT_DATE", "CURRENT_TIMESTAMP",
+        "DATABASE", "DEFAULT", "DELETE", "DESC", "DISTINCT", "DO", "DROP", "ELSE", "END",
+        "EXCEPT", "EXISTS", "EXPLAIN", "FALSE", "FOREIGN", "FROM", "FULL", "FUNCTION", "GRANT",
+        "GROUP", "HAVING", "IF", "IN", "INDEX", "INNER", "INSERT", "INTEGER", "INTERSECT",
+        "INTO", "IS", "JOIN", "KEY", "LANGUAGE", "LEFT", "LIKE", "LIMIT", "NATURAL", "NOT",
+        "NOTHING", "NULL", "NUMERIC", "OFFSET", "ON", "OR", "ORDER", "OUTER", "OVER",
+        "PARTITION", "PRAGMA", "PRIMARY", "REAL", "RECURSIVE", "REFERENCES", "RENAME",
+        "REPLACE", "RETURNING", "RETURNS", "REVOKE", "RIGHT", "ROLLBACK", "SCHEMA", "SELECT",
+        "SEQUENCE", "SET", "TABLE", "TEXT", "THEN", "TIMESTAMP", "TO", "TRANSACTION", "TRIGGER",
+        "TRUE", "TRUNCATE", "UNION", "UNIQUE", "UPDATE", "USING", "VACUUM", "VALUES", "VARCHAR",
+        "VIEW", "WHEN", "WHERE", "WINDOW", "WITH",
+    };
+
+    constexpr size_t kMaxKeywordLength = 24;
+    constexpr size_t kCompareChunk = 4096;
+
+    bool isWordChar(const char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    }
+
+    bool isKeyword(const std::string_view word) {
+        if (word.size() > kMaxKeywordLength) {
+            return false;
+        }
+        char upper[kMaxKeywordLength + 1];
+        for (size_t i = 0; i < word.size(); i++) {
+            upper[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(word[i])));
+        }
+        upper[word.size()] = '\0';
+        return std::binary_search(std::begin(kKeywords), std::end(kKeywords), upper,
+                                  [](const char *a, const char *b) { return strcmp(a, b) < 0; });
+    }
+
+    // Length of the common prefix, compared a chunk at a time
+    size_t commonPrefix(const std::string_view a, const std::string_view b) {
+        const size_t limit = std::min(a.size(), b.size());
+        size_t i = 0;
+        while (i + kCompareChunk <= limit &&
+               memcmp(a.data() + i, b.data() + i, kCompareChunk) == 0) {
+            i += kCompareChunk;
+        }
+        while (i < limit && a[i] == b[i]) {
+            i++;
+        }
+        return i;
+    }
+
+    size_t commonSuffix(const std::string_view a, const std::string_view b, const size_t limit) {
+        size_t i = 0;
+        while (i + kCompareChunk <= limit &&
+               memcmp(a.data() + a.size() - i - kCompareChunk,
+                      b.data() + b.size() - i - kCompareChunk, kCompareChunk) == 0) {
+            i += kCompareChunk;
+        }
+        while (i < limit && a[a.size() - 1 - i] == b[b.size() - 1 - i]) {
+            i++;
+        }
+        return i;
+    }
+} // namespace
+
+SqlHighlighter::SqlHighlighter() : lines(1), dollarTags(1) {}
+
+SqlHighlighter::State SqlHighlighter::lexLine(const std::string_view text, const size_t begin,
+                                              const size_t end, State state, std::string &tag,
+                                              std::vector<Token> *tokens) {
+    using Kind = TokenKind;
+    const auto emit = [tokens](size_t from, size_t to, Kind kind) {
+        if (tokens && to > from) {
+            tokens->push_back({from, to, kind});
+        }
+    };
+
+    // Start of the token the current state belongs to
+    size_t tokenStart = begin;
+    size_t i = begin;
+    while (i < end) {
+        switch (state) {
+        case State::BLOCK_COMMENT: {
+            const size_t close = text.substr(0, end).find("*/", i);
+            if (close == std::string_view::npos) {
+                emit(tokenStart, end, Kind::COMMENT);
+                return state;
+            }
+            emit(tokenStart, close + 2, Kind::COMMENT);
+            i = close + 2;
+            state = State::NORMAL;
+            break;
+        }
+        case State::STRING:
+        case State::QUOTED_IDENTIFIER: {
+            // A doubled quote is an escaped one
+            const char quote = state == State::STRING ? '\'' : '"';
+            const Kind kind = state == State::STRING ? Kind::STRING : Kind::IDENTIFIER;
+            while (i < end && (text[i] != quote || (i + 1 < end && text[i + 1] == quote))) {
+                i += text[i] == quote ? 2 : 1;
+            }
+            if (i >= end) {
+                emit(tokenStart, end, kind);
+                return state;
+            }
+            emit(tokenStart, i + 1, kind);
+            i++;
+            state = State::NORMAL;
+            break;
+        }
+        case State::DOLLAR_QUOTE: {
+            const std::string delimiter = "$" + tag + "$";
+            const size_t close = text.substr(0, end).find(delimiter, i);
+            if (close == std::string_view::npos) {
+                emit(tokenStart, end, Kind::STRING);
+                return state;
+            }
+            emit(tokenStart, close + delimiter.size(), Kind::STRING);
+            i = close + delimiter.size();
+            state = State::NORMAL;
+            break;
+        }
+        case State::NORMAL: {
+            const char c = text[i];
+            const char next = i + 1 < end ? text[i + 1] : '\0';
+            tokenStart = i;
+            if (c == '-' && next == '-') {
+                emit(i, end, Kind::COMMENT);
+                return state;
+            } else if (c == '/' && next == '*') {
+                state = State::BLOCK_COMMENT;
+                i += 2;
+            } else if (c == '\'') {
+                state = State::STRING;
+                i++;
+            } else if (c == '"') {
+                state = State::QUOTED_IDENTIFIER;
+                i++;
+            } else if (c == '$' && !std::isdigit(static_cast<unsigned char>(next))) {
+                // $tag$ opens a dollar quote; $1 is a parameter
+                size_t j = i + 1;
+                while (j < end && (std::isalnum(static_cast<unsigned char>(text[j])) ||
+                                   text[j] == '_')) {
+                    j++;
+                }
+                if (j < end && text[j] == '$') {
+                    tag.assign(text.substr(i + 1, j - i - 1));
+                    state = State::DOLLAR_QUOTE;
+                    i = j + 1;
+                } else {
+                    i = j;
+                }
+            } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+                       (c == '.' && std::isdigit(static_cast<unsigned char>(next)))) {
+                size_t j = i + 1;
+                while (j < end && (std::isalnum(static_cast<unsigned char>(text[j])) ||
+                                   text[j] == '.' ||
+                                   ((text[j] == '+' || text[j] == '-') &&
+                                    (text[j - 1] == 'e' || text[j - 1] == 'E')))) {
+                    j++;
+                }
+                emit(i, j, Kind::NUMBER);
+                i = j;
+            } else if (isWordChar(c)) {
+                size_t j = i + 1;
+                while (j < end && isWordChar(text[j])) {
+                    j++;
+                }
+                if (isKeyword(text.substr(i, j - i))) {
+                    emit(i, j, Kind::KEYWORD);
+                }
+                i = j;
+            } else {
+                i++;
+            }
+            break;
+        }
+        }
+    }
+    return state;
+}
+
+size_t SqlHighlighter::getLineEnd(const size_t line) const {
+    return line + 1 < lines.size() ? lines[line + 1].start - 1 : text.size();
+}
+
+size_t SqlHighlighter::findLine(const size_t offset) const {
+    const auto it =
+        std::upper_bound(lines.begin(), lines.end(), offset,
+                         [](size_t value, const Line &line) { return value < line.start; });
+    return static_cast<size_t>(it - lines.begin()) - 1;
+}
+
+uint32_t SqlHighlighter::internTag(const std::string_view tag) {
+    const auto it = std::find(dollarTags.begin(), dollarTags.end(), tag);
+    if (it != dollarTags.end()) {
+        return static_cast<uint32_t>(it - dollarTags.begin());
+    }
+    dollarTags.emplace_back(tag);
+    return static_cast<uint32_t>(dollarTags.size() - 1);
+}
+
+void SqlHighlighter::update(const std::string_view newText) {
+    lastRelexedLines = 0;
+    const size_t prefix = commonPrefix(text, newText);
+    if (prefix == text.size() && prefix == newText.size()) {
+        return;
+    }
+    const size_t suffix =
+        commonSuffix(text, newText, std::min(text.size(), newText.size()) - prefix);
+    const size_t oldChangedEnd = text.size() - suffix;
+    const size_t newChangedEnd = newText.size() - suffix;
+
+    // Lines starting after the changed bytes survive, shifted; the line holding the first changed
+    // byte keeps its start and state, and the lines in between are replaced
+    const size_t firstLine = findLine(prefix);
+    const auto kept = std::upper_bound(
+        lines.begin() + firstLine + 1, lines.end(), oldChangedEnd,
+        [](size_t value, const Line &line) { return value < line.start; });
+    std::vector<Line> changed;
+    for (size_t i = prefix; i < newChangedEnd; i++) {
+        if (newText[i] == '\n') {
+            changed.push_back({i + 1, State::NORMAL, 0});
+        }
+    }
+    const auto changedEnd = lines.erase(lines.begin() + firstLine + 1, kept);
+    const size_t keptIndex = static_cast<size_t>(changedEnd - lines.begin()) + changed.size();
+    lines.insert(changedEnd, changed.begin(), changed.end());
+    for (size_t i = keptIndex; i < lines.size(); i++) {
+        lines[i].start = lines[i].start + newText.size() - text.size();
+    }
+    text.assign(newText);
+
+    // Re-lex until a surviving line's cached state turns out to be right already
+    std::string tag = dollarTags[lines[firstLine].tag];
+    State state = lines[firstLine].state;
+    for (size_t line = firstLine; line < lines.size(); line++) {
+        state = lexLine(text, lines[line].start, getLineEnd(line), state, tag, nullptr);
+        lastRelexedLines++;
+        if (line + 1 == lines.size()) {
+            break;
+        }
+        Line &next = lines[line + 1];
+        const uint32_t nextTag = state == State::DOLLAR_QUOTE ? internTag(tag) : 0;
+        if (line + 1 >= keptIndex && next.state == state && next.tag == nextTag) {
+            break;
+        }
+        next.state = state;
+        next.tag = nextTag;
+    }
+}
+
+void SqlHighlighter::tokenizeLine(const size_t line, std::vector<Token> &out) const {
+    std::string tag = dollarTags[lines[line].tag];
+    lexLine(text, lines[line].start, getLineEnd(line), lines[line].state, tag, &out);
+}
+
+size_t SqlHighlighter::getMemoryUsage() const {
+    return text.capacity() + lines.capacity() * sizeof(Line);
+}
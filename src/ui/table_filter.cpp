@@ -0,0 +1,151 @@
+#include "ui/table_filter.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+    // Any substring match ranks above any scattered one. Scores stay small so the matches can
+    // be ordered with a counting sort.
+    constexpr int kBoundaryBonus = 8;
+    constexpr int kConsecutiveBonus = 10;
+    constexpr int kMaxGapPenalty = 5;
+    constexpr size_t kMaxPositionPenalty = 100;
+    constexpr int kSubstringScore = 1024;
+    constexpr int kMaxSubsequenceScore = kSubstringScore - 2 * kMaxPositionPenalty - 1;
+    constexpr int kMaxScore = kSubstringScore + kBoundaryBonus * 4;
+
+    char toLower(const char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    // Characters folded onto 64 bits; a collision only lets a name through to the real check
+    uint64_t charMask(const std::string_view text) {
+        uint64_t mask = 0;
+        for (const char c : text) {
+            mask |= uint64_t(1) << (static_cast<unsigned char>(c) & 63);
+        }
+        return mask;
+    }
+
+    bool isBoundary(const std::string_view name, const size_t at) {
+        return at == 0 || !std::isalnum(static_cast<unsigned char>(name[at - 1]));
+    }
+} // namespace
+
+int TableFilter::score(const std::string_view name, const std::string_view query) {
+    if (query.empty()) {
+        return 0;
+    }
+
+    // Earlier and shorter names win among substring matches
+    const size_t found = name.find(query);
+    if (found != std::string_view::npos) {
+        int result = kSubstringScore;
+        result -= static_cast<int>(std::min(found, kMaxPositionPenalty));
+        result -= static_cast<int>(std::min(name.size() - query.size(), kMaxPositionPenalty));
+        return isBoundary(name, found) ? result + kBoundaryBonus * 4 : result;
+    }
+
+    int result = 0;
+    size_t from = 0;
+    for (size_t i = 0; i < query.size(); i++) {
+        const size_t at = name.find(query[i], from);
+        if (at == std::string_view::npos) {
+            return -1;
+        }
+        if (i > 0 && at == from) {
+            result += kConsecutiveBonus;
+        } else {
+            result -= static_cast<int>(std::min<size_t>(at - from, kMaxGapPenalty));
+        }
+        if (isBoundary(name, at)) {
+            result += kBoundaryBonus;
+        }
+        from = at + 1;
+    }
+    return std::clamp(result, 0, kMaxSubsequenceScore);
+}
+
+void TableFilter::rebuild(const std::vector<Table> &tables, const std::string_view schema) {
+    names.clear();
+    entries.clear();
+    for (size_t i = 0; i < tables.size(); i++) {
+        const Table &table = tables[i];
+        if (table.schema != schema) {
+            continue;
+        }
+        Entry entry;
+        entry.offset = static_cast<uint32_t>(names.size());
+        entry.length = static_cast<uint32_t>(table.name.size());
+        entry.table = static_cast<uint32_t>(i);
+        for (const char c : table.name) {
+            names.push_back(toLower(c));
+        }
+        entry.mask = charMask(std::string_view(names).substr(entry.offset, entry.length));
+        entries.push_back(entry);
+    }
+}
+
+const std::vector<size_t> &TableFilter::match(const DatabaseInterface &db,
+                                              const std::string_view schema,
+                                              const std::string_view query) {
+    std::string lowered(query);
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), toLower);
+
+    const bool stale = !indexed || generation != db.getSchemaGeneration();
+    if (stale) {
+        rebuild(db.getTables(), schema);
+        generation = db.getSchemaGeneration();
+        indexed = true;
+    } else if (lowered == lastQuery) {
+        return matches;
+    }
+
+    // Typing on narrows the previous matches; anything else starts from every table
+    const bool narrowing = !stale && !lastQuery.empty() &&
+                           lowered.compare(0, lastQuery.size(), lastQuery) == 0;
+    if (!narrowing) {
+        candidates.resize(entries.size());
+        for (size_t i = 0; i < candidates.size(); i++) {
+            candidates[i] = i;
+        }
+    }
+    lastQuery = std::move(lowered);
+
+    if (lastQuery.empty()) {
+        matches.clear();
+        for (const Entry &entry : entries) {
+            matches.push_back(entry.table);
+        }
+        return matches;
+    }
+
+    const uint64_t queryMask = charMask(lastQuery);
+    const std::string_view all(names);
+    scored.clear();
+    bucketStarts.assign(kMaxScore + 2, 0);
+    for (const size_t candidate : candidates) {
+        const Entry &entry = entries[candidate];
+        if ((queryMask & ~entry.mask) != 0) {
+            continue;
+        }
+        const int value = score(all.substr(entry.offset, entry.length), lastQuery);
+        if (value >= 0) {
+            scored.emplace_back(value, candidate);
+            bucketStarts[kMaxScore - value + 1]++;
+        }
+    }
+
+    // Best score first; the sort is stable, so ties keep the order they were scanned in
+    for (size_t i = 1; i < bucketStarts.size(); i++) {
+        bucketStarts[i] += bucketStarts[i - 1];
+    }
+    candidates.resize(scored.size());
+    for (const auto &[value, candidate] : scored) {
+        candidates[bucketStarts[kMaxScore - value]++] = candidate;
+    }
+    matches.resize(candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++) {
+        matches[i] = entries[candidates[i]].table;
+    }
+    return matches;
+}
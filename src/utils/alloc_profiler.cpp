@@ -0,0 +1,132 @@
+#include "utils/alloc_profiler.hpp"
+
+#ifdef DEAR_SQL_ALLOC_PROFILER
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<uint64_t> allocationCount{0};
+    std::atomic<uint64_t> allocatedBytes{0};
+    AllocProfiler::Counters lastTotals;
+
+    void *countedAlloc(const std::size_t size) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+    }
+
+    void *countedAlignedAlloc(const std::size_t size, const std::align_val_t alignment) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        void *ptr = nullptr;
+        const auto align = std::max(static_cast<std::size_t>(alignment), sizeof(void *));
+        return posix_memalign(&ptr, align, size ? size : 1) == 0 ? ptr : nullptr;
+    }
+} // namespace
+
+void *operator new(std::size_t size) {
+    if (void *ptr = countedAlloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    if (void *ptr = countedAlloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return countedAlloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return countedAlloc(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    if (void *ptr = countedAlignedAlloc(size, alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    if (void *ptr = countedAlignedAlloc(size, alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+namespace AllocProfiler {
+    bool isEnabled() {
+        return true;
+    }
+
+    Counters getTotals() {
+        return {allocationCount.load(std::memory_order_relaxed),
+                allocatedBytes.load(std::memory_order_relaxed)};
+    }
+
+    Counters endFrame() {
+        const Counters totals = getTotals();
+        const Counters frame{totals.allocations - lastTotals.allocations,
+                             totals.bytes - lastTotals.bytes};
+        lastTotals = totals;
+        return frame;
+    }
+} // namespace AllocProfiler
+
+#else
+
+namespace AllocProfiler {
+    bool isEnabled() {
+        return false;
+    }
+
+    Counters getTotals() {
+        return {};
+    }
+
+    Counters endFrame() {
+        return {};
+    }
+} // namespace AllocProfiler
+
+#endif
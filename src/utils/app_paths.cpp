@@ -0,0 +1,28 @@
+#include "utils/app_paths.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+std::string AppPaths::dataDirectory() {
+    const char *home = std::getenv("HOME");
+    if (!home || !*home) {
+        home = std::getenv("USERPROFILE");
+    }
+    if (!home || !*home) {
+        return "";
+    }
+
+    const std::filesystem::path directory = std::filesystem::path(home) / ".dear-sql";
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Failed to create " << directory << ": " << error.message() << std::endl;
+        return "";
+    }
+    return directory.string();
+}
+
+std::string AppPaths::dataFile(const std::string &name) {
+    const std::string directory = dataDirectory();
+    return directory.empty() ? "" : (std::filesystem::path(directory) / name).string();
+}
@@ -0,0 +1,101 @@
+#include "utils/downsample.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    void keepAll(const size_t begin, const size_t end, std::vector<size_t> &out) {
+        for (size_t i = begin; i < end; i++) {
+            out.push_back(i);
+        }
+    }
+} // namespace
+
+void Downsample::lttb(const double *x, const double *y, const size_t begin, const size_t end,
+                      const size_t threshold, std::vector<size_t> &out) {
+    const size_t count = end > begin ? end - begin : 0;
+    if (threshold < 3 || count <= threshold) {
+        keepAll(begin, end, out);
+        return;
+    }
+
+    // The first and last point are always kept; the rest is split into equal-count buckets
+    const size_t buckets = threshold - 2;
+    const double bucketSize = static_cast<double>(count - 2) / static_cast<double>(buckets);
+    const auto bucketStart = [&](const size_t bucket) {
+        return begin + 1 + static_cast<size_t>(static_cast<double>(bucket) * bucketSize);
+    };
+
+    size_t kept = begin;
+    out.push_back(kept);
+    for (size_t bucket = 0; bucket < buckets; bucket++) {
+        const size_t from = bucketStart(bucket);
+        const size_t to = bucketStart(bucket + 1);
+
+        // Average of the next bucket; the last bucket looks at the last point
+        const size_t nextFrom = to;
+        const size_t nextTo = bucket + 1 < buckets ? bucketStart(bucket + 2) : end;
+        double averageX = 0.0;
+        double averageY = 0.0;
+        for (size_t i = nextFrom; i < nextTo; i++) {
+            averageX += x[i];
+            averageY += y[i];
+        }
+        averageX /= static_cast<double>(nextTo - nextFrom);
+        averageY /= static_cast<double>(nextTo - nextFrom);
+
+        // Twice the triangle area, which picks the same point
+        const double keptX = x[kept];
+        const double keptY = y[kept];
+        double bestArea = -1.0;
+        size_t best = from;
+        for (size_t i = from; i < to; i++) {
+            const double area = std::fabs((keptX - averageX) * (y[i] - keptY) -
+                                          (keptX - x[i]) * (averageY - keptY));
+            if (area > bestArea) {
+                bestArea = area;
+                best = i;
+            }
+        }
+        kept = best;
+        out.push_back(kept);
+    }
+    out.push_back(end - 1);
+}
+
+void Downsample::minMax(const double *x, const double *y, const size_t begin, const size_t end,
+                        const size_t buckets, std::vector<size_t> &out) {
+    const size_t count = end > begin ? end - begin : 0;
+    if (buckets == 0 || count <= buckets * 2) {
+        keepAll(begin, end, out);
+        return;
+    }
+
+    const double first = x[begin];
+    const double span = x[end - 1] - first;
+    const auto sliceOf = [&](const size_t i) {
+        if (span <= 0.0) {
+            return size_t(0);
+        }
+        const double slice = (x[i] - first) / span * static_cast<double>(buckets);
+        return std::min(static_cast<size_t>(slice), buckets - 1);
+    };
+
+    size_t i = begin;
+    while (i < end) {
+        const size_t slice = sliceOf(i);
+        size_t low = i;
+        size_t high = i;
+        for (i++; i < end && sliceOf(i) == slice; i++) {
+            if (y[i] < y[low]) {
+                low = i;
+            }
+            if (y[i] > y[high]) {
+                high = i;
+            }
+        }
+        out.push_back(std::min(low, high));
+        if (low != high) {
+            out.push_back(std::max(low, high));
+        }
+    }
+}
@@ -22,10 +22,11 @@ void FileDialog::cleanup() {
 
 std::shared_ptr<DatabaseInterface> FileDialog::openSQLiteFile() {
     nfdchar_t *outPath;
-    constexpr nfdfilteritem_t filterItem[2] = {{"SQLite Database", "db,sqlite,sqlite3"},
+    constexpr nfdfilteritem_t filterItem[3] = {{"SQLite Database", "db,sqlite,sqlite3"},
+                                               {"CSV File", "csv"},
                                                {"All Files", "*"}};
 
-    const nfdresult_t result = NFD_OpenDialog(&outPath, filterItem, 2, nullptr);
+    const nfdresult_t result = NFD_OpenDialog(&outPath, filterItem, 3, nullptr);
     if (result == NFD_OKAY) {
         std::string path(outPath);
         const size_t lastSlash = path.find_last_of("/\\");
@@ -41,3 +42,69 @@ std::shared_ptr<DatabaseInterface> FileDialog::openSQLiteFile() {
     std::cerr << "File dialog error: " << NFD_GetError() << std::endl;
     return nullptr;
 }
+
+std::string FileDialog::openCsvFile() {
+    nfdchar_t *outPath;
+    constexpr nfdfilteritem_t filterItem[1] = {{"CSV File", "csv"}};
+
+    const nfdresult_t result = NFD_OpenDialog(&outPath, filterItem, 1, nullptr);
+    if (result == NFD_OKAY) {
+        std::string path(outPath);
+        NFD_FreePath(outPath);
+        return path;
+    }
+    if (result == NFD_ERROR) {
+        std::cerr << "File dialog error: " << NFD_GetError() << std::endl;
+    }
+    return "";
+}
+
+std::string FileDialog::openSnapshotFile() {
+    nfdchar_t *outPath;
+    constexpr nfdfilteritem_t filterItem[1] = {{"Result Snapshot", "dsnap"}};
+
+    const nfdresult_t result = NFD_OpenDialog(&outPath, filterItem, 1, nullptr);
+    if (result == NFD_OKAY) {
+        std::string path(outPath);
+        NFD_FreePath(outPath);
+        return path;
+    }
+    if (result == NFD_ERROR) {
+        std::cerr << "File dialog error: " << NFD_GetError() << std::endl;
+    }
+    return "";
+}
+
+std::string FileDialog::saveSnapshotFile(const std::string &defaultName) {
+    nfdchar_t *outPath;
+    constexpr nfdfilteritem_t filterItem[1] = {{"Result Snapshot", "dsnap"}};
+
+    const nfdresult_t result =
+        NFD_SaveDialog(&outPath, filterItem, 1, nullptr, defaultName.c_str());
+    if (result == NFD_OKAY) {
+        std::string path(outPath);
+        NFD_FreePath(outPath);
+        return path;
+    }
+    if (result == NFD_ERROR) {
+        std::cerr << "File dialog error: " << NFD_GetError() << std::endl;
+    }
+    return "";
+}
+
+std::string FileDialog::saveCsvFile(const std::string &defaultName) {
+    nfdchar_t *outPath;
+    constexpr nfdfilteritem_t filterItem[1] = {{"CSV File", "csv"}};
+
+    const nfdresult_t result =
+        NFD_SaveDialog(&outPath, filterItem, 1, nullptr, defaultName.c_str());
+    if (result == NFD_OKAY) {
+        std::string path(outPath);
+        NFD_FreePath(outPath);
+        return path;
+    }
+    if (result == NFD_ERROR) {
+        std::cerr << "File dialog error: " << NFD_GetError() << std::endl;
+    }
+    return "";
+}
@@ -0,0 +1,85 @@
+#include "utils/frame_arena.hpp"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+FrameArena::FrameArena(const size_t blockSize) : blockSize(blockSize) {
+    blocks.push_back({std::make_unique<char[]>(blockSize), blockSize});
+}
+
+void *FrameArena::allocate(const size_t size, const size_t alignment) {
+    return allocateBytes(size, alignment);
+}
+
+char *FrameArena::allocateBytes(const size_t size, const size_t alignment) {
+    Block *block = &blocks.back();
+    size_t start = (offset + alignment - 1) / alignment * alignment;
+    if (start + size > block->size) {
+        // New blocks are only created on overflow and merged away by the next reset()
+        const size_t newSize = std::max(blockSize, size + alignment);
+        blocks.push_back({std::make_unique<char[]>(newSize), newSize});
+        block = &blocks.back();
+        start = 0;
+    }
+
+    offset = start + size;
+    usedBytes += size;
+    peakBytes = std::max(peakBytes, usedBytes);
+    return block->data.get() + start;
+}
+
+const char *FrameArena::copy(const std::string_view text) {
+    char *result = allocateBytes(text.size() + 1, 1);
+    memcpy(result, text.data(), text.size());
+    result[text.size()] = '\0';
+    return result;
+}
+
+const char *FrameArena::format(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    va_list retry;
+    va_copy(retry, args);
+
+    // Try the space left in the current block first, which avoids formatting twice
+    const Block &block = blocks.back();
+    const size_t available = block.size - std::min(offset, block.size);
+    char *target = block.data.get() + std::min(offset, block.size);
+    const int length = vsnprintf(target, available, fmt, args);
+    va_end(args);
+
+    const char *result = nullptr;
+    if (length < 0) {
+        result = "";
+    } else if ((size_t)length < available) {
+        result = allocateBytes((size_t)length + 1, 1);
+    } else {
+        char *buffer = allocateBytes((size_t)length + 1, 1);
+        vsnprintf(buffer, (size_t)length + 1, fmt, retry);
+        result = buffer;
+    }
+    va_end(retry);
+    return result;
+}
+
+void FrameArena::reset() {
+    if (blocks.size() > 1) {
+        size_t total = 0;
+        for (const auto &block : blocks) {
+            total += block.size;
+        }
+        blocks.clear();
+        blocks.push_back({std::make_unique<char[]>(total), total});
+    }
+    offset = 0;
+    usedBytes = 0;
+}
+
+size_t FrameArena::getCapacity() const {
+    size_t capacity = 0;
+    for (const auto &block : blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
@@ -0,0 +1,79 @@
+#include "utils/job_runner.hpp"
+#include <algorithm>
+#include <iostream>
+
+JobRunner::JobRunner(size_t workerCount) {
+    if (workerCount == 0) {
+        const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = std::max(2u, hardwareThreads > 1 ? hardwareThreads - 1 : 1u);
+    }
+    for (size_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(&JobRunner::workerLoop, this);
+    }
+}
+
+JobRunner::~JobRunner() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+        jobs.clear();
+    }
+    jobReady.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void JobRunner::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back(std::move(job));
+    }
+    jobReady.notify_one();
+}
+
+void JobRunner::post(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    callbacks.push_back(std::move(callback));
+}
+
+void JobRunner::drainMainThread() {
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        if (callbacks.empty()) {
+            return;
+        }
+        // Swap so callbacks can post again without deadlocking; both vectors keep capacity
+        runningCallbacks.swap(callbacks);
+    }
+    for (auto &callback : runningCallbacks) {
+        callback();
+    }
+    runningCallbacks.clear();
+}
+
+size_t JobRunner::getPendingJobs() const {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    return jobs.size();
+}
+
+void JobRunner::workerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        try {
+            job();
+        } catch (const std::exception &e) {
+            std::cerr << "Background job failed: " << e.what() << std::endl;
+        }
+    }
+}
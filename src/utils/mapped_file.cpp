@@ -0,0 +1,71 @@
+#include "utils/mapped_file.hpp"
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : address(other.address), length(other.length) {
+    other.address = nullptr;
+    other.length = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        address = other.address;
+        length = other.length;
+        other.address = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open file for mapping: " << path << std::endl;
+        return false;
+    }
+
+    struct stat info {};
+    bool mapped = false;
+    if (fstat(fd, &info) == 0) {
+        mapped = map(fd, static_cast<size_t>(info.st_size));
+    }
+    ::close(fd); // The mapping keeps the file alive
+    return mapped;
+}
+
+bool MappedFile::map(const int fd, const size_t size) {
+    if (size == 0) {
+        close();
+        return false;
+    }
+
+    // The old mapping stays valid until the new one is in place, so a failed remap leaves
+    // pointers into it usable
+    void *result = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (result == MAP_FAILED) {
+        std::cerr << "Failed to map file (" << size << " bytes)" << std::endl;
+        return false;
+    }
+
+    close();
+    address = result;
+    length = size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (address) {
+        munmap(address, length);
+        address = nullptr;
+        length = 0;
+    }
+}
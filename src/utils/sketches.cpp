@@ -0,0 +1,245 @@
+#include "utils/sketches.hpp"
+#include <algorithm>
+#include <cmath>
+
+uint64_t sketchHash(const std::string_view value) {
+    // FNV-1a, then the MurmurHash3 finalizer so every output bit depends on every input bit
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char c : value) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// HyperLogLog
+HyperLogLog::HyperLogLog() : registers(size_t(1) << kPrecision, 0) {}
+
+void HyperLogLog::add(const uint64_t hash) {
+    const size_t index = hash >> (64 - kPrecision);
+    // Position of the first set bit in the remaining bits; a sentinel bit bounds the count
+    const uint64_t rest = (hash << kPrecision) | (uint64_t(1) << (kPrecision - 1));
+    uint8_t rank = 1;
+    for (uint64_t bit = uint64_t(1) << 63; !(rest & bit); bit >>= 1) {
+        rank++;
+    }
+    registers[index] = std::max(registers[index], rank);
+}
+
+void HyperLogLog::merge(const HyperLogLog &other) {
+    for (size_t i = 0; i < registers.size(); i++) {
+        registers[i] = std::max(registers[i], other.registers[i]);
+    }
+}
+
+double HyperLogLog::estimate() const {
+    const double m = static_cast<double>(registers.size());
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (const uint8_t rank : registers) {
+        sum += std::ldexp(1.0, -rank);
+        zeros += rank == 0;
+    }
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    const double raw = alpha * m * m / sum;
+    if (raw <= 2.5 * m && zeros > 0) {
+        return m * std::log(m / static_cast<double>(zeros));
+    }
+    return raw;
+}
+
+// SpaceSaving
+SpaceSaving::SpaceSaving(const size_t capacity) : capacity(capacity) {
+    heap.reserve(capacity);
+    positions.reserve(capacity);
+}
+
+void SpaceSaving::add(const std::string_view value) {
+    std::string key(value);
+    const auto it = positions.find(key);
+    if (it != positions.end()) {
+        heap[it->second].count++;
+        siftDown(it->second);
+        return;
+    }
+
+    if (heap.size() < capacity) {
+        // A new counter of 1 is never larger than its parent
+        heap.push_back({key, 1, 0});
+        size_t index = heap.size() - 1;
+        positions.emplace(std::move(key), index);
+        while (index > 0 && heap[(index - 1) / 2].count > heap[index].count) {
+            swapItems(index, (index - 1) / 2);
+            index = (index - 1) / 2;
+        }
+        return;
+    }
+
+    // Evict the smallest counter; its count becomes the newcomer's error
+    Item &smallest = heap[0];
+    positions.erase(smallest.value);
+    smallest.error = smallest.count;
+    smallest.count++;
+    smallest.value = key;
+    positions.emplace(std::move(key), 0);
+    siftDown(0);
+}
+
+void SpaceSaving::merge(const SpaceSaving &other) {
+    // Values missing from a full summary may have occurred up to its smallest count times
+    const uint64_t ownMissing = heap.size() < capacity ? 0 : minCount();
+    const uint64_t otherMissing = other.heap.size() < other.capacity ? 0 : other.minCount();
+
+    std::unordered_map<std::string, Item> combined;
+    for (const Item &item : heap) {
+        Item merged = item;
+        merged.count += otherMissing;
+        merged.error += otherMissing;
+        combined.emplace(item.value, std::move(merged));
+    }
+    for (const Item &item : other.heap) {
+        const auto it = combined.find(item.value);
+        if (it != combined.end()) {
+            it->second.count += item.count - otherMissing;
+            it->second.error += item.error - otherMissing;
+        } else {
+            combined.emplace(item.value, Item{item.value, item.count + ownMissing,
+                                              item.error + ownMissing});
+        }
+    }
+
+    std::vector<Item> items;
+    items.reserve(combined.size());
+    for (auto &entry : combined) {
+        items.push_back(std::move(entry.second));
+    }
+    std::sort(items.begin(), items.end(),
+              [](const Item &a, const Item &b) { return a.count > b.count; });
+    items.resize(std::min(items.size(), capacity));
+
+    // Largest first is not a min-heap; reversed it is
+    std::reverse(items.begin(), items.end());
+    heap = std::move(items);
+    positions.clear();
+    for (size_t i = 0; i < heap.size(); i++) {
+        positions.emplace(heap[i].value, i);
+    }
+}
+
+std::vector<SpaceSaving::Item> SpaceSaving::top(const size_t k) const {
+    std::vector<Item> items = heap;
+    std::sort(items.begin(), items.end(),
+              [](const Item &a, const Item &b) { return a.count > b.count; });
+    items.resize(std::min(items.size(), k));
+    return items;
+}
+
+void SpaceSaving::siftDown(size_t index) {
+    while (true) {
+        const size_t left = 2 * index + 1;
+        const size_t right = left + 1;
+        size_t smallest = index;
+        if (left < heap.size() && heap[left].count < heap[smallest].count) {
+            smallest = left;
+        }
+        if (right < heap.size() && heap[right].count < heap[smallest].count) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            return;
+        }
+        swapItems(index, smallest);
+        index = smallest;
+    }
+}
+
+void SpaceSaving::swapItems(const size_t a, const size_t b) {
+    std::swap(heap[a], heap[b]);
+    positions[heap[a].value] = a;
+    positions[heap[b].value] = b;
+}
+
+uint64_t SpaceSaving::minCount() const {
+    return heap.empty() ? 0 : heap[0].count;
+}
+
+// StreamingHistogram
+void StreamingHistogram::add(const double value, const uint64_t count) {
+    const auto it = std::lower_bound(
+        centroids.begin(), centroids.end(), value,
+        [](const std::pair<double, uint64_t> &centroid, double v) { return centroid.first < v; });
+    if (it != centroids.end() && it->first == value) {
+        it->second += count;
+        return;
+    }
+    centroids.insert(it, {value, count});
+    if (centroids.size() > kBins) {
+        compress();
+    }
+}
+
+void StreamingHistogram::merge(const StreamingHistogram &other) {
+    for (const auto &[value, count] : other.centroids) {
+        add(value, count);
+    }
+}
+
+void StreamingHistogram::compress() {
+    while (centroids.size() > kBins) {
+        size_t closest = 0;
+        for (size_t i = 1; i + 1 < centroids.size(); i++) {
+            if (centroids[i + 1].first - centroids[i].first <
+                centroids[closest + 1].first - centroids[closest].first) {
+                closest = i;
+            }
+        }
+        auto &a = centroids[closest];
+        const auto &b = centroids[closest + 1];
+        const uint64_t count = a.second + b.second;
+        a.first = (a.first * static_cast<double>(a.second) +
+                   b.first * static_cast<double>(b.second)) /
+                  static_cast<double>(count);
+        a.second = count;
+        centroids.erase(centroids.begin() + static_cast<std::ptrdiff_t>(closest) + 1);
+    }
+}
+
+std::vector<float> StreamingHistogram::equalWidth(const size_t buckets, const double low,
+                                                  const double high) const {
+    std::vector<float> counts(buckets, 0.0f);
+    if (buckets == 0 || centroids.empty()) {
+        return counts;
+    }
+    const double width = (high - low) / static_cast<double>(buckets);
+    const auto bucketOf = [&](const double value) {
+        const double position = width > 0.0 ? (value - low) / width : 0.0;
+        return position <= 0.0 ? 0 : std::min(buckets - 1, static_cast<size_t>(position));
+    };
+
+    // Each centroid's count is spread evenly from halfway to its left neighbour to halfway to
+    // its right one, rather than piled into the bucket holding its mean
+    for (size_t i = 0; i < centroids.size(); i++) {
+        const auto [value, count] = centroids[i];
+        const double from = i > 0 ? (centroids[i - 1].first + value) / 2.0 : value;
+        const double to = i + 1 < centroids.size() ? (value + centroids[i + 1].first) / 2.0 : value;
+        if (to <= from || width <= 0.0) {
+            counts[bucketOf(value)] += static_cast<float>(count);
+            continue;
+        }
+        for (size_t bucket = bucketOf(from); bucket <= bucketOf(to); bucket++) {
+            const double bucketLow = low + width * static_cast<double>(bucket);
+            const double overlap =
+                std::min(to, bucketLow + width) - std::max(from, bucketLow);
+            if (overlap > 0.0) {
+                counts[bucket] += static_cast<float>(static_cast<double>(count) * overlap /
+                                                     (to - from));
+            }
+        }
+    }
+    return counts;
+}